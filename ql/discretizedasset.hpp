@@ -212,6 +212,50 @@ namespace QuantLib {
         }
     }
 
+    inline void Lattice::rollback(
+              const std::vector<boost::shared_ptr<DiscretizedAsset> >& assets,
+              Time to) const {
+        partialRollback(assets,to);
+        for (Size k=0; k<assets.size(); ++k)
+            assets[k]->adjustValues();
+    }
+
+    inline void Lattice::partialRollback(
+              const std::vector<boost::shared_ptr<DiscretizedAsset> >& assets,
+              Time to) const {
+
+        const Size nAssets = assets.size();
+        const Size iTo = t_.index(to);
+        std::vector<Size> iFrom(nAssets, iTo);
+        Size iMax = iTo;
+        for (Size k=0; k<nAssets; ++k) {
+            QL_REQUIRE(assets[k], "null asset");
+            Time from = assets[k]->time();
+            if (close(from,to))
+                continue;
+            QL_REQUIRE(from > to,
+                       "cannot roll the asset back to" << to
+                       << " (it is already at t = " << from << ")");
+            iFrom[k] = t_.index(from);
+            iMax = std::max(iMax, iFrom[k]);
+        }
+
+        // assets join as soon as the rollback reaches their time
+        for (Size i=iMax; i>iTo; --i) {
+            for (Size k=0; k<nAssets; ++k) {
+                if (iFrom[k] >= i)
+                    partialRollback(*assets[k], t_[i-1]);
+            }
+            // skip the very last adjustment
+            if (i-1 != iTo) {
+                for (Size k=0; k<nAssets; ++k) {
+                    if (iFrom[k] >= i)
+                        assets[k]->adjustValues();
+                }
+            }
+        }
+    }
+
     inline bool DiscretizedAsset::isOnTime(Time t) const {
         const TimeGrid& grid = method()->timeGrid();
         return close_enough(grid[grid.index(t)],time());
@@ -40,6 +40,29 @@
 
 namespace QuantLib {
 
+    //! base class for array expressions
+    /*! Arithmetic operators and functions on arrays return
+        expressions which are evaluated element by element when they
+        are assigned to an array.  A chained expression such as
+        <tt>a*x + b*y - z</tt> is thus calculated in a single loop,
+        without allocating temporary arrays.
+
+        \warning expressions refer to their array operands and must
+                 not be stored; they are meant to be assigned to an
+                 Array, or passed where an Array is expected, within
+                 the statement that creates them.
+    */
+    template <class E>
+    class ArrayExpression {
+      public:
+        const E& self() const { return static_cast<const E&>(*this); }
+      protected:
+        ArrayExpression() {}
+    };
+
+    class Array;
+    template <> class Disposable<Array>;
+
     //! 1-D array used in linear algebra.
     /*! This class implements the concept of vector as used in linear
         algebra.
@@ -48,7 +71,7 @@ namespace QuantLib {
 
         \test construction of arrays is checked in a number of cases
     */
-    class Array {
+    class Array : public ArrayExpression<Array> {
       public:
         //! \name Constructors, destructor, and assignment
         //@{
@@ -62,12 +85,21 @@ namespace QuantLib {
         Array(Size size, Real value, Real increment);
         Array(const Array&);
         Array(const Disposable<Array>&);
+        //! creates the array by evaluating an expression
+        template <class E>
+        Array(const ArrayExpression<E>&);
         //! creates the array from an iterable sequence
         template <class ForwardIterator>
         Array(ForwardIterator begin, ForwardIterator end);
 
         Array& operator=(const Array&);
         Array& operator=(const Disposable<Array>&);
+        /*! the expression is evaluated in place if the array has
+            the right size; the expression can refer to the array
+            itself.
+        */
+        template <class E>
+        Array& operator=(const ArrayExpression<E>&);
         bool operator==(const Array&) const;
         bool operator!=(const Array&) const;
         //@}
@@ -83,13 +115,17 @@ namespace QuantLib {
             the same size.
         */
         //@{
-        const Array& operator+=(const Array&);
+        template <class E>
+        const Array& operator+=(const ArrayExpression<E>&);
         const Array& operator+=(Real);
-        const Array& operator-=(const Array&);
+        template <class E>
+        const Array& operator-=(const ArrayExpression<E>&);
         const Array& operator-=(Real);
-        const Array& operator*=(const Array&);
+        template <class E>
+        const Array& operator*=(const ArrayExpression<E>&);
         const Array& operator*=(Real);
-        const Array& operator/=(const Array&);
+        template <class E>
+        const Array& operator/=(const ArrayExpression<E>&);
         const Array& operator/=(Real);
         //@}
         //! \name Element access
@@ -149,55 +185,196 @@ namespace QuantLib {
 
 
 
+    //! disposable array, also obtained by evaluating an expression
+    /*! This specialization allows functions returning
+        <tt>Disposable\<Array\></tt> to return array expressions.
+    */
+    template <>
+    class Disposable<Array> : public Array {
+      public:
+        Disposable(Array& t) { this->swap(t); }
+        Disposable(const Disposable<Array>& t) : Array() {
+            this->swap(const_cast<Disposable<Array>&>(t));
+        }
+        template <class E>
+        Disposable(const ArrayExpression<E>& e) : Array(e) {}
+        Disposable<Array>& operator=(const Disposable<Array>& t) {
+            this->swap(const_cast<Disposable<Array>&>(t));
+            return *this;
+        }
+    };
+
+    namespace detail {
+
+        // arrays are held by reference in expressions; other
+        // expressions are lightweight and held by value
+        template <class E>
+        struct ArrayOperand {
+            typedef const E type;
+        };
+
+        template <>
+        struct ArrayOperand<Array> {
+            typedef const Array& type;
+        };
+
+        template <class E, class F>
+        class ArrayUnaryExpression
+            : public ArrayExpression<ArrayUnaryExpression<E,F> > {
+          public:
+            ArrayUnaryExpression(const E& e, const F& f) : e_(e), f_(f) {}
+            Size size() const { return e_.size(); }
+            Real operator[](Size i) const { return f_(e_[i]); }
+          private:
+            typename ArrayOperand<E>::type e_;
+            F f_;
+        };
+
+        template <class E1, class E2, class F>
+        class ArrayBinaryExpression
+            : public ArrayExpression<ArrayBinaryExpression<E1,E2,F> > {
+          public:
+            ArrayBinaryExpression(const E1& e1, const E2& e2, const F& f)
+            : e1_(e1), e2_(e2), f_(f) {}
+            Size size() const { return e1_.size(); }
+            Real operator[](Size i) const { return f_(e1_[i], e2_[i]); }
+          private:
+            typename ArrayOperand<E1>::type e1_;
+            typename ArrayOperand<E2>::type e2_;
+            F f_;
+        };
+
+        template <class E>
+        struct ArrayNegate {
+            typedef ArrayUnaryExpression<E, std::negate<Real> > type;
+        };
+
+        template <class E, class Op>
+        struct ArrayScalarRight {
+            typedef ArrayUnaryExpression<E, std::binder2nd<Op> > type;
+        };
+
+        template <class E, class Op>
+        struct ArrayScalarLeft {
+            typedef ArrayUnaryExpression<E, std::binder1st<Op> > type;
+        };
+
+        template <class E1, class E2, class Op>
+        struct ArrayBinary {
+            typedef ArrayBinaryExpression<E1, E2, Op> type;
+        };
+
+        template <class E>
+        struct ArrayFunction {
+            typedef ArrayUnaryExpression<
+                E, std::pointer_to_unary_function<Real,Real> > type;
+        };
+
+        template <class E>
+        struct ArrayPower {
+            typedef ArrayUnaryExpression<
+                E, std::binder2nd<
+                       std::pointer_to_binary_function<Real,Real,Real> > >
+            type;
+        };
+
+        inline void checkArraySizes(Size n1, Size n2, const char* what) {
+            QL_REQUIRE(n1 == n2,
+                       "arrays with different sizes (" << n1 << ", "
+                       << n2 << ") cannot be " << what);
+        }
+
+    }
+
+
     /*! \relates Array */
-    Real DotProduct(const Array&, const Array&);
+    template <class E1, class E2>
+    Real DotProduct(const ArrayExpression<E1>&, const ArrayExpression<E2>&);
 
     /*! \relates Array */
-    Real Norm2(const Array&);
+    template <class E>
+    Real Norm2(const ArrayExpression<E>&);
 
     // unary operators
     /*! \relates Array */
-    const Disposable<Array> operator+(const Array& v);
+    template <class E>
+    const E& operator+(const ArrayExpression<E>& v);
     /*! \relates Array */
-    const Disposable<Array> operator-(const Array& v);
+    template <class E>
+    const typename detail::ArrayNegate<E>::type
+    operator-(const ArrayExpression<E>& v);
 
     // binary operators
     /*! \relates Array */
-    const Disposable<Array> operator+(const Array&, const Array&);
+    template <class E1, class E2>
+    const typename detail::ArrayBinary<E1,E2,std::plus<Real> >::type
+    operator+(const ArrayExpression<E1>&, const ArrayExpression<E2>&);
     /*! \relates Array */
-    const Disposable<Array> operator+(const Array&, Real);
+    template <class E>
+    const typename detail::ArrayScalarRight<E,std::plus<Real> >::type
+    operator+(const ArrayExpression<E>&, Real);
     /*! \relates Array */
-    const Disposable<Array> operator+(Real, const Array&);
+    template <class E>
+    const typename detail::ArrayScalarLeft<E,std::plus<Real> >::type
+    operator+(Real, const ArrayExpression<E>&);
     /*! \relates Array */
-    const Disposable<Array> operator-(const Array&, const Array&);
+    template <class E1, class E2>
+    const typename detail::ArrayBinary<E1,E2,std::minus<Real> >::type
+    operator-(const ArrayExpression<E1>&, const ArrayExpression<E2>&);
     /*! \relates Array */
-    const Disposable<Array> operator-(const Array&, Real);
+    template <class E>
+    const typename detail::ArrayScalarRight<E,std::minus<Real> >::type
+    operator-(const ArrayExpression<E>&, Real);
     /*! \relates Array */
-    const Disposable<Array> operator-(Real, const Array&);
+    template <class E>
+    const typename detail::ArrayScalarLeft<E,std::minus<Real> >::type
+    operator-(Real, const ArrayExpression<E>&);
     /*! \relates Array */
-    const Disposable<Array> operator*(const Array&, const Array&);
+    template <class E1, class E2>
+    const typename detail::ArrayBinary<E1,E2,std::multiplies<Real> >::type
+    operator*(const ArrayExpression<E1>&, const ArrayExpression<E2>&);
     /*! \relates Array */
-    const Disposable<Array> operator*(const Array&, Real);
+    template <class E>
+    const typename detail::ArrayScalarRight<E,std::multiplies<Real> >::type
+    operator*(const ArrayExpression<E>&, Real);
     /*! \relates Array */
-    const Disposable<Array> operator*(Real, const Array&);
+    template <class E>
+    const typename detail::ArrayScalarLeft<E,std::multiplies<Real> >::type
+    operator*(Real, const ArrayExpression<E>&);
     /*! \relates Array */
-    const Disposable<Array> operator/(const Array&, const Array&);
+    template <class E1, class E2>
+    const typename detail::ArrayBinary<E1,E2,std::divides<Real> >::type
+    operator/(const ArrayExpression<E1>&, const ArrayExpression<E2>&);
     /*! \relates Array */
-    const Disposable<Array> operator/(const Array&, Real);
+    template <class E>
+    const typename detail::ArrayScalarRight<E,std::divides<Real> >::type
+    operator/(const ArrayExpression<E>&, Real);
     /*! \relates Array */
-    const Disposable<Array> operator/(Real, const Array&);
+    template <class E>
+    const typename detail::ArrayScalarLeft<E,std::divides<Real> >::type
+    operator/(Real, const ArrayExpression<E>&);
 
     // math functions
     /*! \relates Array */
-    const Disposable<Array> Abs(const Array&);
+    template <class E>
+    const typename detail::ArrayFunction<E>::type
+    Abs(const ArrayExpression<E>&);
     /*! \relates Array */
-    const Disposable<Array> Sqrt(const Array&);
+    template <class E>
+    const typename detail::ArrayFunction<E>::type
+    Sqrt(const ArrayExpression<E>&);
     /*! \relates Array */
-    const Disposable<Array> Log(const Array&);
+    template <class E>
+    const typename detail::ArrayFunction<E>::type
+    Log(const ArrayExpression<E>&);
     /*! \relates Array */
-    const Disposable<Array> Exp(const Array&);
+    template <class E>
+    const typename detail::ArrayFunction<E>::type
+    Exp(const ArrayExpression<E>&);
     /*! \relates Array */
-    const Disposable<Array> Pow(const Array&, Real);
+    template <class E>
+    const typename detail::ArrayPower<E>::type
+    Pow(const ArrayExpression<E>&, Real);
 
     // utilities
     /*! \relates Array */
@@ -237,6 +414,15 @@ namespace QuantLib {
         swap(const_cast<Disposable<Array>&>(from));
     }
 
+    template <class E>
+    inline Array::Array(const ArrayExpression<E>& e)
+    : data_(e.self().size() ? new Real[e.self().size()] : (Real*)(0)),
+      n_(e.self().size()) {
+        const E& from = e.self();
+        for (Size i=0; i<n_; ++i)
+            data_[i] = from[i];
+    }
+
     namespace detail {
 
         template <class I>
@@ -302,12 +488,27 @@ namespace QuantLib {
         return *this;
     }
 
-    inline const Array& Array::operator+=(const Array& v) {
-        QL_REQUIRE(n_ == v.n_,
-                   "arrays with different sizes (" << n_ << ", "
-                   << v.n_ << ") cannot be added");
-        std::transform(begin(),end(),v.begin(),begin(),
-                       std::plus<Real>());
+    template <class E>
+    inline Array& Array::operator=(const ArrayExpression<E>& e) {
+        const E& from = e.self();
+        if (from.size() == n_) {
+            // elements only depend on the corresponding elements of
+            // the operands, so that aliasing is not an issue
+            for (Size i=0; i<n_; ++i)
+                data_[i] = from[i];
+        } else {
+            Array temp(e);
+            swap(temp);
+        }
+        return *this;
+    }
+
+    template <class E>
+    inline const Array& Array::operator+=(const ArrayExpression<E>& e) {
+        const E& v = e.self();
+        detail::checkArraySizes(n_, v.size(), "added");
+        for (Size i=0; i<n_; ++i)
+            data_[i] += v[i];
         return *this;
     }
 
@@ -318,12 +519,12 @@ namespace QuantLib {
         return *this;
     }
 
-    inline const Array& Array::operator-=(const Array& v) {
-        QL_REQUIRE(n_ == v.n_,
-                   "arrays with different sizes (" << n_ << ", "
-                   << v.n_ << ") cannot be subtracted");
-        std::transform(begin(),end(),v.begin(),begin(),
-                       std::minus<Real>());
+    template <class E>
+    inline const Array& Array::operator-=(const ArrayExpression<E>& e) {
+        const E& v = e.self();
+        detail::checkArraySizes(n_, v.size(), "subtracted");
+        for (Size i=0; i<n_; ++i)
+            data_[i] -= v[i];
         return *this;
     }
 
@@ -333,12 +534,12 @@ namespace QuantLib {
         return *this;
     }
 
-    inline const Array& Array::operator*=(const Array& v) {
-        QL_REQUIRE(n_ == v.n_,
-                   "arrays with different sizes (" << n_ << ", "
-                   << v.n_ << ") cannot be multiplied");
-        std::transform(begin(),end(),v.begin(),begin(),
-                       std::multiplies<Real>());
+    template <class E>
+    inline const Array& Array::operator*=(const ArrayExpression<E>& e) {
+        const E& v = e.self();
+        detail::checkArraySizes(n_, v.size(), "multiplied");
+        for (Size i=0; i<n_; ++i)
+            data_[i] *= v[i];
         return *this;
     }
 
@@ -348,12 +549,12 @@ namespace QuantLib {
         return *this;
     }
 
-    inline const Array& Array::operator/=(const Array& v) {
-        QL_REQUIRE(n_ == v.n_,
-                   "arrays with different sizes (" << n_ << ", "
-                   << v.n_ << ") cannot be divided");
-        std::transform(begin(),end(),v.begin(),begin(),
-                       std::divides<Real>());
+    template <class E>
+    inline const Array& Array::operator/=(const ArrayExpression<E>& e) {
+        const E& v = e.self();
+        detail::checkArraySizes(n_, v.size(), "divided");
+        for (Size i=0; i<n_; ++i)
+            data_[i] /= v[i];
         return *this;
     }
 
@@ -471,14 +672,20 @@ namespace QuantLib {
 
     // dot product and norm
 
-    inline Real DotProduct(const Array& v1, const Array& v2) {
-        QL_REQUIRE(v1.size() == v2.size(),
-                   "arrays with different sizes (" << v1.size() << ", "
-                   << v2.size() << ") cannot be multiplied");
-        return std::inner_product(v1.begin(),v1.end(),v2.begin(),0.0);
+    template <class E1, class E2>
+    inline Real DotProduct(const ArrayExpression<E1>& e1,
+                           const ArrayExpression<E2>& e2) {
+        const E1& v1 = e1.self();
+        const E2& v2 = e2.self();
+        detail::checkArraySizes(v1.size(), v2.size(), "multiplied");
+        Real result = 0.0;
+        for (Size i=0; i<v1.size(); ++i)
+            result += v1[i]*v2[i];
+        return result;
     }
 
-    inline Real Norm2(const Array& v) {
+    template <class E>
+    inline Real Norm2(const ArrayExpression<E>& v) {
         return std::sqrt(DotProduct(v, v));
     }
 
@@ -486,157 +693,164 @@ namespace QuantLib {
 
     // unary
 
-    inline const Disposable<Array> operator+(const Array& v) {
-        Array result = v;
-        return result;
+    template <class E>
+    inline const E& operator+(const ArrayExpression<E>& v) {
+        return v.self();
     }
 
-    inline const Disposable<Array> operator-(const Array& v) {
-        Array result(v.size());
-        std::transform(v.begin(),v.end(),result.begin(),
-                       std::negate<Real>());
-        return result;
+    template <class E>
+    inline const typename detail::ArrayNegate<E>::type
+    operator-(const ArrayExpression<E>& v) {
+        return typename detail::ArrayNegate<E>::type(v.self(),
+                                                     std::negate<Real>());
     }
 
 
     // binary operators
 
-    inline const Disposable<Array> operator+(const Array& v1,
-                                             const Array& v2) {
-        QL_REQUIRE(v1.size() == v2.size(),
-                   "arrays with different sizes (" << v1.size() << ", "
-                   << v2.size() << ") cannot be added");
-        Array result(v1.size());
-        std::transform(v1.begin(),v1.end(),v2.begin(),result.begin(),
-                       std::plus<Real>());
-        return result;
-    }
-
-    inline const Disposable<Array> operator+(const Array& v1, Real a) {
-        Array result(v1.size());
-        std::transform(v1.begin(),v1.end(),result.begin(),
-                       std::bind2nd(std::plus<Real>(),a));
-        return result;
-    }
-
-    inline const Disposable<Array> operator+(Real a, const Array& v2) {
-        Array result(v2.size());
-        std::transform(v2.begin(),v2.end(),result.begin(),
-                       std::bind1st(std::plus<Real>(),a));
-        return result;
-    }
-
-    inline const Disposable<Array> operator-(const Array& v1,
-                                             const Array& v2) {
-        QL_REQUIRE(v1.size() == v2.size(),
-                   "arrays with different sizes (" << v1.size() << ", "
-                   << v2.size() << ") cannot be subtracted");
-        Array result(v1.size());
-        std::transform(v1.begin(),v1.end(),v2.begin(),result.begin(),
-                       std::minus<Real>());
-        return result;
-    }
-
-    inline const Disposable<Array> operator-(const Array& v1, Real a) {
-        Array result(v1.size());
-        std::transform(v1.begin(),v1.end(),result.begin(),
-                       std::bind2nd(std::minus<Real>(),a));
-        return result;
-    }
-
-    inline const Disposable<Array> operator-(Real a, const Array& v2) {
-        Array result(v2.size());
-        std::transform(v2.begin(),v2.end(),result.begin(),
-                       std::bind1st(std::minus<Real>(),a));
-        return result;
-    }
-
-    inline const Disposable<Array> operator*(const Array& v1,
-                                             const Array& v2) {
-        QL_REQUIRE(v1.size() == v2.size(),
-                   "arrays with different sizes (" << v1.size() << ", "
-                   << v2.size() << ") cannot be multiplied");
-        Array result(v1.size());
-        std::transform(v1.begin(),v1.end(),v2.begin(),result.begin(),
-                       std::multiplies<Real>());
-        return result;
-    }
-
-    inline const Disposable<Array> operator*(const Array& v1, Real a) {
-        Array result(v1.size());
-        std::transform(v1.begin(),v1.end(),result.begin(),
-                       std::bind2nd(std::multiplies<Real>(),a));
-        return result;
-    }
-
-    inline const Disposable<Array> operator*(Real a, const Array& v2) {
-        Array result(v2.size());
-        std::transform(v2.begin(),v2.end(),result.begin(),
-                       std::bind1st(std::multiplies<Real>(),a));
-        return result;
-    }
-
-    inline const Disposable<Array> operator/(const Array& v1,
-                                             const Array& v2) {
-        QL_REQUIRE(v1.size() == v2.size(),
-                   "arrays with different sizes (" << v1.size() << ", "
-                   << v2.size() << ") cannot be divided");
-        Array result(v1.size());
-        std::transform(v1.begin(),v1.end(),v2.begin(),result.begin(),
-                       std::divides<Real>());
-        return result;
-    }
-
-    inline const Disposable<Array> operator/(const Array& v1, Real a) {
-        Array result(v1.size());
-        std::transform(v1.begin(),v1.end(),result.begin(),
-                       std::bind2nd(std::divides<Real>(),a));
-        return result;
-    }
-
-    inline const Disposable<Array> operator/(Real a, const Array& v2) {
-        Array result(v2.size());
-        std::transform(v2.begin(),v2.end(),result.begin(),
-                       std::bind1st(std::divides<Real>(),a));
-        return result;
+    template <class E1, class E2>
+    inline const typename detail::ArrayBinary<E1,E2,std::plus<Real> >::type
+    operator+(const ArrayExpression<E1>& v1,
+              const ArrayExpression<E2>& v2) {
+        detail::checkArraySizes(v1.self().size(), v2.self().size(),
+                                "added");
+        return typename detail::ArrayBinary<E1,E2,std::plus<Real> >::type(
+                                   v1.self(), v2.self(), std::plus<Real>());
+    }
+
+    template <class E>
+    inline const typename detail::ArrayScalarRight<E,std::plus<Real> >::type
+    operator+(const ArrayExpression<E>& v1, Real a) {
+        return typename detail::ArrayScalarRight<E,std::plus<Real> >::type(
+                            v1.self(), std::bind2nd(std::plus<Real>(),a));
+    }
+
+    template <class E>
+    inline const typename detail::ArrayScalarLeft<E,std::plus<Real> >::type
+    operator+(Real a, const ArrayExpression<E>& v2) {
+        return typename detail::ArrayScalarLeft<E,std::plus<Real> >::type(
+                            v2.self(), std::bind1st(std::plus<Real>(),a));
+    }
+
+    template <class E1, class E2>
+    inline const typename detail::ArrayBinary<E1,E2,std::minus<Real> >::type
+    operator-(const ArrayExpression<E1>& v1,
+              const ArrayExpression<E2>& v2) {
+        detail::checkArraySizes(v1.self().size(), v2.self().size(),
+                                "subtracted");
+        return typename detail::ArrayBinary<E1,E2,std::minus<Real> >::type(
+                                  v1.self(), v2.self(), std::minus<Real>());
+    }
+
+    template <class E>
+    inline const typename detail::ArrayScalarRight<E,std::minus<Real> >::type
+    operator-(const ArrayExpression<E>& v1, Real a) {
+        return typename detail::ArrayScalarRight<E,std::minus<Real> >::type(
+                           v1.self(), std::bind2nd(std::minus<Real>(),a));
+    }
+
+    template <class E>
+    inline const typename detail::ArrayScalarLeft<E,std::minus<Real> >::type
+    operator-(Real a, const ArrayExpression<E>& v2) {
+        return typename detail::ArrayScalarLeft<E,std::minus<Real> >::type(
+                           v2.self(), std::bind1st(std::minus<Real>(),a));
+    }
+
+    template <class E1, class E2>
+    inline const
+    typename detail::ArrayBinary<E1,E2,std::multiplies<Real> >::type
+    operator*(const ArrayExpression<E1>& v1,
+              const ArrayExpression<E2>& v2) {
+        detail::checkArraySizes(v1.self().size(), v2.self().size(),
+                                "multiplied");
+        return typename
+            detail::ArrayBinary<E1,E2,std::multiplies<Real> >::type(
+                             v1.self(), v2.self(), std::multiplies<Real>());
+    }
+
+    template <class E>
+    inline const
+    typename detail::ArrayScalarRight<E,std::multiplies<Real> >::type
+    operator*(const ArrayExpression<E>& v1, Real a) {
+        return typename
+            detail::ArrayScalarRight<E,std::multiplies<Real> >::type(
+                      v1.self(), std::bind2nd(std::multiplies<Real>(),a));
+    }
+
+    template <class E>
+    inline const
+    typename detail::ArrayScalarLeft<E,std::multiplies<Real> >::type
+    operator*(Real a, const ArrayExpression<E>& v2) {
+        return typename
+            detail::ArrayScalarLeft<E,std::multiplies<Real> >::type(
+                      v2.self(), std::bind1st(std::multiplies<Real>(),a));
+    }
+
+    template <class E1, class E2>
+    inline const
+    typename detail::ArrayBinary<E1,E2,std::divides<Real> >::type
+    operator/(const ArrayExpression<E1>& v1,
+              const ArrayExpression<E2>& v2) {
+        detail::checkArraySizes(v1.self().size(), v2.self().size(),
+                                "divided");
+        return typename detail::ArrayBinary<E1,E2,std::divides<Real> >::type(
+                                v1.self(), v2.self(), std::divides<Real>());
+    }
+
+    template <class E>
+    inline const
+    typename detail::ArrayScalarRight<E,std::divides<Real> >::type
+    operator/(const ArrayExpression<E>& v1, Real a) {
+        return typename
+            detail::ArrayScalarRight<E,std::divides<Real> >::type(
+                         v1.self(), std::bind2nd(std::divides<Real>(),a));
+    }
+
+    template <class E>
+    inline const
+    typename detail::ArrayScalarLeft<E,std::divides<Real> >::type
+    operator/(Real a, const ArrayExpression<E>& v2) {
+        return typename
+            detail::ArrayScalarLeft<E,std::divides<Real> >::type(
+                         v2.self(), std::bind1st(std::divides<Real>(),a));
     }
 
     // functions
 
-    inline const Disposable<Array> Abs(const Array& v) {
-        Array result(v.size());
-        std::transform(v.begin(),v.end(),result.begin(),
-                       std::ptr_fun<Real,Real>(std::fabs));
-        return result;
+    template <class E>
+    inline const typename detail::ArrayFunction<E>::type
+    Abs(const ArrayExpression<E>& v) {
+        return typename detail::ArrayFunction<E>::type(
+                            v.self(), std::ptr_fun<Real,Real>(std::fabs));
     }
 
-    inline const Disposable<Array> Sqrt(const Array& v) {
-        Array result(v.size());
-        std::transform(v.begin(),v.end(),result.begin(),
-                       std::ptr_fun<Real,Real>(std::sqrt));
-        return result;
+    template <class E>
+    inline const typename detail::ArrayFunction<E>::type
+    Sqrt(const ArrayExpression<E>& v) {
+        return typename detail::ArrayFunction<E>::type(
+                            v.self(), std::ptr_fun<Real,Real>(std::sqrt));
     }
 
-    inline const Disposable<Array> Log(const Array& v) {
-        Array result(v.size());
-        std::transform(v.begin(),v.end(),result.begin(),
-                       std::ptr_fun<Real,Real>(std::log));
-        return result;
+    template <class E>
+    inline const typename detail::ArrayFunction<E>::type
+    Log(const ArrayExpression<E>& v) {
+        return typename detail::ArrayFunction<E>::type(
+                             v.self(), std::ptr_fun<Real,Real>(std::log));
     }
 
-    inline const Disposable<Array> Exp(const Array& v) {
-        Array result(v.size());
-        std::transform(v.begin(),v.end(),result.begin(),
-                       std::ptr_fun<Real,Real>(std::exp));
-        return result;
+    template <class E>
+    inline const typename detail::ArrayFunction<E>::type
+    Exp(const ArrayExpression<E>& v) {
+        return typename detail::ArrayFunction<E>::type(
+                             v.self(), std::ptr_fun<Real,Real>(std::exp));
     }
 
-    inline const Disposable<Array> Pow(const Array& v, Real alpha) {
-        Array result(v.size());
-        std::transform(v.begin(), v.end(), result.begin(),
+    template <class E>
+    inline const typename detail::ArrayPower<E>::type
+    Pow(const ArrayExpression<E>& v, Real alpha) {
+        return typename detail::ArrayPower<E>::type(
+            v.self(),
             std::bind2nd(std::ptr_fun<Real, Real, Real>(std::pow), alpha));
-
-        return result;
     }
 
 
@@ -29,6 +29,7 @@
 #include <ql/math/errorfunction.hpp>
 #include <ql/errors.hpp>
 #include <ql/math/comparison.hpp>
+#include <algorithm>
 
 #if defined(__GNUC__) && (((__GNUC__ == 4) && (__GNUC_MINOR__ >= 8)) || (__GNUC__ > 4))
 #pragma GCC diagnostic push
@@ -148,6 +149,15 @@ namespace QuantLib {
 
             return z;
         }
+        //! transforms the values in [begin, end) into out
+        /*! The results are the same as those of operator(), but the
+            rational approximation for the central region is
+            calculated on blocks of values in a loop without branches
+            which the compiler can vectorize; the few values in the
+            tails are then corrected one by one.  The output range
+            can coincide with the input one.
+        */
+        void transform(const Real* begin, const Real* end, Real* out) const;
       private:
         /* Handling tails moved into a separate method, which should
            make the inlining of operator() and standard_value method
@@ -373,6 +383,49 @@ namespace QuantLib {
     // const CumulativeNormalDistribution InverseCumulativeNormal::f_;
     // #endif
 
+    inline void InverseCumulativeNormal::transform(const Real* begin,
+                                                   const Real* end,
+                                                   Real* out) const {
+        const Size block = 64;
+        Real x[block], z[block];
+        Size tails[block];
+        while (begin < end) {
+            // blocks are padded to full size so that the loop below
+            // has a fixed number of iterations
+            const Size n = std::min<Size>(block, end-begin);
+            std::copy(begin, begin+n, x);
+            std::fill(x+n, x+block, 0.5);
+
+            // central region for all values...
+            for (Size i=0; i<block; ++i) {
+                const Real y = x[i] - 0.5;
+                const Real r = y*y;
+                z[i] = (((((a1_()*r+a2_())*r+a3_())*r+a4_())*r+a5_())*r+a6_())*y /
+                       (((((b1_()*r+b2_())*r+b3_())*r+b4_())*r+b5_())*r+1.0);
+            }
+            // ...then the tails, collected without branches since
+            // random inputs would make them hard to predict
+            Size m = 0;
+            for (Size i=0; i<n; ++i) {
+                tails[m] = i;
+                m += (x[i] < x_low_() || x_high_() < x[i]);
+            }
+            for (Size j=0; j<m; ++j)
+                z[tails[j]] = tail_value(x[tails[j]]);
+
+            for (Size i=0; i<n; ++i) {
+                #ifdef REFINE_TO_FULL_MACHINE_PRECISION_USING_HALLEYS_METHOD
+                const Real r =
+                    (f_(z[i]) - x[i]) * M_SQRT2 * M_SQRTPI * exp(0.5 * z[i]*z[i]);
+                z[i] -= r/(1+0.5*z[i]*r);
+                #endif
+                out[i] = average_ + sigma_*z[i];
+            }
+            begin += n;
+            out += n;
+        }
+    }
+
     inline Real InverseCumulativeNormal::tail_value(Real x) {
         if (x <= 0.0 || x >= 1.0) {
             // try to recover if due to numerical error
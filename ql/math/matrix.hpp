@@ -27,6 +27,7 @@
 #define quantlib_matrix_hpp
 
 #include <ql/math/array.hpp>
+#include <ql/math/matrixutilities/blaskernels.hpp>
 #include <ql/utilities/steppingiterator.hpp>
 
 #if defined(QL_PATCH_MSVC)
@@ -65,12 +66,38 @@
 
 namespace QuantLib {
 
+    //! base class for matrix expressions
+    /*! As for arrays, sums and differences of matrices, their
+        products and quotients with scalars, and transposed matrices
+        are expressions which are evaluated element by element when
+        assigned to a matrix, without allocating temporaries.  Matrix
+        products are still calculated eagerly, using the cache-blocked
+        kernels in blaskernels.hpp.
+
+        \warning expressions refer to their matrix operands and must
+                 not be stored.
+    */
+    template <class E>
+    class MatrixExpression {
+      public:
+        const E& self() const { return static_cast<const E&>(*this); }
+      protected:
+        MatrixExpression() {}
+    };
+
+    class Matrix;
+    template <> class Disposable<Matrix>;
+
+    namespace detail {
+        template <class E> class MatrixTransposeExpression;
+    }
+
     //! %Matrix used in linear algebra.
     /*! This class implements the concept of Matrix as used in linear
         algebra. As such, it is <b>not</b> meant to be used as a
         container.
     */
-    class Matrix {
+    class Matrix : public MatrixExpression<Matrix> {
       public:
         //! \name Constructors, destructor, and assignment
         //@{
@@ -89,8 +116,16 @@ namespace QuantLib {
         Matrix(Size rows, Size columns, Iterator begin, Iterator end);
         Matrix(const Matrix &);
         Matrix(const Disposable<Matrix>&);
+        //! creates the matrix by evaluating an expression
+        template <class E>
+        Matrix(const MatrixExpression<E>&);
         Matrix& operator=(const Matrix&);
         Matrix& operator=(const Disposable<Matrix>&);
+        /*! the expression is evaluated in place if the matrix has
+            the right size and is not transposed by the expression.
+        */
+        template <class E>
+        Matrix& operator=(const MatrixExpression<E>&);
         //@}
 
         //! \name Algebraic operators
@@ -98,8 +133,10 @@ namespace QuantLib {
                  the same size.
         */
         //@{
-        const Matrix& operator+=(const Matrix&);
-        const Matrix& operator-=(const Matrix&);
+        template <class E>
+        const Matrix& operator+=(const MatrixExpression<E>&);
+        template <class E>
+        const Matrix& operator-=(const MatrixExpression<E>&);
         const Matrix& operator*=(Real);
         const Matrix& operator/=(Real);
         //@}
@@ -170,23 +207,154 @@ namespace QuantLib {
         //@{
         void swap(Matrix&);
         //@}
+        //! \name Expression interface
+        //@{
+        bool contains(const Matrix* m) const { return m == this; }
+        bool transposes(const Matrix*) const { return false; }
+        //@}
       private:
+        template <class E>
+        void assign(const E& e);
+        template <class E>
+        void assign(const detail::MatrixTransposeExpression<E>& e);
         boost::scoped_array<Real> data_;
         Size rows_, columns_;
     };
 
+    //! disposable matrix, also obtained by evaluating an expression
+    template <>
+    class Disposable<Matrix> : public Matrix {
+      public:
+        Disposable(Matrix& t) { this->swap(t); }
+        Disposable(const Disposable<Matrix>& t) : Matrix() {
+            this->swap(const_cast<Disposable<Matrix>&>(t));
+        }
+        template <class E>
+        Disposable(const MatrixExpression<E>& e) : Matrix(e) {}
+        Disposable<Matrix>& operator=(const Disposable<Matrix>& t) {
+            this->swap(const_cast<Disposable<Matrix>&>(t));
+            return *this;
+        }
+    };
+
+    namespace detail {
+
+        // matrices are held by reference in expressions; other
+        // expressions are lightweight and held by value
+        template <class E>
+        struct MatrixOperand {
+            typedef const E type;
+        };
+
+        template <>
+        struct MatrixOperand<Matrix> {
+            typedef const Matrix& type;
+        };
+
+        template <class E, class F>
+        class MatrixUnaryExpression
+            : public MatrixExpression<MatrixUnaryExpression<E,F> > {
+          public:
+            MatrixUnaryExpression(const E& e, const F& f) : e_(e), f_(f) {}
+            Size rows() const { return e_.rows(); }
+            Size columns() const { return e_.columns(); }
+            Real operator()(Size i, Size j) const { return f_(e_(i,j)); }
+            bool contains(const Matrix* m) const { return e_.contains(m); }
+            bool transposes(const Matrix* m) const {
+                return e_.transposes(m);
+            }
+          private:
+            typename MatrixOperand<E>::type e_;
+            F f_;
+        };
+
+        template <class E1, class E2, class F>
+        class MatrixBinaryExpression
+            : public MatrixExpression<MatrixBinaryExpression<E1,E2,F> > {
+          public:
+            MatrixBinaryExpression(const E1& e1, const E2& e2, const F& f)
+            : e1_(e1), e2_(e2), f_(f) {}
+            Size rows() const { return e1_.rows(); }
+            Size columns() const { return e1_.columns(); }
+            Real operator()(Size i, Size j) const {
+                return f_(e1_(i,j), e2_(i,j));
+            }
+            bool contains(const Matrix* m) const {
+                return e1_.contains(m) || e2_.contains(m);
+            }
+            bool transposes(const Matrix* m) const {
+                return e1_.transposes(m) || e2_.transposes(m);
+            }
+          private:
+            typename MatrixOperand<E1>::type e1_;
+            typename MatrixOperand<E2>::type e2_;
+            F f_;
+        };
+
+        template <class E>
+        class MatrixTransposeExpression
+            : public MatrixExpression<MatrixTransposeExpression<E> > {
+          public:
+            explicit MatrixTransposeExpression(const E& e) : e_(e) {}
+            Size rows() const { return e_.columns(); }
+            Size columns() const { return e_.rows(); }
+            Real operator()(Size i, Size j) const { return e_(j,i); }
+            bool contains(const Matrix* m) const { return e_.contains(m); }
+            bool transposes(const Matrix* m) const { return e_.contains(m); }
+          private:
+            typename MatrixOperand<E>::type e_;
+        };
+
+        template <class E, class Op>
+        struct MatrixScalarRight {
+            typedef MatrixUnaryExpression<E, std::binder2nd<Op> > type;
+        };
+
+        template <class E, class Op>
+        struct MatrixScalarLeft {
+            typedef MatrixUnaryExpression<E, std::binder1st<Op> > type;
+        };
+
+        template <class E1, class E2, class Op>
+        struct MatrixBinary {
+            typedef MatrixBinaryExpression<E1, E2, Op> type;
+        };
+
+        template <class E1, class E2>
+        inline void checkMatrixSizes(const E1& m1, const E2& m2,
+                                     const char* what) {
+            QL_REQUIRE(m1.rows() == m2.rows() &&
+                       m1.columns() == m2.columns(),
+                       "matrices with different sizes (" <<
+                       m1.rows() << "x" << m1.columns() << ", " <<
+                       m2.rows() << "x" << m2.columns() << ") cannot be "
+                       << what);
+        }
+
+    }
+
     // algebraic operators
 
     /*! \relates Matrix */
-    const Disposable<Matrix> operator+(const Matrix&, const Matrix&);
+    template <class E1, class E2>
+    const typename detail::MatrixBinary<E1,E2,std::plus<Real> >::type
+    operator+(const MatrixExpression<E1>&, const MatrixExpression<E2>&);
     /*! \relates Matrix */
-    const Disposable<Matrix> operator-(const Matrix&, const Matrix&);
+    template <class E1, class E2>
+    const typename detail::MatrixBinary<E1,E2,std::minus<Real> >::type
+    operator-(const MatrixExpression<E1>&, const MatrixExpression<E2>&);
     /*! \relates Matrix */
-    const Disposable<Matrix> operator*(const Matrix&, Real);
+    template <class E>
+    const typename detail::MatrixScalarRight<E,std::multiplies<Real> >::type
+    operator*(const MatrixExpression<E>&, Real);
     /*! \relates Matrix */
-    const Disposable<Matrix> operator*(Real, const Matrix&);
+    template <class E>
+    const typename detail::MatrixScalarLeft<E,std::multiplies<Real> >::type
+    operator*(Real, const MatrixExpression<E>&);
     /*! \relates Matrix */
-    const Disposable<Matrix> operator/(const Matrix&, Real);
+    template <class E>
+    const typename detail::MatrixScalarRight<E,std::divides<Real> >::type
+    operator/(const MatrixExpression<E>&, Real);
 
 
     // vectorial products
@@ -201,7 +369,9 @@ namespace QuantLib {
     // misc. operations
 
     /*! \relates Matrix */
-    const Disposable<Matrix> transpose(const Matrix&);
+    template <class E>
+    const detail::MatrixTransposeExpression<E>
+    transpose(const MatrixExpression<E>&);
 
     /*! \relates Matrix */
     const Disposable<Matrix> outerProduct(const Array& v1, const Array& v2);
@@ -260,6 +430,41 @@ namespace QuantLib {
         swap(const_cast<Disposable<Matrix>&>(from));
     }
 
+    template <class E>
+    inline Matrix::Matrix(const MatrixExpression<E>& e)
+    : data_(e.self().rows()*e.self().columns() > 0 ?
+            new Real[e.self().rows()*e.self().columns()] : (Real*)(0)),
+      rows_(e.self().rows()), columns_(e.self().columns()) {
+        assign(e.self());
+    }
+
+    template <class E>
+    inline void Matrix::assign(const E& e) {
+        for (Size i=0; i<rows_; ++i) {
+            Real* row = data_.get()+i*columns_;
+            for (Size j=0; j<columns_; ++j)
+                row[j] = e(i,j);
+        }
+    }
+
+    template <class E>
+    inline void Matrix::assign(const detail::MatrixTransposeExpression<E>& e) {
+        // the operand is read by columns, so the copy is done on
+        // blocks small enough for their rows to stay in cache
+        const Size block = 32;
+        for (Size ii=0; ii<rows_; ii+=block) {
+            const Size iEnd = std::min(ii+block, rows_);
+            for (Size jj=0; jj<columns_; jj+=block) {
+                const Size jEnd = std::min(jj+block, columns_);
+                for (Size i=ii; i<iEnd; ++i) {
+                    Real* row = data_.get()+i*columns_;
+                    for (Size j=jj; j<jEnd; ++j)
+                        row[j] = e(i,j);
+                }
+            }
+        }
+    }
+
     inline Matrix& Matrix::operator=(const Matrix& from) {
         // strong guarantee
         Matrix temp(from);
@@ -272,6 +477,21 @@ namespace QuantLib {
         return *this;
     }
 
+    template <class E>
+    inline Matrix& Matrix::operator=(const MatrixExpression<E>& e) {
+        const E& from = e.self();
+        // elements only depend on the corresponding elements of the
+        // operands, unless the latter are transposed
+        if (from.rows() == rows_ && from.columns() == columns_
+            && !from.transposes(this)) {
+            assign(from);
+        } else {
+            Matrix temp(e);
+            swap(temp);
+        }
+        return *this;
+    }
+
     inline void Matrix::swap(Matrix& from) {
         using std::swap;
         data_.swap(from.data_);
@@ -279,25 +499,31 @@ namespace QuantLib {
         swap(columns_,from.columns_);
     }
 
-    inline const Matrix& Matrix::operator+=(const Matrix& m) {
-        QL_REQUIRE(rows_ == m.rows_ && columns_ == m.columns_,
-                   "matrices with different sizes (" <<
-                   m.rows_ << "x" << m.columns_ << ", " <<
-                   rows_ << "x" << columns_ << ") cannot be "
-                   "added");
-        std::transform(begin(),end(),m.begin(),
-                       begin(),std::plus<Real>());
+    template <class E>
+    inline const Matrix& Matrix::operator+=(const MatrixExpression<E>& e) {
+        const E& m = e.self();
+        detail::checkMatrixSizes(*this, m, "added");
+        if (m.transposes(this))
+            return *this += Matrix(m);
+        for (Size i=0; i<rows_; ++i) {
+            Real* row = data_.get()+i*columns_;
+            for (Size j=0; j<columns_; ++j)
+                row[j] += m(i,j);
+        }
         return *this;
     }
 
-    inline const Matrix& Matrix::operator-=(const Matrix& m) {
-        QL_REQUIRE(rows_ == m.rows_ && columns_ == m.columns_,
-                   "matrices with different sizes (" <<
-                   m.rows_ << "x" << m.columns_ << ", " <<
-                   rows_ << "x" << columns_ << ") cannot be "
-                   "subtracted");
-        std::transform(begin(),end(),m.begin(),begin(),
-                       std::minus<Real>());
+    template <class E>
+    inline const Matrix& Matrix::operator-=(const MatrixExpression<E>& e) {
+        const E& m = e.self();
+        detail::checkMatrixSizes(*this, m, "subtracted");
+        if (m.transposes(this))
+            return *this -= Matrix(m);
+        for (Size i=0; i<rows_; ++i) {
+            Real* row = data_.get()+i*columns_;
+            for (Size j=0; j<columns_; ++j)
+                row[j] -= m(i,j);
+        }
         return *this;
     }
 
@@ -510,53 +736,49 @@ namespace QuantLib {
         return rows_ == 0 || columns_ == 0;
     }
 
-    inline const Disposable<Matrix> operator+(const Matrix& m1,
-                                              const Matrix& m2) {
-        QL_REQUIRE(m1.rows() == m2.rows() &&
-                   m1.columns() == m2.columns(),
-                   "matrices with different sizes (" <<
-                   m1.rows() << "x" << m1.columns() << ", " <<
-                   m2.rows() << "x" << m2.columns() << ") cannot be "
-                   "added");
-        Matrix temp(m1.rows(),m1.columns());
-        std::transform(m1.begin(),m1.end(),m2.begin(),temp.begin(),
-                       std::plus<Real>());
-        return temp;
+    template <class E1, class E2>
+    inline const typename detail::MatrixBinary<E1,E2,std::plus<Real> >::type
+    operator+(const MatrixExpression<E1>& m1,
+              const MatrixExpression<E2>& m2) {
+        detail::checkMatrixSizes(m1.self(), m2.self(), "added");
+        return typename detail::MatrixBinary<E1,E2,std::plus<Real> >::type(
+                                   m1.self(), m2.self(), std::plus<Real>());
     }
 
-    inline const Disposable<Matrix> operator-(const Matrix& m1,
-                                              const Matrix& m2) {
-        QL_REQUIRE(m1.rows() == m2.rows() &&
-                   m1.columns() == m2.columns(),
-                   "matrices with different sizes (" <<
-                   m1.rows() << "x" << m1.columns() << ", " <<
-                   m2.rows() << "x" << m2.columns() << ") cannot be "
-                   "subtracted");
-        Matrix temp(m1.rows(),m1.columns());
-        std::transform(m1.begin(),m1.end(),m2.begin(),temp.begin(),
-                       std::minus<Real>());
-        return temp;
+    template <class E1, class E2>
+    inline const typename detail::MatrixBinary<E1,E2,std::minus<Real> >::type
+    operator-(const MatrixExpression<E1>& m1,
+              const MatrixExpression<E2>& m2) {
+        detail::checkMatrixSizes(m1.self(), m2.self(), "subtracted");
+        return typename detail::MatrixBinary<E1,E2,std::minus<Real> >::type(
+                                  m1.self(), m2.self(), std::minus<Real>());
     }
 
-    inline const Disposable<Matrix> operator*(const Matrix& m, Real x) {
-        Matrix temp(m.rows(),m.columns());
-        std::transform(m.begin(),m.end(),temp.begin(),
-                       std::bind2nd(std::multiplies<Real>(),x));
-        return temp;
+    template <class E>
+    inline const
+    typename detail::MatrixScalarRight<E,std::multiplies<Real> >::type
+    operator*(const MatrixExpression<E>& m, Real x) {
+        return typename
+            detail::MatrixScalarRight<E,std::multiplies<Real> >::type(
+                       m.self(), std::bind2nd(std::multiplies<Real>(),x));
     }
 
-    inline const Disposable<Matrix> operator*(Real x, const Matrix& m) {
-        Matrix temp(m.rows(),m.columns());
-        std::transform(m.begin(),m.end(),temp.begin(),
-                       std::bind2nd(std::multiplies<Real>(),x));
-        return temp;
+    template <class E>
+    inline const
+    typename detail::MatrixScalarLeft<E,std::multiplies<Real> >::type
+    operator*(Real x, const MatrixExpression<E>& m) {
+        return typename
+            detail::MatrixScalarLeft<E,std::multiplies<Real> >::type(
+                       m.self(), std::bind1st(std::multiplies<Real>(),x));
     }
 
-    inline const Disposable<Matrix> operator/(const Matrix& m, Real x) {
-        Matrix temp(m.rows(),m.columns());
-        std::transform(m.begin(),m.end(),temp.begin(),
-                       std::bind2nd(std::divides<Real>(),x));
-        return temp;
+    template <class E>
+    inline const
+    typename detail::MatrixScalarRight<E,std::divides<Real> >::type
+    operator/(const MatrixExpression<E>& m, Real x) {
+        return typename
+            detail::MatrixScalarRight<E,std::divides<Real> >::type(
+                          m.self(), std::bind2nd(std::divides<Real>(),x));
     }
 
     inline const Disposable<Array> operator*(const Array& v, const Matrix& m) {
@@ -565,10 +787,8 @@ namespace QuantLib {
                    << v.size() << ", " << m.rows() << "x" << m.columns() <<
                    ") cannot be multiplied");
         Array result(m.columns());
-        for (Size i=0; i<result.size(); i++)
-            result[i] =
-                std::inner_product(v.begin(),v.end(),
-                                   m.column_begin(i),0.0);
+        detail::gemvTransposed(m.rows(), m.columns(), m.begin(), m.columns(),
+                               v.begin(), result.begin());
         return result;
     }
 
@@ -578,9 +798,8 @@ namespace QuantLib {
                    << v.size() << ", " << m.rows() << "x" << m.columns() <<
                    ") cannot be multiplied");
         Array result(m.rows());
-        for (Size i=0; i<result.size(); i++)
-            result[i] =
-                std::inner_product(v.begin(),v.end(),m.row_begin(i),0.0);
+        detail::gemv(m.rows(), m.columns(), m.begin(), m.columns(),
+                     v.begin(), result.begin());
         return result;
     }
 
@@ -592,24 +811,16 @@ namespace QuantLib {
                    m2.rows() << "x" << m2.columns() << ") cannot be "
                    "multiplied");
         Matrix result(m1.rows(),m2.columns(),0.0);
-        for (Size i=0; i<result.rows(); ++i) {
-            for (Size k=0; k<m1.columns(); ++k) {
-                for (Size j=0; j<result.columns(); ++j) {
-                    result[i][j] += m1[i][k]*m2[k][j];
-                }
-            }
-        }
+        detail::gemm(m1.rows(), m2.columns(), m1.columns(), 1.0,
+                     m1.begin(), m1.columns(), m2.begin(), m2.columns(),
+                     result.begin(), result.columns());
         return result;
     }
 
-    inline const Disposable<Matrix> transpose(const Matrix& m) {
-        Matrix result(m.columns(),m.rows());
-        #if defined(QL_PATCH_MSVC) && defined(QL_DEBUG)
-        if (!m.empty())
-        #endif
-        for (Size i=0; i<m.rows(); i++)
-            std::copy(m.row_begin(i),m.row_end(i),result.column_begin(i));
-        return result;
+    template <class E>
+    inline const detail::MatrixTransposeExpression<E>
+    transpose(const MatrixExpression<E>& m) {
+        return detail::MatrixTransposeExpression<E>(m.self());
     }
 
     inline const Disposable<Matrix> outerProduct(const Array& v1,
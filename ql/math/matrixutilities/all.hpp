@@ -1,5 +1,6 @@
 #include <ql/math/matrixutilities/basisincompleteordered.hpp> // causes weird compile error
 #include <ql/math/matrixutilities/bicgstab.hpp>
+#include <ql/math/matrixutilities/blaskernels.hpp>
 #include <ql/math/matrixutilities/choleskydecomposition.hpp>
 #include <ql/math/matrixutilities/factorreduction.hpp>
 #include <ql/math/matrixutilities/getcovariance.hpp>
@@ -0,0 +1,262 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file blaskernels.hpp
+    \brief dense matrix-matrix and matrix-vector product kernels
+*/
+
+#ifndef quantlib_blas_kernels_hpp
+#define quantlib_blas_kernels_hpp
+
+#include <ql/types.hpp>
+#include <algorithm>
+#include <vector>
+
+#if defined(QL_USE_BLAS)
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_same.hpp>
+#endif
+
+#if defined(QL_USE_BLAS)
+/* Fortran BLAS and LAPACK routines, to be provided by the system
+   libraries (e.g., linking with -llapack -lblas or -lopenblas) */
+extern "C" {
+    void dpotrf_(const char* uplo, const int* n, double* a,
+                 const int* lda, int* info);
+    void dgemm_(const char* transa, const char* transb,
+                const int* m, const int* n, const int* k,
+                const double* alpha, const double* a, const int* lda,
+                const double* b, const int* ldb,
+                const double* beta, double* c, const int* ldc);
+    void dgemv_(const char* trans, const int* m, const int* n,
+                const double* alpha, const double* a, const int* lda,
+                const double* x, const int* incx,
+                const double* beta, double* y, const int* incy);
+}
+#endif
+
+namespace QuantLib {
+
+    namespace detail {
+
+        /* The kernels below work on row-major blocks of memory with
+           the given leading dimensions (i.e., the distance between
+           the beginnings of consecutive rows.)
+
+           The matrix product is calculated on panels of the operands
+           small enough to stay in cache.  The panels are copied into
+           contiguous buffers so that the innermost loops work on a
+           4x4 block of the result held in registers, and have fixed
+           bounds and unit strides which the compiler can vectorize.
+           Blocks of rows of the result are calculated in parallel
+           when OpenMP is enabled.
+
+           When QL_USE_BLAS is defined, the kernels forward to the
+           corresponding routines of the system BLAS library; the
+           Cholesky decomposition also uses LAPACK's dpotrf.
+        */
+
+        const Size gemmRowBlock = 64;
+        const Size gemmDepthBlock = 256;
+        const Size gemmColumnBlock = 512;
+
+        // copies a depth x width panel of b into strips of 4 columns,
+        // padded with zeros and multiplied by alpha
+        inline void packGemmColumns(Size depth, Size width, Real alpha,
+                                    const Real* b, Size ldb, Real* buffer) {
+            for (Size j=0; j<width; j+=4) {
+                const Size w = std::min<Size>(4, width-j);
+                Real* strip = buffer + j*depth;
+                for (Size p=0; p<depth; ++p) {
+                    const Real* from = b + p*ldb + j;
+                    for (Size l=0; l<4; ++l)
+                        strip[4*p+l] = l < w ? alpha*from[l] : 0.0;
+                }
+            }
+        }
+
+        // copies a height x depth panel of a into strips of 4 rows,
+        // padded with zeros
+        inline void packGemmRows(Size height, Size depth,
+                                 const Real* a, Size lda, Real* buffer) {
+            for (Size i=0; i<height; i+=4) {
+                const Size h = std::min<Size>(4, height-i);
+                Real* strip = buffer + i*depth;
+                for (Size p=0; p<depth; ++p) {
+                    for (Size l=0; l<4; ++l)
+                        strip[4*p+l] = l < h ? a[(i+l)*lda+p] : 0.0;
+                }
+            }
+        }
+
+        // adds the product of two packed strips to a block of c
+        inline void gemmMicroKernel(Size depth,
+                                    const Real* a, const Real* b,
+                                    Size height, Size width,
+                                    Real* c, Size ldc) {
+            Real sum[16] = { 0.0 };
+            for (Size p=0; p<depth; ++p) {
+                const Real* x = a + 4*p;
+                const Real* y = b + 4*p;
+                for (Size i=0; i<4; ++i)
+                    for (Size j=0; j<4; ++j)
+                        sum[4*i+j] += x[i]*y[j];
+            }
+            for (Size i=0; i<height; ++i)
+                for (Size j=0; j<width; ++j)
+                    c[i*ldc+j] += sum[4*i+j];
+        }
+
+        //! c += alpha a b, with a m x k, b k x n and c m x n
+        inline void gemm(Size m, Size n, Size k, Real alpha,
+                         const Real* a, Size lda,
+                         const Real* b, Size ldb,
+                         Real* c, Size ldc) {
+            if (m == 0 || n == 0 || k == 0)
+                return;
+
+            #if defined(QL_USE_BLAS)
+            BOOST_STATIC_ASSERT((boost::is_same<Real, double>::value));
+            // a row-major matrix is its column-major transpose, so
+            // c' = b' a' is calculated instead
+            const int rows = int(n), columns = int(m), depth = int(k);
+            const int ldA = int(lda), ldB = int(ldb), ldC = int(ldc);
+            const double one = 1.0;
+            dgemm_("N", "N", &rows, &columns, &depth,
+                   &alpha, b, &ldB, a, &ldA, &one, c, &ldC);
+            #else
+            std::vector<Real> packedColumns(
+                gemmDepthBlock*(std::min(n, gemmColumnBlock)+3));
+            for (Size jj=0; jj<n; jj+=gemmColumnBlock) {
+                const Size width = std::min(gemmColumnBlock, n-jj);
+                for (Size pp=0; pp<k; pp+=gemmDepthBlock) {
+                    const Size depth = std::min(gemmDepthBlock, k-pp);
+                    packGemmColumns(depth, width, alpha,
+                                    b + pp*ldb + jj, ldb, &packedColumns[0]);
+                    const Real* columns = &packedColumns[0];
+
+                    const Size blocks = (m+gemmRowBlock-1)/gemmRowBlock;
+                    #pragma omp parallel for if(blocks > 1 && m*width*depth > 1000000)
+                    for (Size block=0; block<blocks; ++block) {
+                        const Size ii = block*gemmRowBlock;
+                        const Size height = std::min(gemmRowBlock, m-ii);
+                        std::vector<Real> packedRows(depth*(height+3));
+                        packGemmRows(height, depth,
+                                     a + ii*lda + pp, lda, &packedRows[0]);
+                        for (Size i=0; i<height; i+=4) {
+                            const Real* rows = &packedRows[i*depth];
+                            for (Size j=0; j<width; j+=4) {
+                                gemmMicroKernel(
+                                    depth, rows, columns + j*depth,
+                                    std::min<Size>(4, height-i),
+                                    std::min<Size>(4, width-j),
+                                    c + (ii+i)*ldc + jj + j, ldc);
+                            }
+                        }
+                    }
+                }
+            }
+            #endif
+        }
+
+        //! y = a x, with a m x n
+        inline void gemv(Size m, Size n, const Real* a, Size lda,
+                         const Real* x, Real* y) {
+            if (m == 0)
+                return;
+            #if defined(QL_USE_BLAS)
+            BOOST_STATIC_ASSERT((boost::is_same<Real, double>::value));
+            if (n == 0) {
+                std::fill(y, y+m, 0.0);
+                return;
+            }
+            const int rows = int(n), columns = int(m), ldA = int(lda);
+            const int inc = 1;
+            const double one = 1.0, zero = 0.0;
+            dgemv_("T", &rows, &columns, &one, a, &ldA, x, &inc,
+                   &zero, y, &inc);
+            #else
+            // four rows at a time, so that x is read once for each
+            Size i = 0;
+            for (; i+4<=m; i+=4) {
+                const Real* a0 = a + i*lda;
+                const Real* a1 = a0 + lda;
+                const Real* a2 = a1 + lda;
+                const Real* a3 = a2 + lda;
+                Real y0 = 0.0, y1 = 0.0, y2 = 0.0, y3 = 0.0;
+                for (Size j=0; j<n; ++j) {
+                    y0 += a0[j]*x[j];
+                    y1 += a1[j]*x[j];
+                    y2 += a2[j]*x[j];
+                    y3 += a3[j]*x[j];
+                }
+                y[i] = y0; y[i+1] = y1; y[i+2] = y2; y[i+3] = y3;
+            }
+            for (; i<m; ++i) {
+                const Real* ai = a + i*lda;
+                Real yi = 0.0;
+                for (Size j=0; j<n; ++j)
+                    yi += ai[j]*x[j];
+                y[i] = yi;
+            }
+            #endif
+        }
+
+        //! y = x a, with a m x n
+        inline void gemvTransposed(Size m, Size n, const Real* a, Size lda,
+                                   const Real* x, Real* y) {
+            if (n == 0)
+                return;
+            #if defined(QL_USE_BLAS)
+            BOOST_STATIC_ASSERT((boost::is_same<Real, double>::value));
+            if (m == 0) {
+                std::fill(y, y+n, 0.0);
+                return;
+            }
+            const int rows = int(n), columns = int(m), ldA = int(lda);
+            const int inc = 1;
+            const double one = 1.0, zero = 0.0;
+            dgemv_("N", &rows, &columns, &one, a, &ldA, x, &inc,
+                   &zero, y, &inc);
+            #else
+            // rows are added to y instead of walking down the columns
+            std::fill(y, y+n, 0.0);
+            Size i = 0;
+            for (; i+4<=m; i+=4) {
+                const Real* a0 = a + i*lda;
+                const Real* a1 = a0 + lda;
+                const Real* a2 = a1 + lda;
+                const Real* a3 = a2 + lda;
+                const Real x0 = x[i], x1 = x[i+1], x2 = x[i+2], x3 = x[i+3];
+                for (Size j=0; j<n; ++j)
+                    y[j] += x0*a0[j] + x1*a1[j] + x2*a2[j] + x3*a3[j];
+            }
+            for (; i<m; ++i) {
+                const Real* ai = a + i*lda;
+                const Real xi = x[i];
+                for (Size j=0; j<n; ++j)
+                    y[j] += xi*ai[j];
+            }
+            #endif
+        }
+
+    }
+
+}
+
+
+#endif
@@ -29,10 +29,81 @@
 
 namespace QuantLib {
 
-    /*! \relates Matrix */
+    /*! The decomposition is calculated on blocks of columns, and the
+        remaining part of the matrix is updated with a matrix product
+        after each block.  When QL_USE_BLAS is defined, LAPACK's
+        dpotrf is used instead; if it fails and \c flexible is
+        \c true, the calculation falls back to the blocked algorithm
+        so that semi-definite matrices are still handled.
+
+        \relates Matrix
+    */
     const Disposable<Matrix> CholeskyDecomposition(const Matrix& m,
                                                    bool flexible = false);
 
+    namespace detail {
+
+        const Size choleskyBlock = 64;
+
+        /* decomposes the columns [begin, end) of the lower triangle
+           of l, whose contributions from the previous columns were
+           already subtracted. */
+        inline void choleskyPanel(Matrix& l, Size begin, Size end,
+                                  bool flexible) {
+            const Size size = l.rows();
+            for (Size i=begin; i<end; ++i) {
+                const Real* li = l[i];
+                Real sum = li[i];
+                for (Size k=begin; k<i; ++k)
+                    sum -= li[k]*li[k];
+                QL_REQUIRE(flexible || sum > 0.0,
+                           "input matrix is not positive definite");
+                // To handle positive semi-definite matrices take the
+                // square root of sum if positive, else zero.
+                const Real diagonal = std::sqrt(std::max<Real>(sum, 0.0));
+                l[i][i] = diagonal;
+                for (Size j=i+1; j<size; ++j) {
+                    Real* lj = l[j];
+                    sum = lj[i];
+                    for (Size k=begin; k<i; ++k)
+                        sum -= lj[k]*li[k];
+                    // With positive semi-definite matrices is possible
+                    // to have result[i][i]==0.0
+                    // In this case sum happens to be zero as well
+                    lj[i] = close_enough(diagonal, 0.0) ? 0.0
+                                                        : sum / diagonal;
+                }
+            }
+        }
+
+        inline void blockedCholesky(Matrix& l, bool flexible) {
+            const Size size = l.rows();
+            std::vector<Real> panel;
+            for (Size begin=0; begin<size; begin+=choleskyBlock) {
+                const Size end = std::min(begin+choleskyBlock, size);
+                choleskyPanel(l, begin, end, flexible);
+
+                // subtract the contributions of the panel from the
+                // lower triangle of the remaining matrix
+                const Size width = end-begin, rest = size-end;
+                if (rest == 0)
+                    break;
+                panel.resize(width*rest);
+                for (Size j=0; j<rest; ++j)
+                    for (Size k=0; k<width; ++k)
+                        panel[k*rest+j] = l[end+j][begin+k];
+                for (Size i=0; i<rest; i+=choleskyBlock) {
+                    const Size rows = std::min(choleskyBlock, rest-i);
+                    gemm(rows, i+rows, width, -1.0,
+                         l[end+i]+begin, size,
+                         &panel[0], rest,
+                         l[end+i]+end, size);
+                }
+            }
+        }
+
+    }
+
     // implementation
 
     inline const Disposable<Matrix> CholeskyDecomposition(const Matrix &S,
@@ -48,30 +119,34 @@ namespace QuantLib {
                            "input matrix is not symmetric");
         #endif
 
-        Matrix result(size, size, 0.0);
-        Real sum;
-        for (i=0; i<size; i++) {
-            for (j=i; j<size; j++) {
-                sum = S[i][j];
-                for (Integer k=0; k<=Integer(i)-1; k++) {
-                    sum -= result[i][k]*result[j][k];
-                }
-                if (i == j) {
-                    QL_REQUIRE(flexible || sum > 0.0,
-                               "input matrix is not positive definite");
-                    // To handle positive semi-definite matrices take the
-                    // square root of sum if positive, else zero.
-                    result[i][i] = std::sqrt(std::max<Real>(sum, 0.0));
-                } else {
-                    // With positive semi-definite matrices is possible
-                    // to have result[i][i]==0.0
-                    // In this case sum happens to be zero as well
-                    result[j][i] = close_enough(result[i][i], 0.0)
-                                       ? 0.0
-                                       : sum / result[i][i];
-                }
-            }
+        // the algorithm reads the upper triangle of the input
+        Matrix result(S);
+        for (i=0; i<size; i++)
+            for (j=i+1; j<size; j++)
+                result[j][i] = S[i][j];
+
+        #if defined(QL_USE_BLAS)
+        if (size > 0) {
+            // a row-major lower triangle is a column-major upper one
+            Matrix lower(result);
+            const int n = int(size);
+            int info = 0;
+            dpotrf_("U", &n, lower.begin(), &n, &info);
+            QL_REQUIRE(info >= 0, "dpotrf failed (info = " << info << ")");
+            QL_REQUIRE(flexible || info == 0,
+                       "input matrix is not positive definite");
+            if (info == 0)
+                result.swap(lower);
+            else
+                detail::blockedCholesky(result, flexible);
         }
+        #else
+        detail::blockedCholesky(result, flexible);
+        #endif
+
+        for (i=0; i<size; i++)
+            for (j=i+1; j<size; j++)
+                result[i][j] = 0.0;
         return result;
     }
 
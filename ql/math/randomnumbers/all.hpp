@@ -1,5 +1,6 @@
 #include <ql/math/randomnumbers/boxmullergaussianrng.hpp>
 #include <ql/math/randomnumbers/centrallimitgaussianrng.hpp>
+#include <ql/math/randomnumbers/counterbaseduniformrng.hpp>
 #include <ql/math/randomnumbers/faurersg.hpp>
 #include <ql/math/randomnumbers/haltonrsg.hpp>
 #include <ql/math/randomnumbers/inversecumulativerng.hpp>
@@ -11,6 +12,7 @@
 #include <ql/math/randomnumbers/mt19937uniformrng.hpp>
 #include <ql/math/randomnumbers/primitivepolynomials.hpp>
 #include <ql/math/randomnumbers/randomizedlds.hpp>
+#include <ql/math/randomnumbers/randomizedrngtraits.hpp>
 #include <ql/math/randomnumbers/randomsequencegenerator.hpp>
 #include <ql/math/randomnumbers/ranluxuniformrng.hpp>
 #include <ql/math/randomnumbers/rngtraits.hpp>
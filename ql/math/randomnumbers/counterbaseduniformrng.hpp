@@ -0,0 +1,282 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file counterbaseduniformrng.hpp
+    \brief Counter-based (Philox and Threefry) uniform random number generators
+*/
+
+#ifndef quantlib_counter_based_uniform_rng_hpp
+#define quantlib_counter_based_uniform_rng_hpp
+
+#include <ql/methods/montecarlo/sample.hpp>
+#include <ql/math/randomnumbers/seedgenerator.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+
+namespace QuantLib {
+
+    namespace detail {
+
+        /* The bijections below scramble n 128-bit counters, stored as
+           four arrays of 32-bit words, in place.  The loops run over
+           the counters within each round so that they can be
+           vectorized by the compiler.
+        */
+
+        //! Philox4x32 bijection with 10 rounds
+        struct Philox4x32 {
+            static void apply(Size n,
+                              boost::uint32_t* x0, boost::uint32_t* x1,
+                              boost::uint32_t* x2, boost::uint32_t* x3,
+                              const boost::uint32_t* key) {
+                const boost::uint64_t m0 = 0xD2511F53UL, m1 = 0xCD9E8D57UL;
+                boost::uint32_t k0 = key[0], k1 = key[1];
+                for (Size r=0; r<10; ++r) {
+                    for (Size i=0; i<n; ++i) {
+                        const boost::uint64_t p0 = m0*x0[i], p1 = m1*x2[i];
+                        const boost::uint32_t y0 =
+                            boost::uint32_t(p1 >> 32) ^ x1[i] ^ k0;
+                        const boost::uint32_t y2 =
+                            boost::uint32_t(p0 >> 32) ^ x3[i] ^ k1;
+                        x1[i] = boost::uint32_t(p1);
+                        x3[i] = boost::uint32_t(p0);
+                        x0[i] = y0;
+                        x2[i] = y2;
+                    }
+                    k0 += 0x9E3779B9UL;
+                    k1 += 0xBB67AE85UL;
+                }
+            }
+        };
+
+        //! Threefry4x32 bijection with 20 rounds
+        struct Threefry4x32 {
+            static void apply(Size n,
+                              boost::uint32_t* x0, boost::uint32_t* x1,
+                              boost::uint32_t* x2, boost::uint32_t* x3,
+                              const boost::uint32_t* key) {
+                static const unsigned int rotations[8][2] = {
+                    { 10, 26 }, { 11, 21 }, { 13, 27 }, { 23, 5 },
+                    {  6, 20 }, { 17, 11 }, { 25, 10 }, { 18, 20 }
+                };
+                boost::uint32_t ks[5];
+                ks[4] = 0x1BD11BDAUL;
+                for (Size j=0; j<4; ++j) {
+                    ks[j] = key[j];
+                    ks[4] ^= key[j];
+                }
+                for (Size i=0; i<n; ++i) {
+                    x0[i] += ks[0]; x1[i] += ks[1];
+                    x2[i] += ks[2]; x3[i] += ks[3];
+                }
+                for (Size r=0; r<20; ++r) {
+                    const unsigned int a = rotations[r%8][0],
+                                       b = rotations[r%8][1];
+                    if (r%2 == 0) {
+                        for (Size i=0; i<n; ++i) {
+                            x0[i] += x1[i];
+                            x1[i] = ((x1[i] << a) | (x1[i] >> (32-a))) ^ x0[i];
+                            x2[i] += x3[i];
+                            x3[i] = ((x3[i] << b) | (x3[i] >> (32-b))) ^ x2[i];
+                        }
+                    } else {
+                        for (Size i=0; i<n; ++i) {
+                            x0[i] += x3[i];
+                            x3[i] = ((x3[i] << a) | (x3[i] >> (32-a))) ^ x0[i];
+                            x2[i] += x1[i];
+                            x1[i] = ((x1[i] << b) | (x1[i] >> (32-b))) ^ x2[i];
+                        }
+                    }
+                    if (r%4 == 3) {
+                        const Size s = (r+1)/4;
+                        for (Size i=0; i<n; ++i) {
+                            x0[i] += ks[s%5];
+                            x1[i] += ks[(s+1)%5];
+                            x2[i] += ks[(s+2)%5];
+                            x3[i] += ks[(s+3)%5] + boost::uint32_t(s);
+                        }
+                    }
+                }
+            }
+        };
+
+    }
+
+    //! Counter-based uniform random number generator
+    /*! The i-th number of a stream is obtained by scrambling a
+        counter made of the stream number and of i/4 with a keyed
+        bijection, which yields four 32-bit numbers at a time; the
+        key is given by the seed.  Unlike sequential generators,
+        any position of any stream can therefore be reached in
+        constant time; parallel workers can be given different
+        streams, or different ranges of the same stream, and obtain
+        the same numbers regardless of scheduling.
+
+        For more details see J.K. Salmon, M.A. Moraes, R.O. Dror and
+        D.E. Shaw, "Parallel random numbers: as easy as 1, 2, 3",
+        Proceedings of SC11, 2011.
+
+        \test the correctness of the returned values is tested by
+              checking them against known good results, and the
+              consistency of jumps and bulk generation with the
+              sequential draws is checked.
+    */
+    template <class Bijection>
+    class CounterBasedUniformRng {
+      public:
+        typedef Sample<Real> sample_type;
+        /*! if the given seed is 0, a random seed will be chosen
+            by the SeedGenerator */
+        explicit CounterBasedUniformRng(BigNatural seed = 0,
+                                        BigNatural stream = 0);
+        /*! returns a sample with weight 1.0 containing a random number
+            in the (0.0, 1.0) interval  */
+        sample_type next() const { return sample_type(nextReal(),1.0); }
+        //! return a random number in the (0.0, 1.0)-interval
+        Real nextReal() const { return toReal(nextInt32()); }
+        //! return a random integer in the [0,0xffffffff]-interval
+        unsigned long nextInt32() const {
+            if (position_ == 4)
+                generate();
+            return buffer_[position_++];
+        }
+        /*! fills the range [begin, begin+n) with the next n numbers
+            in the (0.0, 1.0) interval; the result is the same as
+            calling nextReal() n times. */
+        void fill(Real* begin, Size n) const;
+        //! moves to the given position of the given stream
+        void jump(BigNatural stream, BigNatural index);
+        //! skips the next n numbers of the current stream
+        void discard(BigNatural n);
+        //! \name Inspectors
+        //@{
+        BigNatural stream() const { return stream_; }
+        //! position in the stream of the next number
+        BigNatural index() const {
+            return BigNatural(4*block_ - (4 - position_));
+        }
+        //@}
+      private:
+        static Real toReal(boost::uint32_t x) {
+            return (Real(x) + 0.5)/4294967296.0;
+        }
+        void generate() const;
+        boost::uint32_t key_[4];
+        BigNatural stream_;
+        boost::uint32_t streamWords_[2];
+        // the buffer contains the numbers from the block before block_
+        mutable boost::uint64_t block_;
+        mutable boost::uint32_t buffer_[4];
+        mutable Size position_;
+    };
+
+    //! Philox4x32-10 uniform random number generator
+    typedef CounterBasedUniformRng<detail::Philox4x32> PhiloxUniformRng;
+
+    //! Threefry4x32-20 uniform random number generator
+    typedef CounterBasedUniformRng<detail::Threefry4x32> ThreefryUniformRng;
+
+
+    // inline definitions
+
+    template <class B>
+    inline CounterBasedUniformRng<B>::CounterBasedUniformRng(
+                                         BigNatural seed, BigNatural stream) {
+        const boost::uint64_t s =
+            (seed != 0 ? seed : SeedGenerator::instance().get());
+        key_[0] = boost::uint32_t(s);
+        key_[1] = boost::uint32_t(s >> 32);
+        key_[2] = key_[3] = 0;
+        jump(stream, 0);
+    }
+
+    template <class B>
+    inline void CounterBasedUniformRng<B>::jump(BigNatural stream,
+                                                BigNatural index) {
+        stream_ = stream;
+        streamWords_[0] = boost::uint32_t(boost::uint64_t(stream));
+        streamWords_[1] = boost::uint32_t(boost::uint64_t(stream) >> 32);
+        block_ = boost::uint64_t(index)/4;
+        position_ = 4;
+        if (index % 4 != 0) {
+            generate();
+            position_ = Size(index % 4);
+        }
+    }
+
+    template <class B>
+    inline void CounterBasedUniformRng<B>::discard(BigNatural n) {
+        jump(stream_, index() + n);
+    }
+
+    template <class B>
+    inline void CounterBasedUniformRng<B>::generate() const {
+        boost::uint32_t x0 = boost::uint32_t(block_),
+                        x1 = boost::uint32_t(block_ >> 32),
+                        x2 = streamWords_[0],
+                        x3 = streamWords_[1];
+        B::apply(1, &x0, &x1, &x2, &x3, key_);
+        buffer_[0] = x0;
+        buffer_[1] = x1;
+        buffer_[2] = x2;
+        buffer_[3] = x3;
+        ++block_;
+        position_ = 0;
+    }
+
+    template <class B>
+    inline void CounterBasedUniformRng<B>::fill(Real* begin, Size n) const {
+        Size i = 0;
+        // first, what is left of the current block...
+        while (i < n && position_ < 4)
+            begin[i++] = toReal(buffer_[position_++]);
+
+        // ...then whole blocks, scrambled together...
+        const Size batch = 64;
+        boost::uint32_t x[4][batch];
+        while (n-i >= 4) {
+            const Size blocks = std::min(batch, (n-i)/4);
+            for (Size b=0; b<blocks; ++b) {
+                x[0][b] = boost::uint32_t(block_+b);
+                x[1][b] = boost::uint32_t((block_+b) >> 32);
+                x[2][b] = streamWords_[0];
+                x[3][b] = streamWords_[1];
+            }
+            B::apply(blocks, x[0], x[1], x[2], x[3], key_);
+            for (Size b=0; b<blocks; ++b) {
+                Real* out = begin + i + 4*b;
+                out[0] = toReal(x[0][b]);
+                out[1] = toReal(x[1][b]);
+                out[2] = toReal(x[2][b]);
+                out[3] = toReal(x[3][b]);
+            }
+            block_ += blocks;
+            i += 4*blocks;
+        }
+
+        // ...and the beginning of a new one
+        if (i < n) {
+            generate();
+            while (i < n)
+                begin[i++] = toReal(buffer_[position_++]);
+        }
+    }
+
+}
+
+
+#endif
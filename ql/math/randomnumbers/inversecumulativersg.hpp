@@ -26,6 +26,7 @@
 #define quantlib_inversecumulative_rsg_h
 
 #include <ql/methods/montecarlo/sample.hpp>
+#include <ql/math/distributions/normaldistribution.hpp>
 #include <vector>
 
 namespace QuantLib {
@@ -51,6 +52,9 @@ namespace QuantLib {
             IC::IC();
             Real IC::operator() const;
         \endcode
+
+        When IC is InverseCumulativeNormal, its transform() method is
+        used to convert each sequence as a whole.
     */
     template <class USG, class IC>
     class InverseCumulativeRsg {
@@ -70,6 +74,26 @@ namespace QuantLib {
         IC ICD_;
     };
 
+    namespace detail {
+
+        template <class IC>
+        inline void inverseCumulativeTransform(const IC& ic,
+                                               const Real* begin,
+                                               const Real* end,
+                                               Real* out) {
+            for (; begin != end; ++begin, ++out)
+                *out = ic(*begin);
+        }
+
+        inline void inverseCumulativeTransform(
+                                       const InverseCumulativeNormal& ic,
+                                       const Real* begin, const Real* end,
+                                       Real* out) {
+            ic.transform(begin, end, out);
+        }
+
+    }
+
     template <class USG, class IC>
     InverseCumulativeRsg<USG, IC>::InverseCumulativeRsg(const USG& usg)
     : uniformSequenceGenerator_(usg),
@@ -87,12 +111,13 @@ namespace QuantLib {
     template <class USG, class IC>
     inline const typename InverseCumulativeRsg<USG, IC>::sample_type&
     InverseCumulativeRsg<USG, IC>::nextSequence() const {
-        typename USG::sample_type sample =
+        const typename USG::sample_type& sample =
             uniformSequenceGenerator_.nextSequence();
         x_.weight = sample.weight;
-        for (Size i = 0; i < dimension_; i++) {
-            x_.value[i] = ICD_(sample.value[i]);
-        }
+        if (dimension_ > 0)
+            detail::inverseCumulativeTransform(ICD_, &sample.value[0],
+                                               &sample.value[0]+dimension_,
+                                               &x_.value[0]);
         return x_;
     }
 
@@ -25,18 +25,30 @@
 #define quantlib_lattice_rsg_hpp
 
 #include <ql/methods/montecarlo/sample.hpp>
+#include <ql/errors.hpp>
 #include <vector>
 
 namespace QuantLib {
 
    
+    //! Rank-1 lattice rule generator
+    /*! The i-th point is \f$ \{ i z / N \} \f$.  When the points are
+        required in radical-inverse order, the i-th point is instead
+        \f$ \{ \phi_2(i) z \} \f$, where \f$ \phi_2 \f$ reverses the
+        binary digits of \f$ i \f$; for embedded rules such as those
+        given by LatticeRule, the first \f$ 2^k \f$ points are then the
+        rule with \f$ 2^k \f$ points, so that the sequence can be
+        stopped at any power of two.  N must be a power of two in
+        this case.
+    */
     class LatticeRsg 
     {
       public:
         typedef Sample<std::vector<Real> > sample_type;
          LatticeRsg(Size dimensionality,
              const std::vector<Real>& z,
-             Size N);
+             Size N,
+             bool radicalInverseOrder = false);
         /*! skip to the n-th sample in the low-discrepancy sequence */
         void skipTo(unsigned long n);
         const LatticeRsg::sample_type& nextSequence();     
@@ -48,6 +60,8 @@ namespace QuantLib {
         Size N_;
         Size i_;
         std::vector<Real> z_;
+        bool radicalInverseOrder_;
+        Size bits_;
         
         sample_type sequence_;
     };
@@ -82,14 +96,27 @@ namespace QuantLib
 
     inline LatticeRsg::LatticeRsg(Size dimensionality,
         const std::vector<Real>& z,
-        Size N)             
+        Size N,
+        bool radicalInverseOrder)
         :
     dimensionality_(dimensionality),
         N_(N),
         i_(0),
         z_(z),
+        radicalInverseOrder_(radicalInverseOrder),
+        bits_(0),
         sequence_(std::vector<Real> (dimensionality), 1.0)
     {
+        QL_REQUIRE(z_.size() >= dimensionality_,
+                   "generating vector of size " << z_.size()
+                   << " too short for dimension " << dimensionality_);
+        if (radicalInverseOrder_) {
+            QL_REQUIRE(N_ > 0 && (N_ & (N_-1)) == 0,
+                       "number of points (" << N_
+                       << ") must be a power of two");
+            while ((Size(1) << bits_) < N_)
+                ++bits_;
+        }
     }
     /*! skip to the n-th sample in the low-discrepancy sequence */
     inline void LatticeRsg::skipTo(unsigned long n)
@@ -99,9 +126,16 @@ namespace QuantLib
 
     inline const LatticeRsg::sample_type& LatticeRsg::nextSequence()
     {
+        Size k = i_;
+        if (radicalInverseOrder_) {
+            QL_REQUIRE(i_ < N_, "all " << N_ << " lattice points used");
+            k = 0;
+            for (Size b=0; b<bits_; ++b)
+                k |= ((i_ >> b) & 1) << (bits_-1-b);
+        }
         for (Size j=0; j < dimensionality_; ++j)
         {
-            Real theta = i_*z_[j]/N_;
+            Real theta = k*z_[j]/N_;
             sequence_.value[j]= std::fmod(theta,1.0);
         }
         ++i_;
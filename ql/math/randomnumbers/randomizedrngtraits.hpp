@@ -0,0 +1,138 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file randomizedrngtraits.hpp
+    \brief random-number generation policies for randomized quasi-Monte Carlo
+*/
+
+#ifndef quantlib_randomized_rng_traits_hpp
+#define quantlib_randomized_rng_traits_hpp
+
+#include <ql/math/randomnumbers/rngtraits.hpp>
+#include <ql/math/randomnumbers/randomizedlds.hpp>
+#include <ql/math/randomnumbers/haltonrsg.hpp>
+#include <ql/math/randomnumbers/faurersg.hpp>
+#include <ql/math/randomnumbers/latticersg.hpp>
+#include <ql/math/randomnumbers/latticerules.hpp>
+
+namespace QuantLib {
+
+    namespace detail {
+
+        // builds the deterministic version of the sequence; the
+        // randomization is added by RandomizedLDS
+        template <class URSG>
+        struct LowDiscrepancyFactory {
+            static URSG create(Size dimension) {
+                return URSG(dimension);
+            }
+        };
+
+        template <>
+        struct LowDiscrepancyFactory<HaltonRsg> {
+            static HaltonRsg create(Size dimension) {
+                return HaltonRsg(dimension, 0, false, false);
+            }
+        };
+
+        template <>
+        struct LowDiscrepancyFactory<LatticeRsg> {
+            static LatticeRsg create(Size dimension) {
+                // the rules are embedded, so that any power of two
+                // up to the maximum number of points can be used
+                const Size points = 1 << 20;
+                std::vector<Real> z;
+                LatticeRule::getRule(LatticeRule::A, z, points);
+                QL_REQUIRE(dimension <= z.size(),
+                           "lattice rule not available in dimension "
+                           << dimension << " (max " << z.size() << ")");
+                return LatticeRsg(dimension, z, points, true);
+            }
+        };
+
+    }
+
+
+    //! traits for randomized quasi-Monte Carlo
+    /*! Each generator returned by the factory draws the points of
+        the low-discrepancy sequence URSG shifted, modulo 1, by a
+        uniform random vector drawn from the given seed.  Generators
+        built with different seeds are thus independent
+        randomizations of the same sequence, each one giving an
+        unbiased estimate.
+
+        The samples drawn from a single generator are not
+        independent, so that the usual error estimate does not
+        apply; instead, McSimulation runs each randomization on its
+        own worker (and thread, if OpenMP is enabled) and estimates
+        the error from the spread of the worker means.  At least two
+        workers are therefore required.
+
+        Lattice rules are used in radical-inverse order, so that any
+        power of two up to \f$ 2^{20} \f$ points can be drawn by each
+        worker; Sobol and Faure sequences are also best used with
+        powers of two (or of the base of the Faure sequence).
+    */
+    template <class URSG, class IC>
+    struct GenericRandomizedLowDiscrepancy {
+        // typedefs
+        typedef RandomizedLDS<URSG> ursg_type;
+        typedef InverseCumulativeRsg<ursg_type,IC> rsg_type;
+        // more traits
+        enum { allowsErrorEstimate = 1 };
+        enum { workerErrorEstimate = 1 };
+        // factory
+        static rsg_type make_sequence_generator(Size dimension,
+                                                BigNatural seed) {
+            ursg_type g(detail::LowDiscrepancyFactory<URSG>::create(dimension),
+                        RandomSequenceGenerator<MersenneTwisterUniformRng>(
+                                                          dimension, seed));
+            return (icInstance ? rsg_type(g, *icInstance) : rsg_type(g));
+        }
+        // data
+        static boost::shared_ptr<IC> icInstance;
+    };
+
+    // static member initialization
+    template<class URSG, class IC>
+    boost::shared_ptr<IC> GenericRandomizedLowDiscrepancy<URSG, IC>::icInstance;
+
+
+    //! traits for randomized quasi-Monte Carlo with Sobol sequences
+    typedef GenericRandomizedLowDiscrepancy<SobolRsg,
+                                            InverseCumulativeNormal>
+                                                    RandomizedLowDiscrepancy;
+
+    //! traits for randomized quasi-Monte Carlo with Halton sequences
+    typedef GenericRandomizedLowDiscrepancy<HaltonRsg,
+                                            InverseCumulativeNormal>
+                                                    RandomizedHalton;
+
+    //! traits for randomized quasi-Monte Carlo with Faure sequences
+    typedef GenericRandomizedLowDiscrepancy<FaureRsg,
+                                            InverseCumulativeNormal>
+                                                    RandomizedFaure;
+
+    //! traits for randomized quasi-Monte Carlo with lattice rules
+    typedef GenericRandomizedLowDiscrepancy<LatticeRsg,
+                                            InverseCumulativeNormal>
+                                                    RandomizedLattice;
+
+}
+
+
+#endif
@@ -28,6 +28,7 @@
 
 #include <ql/methods/montecarlo/pathgenerator.hpp>
 #include <ql/math/randomnumbers/mt19937uniformrng.hpp>
+#include <ql/math/randomnumbers/counterbaseduniformrng.hpp>
 #include <ql/math/randomnumbers/inversecumulativerng.hpp>
 #include <ql/math/randomnumbers/randomsequencegenerator.hpp>
 #include <ql/math/randomnumbers/sobolrsg.hpp>
@@ -48,12 +49,25 @@ namespace QuantLib {
         typedef InverseCumulativeRsg<ursg_type,IC> rsg_type;
         // more traits
         enum { allowsErrorEstimate = 1 };
+        enum { workerErrorEstimate = 0 };
         // factory
         static rsg_type make_sequence_generator(Size dimension,
                                                 BigNatural seed) {
             ursg_type g(dimension, seed);
             return (icInstance ? rsg_type(g, *icInstance) : rsg_type(g));
         }
+        /*! available for generators with independent streams, such
+            as PhiloxUniformRng; the sequences start at the given
+            position of the given stream. */
+        static rsg_type make_sequence_generator(Size dimension,
+                                                BigNatural seed,
+                                                BigNatural stream,
+                                                BigNatural index = 0) {
+            urng_type rng(seed, stream);
+            rng.discard(index);
+            ursg_type g(dimension, rng);
+            return (icInstance ? rsg_type(g, *icInstance) : rsg_type(g));
+        }
         // data
         static boost::shared_ptr<IC> icInstance;
     };
@@ -77,6 +91,16 @@ namespace QuantLib {
     typedef GenericPseudoRandom<MersenneTwisterUniformRng,
                                 InverseCumulativePoisson> PoissonPseudoRandom;
 
+    //! traits for counter-based pseudo-random number generation
+    /*! Parallel workers can obtain independent and reproducible
+        sequences by passing different streams to the factory.
+
+        \test a sequence generator is generated and tested by comparing
+              samples against the underlying generator.
+    */
+    typedef GenericPseudoRandom<PhiloxUniformRng,
+                                InverseCumulativeNormal> PhiloxPseudoRandom;
+
 
     template <class URSG, class IC>
     struct GenericLowDiscrepancy {
@@ -85,6 +109,7 @@ namespace QuantLib {
         typedef InverseCumulativeRsg<ursg_type,IC> rsg_type;
         // more traits
         enum { allowsErrorEstimate = 0 };
+        enum { workerErrorEstimate = 0 };
         // factory
         static rsg_type make_sequence_generator(Size dimension,
                                                 BigNatural seed) {
@@ -104,6 +129,41 @@ namespace QuantLib {
     typedef GenericLowDiscrepancy<SobolRsg,
                                   InverseCumulativeNormal> LowDiscrepancy;
 
+
+    namespace detail {
+
+        template <int> struct WorkerErrorEstimateTag {};
+
+        template <class RNG>
+        class HasWorkerErrorEstimate {
+            typedef char yes;
+            typedef char (&no)[2];
+            template <class T>
+            static yes test(
+                      WorkerErrorEstimateTag<T::workerErrorEstimate>*);
+            template <class T>
+            static no test(...);
+          public:
+            enum { value = (sizeof(test<RNG>(0)) == sizeof(yes)) };
+        };
+
+    }
+
+    //! whether the error is estimated from the means of the workers
+    /*! This is the workerErrorEstimate trait of the given traits
+        class, or false for traits not defining it.
+    */
+    template <class RNG,
+              bool = detail::HasWorkerErrorEstimate<RNG>::value>
+    struct WorkerErrorEstimate {
+        enum { value = 0 };
+    };
+
+    template <class RNG>
+    struct WorkerErrorEstimate<RNG, true> {
+        enum { value = RNG::workerErrorEstimate };
+    };
+
 }
 
 
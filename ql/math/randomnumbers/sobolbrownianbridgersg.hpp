@@ -33,12 +33,15 @@ namespace QuantLib {
       public:
         typedef Sample<std::vector<Real> > sample_type;
 
+        /*! the Joe-Kuo D7 direction integers are not included in
+            this distribution, hence the D6 ones are the default.
+        */
         SobolBrownianBridgeRsg(Size factors, Size steps,
                                SobolBrownianGenerator::Ordering ordering
                                    = SobolBrownianGenerator::Diagonal,
                                unsigned long seed = 0,
                                SobolRsg::DirectionIntegers directionIntegers
-                                   = SobolRsg::JoeKuoD7);
+                                   = SobolRsg::JoeKuoD6);
 
         const sample_type& nextSequence() const;
         const sample_type& lastSequence() const;
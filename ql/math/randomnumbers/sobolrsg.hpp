@@ -0,0 +1,571 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2003, 2004 Ferdinando Ametrano
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file sobolrsg.hpp
+    \brief Sobol low-discrepancy sequence generator
+*/
+
+#ifndef quantlib_sobol_ld_rsg_hpp
+#define quantlib_sobol_ld_rsg_hpp
+
+#include <ql/methods/montecarlo/sample.hpp>
+#include <vector>
+
+namespace QuantLib {
+
+    //! Sobol low-discrepancy sequence generator
+    /*! A Gray code counter and bitwise operations are used for very
+        fast sequence generation: each new point costs one XOR per
+        dimension, and skipTo() positions the generator anywhere in
+        the sequence in O(log n) operations, so that parallel workers
+        can draw disjoint blocks of the same sequence.
+
+        The implementation relies on primitive polynomials modulo two
+        from the book "Monte Carlo Methods in Finance" by Peter
+        Jäckel.
+
+        21 200 primitive polynomials modulo two are provided by
+        default in QuantLib. Jäckel has calculated 8 129 334
+        polynomials: if you need that many dimensions you can replace
+        the primitivepolynomials.hpp file included in QuantLib with
+        the one provided in the CD of the "Monte Carlo Methods in
+        Finance" book.
+
+        The choice of initialization numbers (also know as free
+        direction integers) is crucial for the homogeneity properties
+        of the sequence. Sobol defines two homogeneity properties:
+        Property A and Property A'.
+
+        The unit initialization numbers suggested in "Numerical
+        Recipes in C", 2nd edition, by Press, Teukolsky, Vetterling,
+        and Flannery (section 7.7) fail the test for Property A even
+        for low dimensions.
+
+        Bratley and Fox published coefficients of the free direction
+        integers up to dimension 40, crediting unpublished work of
+        Sobol' and Levitan. See Bratley, P., Fox, B.L. (1988)
+        "Algorithm 659: Implementing Sobol's quasirandom sequence
+        generator," ACM Transactions on Mathematical Software
+        14:88-100. These values satisfy Property A for d<=20 and d =
+        23, 31, 33, 34, 37; Property A' holds for d<=6. They were
+        computed for the primitive polynomials in the order listed by
+        Bratley and Fox, which is therefore used with them; the other
+        polynomials follow in the usual order.
+
+        Jäckel provides in his book (section 8.3) initialization
+        numbers up to dimension 32, for the primitive polynomials in
+        the usual order. Beyond the tabulated dimensions, Jäckel's
+        random initialization is used: the initialization numbers
+        are drawn with a Mersenne-twister generator seeded with the
+        given seed, subject to the constraints of Property A.
+
+        Joe and Kuo found direction numbers with good two-dimensional
+        projections up to dimension 21201; the D6 set is tabulated
+        here up to dimension 3667. See S. Joe and F. Y. Kuo,
+        "Constructing Sobol sequences with better two-dimensional
+        projections," SIAM J. Sci. Comput. 30, 2635-2654 (2008).
+        Beyond dimension 3667 the random initialization is used.
+
+        Lemieux extended the Sobol'-Levitan values up to dimension
+        360; only the first 40 dimensions, where the two sets
+        coincide, are tabulated here, and SobolLevitanLemieux uses the
+        random initialization beyond them.
+
+        \warning SobolLevitanLemieux reproduces Lemieux's values only
+                 up to dimension 40. The JoeKuoD5, JoeKuoD7, Kuo,
+                 Kuo2 and Kuo3 sets are not included in this
+                 distribution; requesting them raises an error rather
+                 than silently falling back to a different set.
+
+        \test
+        - the correctness of the returned values is tested by
+          reproducing known good values.
+        - the correctness of the returned values is tested by checking
+          their discrepancy against known good values.
+        - skipTo() is tested against the equivalent number of draws.
+        - nextSequences() is tested against the equivalent number of
+          single draws.
+    */
+    class SobolRsg {
+      public:
+        typedef Sample<std::vector<Real> > sample_type;
+        enum DirectionIntegers {
+            Unit, Jaeckel, SobolLevitan, SobolLevitanLemieux,
+            JoeKuoD5, JoeKuoD6, JoeKuoD7,
+            Kuo, Kuo2, Kuo3 };
+        /*! \pre dimensionality must be <= PPMT_MAX_DIM */
+        SobolRsg(Size dimensionality,
+                 unsigned long seed = 0,
+                 DirectionIntegers directionIntegers = Jaeckel);
+        /*! skip to the n-th sample in the low-discrepancy sequence,
+            i.e., the next draw will return the n-th point (counting
+            from zero) in O(log n) operations.
+        */
+        void skipTo(unsigned long n);
+        const std::vector<unsigned long>& nextInt32Sequence() const;
+        const sample_type& nextSequence() const;
+        /*! draws the next n points of the sequence into a contiguous
+            buffer of n*dimension() elements; the i-th point occupies
+            the elements from i*dimension() to (i+1)*dimension()-1.
+            The result is the same as calling nextSequence() n times;
+            afterwards, lastSequence() returns the last point drawn.
+        */
+        void nextSequences(Size n, std::vector<Real>& points) const;
+        const sample_type& lastSequence() const { return sequence_; }
+        Size dimension() const { return dimensionality_; }
+      private:
+        void advance() const;
+        static const int bits_ = 8*sizeof(unsigned long);
+        Size dimensionality_;
+        mutable unsigned long sequenceCounter_;
+        mutable bool firstDraw_;
+        mutable sample_type sequence_;
+        mutable std::vector<unsigned long> integerSequence_;
+        // stored as directionIntegers_[bit][dimension] so that the
+        // update of a point only touches one contiguous row
+        std::vector<std::vector<unsigned long> > directionIntegers_;
+        Real normalizationFactor_;
+    };
+
+}
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2003, 2004 Ferdinando Ametrano
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+// ===========================================================================
+// NOTE: The following copyright notice applies to the original code,
+//
+// Copyright (C) 2002 Peter Jäckel "Monte Carlo Methods in Finance".
+// All rights reserved.
+//
+// Permission to use, copy, modify, and distribute this software is freely
+// granted, provided that this notice is preserved.
+// ===========================================================================
+
+#include <ql/errors.hpp>
+#include <ql/math/randomnumbers/mt19937uniformrng.hpp>
+#include <ql/math/randomnumbers/primitivepolynomials.hpp>
+#include <ql/math/randomnumbers/joekuodirectionintegers.hpp>
+#include <algorithm>
+
+namespace QuantLib {
+
+    namespace detail {
+
+        /* Coefficients of the free direction integers for dimensions
+           2 to 32, each one terminated by a 0, as given by Jäckel in
+           "Monte Carlo Methods in Finance", section 8.3.
+        */
+        inline const unsigned short* SobolJaeckelInitializers() {
+            static const unsigned short initializers[] = {
+                1,0,
+                1,1,0,
+                1,3,7,0,
+                1,1,5,0,
+                1,3,1,1,0,
+                1,1,3,7,0,
+                1,3,3,9,9,0,
+                1,3,7,7,21,0,
+                1,1,5,11,27,0,
+                1,1,7,3,29,0,
+                1,3,7,13,3,0,
+                1,3,5,1,15,0,
+                1,1,1,9,23,37,0,
+                1,1,3,13,11,7,0,
+                1,3,3,5,19,33,0,
+                1,1,7,13,25,5,0,
+                1,1,1,3,13,39,0,
+                1,3,5,11,7,11,0,
+                1,3,1,7,3,23,79,0,
+                1,3,1,15,17,63,13,0,
+                1,3,3,3,25,17,115,0,
+                1,3,7,9,31,29,17,0,
+                1,1,3,15,29,15,41,0,
+                1,3,1,9,5,21,119,0,
+                1,1,5,5,1,27,33,0,
+                1,1,3,1,23,13,75,0,
+                1,1,7,7,19,25,105,0,
+                1,3,5,5,21,9,7,0,
+                1,1,1,15,5,49,59,0,
+                1,3,5,15,17,19,21,0,
+                1,1,7,11,13,29,3,0
+            };
+            return initializers;
+        }
+
+        /* Coefficients of the free direction integers for dimensions
+           2 to 40, each one terminated by a 0, as published by Bratley
+           and Fox (ACM TOMS Algorithm 659).
+        */
+        inline const unsigned short* SobolLevitanInitializers() {
+            static const unsigned short initializers[] = {
+                1,0,
+                1,1,0,
+                1,3,7,0,
+                1,1,5,0,
+                1,3,1,1,0,
+                1,1,3,7,0,
+                1,3,3,9,9,0,
+                1,3,7,13,3,0,
+                1,1,5,11,27,0,
+                1,3,5,1,15,0,
+                1,1,7,3,29,0,
+                1,3,7,7,21,0,
+                1,1,1,9,23,37,0,
+                1,3,3,5,19,33,0,
+                1,1,3,13,11,7,0,
+                1,1,7,13,25,5,0,
+                1,3,5,11,7,11,0,
+                1,1,1,3,13,39,0,
+                1,3,1,15,17,63,13,0,
+                1,1,5,5,1,27,33,0,
+                1,3,3,3,25,17,115,0,
+                1,1,3,15,29,15,41,0,
+                1,3,1,7,3,23,79,0,
+                1,3,7,9,31,29,17,0,
+                1,1,5,13,11,3,29,0,
+                1,3,1,9,5,21,119,0,
+                1,1,3,1,23,13,75,0,
+                1,3,3,11,27,31,73,0,
+                1,1,7,7,19,25,105,0,
+                1,3,5,5,21,9,7,0,
+                1,1,1,15,5,49,59,0,
+                1,1,1,1,1,33,65,0,
+                1,3,5,15,17,19,21,0,
+                1,1,7,11,13,29,3,0,
+                1,3,7,5,7,11,113,0,
+                1,1,5,3,15,19,61,0,
+                1,3,1,1,9,27,89,7,0,
+                1,1,3,7,31,15,45,23,0,
+                1,3,3,9,9,25,107,39,0
+            };
+            return initializers;
+        }
+
+        /* The primitive polynomials for dimensions 2 to 40, including
+           their leading and trailing coefficients, in the order used
+           by Bratley and Fox; within each degree, it differs from the
+           one of the PrimitivePolynomials table.
+        */
+        inline const unsigned short* BratleyFoxPolynomials() {
+            static const unsigned short polynomials[] = {
+                  3,   7,  11,  13,  19,  25,  37,  59,  47,  61,
+                 55,  41,  67,  97,  91, 109, 103, 115, 131, 193,
+                137, 145, 143, 241, 157, 185, 167, 229, 171, 213,
+                191, 253, 203, 211, 239, 247, 285, 369, 299
+            };
+            return polynomials;
+        }
+
+        const Size BratleyFoxPolynomialsNumber = 39;
+
+        inline bool isBratleyFoxPolynomial(unsigned int degree,
+                                           long polynomial) {
+            const unsigned short p = static_cast<unsigned short>(
+                          (1UL << degree) | (polynomial << 1) | 1UL);
+            const unsigned short* polynomials = BratleyFoxPolynomials();
+            return std::find(polynomials,
+                             polynomials + BratleyFoxPolynomialsNumber,
+                             p) != polynomials + BratleyFoxPolynomialsNumber;
+        }
+
+    }
+
+    inline SobolRsg::SobolRsg(Size dimensionality, unsigned long seed,
+                              DirectionIntegers directionIntegers)
+    : dimensionality_(dimensionality), sequenceCounter_(0), firstDraw_(true),
+      sequence_(std::vector<Real>(dimensionality), 1.0),
+      integerSequence_(dimensionality, 0),
+      directionIntegers_(bits_, std::vector<unsigned long>(dimensionality)),
+      normalizationFactor_(0.5/(1UL<<(bits_-1))) {
+
+        QL_REQUIRE(dimensionality>0,
+                   "dimensionality must be greater than 0");
+        QL_REQUIRE(dimensionality<=PPMT_MAX_DIM,
+                   "dimensionality " << dimensionality
+                   << " exceeds the number of available "
+                   << "primitive polynomials modulo two ("
+                   << PPMT_MAX_DIM << ")");
+
+        // initializes coefficient array of the k-th primitive polynomial
+        // and degree of the k-th primitive polynomial
+        std::vector<unsigned int> degree(dimensionality_);
+        std::vector<long> ppmt(dimensionality_);
+
+        // degree 0 is not used
+        ppmt[0]=0;
+        degree[0]=0;
+        Size k = 1;
+
+        // the Sobol'-Levitan values were computed for the polynomials
+        // in the order used by Bratley and Fox; the other polynomials
+        // follow in the usual order
+        const bool bratleyFoxOrder =
+            (directionIntegers == SobolLevitan ||
+             directionIntegers == SobolLevitanLemieux);
+        if (bratleyFoxOrder) {
+            const unsigned short* polynomials =
+                detail::BratleyFoxPolynomials();
+            Size n = std::min(dimensionality_,
+                              detail::BratleyFoxPolynomialsNumber+1);
+            for (; k<n; k++) {
+                unsigned long p = polynomials[k-1];
+                unsigned int gk = 0;
+                while (p >> (gk+1))
+                    ++gk;
+                degree[k] = gk;
+                ppmt[k] = long((p >> 1) & ((1UL << (gk-1)) - 1));
+            }
+        }
+
+        Size index = 0;
+        unsigned int currentDegree = 1;
+        while (k<dimensionality_) {
+            long p = PrimitivePolynomials[currentDegree-1][index++];
+            if (p == -1) {
+                ++currentDegree;
+                index = 0;
+            } else if (!bratleyFoxOrder ||
+                       !detail::isBratleyFoxPolynomial(currentDegree, p)) {
+                ppmt[k] = p;
+                degree[k] = currentDegree;
+                k++;
+            }
+        }
+
+        // initializes bits_ direction integers for each dimension
+        // and store them into directionIntegers_[bits_][dimensionality_]
+        //
+        // In each dimension k with its associated primitive polynomial,
+        // the first degree[k] direction integers can be chosen freely
+        // provided that only the l leftmost bits can be non-zero, and
+        // that the l-th leftmost bit must be set
+
+        // degenerate (no free direction integers) first dimension
+        int j;
+        for (j=0; j<bits_; j++)
+            directionIntegers_[j][0] = (1UL<<(bits_-j-1));
+
+        // dimensions from 2 (k=1) to maxTabulated (k=maxTabulated-1)
+        // included are initialized from tabulated coefficients
+        Size maxTabulated = 0;
+        const unsigned short* initializers = 0;
+        switch (directionIntegers) {
+          case Unit:
+            maxTabulated = dimensionality_;
+            for (k=1; k<maxTabulated; k++) {
+                for (Size l=1; l<=degree[k]; l++)
+                    directionIntegers_[l-1][k] = (1UL<<(bits_-l));
+            }
+            break;
+          case Jaeckel:
+            maxTabulated = 32;
+            initializers = detail::SobolJaeckelInitializers();
+            break;
+          case SobolLevitan:
+          case SobolLevitanLemieux:
+            // Lemieux's set extends the Sobol'-Levitan one, with which
+            // it coincides up to dimension 40
+            maxTabulated = 40;
+            initializers = detail::SobolLevitanInitializers();
+            break;
+          case JoeKuoD6:
+            maxTabulated = detail::JoeKuoD6MaxDimension;
+            initializers = detail::JoeKuoD6Initializers();
+            break;
+          case JoeKuoD5:
+            QL_FAIL("JoeKuoD5 direction integers not available");
+          case JoeKuoD7:
+            QL_FAIL("JoeKuoD7 direction integers not available");
+          case Kuo:
+            QL_FAIL("Kuo direction integers not available");
+          case Kuo2:
+            QL_FAIL("Kuo2 direction integers not available");
+          case Kuo3:
+            QL_FAIL("Kuo3 direction integers not available");
+          default:
+            QL_FAIL("unknown direction integers");
+        }
+
+        if (initializers != 0) {
+            // 0 marks the end of the coefficients of a given dimension
+            for (k=1; k<std::min(dimensionality_, maxTabulated); k++) {
+                for (j=0; *initializers != 0; ++j, ++initializers)
+                    directionIntegers_[j][k] =
+                        (static_cast<unsigned long>(*initializers)
+                                                        << (bits_-j-1));
+                ++initializers;
+            }
+        }
+
+        // random initialization for higher dimensions
+        if (dimensionality_>maxTabulated) {
+            MersenneTwisterUniformRng uniformRng(seed);
+            for (k=maxTabulated; k<dimensionality_; k++) {
+                for (Size l=1; l<=degree[k]; l++) {
+                    unsigned long v;
+                    do {
+                        // u is in (0,1)
+                        double u = uniformRng.next().value;
+                        // the direction integer has at most the
+                        // rightmost l bits non-zero
+                        v = (unsigned long)(u*(1UL<<l));
+                    } while (!(v & 1UL));
+                    // iterate until the direction integer is odd
+                    // that is it has the rightmost bit set
+
+                    // shifting bits_-l bits to the left
+                    // we are guaranteed that the l-th leftmost bit
+                    // is set, and only the first l leftmost bit
+                    // can be non-zero
+                    directionIntegers_[l-1][k] = v << (bits_-l);
+                }
+            }
+        }
+
+        // computation of directionIntegers_[l][k] for l>=degree[k]
+        // by recurrence relation
+        for (k=1; k<dimensionality_; k++) {
+            unsigned int gk = degree[k];
+            for (int l=gk; l<bits_; l++) {
+                // eq. 8.19 page 400
+                unsigned long n = (directionIntegers_[l-gk][k]>>gk);
+                // a[k][j] are the coefficients of the monomials in ppmt[k]
+                // The highest order coefficient a[k][0] is not actually
+                // used in the recurrence relation, and the lowest order
+                // coefficient a[k][gk] is always set: this is the reason
+                // why the highest and lowest coefficient of
+                // the polynomial ppmt[k] are not included in its encoding,
+                // provided that its degree is known.
+                // That is: a[k][j] = ppmt[k] >> (gk-j-1)
+                for (Size m=1; m<gk; m++) {
+                    // XORed with a selection of (unshifted) direction
+                    // integers controlled by which of the a[k][m] are set
+                    if ((ppmt[k] >> (gk-m-1)) & 1UL)
+                        n ^= directionIntegers_[l-m][k];
+                }
+                // a[k][gk] is always set, so directionIntegers_[l-gk][k]
+                // will always enter
+                n ^= directionIntegers_[l-gk][k];
+                directionIntegers_[l][k] = n;
+            }
+        }
+
+        // initialize the Sobol integer/double vectors
+        // first draw
+        integerSequence_ = directionIntegers_[0];
+    }
+
+    inline void SobolRsg::skipTo(unsigned long n) {
+        QL_REQUIRE(n+1 != 0, "cannot skip beyond the sequence period");
+        // the n-th draw (counting from zero) is generated by the Gray
+        // code of n+1, G = (n+1) XOR ((n+1)>>1)
+        unsigned long N = n+1;
+        unsigned long G = N ^ (N>>1);
+        std::fill(integerSequence_.begin(), integerSequence_.end(), 0UL);
+        for (Size index=0; G!=0; ++index, G>>=1) {
+            if (G & 1UL) {
+                const std::vector<unsigned long>& v =
+                    directionIntegers_[index];
+                for (Size k=0; k<dimensionality_; k++)
+                    integerSequence_[k] ^= v[k];
+            }
+        }
+        sequenceCounter_ = n;
+        // the point just computed is returned by the next draw
+        firstDraw_ = true;
+    }
+
+    inline void SobolRsg::advance() const {
+        if (firstDraw_) {
+            // it was precomputed by the constructor or by skipTo()
+            firstDraw_ = false;
+            return;
+        }
+        // increment the counter
+        sequenceCounter_++;
+        // did we overflow?
+        QL_REQUIRE(sequenceCounter_ != 0, "period exceeded");
+
+        // instead of using the counter n as new unique generating integer
+        // for the n-th draw use the Gray code G(n) as proposed
+        // by Antonov and Saleev
+        unsigned long n = sequenceCounter_;
+        // Find rightmost zero bit of n
+        Size j = 0;
+        while (n & 1) { n >>= 1; j++; }
+        // XOR the appropriate direction number into each component of
+        // the integer sequence to obtain a new Sobol integer for that
+        // component
+        const unsigned long* v = &directionIntegers_[j][0];
+        unsigned long* s = &integerSequence_[0];
+        for (Size k=0; k<dimensionality_; k++)
+            s[k] ^= v[k];
+    }
+
+    inline const std::vector<unsigned long>&
+    SobolRsg::nextInt32Sequence() const {
+        advance();
+        return integerSequence_;
+    }
+
+    inline const SobolRsg::sample_type& SobolRsg::nextSequence() const {
+        advance();
+        // normalize to get a double in (0,1)
+        for (Size k=0; k<dimensionality_; ++k)
+            sequence_.value[k] = integerSequence_[k]*normalizationFactor_;
+        return sequence_;
+    }
+
+    inline void SobolRsg::nextSequences(Size n,
+                                        std::vector<Real>& points) const {
+        points.resize(n*dimensionality_);
+        const unsigned long* s = &integerSequence_[0];
+        for (Size i=0; i<n; ++i) {
+            advance();
+            Real* p = &points[i*dimensionality_];
+            for (Size k=0; k<dimensionality_; ++k)
+                p[k] = s[k]*normalizationFactor_;
+        }
+        if (n > 0)
+            std::copy(points.end()-dimensionality_, points.end(),
+                      sequence_.value.begin());
+    }
+
+}
+
+
+#endif
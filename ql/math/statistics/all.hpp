@@ -6,4 +6,5 @@
 #include <ql/math/statistics/incrementalstatistics.hpp>
 #include <ql/math/statistics/riskstatistics.hpp>
 #include <ql/math/statistics/sequencestatistics.hpp>
-#include <ql/math/statistics/statistics.hpp>
\ No newline at end of file
+#include <ql/math/statistics/statistics.hpp>
+#include <ql/math/statistics/tdigeststatistics.hpp>
\ No newline at end of file
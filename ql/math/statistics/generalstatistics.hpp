@@ -27,6 +27,7 @@
 
 #include <ql/utilities/null.hpp>
 #include <ql/errors.hpp>
+#include <algorithm>
 #include <vector>
 #include <utility>
 
@@ -167,6 +168,10 @@ namespace QuantLib {
             for (;begin!=end;++begin,++wbegin)
                 add(*begin, *wbegin);
         }
+        //! adds the data collected by another instance
+        /*! If both data sets are sorted, they are merged so that
+            the result is sorted as well. */
+        void merge(const GeneralStatistics& other);
 
         //! resets the data to a null set
         void reset();
@@ -225,6 +230,22 @@ namespace QuantLib {
         sorted_ = false;
     }
 
+    inline void GeneralStatistics::merge(const GeneralStatistics& other) {
+        if (this == &other) {
+            GeneralStatistics copy(other);
+            merge(copy);
+            return;
+        }
+        const Size n = samples_.size();
+        const bool sorted = sorted_ && other.sorted_;
+        samples_.insert(samples_.end(),
+                        other.samples_.begin(), other.samples_.end());
+        if (sorted)
+            std::inplace_merge(samples_.begin(), samples_.begin()+n,
+                               samples_.end());
+        sorted_ = sorted;
+    }
+
     inline void GeneralStatistics::reset() {
         samples_ = std::vector<std::pair<Real,Real> >();
         sorted_ = true;
@@ -21,8 +21,6 @@
 
 /*! \file incrementalstatistics.hpp
     \brief statistics tool based on incremental accumulation
-           in the meantime, this is just a wrapper to the boost
-           accumulator library, kept for backward compatibility
 */
 
 #ifndef quantlib_incremental_statistics_hpp
@@ -30,26 +28,8 @@
 
 #include <ql/utilities/null.hpp>
 #include <ql/errors.hpp>
-
-#if defined(__clang__)
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wc++11-extensions"
-#endif
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/stats.hpp>
-#include <boost/accumulators/statistics/count.hpp>
-#include <boost/accumulators/statistics/sum.hpp>
-#include <boost/accumulators/statistics/min.hpp>
-#include <boost/accumulators/statistics/max.hpp>
-#include <boost/accumulators/statistics/weighted_mean.hpp>
-#include <boost/accumulators/statistics/weighted_variance.hpp>
-#include <boost/accumulators/statistics/weighted_skewness.hpp>
-#include <boost/accumulators/statistics/weighted_kurtosis.hpp>
-#include <boost/accumulators/statistics/weighted_moment.hpp>
-#if defined(__clang__)
-#pragma clang diagnostic pop
-#endif
-
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 
 namespace QuantLib {
@@ -57,7 +37,14 @@ namespace QuantLib {
     //! Statistics tool based on incremental accumulation
     /*! It can accumulate a set of data and return statistics (e.g: mean,
         variance, skewness, kurtosis, error estimation, etc.).
-        This class is a wrapper to the boost accumulator library.
+
+        Data are accumulated as the boost accumulator library does;
+        the class used to be a wrapper to the latter, and returns the
+        same results.  Unlike boost accumulators, two sets of data
+        accumulated separately (e.g., by different threads) can be
+        merged; the mean and variance are combined with the pairwise
+        formulas of Chan, Golub and LeVeque, which are numerically
+        stable.
     */
 
     class IncrementalStatistics {
@@ -155,29 +142,23 @@ namespace QuantLib {
             for (;begin!=end;++begin,++wbegin)
                 add(*begin, *wbegin);
         }
+        //! adds the data accumulated by another instance
+        /*! The result is the same, up to rounding, as if the data
+            had been added to this instance. */
+        void merge(const IncrementalStatistics& other);
         //! resets the data to a null set
         void reset();
         //@}
-     private:
-       typedef boost::accumulators::accumulator_set<
-           Real,
-           boost::accumulators::stats<
-               boost::accumulators::tag::count, boost::accumulators::tag::min,
-               boost::accumulators::tag::max,
-               boost::accumulators::tag::weighted_mean,
-               boost::accumulators::tag::weighted_variance,
-               boost::accumulators::tag::weighted_skewness,
-               boost::accumulators::tag::weighted_kurtosis,
-               boost::accumulators::tag::sum_of_weights>,
-           Real> accumulator_set;
-        accumulator_set acc_;
-        typedef boost::accumulators::accumulator_set<
-            Real, boost::accumulators::stats<
-                      boost::accumulators::tag::count,
-                      boost::accumulators::tag::weighted_moment<2>,
-                      boost::accumulators::tag::sum_of_weights>,
-            Real> downside_accumulator_set;
-        downside_accumulator_set downsideAcc_;
+      private:
+        Size samples_;
+        Real weightSum_;
+        // running mean and variance, updated as in Welford's algorithm
+        Real mean_, variance_;
+        // weighted sums of the first four powers
+        Real sum1_, sum2_, sum3_, sum4_;
+        Real min_, max_;
+        Size downsideSamples_;
+        Real downsideWeightSum_, downsideSum2_;
     };
 
     // implementation
@@ -187,28 +168,23 @@ namespace QuantLib {
     }
 
     inline Size IncrementalStatistics::samples() const {
-        return boost::accumulators::extract_result<
-            boost::accumulators::tag::count>(acc_);
+        return samples_;
     }
 
     inline Real IncrementalStatistics::weightSum() const {
-        return boost::accumulators::extract_result<
-            boost::accumulators::tag::sum_of_weights>(acc_);
+        return weightSum_;
     }
 
     inline Real IncrementalStatistics::mean() const {
         QL_REQUIRE(weightSum() > 0.0, "sampleWeight_= 0, unsufficient");
-        return boost::accumulators::extract_result<
-            boost::accumulators::tag::weighted_mean>(acc_);
+        return sum1_ / weightSum_;
     }
 
     inline Real IncrementalStatistics::variance() const {
         QL_REQUIRE(weightSum() > 0.0, "sampleWeight_= 0, unsufficient");
         QL_REQUIRE(samples() > 1, "sample number <= 1, unsufficient");
         Real n = static_cast<Real>(samples());
-        return n / (n - 1.0) *
-               boost::accumulators::extract_result<
-                   boost::accumulators::tag::weighted_variance>(acc_);
+        return n / (n - 1.0) * variance_;
     }
 
     inline Real IncrementalStatistics::standardDeviation() const {
@@ -224,47 +200,44 @@ namespace QuantLib {
         Real n = static_cast<Real>(samples());
         Real r1 = n / (n - 2.0);
         Real r2 = (n - 1.0) / (n - 2.0);
-        return std::sqrt(r1 * r2) * 
-               boost::accumulators::extract_result<
-                   boost::accumulators::tag::weighted_skewness>(acc_);
+        Real m1 = sum1_ / weightSum_, m2 = sum2_ / weightSum_,
+             m3 = sum3_ / weightSum_;
+        Real skew = (m3 - 3. * m2 * m1 + 2. * m1 * m1 * m1)
+                  / ((m2 - m1 * m1) * std::sqrt(m2 - m1 * m1));
+        return std::sqrt(r1 * r2) * skew;
     }
 
     inline Real IncrementalStatistics::kurtosis() const {
         QL_REQUIRE(samples() > 3,
                    "sample number <= 3, unsufficient");
-        boost::accumulators::extract_result<
-            boost::accumulators::tag::weighted_kurtosis>(acc_);
         Real n = static_cast<Real>(samples());
         Real r1 = (n - 1.0) / (n - 2.0);
         Real r2 = (n + 1.0) / (n - 3.0);
         Real r3 = (n - 1.0) / (n - 3.0);
-        return ((3.0 + boost::accumulators::extract_result<
-                           boost::accumulators::tag::weighted_kurtosis>(acc_)) *
-                    r2 -
-                3.0 * r3) *
-               r1;
+        Real m1 = sum1_ / weightSum_, m2 = sum2_ / weightSum_,
+             m3 = sum3_ / weightSum_, m4 = sum4_ / weightSum_;
+        Real excess = (m4 - 4. * m3 * m1 + 6. * m2 * m1 * m1
+                       - 3. * m1 * m1 * m1 * m1)
+                    / ((m2 - m1 * m1) * (m2 - m1 * m1)) - 3.;
+        return ((3.0 + excess) * r2 - 3.0 * r3) * r1;
     }
 
     inline Real IncrementalStatistics::min() const {
         QL_REQUIRE(samples() > 0, "empty sample set");
-        return boost::accumulators::extract_result<
-            boost::accumulators::tag::min>(acc_);
+        return min_;
     }
 
     inline Real IncrementalStatistics::max() const {
         QL_REQUIRE(samples() > 0, "empty sample set");
-        return boost::accumulators::extract_result<
-            boost::accumulators::tag::max>(acc_);
+        return max_;
     }
 
     inline Size IncrementalStatistics::downsideSamples() const {
-        return boost::accumulators::extract_result<
-            boost::accumulators::tag::count>(downsideAcc_);
+        return downsideSamples_;
     }
 
     inline Real IncrementalStatistics::downsideWeightSum() const {
-        return boost::accumulators::extract_result<
-            boost::accumulators::tag::sum_of_weights>(downsideAcc_);
+        return downsideWeightSum_;
     }
 
     inline Real IncrementalStatistics::downsideVariance() const {
@@ -272,9 +245,7 @@ namespace QuantLib {
         QL_REQUIRE(downsideSamples() > 1, "sample number <= 1, unsufficient");
         Real n = static_cast<Real>(downsideSamples());
         Real r1 = n / (n - 1.0);
-        return r1 *
-               boost::accumulators::extract_result<
-                   boost::accumulators::tag::moment<2> >(downsideAcc_);
+        return r1 * (downsideSum2_ / downsideWeightSum_);
     }
 
     inline Real IncrementalStatistics::downsideDeviation() const {
@@ -284,14 +255,69 @@ namespace QuantLib {
     inline void IncrementalStatistics::add(Real value, Real valueWeight) {
         QL_REQUIRE(valueWeight >= 0.0, "negative weight (" << valueWeight
                                                            << ") not allowed");
-        acc_(value, boost::accumulators::weight = valueWeight);
-        if(value < 0.0)
-            downsideAcc_(value, boost::accumulators::weight = valueWeight);
+        ++samples_;
+        weightSum_ += valueWeight;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+        // running weighted mean and variance
+        if (weightSum_ > 0.0)
+            mean_ = (mean_ * (weightSum_ - valueWeight) + value * valueWeight)
+                  / weightSum_;
+        if (samples_ > 1 && weightSum_ > valueWeight) {
+            Real d = value - mean_;
+            variance_ = variance_ * (weightSum_ - valueWeight) / weightSum_
+                      + d * d * valueWeight / (weightSum_ - valueWeight);
+        }
+        Real x2 = value * value;
+        sum1_ += value * valueWeight;
+        sum2_ += valueWeight * x2;
+        sum3_ += valueWeight * (x2 * value);
+        sum4_ += valueWeight * (x2 * x2);
+        if (value < 0.0) {
+            ++downsideSamples_;
+            downsideWeightSum_ += valueWeight;
+            downsideSum2_ += valueWeight * x2;
+        }
+    }
+
+    inline void IncrementalStatistics::merge(
+                                     const IncrementalStatistics& other) {
+        if (other.samples_ == 0)
+            return;
+        if (samples_ == 0) {
+            *this = other;
+            return;
+        }
+        Real w1 = weightSum_, w2 = other.weightSum_, w = w1 + w2;
+        if (w2 > 0.0) {
+            Real d = other.mean_ - mean_;
+            if (w1 > 0.0)
+                variance_ = (w1 * variance_ + w2 * other.variance_
+                             + d * d * (w1 * w2 / w)) / w;
+            else
+                variance_ = other.variance_;
+            mean_ += d * (w2 / w);
+        }
+        samples_ += other.samples_;
+        weightSum_ = w;
+        sum1_ += other.sum1_;
+        sum2_ += other.sum2_;
+        sum3_ += other.sum3_;
+        sum4_ += other.sum4_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        downsideSamples_ += other.downsideSamples_;
+        downsideWeightSum_ += other.downsideWeightSum_;
+        downsideSum2_ += other.downsideSum2_;
     }
 
     inline void IncrementalStatistics::reset() {
-        acc_ = accumulator_set();
-        downsideAcc_ = downside_accumulator_set();
+        samples_ = downsideSamples_ = 0;
+        weightSum_ = mean_ = variance_ = 0.0;
+        sum1_ = sum2_ = sum3_ = sum4_ = 0.0;
+        downsideWeightSum_ = downsideSum2_ = 0.0;
+        min_ = QL_MAX_REAL;
+        max_ = -QL_MAX_REAL;
     }
 
 
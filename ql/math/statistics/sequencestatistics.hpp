@@ -139,6 +139,10 @@ namespace QuantLib {
                 stats_[i].add(*begin, weight);
 
         }
+        //! adds the samples accumulated by another instance
+        /*! \pre the underlying statistics must provide a merge()
+                 method. */
+        void merge(const GenericSequenceStatistics& other);
         //@}
       protected:
         Size dimension_;
@@ -244,6 +248,21 @@ namespace QuantLib {
         }
     }
 
+    template <class Stat>
+    void GenericSequenceStatistics<Stat>::merge(
+                                     const GenericSequenceStatistics& other) {
+        if (other.dimension_ == 0)
+            return;
+        if (dimension_ == 0)
+            reset(other.dimension_);
+        QL_REQUIRE(other.dimension_ == dimension_,
+                   "sample size mismatch: " << dimension_ <<
+                   " required, " << other.dimension_ << " provided");
+        for (Size i=0; i<dimension_; ++i)
+            stats_[i].merge(other.stats_[i]);
+        quadraticSum_ += other.quadraticSum_;
+    }
+
     template <class Stat>
     Disposable<Matrix> GenericSequenceStatistics<Stat>::covariance() const {
         Real sampleWeight = weightSum();
@@ -0,0 +1,387 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file tdigeststatistics.hpp
+    \brief statistics tool with bounded memory based on a t-digest
+*/
+
+#ifndef quantlib_tdigest_statistics_hpp
+#define quantlib_tdigest_statistics_hpp
+
+#include <ql/math/statistics/incrementalstatistics.hpp>
+#include <ql/math/statistics/riskstatistics.hpp>
+#include <ql/mathconstants.hpp>
+#include <algorithm>
+#include <vector>
+#include <utility>
+
+namespace QuantLib {
+
+    //! Statistics tool with bounded memory
+    /*! This class provides the same interface as GeneralStatistics,
+        so that it can be used as the underlying tool of
+        GenericRiskStatistics, but it doesn't store the samples.
+        Moments, minimum and maximum are accumulated exactly as in
+        IncrementalStatistics; percentiles and expectation values
+        are calculated on a t-digest, i.e., a set of clusters
+        (centroids) of neighboring samples, each represented by its
+        mean and weight.
+
+        Incoming samples are buffered; when the buffer is full, it
+        is sorted and merged with the existing centroids.  Both the
+        memory used and the cost of an insertion are therefore
+        independent of the number of samples, and the same holds
+        for percentile queries.  Two instances can be merged.
+
+        The clusters are limited by the scale function
+        \f[ k(q) = \frac{\delta}{2\pi} \arcsin(2q-1), \f]
+        where \f$ q \f$ is the quantile and \f$ \delta \f$ the
+        compression: no cluster spans more than one unit of
+        \f$ k \f$.  As a consequence, there are at most
+        \f$ \delta \f$ centroids, and the centroid containing the
+        \f$ q \f$-th quantile holds at most a fraction
+        \f[ \frac{2\pi}{\delta} \sqrt{q(1-q)} \f]
+        of the total weight.  This bounds the error on the rank of
+        the returned percentile; e.g., with the default compression,
+        the 1% percentile is returned with a rank error below 0.32%
+        and usually much smaller, since the values are interpolated
+        between centroids.  Centroids made of a single sample are
+        exact.  Expectation values over a range, e.g., expected
+        shortfall, are integrated over the same interpolated
+        distribution; their error has no such bound, but for
+        smooth distributions it decreases as \f$ 1/\delta \f$ or
+        faster.  In the test suite, expected shortfalls at 95% and
+        99% are reproduced within a relative error of
+        \f$ 3/\delta \f$.
+
+        For more details see T. Dunning and O. Ertl, "Computing
+        extremely accurate quantiles using t-digests", 2019.
+
+        \test the results are compared with those of the exact
+              statistics for both sequential and merged samples.
+    */
+    class TDigestStatistics {
+      public:
+        typedef Real value_type;
+        explicit TDigestStatistics(Real compression = 200.0);
+        //! \name Inspectors
+        //@{
+        //! number of samples collected
+        Size samples() const { return stats_.samples(); }
+
+        //! sum of data weights
+        Real weightSum() const { return stats_.weightSum(); }
+
+        //! returns the mean, as in IncrementalStatistics
+        Real mean() const { return stats_.mean(); }
+
+        //! returns the variance, as in IncrementalStatistics
+        Real variance() const { return stats_.variance(); }
+
+        //! returns the standard deviation, as in IncrementalStatistics
+        Real standardDeviation() const {
+            return stats_.standardDeviation();
+        }
+
+        //! returns the error estimate, as in IncrementalStatistics
+        Real errorEstimate() const { return stats_.errorEstimate(); }
+
+        //! returns the skewness, as in IncrementalStatistics
+        Real skewness() const { return stats_.skewness(); }
+
+        //! returns the excess kurtosis, as in IncrementalStatistics
+        Real kurtosis() const { return stats_.kurtosis(); }
+
+        /*! returns the minimum sample value */
+        Real min() const { return stats_.min(); }
+
+        /*! returns the maximum sample value */
+        Real max() const { return stats_.max(); }
+
+        /*! Expectation value of a function \f$ f \f$ on a given
+            range \f$ \mathcal{R} \f$ over the interpolated
+            distribution used for percentiles; the weight between
+            two consecutive knots is split in a few points evenly
+            spaced in value.  See GeneralStatistics for details.
+        */
+        template <class Func, class Predicate>
+        std::pair<Real,Size> expectationValue(const Func& f,
+                                              const Predicate& inRange) const {
+            compress();
+            const Size subdivisions = 8;
+            Real num = 0.0, den = 0.0, N = 0.0;
+            for (Size j=1; j<knots_.size(); ++j) {
+                const Knot& k0 = knots_[j-1];
+                const Knot& k1 = knots_[j];
+                const Size n = (k0.value == k1.value ? 1 : subdivisions);
+                const Real w = (k1.position-k0.position)/n,
+                           c = (k1.count-k0.count)/n,
+                           dx = (k1.value-k0.value)/n;
+                for (Size i=0; i<n; ++i) {
+                    Real x = k0.value + (i+0.5)*dx;
+                    if (inRange(x)) {
+                        num += f(x)*w;
+                        den += w;
+                        N += c;
+                    }
+                }
+            }
+            if (N == 0.0)
+                return std::make_pair<Real,Size>(Null<Real>(),0);
+            else
+                return std::make_pair(num/den,
+                                      std::max<Size>(Size(N+0.5), 1));
+        }
+
+        /*! \f$ y \f$-th percentile, interpolated between centroids.
+            See GeneralStatistics for the definition.
+
+            \pre \f$ y \f$ must be in the range \f$ (0-1]. \f$
+        */
+        Real percentile(Real y) const;
+
+        /*! \f$ y \f$-th top percentile, interpolated between
+            centroids.  See GeneralStatistics for the definition.
+
+            \pre \f$ y \f$ must be in the range \f$ (0-1]. \f$
+        */
+        Real topPercentile(Real y) const;
+
+        //! compression parameter \f$ \delta \f$
+        Real compression() const { return compression_; }
+
+        //! number of centroids currently used
+        Size centroids() const;
+        //@}
+
+        //! \name Modifiers
+        //@{
+        //! adds a datum to the set, possibly with a weight
+        /*! \pre weight must be positive or null */
+        void add(Real value, Real weight = 1.0);
+        //! adds a sequence of data to the set, with default weight
+        template <class DataIterator>
+        void addSequence(DataIterator begin, DataIterator end) {
+            for (;begin!=end;++begin)
+                add(*begin);
+        }
+        //! adds a sequence of data to the set, each with its weight
+        /*! \pre weights must be positive or null */
+        template <class DataIterator, class WeightIterator>
+        void addSequence(DataIterator begin, DataIterator end,
+                         WeightIterator wbegin) {
+            for (;begin!=end;++begin,++wbegin)
+                add(*begin, *wbegin);
+        }
+        //! adds the data accumulated by another instance
+        void merge(const TDigestStatistics& other);
+
+        //! resets the data to a null set
+        void reset();
+        //@}
+      private:
+        struct Centroid {
+            Real mean, weight;
+            Size count;
+            bool operator<(const Centroid& c) const { return mean < c.mean; }
+        };
+        // cumulated weight and number of samples at a given value of
+        // the interpolated distribution
+        struct Knot {
+            Real position, count, value;
+            bool operator<(Real p) const { return position < p; }
+        };
+        void push(const Centroid& c);
+        void compress() const;
+        Real scale(Real q) const;
+        Real inverseScale(Real k) const;
+        Real compression_;
+        Size bufferSize_;
+        IncrementalStatistics stats_;
+        mutable std::vector<Centroid> centroids_, buffer_, merged_;
+        mutable std::vector<Knot> knots_;
+    };
+
+    //! risk measures tool with bounded memory
+    /*! The compression can be set by passing a TDigestStatistics
+        instance to the constructor. */
+    typedef GenericRiskStatistics<GenericGaussianStatistics<
+                                      TDigestStatistics> > TDigestRiskStatistics;
+
+
+    // inline definitions
+
+    inline TDigestStatistics::TDigestStatistics(Real compression)
+    : compression_(compression) {
+        QL_REQUIRE(compression >= 10.0,
+                   "compression (" << compression << ") must be >= 10");
+        bufferSize_ = static_cast<Size>(5.0*compression_);
+        reset();
+    }
+
+    inline Size TDigestStatistics::centroids() const {
+        compress();
+        return centroids_.size();
+    }
+
+    inline void TDigestStatistics::add(Real value, Real weight) {
+        stats_.add(value, weight);
+        Centroid c = { value, weight, 1 };
+        push(c);
+    }
+
+    inline void TDigestStatistics::push(const Centroid& c) {
+        if (buffer_.size() == bufferSize_)
+            compress();
+        buffer_.push_back(c);
+    }
+
+    inline void TDigestStatistics::merge(const TDigestStatistics& other) {
+        if (this == &other) {
+            TDigestStatistics copy(other);
+            merge(copy);
+            return;
+        }
+        stats_.merge(other.stats_);
+        other.compress();
+        for (Size i=0; i<other.centroids_.size(); ++i)
+            push(other.centroids_[i]);
+    }
+
+    inline void TDigestStatistics::reset() {
+        stats_.reset();
+        centroids_.clear();
+        buffer_.clear();
+        knots_.clear();
+        centroids_.reserve(static_cast<Size>(compression_)+1);
+        buffer_.reserve(bufferSize_);
+        merged_.reserve(bufferSize_ + centroids_.capacity());
+        knots_.reserve(2*centroids_.capacity()+2);
+    }
+
+    inline Real TDigestStatistics::scale(Real q) const {
+        return compression_/(2.0*M_PI) * std::asin(2.0*q-1.0);
+    }
+
+    inline Real TDigestStatistics::inverseScale(Real k) const {
+        Real x = std::min<Real>(2.0*M_PI*k/compression_, M_PI_2);
+        return 0.5*(std::sin(x)+1.0);
+    }
+
+    inline void TDigestStatistics::compress() const {
+        if (buffer_.empty())
+            return;
+
+        std::sort(buffer_.begin(), buffer_.end());
+        merged_.resize(centroids_.size() + buffer_.size());
+        std::merge(centroids_.begin(), centroids_.end(),
+                   buffer_.begin(), buffer_.end(), merged_.begin());
+        buffer_.clear();
+
+        Real total = 0.0;
+        for (Size i=0; i<merged_.size(); ++i)
+            total += merged_[i].weight;
+
+        // each cluster is extended as long as its upper bound stays
+        // within one unit of k from its lower bound
+        centroids_.clear();
+        centroids_.push_back(merged_[0]);
+        Real weightSoFar = 0.0;
+        Real limit = total*inverseScale(scale(0.0)+1.0);
+        for (Size i=1; i<merged_.size(); ++i) {
+            Centroid& last = centroids_.back();
+            const Centroid& next = merged_[i];
+            Real proposed = last.weight + next.weight;
+            if (weightSoFar + proposed <= limit) {
+                if (proposed > 0.0)
+                    last.mean += (next.mean-last.mean)*(next.weight/proposed);
+                last.weight = proposed;
+                last.count += next.count;
+            } else {
+                weightSoFar += last.weight;
+                Real q = (total > 0.0 ? std::min(weightSoFar/total, 1.0)
+                                      : 0.0);
+                limit = total*inverseScale(scale(q)+1.0);
+                centroids_.push_back(next);
+            }
+        }
+
+        /* The cumulative distribution is interpolated linearly
+           between the minimum, the centers of the centroids and the
+           maximum; a single sample is a step of the distribution. */
+        knots_.clear();
+        Knot first = { 0.0, 0.0, stats_.min() };
+        knots_.push_back(first);
+        Real position = 0.0, count = 0.0;
+        for (Size i=0; i<centroids_.size(); ++i) {
+            const Centroid& c = centroids_[i];
+            if (c.count == 1) {
+                Knot begin = { position, count, c.mean };
+                knots_.push_back(begin);
+                position += c.weight;
+                count += 1.0;
+                Knot end = { position, count, c.mean };
+                knots_.push_back(end);
+            } else {
+                Knot center = { position + 0.5*c.weight,
+                                count + 0.5*c.count, c.mean };
+                knots_.push_back(center);
+                position += c.weight;
+                count += c.count;
+            }
+        }
+        Knot last = { position, count, stats_.max() };
+        knots_.push_back(last);
+    }
+
+    inline Real TDigestStatistics::percentile(Real percent) const {
+
+        QL_REQUIRE(percent > 0.0 && percent <= 1.0,
+                   "percentile (" << percent << ") must be in (0.0, 1.0]");
+
+        Real sampleWeight = weightSum();
+        QL_REQUIRE(sampleWeight>0.0,
+                   "empty sample set");
+
+        compress();
+
+        Real target = percent*knots_.back().position;
+        std::vector<Knot>::const_iterator k =
+            std::lower_bound(knots_.begin(), knots_.end()-1, target);
+        if (k == knots_.begin())
+            return k->value;
+        std::vector<Knot>::const_iterator j = k-1;
+        if (k->position == j->position)
+            return k->value;
+        return j->value + (k->value-j->value)
+            * (target-j->position)/(k->position-j->position);
+    }
+
+    inline Real TDigestStatistics::topPercentile(Real percent) const {
+
+        QL_REQUIRE(percent > 0.0 && percent <= 1.0,
+                   "percentile (" << percent << ") must be in (0.0, 1.0]");
+
+        if (percent == 1.0)
+            return min();
+        return percentile(1.0-percent);
+    }
+
+}
+
+
+#endif
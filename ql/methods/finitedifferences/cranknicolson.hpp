@@ -50,6 +50,9 @@ namespace QuantLib {
         // operator interface
         array_type applyTo(const array_type&);
         array_type solveFor(const array_type&);
+        // in-place versions (result and argument can be the same)
+        void applyTo(const array_type&, array_type&);
+        void solveFor(const array_type&, array_type&);
         static Operator identity(Size size);
 
         // operator algebra
@@ -51,6 +51,8 @@ namespace QuantLib {
 
         // operator interface
         array_type applyTo(const array_type&);
+        // in-place version (result and argument can be the same)
+        void applyTo(const array_type&, array_type&);
         static Operator identity(Size size);
 
         // operator algebra
@@ -49,6 +49,8 @@ namespace QuantLib {
 
         // operator interface
         array_type solveFor(const array_type&);
+        // in-place version (result and argument can be the same)
+        void solveFor(const array_type&, array_type&);
         static Operator identity(Size size);
 
         // operator algebra
@@ -51,6 +51,9 @@ namespace QuantLib {
         // operator interface
         array_type applyTo(const array_type&);
         array_type solveFor(const array_type&);
+        // in-place versions (result and argument can be the same)
+        void applyTo(const array_type&, array_type&);
+        void solveFor(const array_type&, array_type&);
         static Operator identity(Size size);
 
         // operator algebra
@@ -114,7 +117,7 @@ namespace QuantLib {
             }
             for (i=0; i<bcs_.size(); i++)
                 bcs_[i]->applyBeforeApplying(explicitPart_);
-            a = explicitPart_.applyTo(a);
+            explicitPart_.applyTo(a, a);
             for (i=0; i<bcs_.size(); i++)
                 bcs_[i]->applyAfterApplying(a);
         }
@@ -52,6 +52,9 @@ namespace QuantLib {
         // operator interface
         array_type applyTo(const array_type&);
         array_type solveFor(const array_type&);
+        // in-place versions (result and argument can be the same)
+        void applyTo(const array_type&, array_type&);
+        void solveFor(const array_type&, array_type&);
         static Operator identity(Size size);
 
         // operator algebra
@@ -123,7 +126,7 @@ namespace QuantLib {
         }
         for (i=0; i<bcs_.size(); i++)
             bcs_[i]->applyBeforeApplying(explicitTrapezoidalPart_);
-        a = explicitTrapezoidalPart_.applyTo(a);
+        explicitTrapezoidalPart_.applyTo(a, a);
         for (i=0; i<bcs_.size(); i++)
             bcs_[i]->applyAfterApplying(a);
 
@@ -134,7 +137,7 @@ namespace QuantLib {
         }
         for (i=0; i<bcs_.size(); i++)
             bcs_[i]->applyBeforeSolving(implicitPart_,a);
-        a = implicitPart_.solveFor(a);
+        implicitPart_.solveFor(a, a);
         for (i=0; i<bcs_.size(); i++)
             bcs_[i]->applyAfterSolving(a);
 
@@ -161,7 +164,7 @@ namespace QuantLib {
         // reuse implicit part - works only for alpha=2-sqrt(2)
         for (i=0; i<bcs_.size(); i++)
             bcs_[i]->applyBeforeSolving(implicitPart_,a);
-        a = implicitPart_.solveFor(a);
+        implicitPart_.solveFor(a, a);
         for (i=0; i<bcs_.size(); i++)
             bcs_[i]->applyAfterSolving(a);
 
@@ -27,6 +27,7 @@
 #define quantlib_tridiagonal_operator_hpp
 
 #include <ql/math/array.hpp>
+#include <ql/math/matrix.hpp>
 #include <ql/math/comparison.hpp>
 #include <boost/shared_ptr.hpp>
 
@@ -74,14 +75,36 @@ namespace QuantLib {
         //@{
         //! apply operator to a given array
         Disposable<Array> applyTo(const Array& v) const;
+        /*! apply operator to a given array without result Array
+            allocation. The v and result parameters can be the same
+            Array, in which case v will be changed
+        */
+        void applyTo(const Array& v,
+                     Array& result) const;
         //! solve linear system for a given right-hand side
         Disposable<Array> solveFor(const Array& rhs) const;
         /*! solve linear system for a given right-hand side
             without result Array allocation. The rhs and result parameters
             can be the same Array, in which case rhs will be changed
+
+            The LU factorization of the operator is computed at the
+            first call and reused until the operator is modified.
         */
         void solveFor(const Array& rhs,
                       Array& result) const;
+        /*! apply operator to each column of the given matrix, whose
+            rows correspond to the grid points. The result must be a
+            different matrix of the same size.
+        */
+        void applyTo(const Matrix& v,
+                     Matrix& result) const;
+        /*! solve linear systems for each column of the given matrix
+            of right-hand sides, whose rows correspond to the grid
+            points; the factorization is shared by all of them. The
+            rhs and result parameters can be the same Matrix.
+        */
+        void solveFor(const Matrix& rhs,
+                      Matrix& result) const;
         //! solve linear system with SOR approach
         Disposable<Array> SOR(const Array& rhs,
                               Real tol) const;
@@ -120,12 +143,19 @@ namespace QuantLib {
         Array diagonal_, lowerDiagonal_, upperDiagonal_;
         mutable Array temp_;
         boost::shared_ptr<TimeSetter> timeSetter_;
+      private:
+        void factorize() const;
+        // LU factorization: temp_ holds the upper factor and
+        // inversePivots_ the inverse of the diagonal of the lower one
+        mutable Array inversePivots_;
+        mutable bool factorized_;
     };
 
     /* \relates TridiagonalOperator */
     void swap(TridiagonalOperator&, TridiagonalOperator&);
 
-    inline TridiagonalOperator::TridiagonalOperator(Size size) {
+    inline TridiagonalOperator::TridiagonalOperator(Size size)
+    : factorized_(false) {
         if (size>=2) {
             n_ = size;
             diagonal_      = Array(size);
@@ -150,7 +180,8 @@ namespace QuantLib {
                                              const Array& mid,
                                              const Array& high)
     : n_(mid.size()),
-      diagonal_(mid), lowerDiagonal_(low), upperDiagonal_(high), temp_(n_) {
+      diagonal_(mid), lowerDiagonal_(low), upperDiagonal_(high), temp_(n_),
+      factorized_(false) {
         QL_REQUIRE(low.size() == n_-1,
                    "low diagonal vector of size " << low.size() <<
                    " instead of " << n_-1);
@@ -160,7 +191,8 @@ namespace QuantLib {
     }
 
     inline TridiagonalOperator::TridiagonalOperator(
-                                const Disposable<TridiagonalOperator>& from) {
+                                const Disposable<TridiagonalOperator>& from)
+    : factorized_(false) {
         swap(const_cast<Disposable<TridiagonalOperator>&>(from));
     }
 
@@ -171,21 +203,32 @@ namespace QuantLib {
                    "vector of the wrong size " << v.size() <<
                    " instead of " << n_);
         Array result(n_);
-        std::transform(diagonal_.begin(), diagonal_.end(),
-                       v.begin(),
-                       result.begin(),
-                       std::multiplies<Real>());
-
-        // matricial product
-        result[0] += upperDiagonal_[0]*v[1];
-        for (Size j=1; j<=n_-2; j++)
-            result[j] += lowerDiagonal_[j-1]*v[j-1]+
-                upperDiagonal_[j]*v[j+1];
-        result[n_-1] += lowerDiagonal_[n_-2]*v[n_-2];
-
+        applyTo(v, result);
         return result;
     }
 
+    inline void TridiagonalOperator::applyTo(const Array& v,
+                                             Array& result) const {
+        QL_REQUIRE(n_!=0,
+                   "uninitialized TridiagonalOperator");
+        QL_REQUIRE(v.size()==n_ && result.size()==n_,
+                   "vector of the wrong size " << v.size() <<
+                   " instead of " << n_);
+
+        // matricial product; v[j-1] is saved before being
+        // overwritten in case v and result are the same array
+        Real previous = v[0];
+        result[0] = diagonal_[0]*v[0] + upperDiagonal_[0]*v[1];
+        for (Size j=1; j<=n_-2; j++) {
+            Real current = v[j];
+            result[j] = diagonal_[j]*current +
+                (lowerDiagonal_[j-1]*previous + upperDiagonal_[j]*v[j+1]);
+            previous = current;
+        }
+        result[n_-1] = diagonal_[n_-1]*v[n_-1] +
+                       lowerDiagonal_[n_-2]*previous;
+    }
+
     inline Disposable<Array> TridiagonalOperator::solveFor(const Array& rhs) const  {
 
         Array result(rhs.size());
@@ -202,21 +245,99 @@ namespace QuantLib {
                    "rhs vector of size " << rhs.size() <<
                    " instead of " << n_);
 
+        if (!factorized_)
+            factorize();
+
+        result[0] = rhs[0]*inversePivots_[0];
+        for (Size j=1; j<=n_-1; ++j)
+            result[j] = (rhs[j] - lowerDiagonal_[j-1]*result[j-1])
+                      * inversePivots_[j];
+        // cannot be j>=0 with Size j
+        for (Size j=n_-2; j>0; --j)
+            result[j] -= temp_[j+1]*result[j+1];
+        result[0] -= temp_[1]*result[1];
+    }
+
+    inline void TridiagonalOperator::applyTo(const Matrix& v,
+                                             Matrix& result) const {
+        QL_REQUIRE(n_!=0,
+                   "uninitialized TridiagonalOperator");
+        QL_REQUIRE(v.rows()==n_,
+                   "matrix with " << v.rows() <<
+                   " rows instead of " << n_);
+        QL_REQUIRE(result.rows()==n_ && result.columns()==v.columns(),
+                   "result matrix of the wrong size");
+        QL_REQUIRE(&v != &result,
+                   "result matrix must differ from the argument");
+
+        // the inner loops run along the rows, which are contiguous
+        const Size m = v.columns();
+        for (Size k=0; k<m; k++)
+            result[0][k] = diagonal_[0]*v[0][k] + upperDiagonal_[0]*v[1][k];
+        for (Size j=1; j<=n_-2; j++) {
+            const Real a = lowerDiagonal_[j-1],
+                       b = diagonal_[j],
+                       c = upperDiagonal_[j];
+            Matrix::const_row_iterator vm = v[j-1], v0 = v[j], vp = v[j+1];
+            Matrix::row_iterator r = result[j];
+            for (Size k=0; k<m; k++)
+                r[k] = b*v0[k] + (a*vm[k] + c*vp[k]);
+        }
+        for (Size k=0; k<m; k++)
+            result[n_-1][k] = diagonal_[n_-1]*v[n_-1][k] +
+                              lowerDiagonal_[n_-2]*v[n_-2][k];
+    }
+
+    inline void TridiagonalOperator::solveFor(const Matrix& rhs,
+                                              Matrix& result) const {
+        QL_REQUIRE(n_!=0,
+                   "uninitialized TridiagonalOperator");
+        QL_REQUIRE(rhs.rows()==n_,
+                   "rhs matrix with " << rhs.rows() <<
+                   " rows instead of " << n_);
+        QL_REQUIRE(result.rows()==n_ && result.columns()==rhs.columns(),
+                   "result matrix of the wrong size");
+
+        if (!factorized_)
+            factorize();
+
+        const Size m = rhs.columns();
+        for (Size k=0; k<m; k++)
+            result[0][k] = rhs[0][k]*inversePivots_[0];
+        for (Size j=1; j<=n_-1; ++j) {
+            const Real a = lowerDiagonal_[j-1], p = inversePivots_[j];
+            Matrix::const_row_iterator b = rhs[j];
+            Matrix::const_row_iterator xm = result[j-1];
+            Matrix::row_iterator x = result[j];
+            for (Size k=0; k<m; k++)
+                x[k] = (b[k] - a*xm[k]) * p;
+        }
+        // cannot be j>=0 with Size j
+        for (Size j=n_-1; j>0; --j) {
+            const Real t = temp_[j];
+            Matrix::const_row_iterator xp = result[j];
+            Matrix::row_iterator x = result[j-1];
+            for (Size k=0; k<m; k++)
+                x[k] -= t*xp[k];
+        }
+    }
+
+    inline void TridiagonalOperator::factorize() const {
+        if (inversePivots_.size() != n_)
+            Array(n_).swap(inversePivots_);
+
         Real bet = diagonal_[0];
         QL_REQUIRE(!close(bet, 0.0),
                    "diagonal's first element (" << bet <<
                    ") cannot be close to zero");
-        result[0] = rhs[0]/bet;
+        inversePivots_[0] = 1.0/bet;
         for (Size j=1; j<=n_-1; ++j) {
             temp_[j] = upperDiagonal_[j-1]/bet;
             bet = diagonal_[j]-lowerDiagonal_[j-1]*temp_[j];
             QL_ENSURE(!close(bet, 0.0), "division by zero");
-            result[j] = (rhs[j] - lowerDiagonal_[j-1]*result[j-1])/bet;
+            inversePivots_[j] = 1.0/bet;
         }
-        // cannot be j>=0 with Size j
-        for (Size j=n_-2; j>0; --j)
-            result[j] -= temp_[j+1]*result[j+1];
-        result[0] -= temp_[1]*result[1];
+        factorized_ = true;
     }
 
     inline Disposable<Array> TridiagonalOperator::SOR(const Array& rhs,
@@ -282,8 +403,13 @@ namespace QuantLib {
 
     inline void TridiagonalOperator::setFirstRow(Real valB,
                                                  Real valC) {
-        diagonal_[0]      = valB;
-        upperDiagonal_[0] = valC;
+        // boundary conditions set the same row at each step; this
+        // doesn't invalidate the factorization
+        if (diagonal_[0] != valB || upperDiagonal_[0] != valC) {
+            diagonal_[0]      = valB;
+            upperDiagonal_[0] = valC;
+            factorized_ = false;
+        }
     }
 
     inline void TridiagonalOperator::setMidRow(Size i,
@@ -295,6 +421,7 @@ namespace QuantLib {
         lowerDiagonal_[i-1] = valA;
         diagonal_[i]        = valB;
         upperDiagonal_[i]   = valC;
+        factorized_ = false;
     }
 
     inline void TridiagonalOperator::setMidRows(Real valA,
@@ -305,12 +432,16 @@ namespace QuantLib {
             diagonal_[i]        = valB;
             upperDiagonal_[i]   = valC;
         }
+        factorized_ = false;
     }
 
     inline void TridiagonalOperator::setLastRow(Real valA,
                                                 Real valB) {
-        lowerDiagonal_[n_-2] = valA;
-        diagonal_[n_-1]      = valB;
+        if (lowerDiagonal_[n_-2] != valA || diagonal_[n_-1] != valB) {
+            lowerDiagonal_[n_-2] = valA;
+            diagonal_[n_-1]      = valB;
+            factorized_ = false;
+        }
     }
 
     inline void TridiagonalOperator::setTime(Time t) {
@@ -326,6 +457,8 @@ namespace QuantLib {
         upperDiagonal_.swap(from.upperDiagonal_);
         temp_.swap(from.temp_);
         swap(timeSetter_, from.timeSetter_);
+        inversePivots_.swap(from.inversePivots_);
+        swap(factorized_, from.factorized_);
     }
 
 
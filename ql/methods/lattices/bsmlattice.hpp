@@ -47,6 +47,12 @@ namespace QuantLib {
                                 Size) const { return discount_; }
 
         void stepback(Size i, const Array& values, Array& newValues) const;
+        void stepbackAll(Size i,
+                         const std::vector<const Array*>& values,
+                         const std::vector<Array*>& newValues) const {
+            for (Size m=0; m<values.size(); ++m)
+                stepback(i, *values[m], *newValues[m]);
+        }
 
         Real underlying(Size i, Size index) const {
             return tree_->underlying(i, index);
@@ -31,6 +31,14 @@
 
 namespace QuantLib {
 
+    namespace detail {
+
+        // below this number of nodes, the cost of starting threads
+        // exceeds that of rolling back a level
+        const Size latticeParallelThreshold = 10000;
+
+    }
+
     //! Tree-based lattice-method base class
     /*! This class defines a lattice method that is able to rollback
         (with discount) a discretized asset object. It will be based
@@ -49,7 +57,13 @@ namespace QuantLib {
           void stepback(Size i,
                         const Array& values,
                         Array& newValues) const;
+          void stepbackAll(Size i,
+                           const std::vector<const Array*>& values,
+                           const std::vector<Array*>& newValues) const;
         \endcode
+        where the second one rolls back the values of several assets
+        by one level when they are rolled back together.  Classes
+        implementing a faster stepback() should implement it as well.
 
         \ingroup lattices
     */
@@ -70,6 +84,13 @@ namespace QuantLib {
         void initialize(DiscretizedAsset&, Time t) const;
         void rollback(DiscretizedAsset&, Time to) const;
         void partialRollback(DiscretizedAsset&, Time to) const;
+        void rollback(
+              const std::vector<boost::shared_ptr<DiscretizedAsset> >&,
+              Time to) const;
+        //! each level is rolled back for all the assets by stepbackAll()
+        void partialRollback(
+              const std::vector<boost::shared_ptr<DiscretizedAsset> >&,
+              Time to) const;
         //! Computes the present value of an asset using Arrow-Debrew prices
         Real presentValue(DiscretizedAsset&) const;
         //@}
@@ -79,6 +100,14 @@ namespace QuantLib {
         void stepback(Size i,
                       const Array& values,
                       Array& newValues) const;
+        /*! The transition probabilities, descendants and discount
+            factors of the level are retrieved once and used for all
+            the assets; the values of different assets are rolled
+            back in parallel if OpenMP is enabled.
+        */
+        void stepbackAll(Size i,
+                         const std::vector<const Array*>& values,
+                         const std::vector<Array*>& newValues) const;
 
       protected:
         void computeStatePrices(Size until) const;
@@ -152,22 +181,95 @@ namespace QuantLib {
         Integer iFrom = Integer(t_.index(from));
         Integer iTo = Integer(t_.index(to));
 
+        // the new values are written into a buffer which is then
+        // swapped with the asset values; the two arrays are reused
+        // as long as the width of the tree doesn't change
+        Array buffer;
         for (Integer i=iFrom-1; i>=iTo; --i) {
-            Array newValues(this->impl().size(i));
-            this->impl().stepback(i, asset.values(), newValues);
+            const Size size = this->impl().size(i);
+            if (buffer.size() != size)
+                Array(size).swap(buffer);
+            this->impl().stepback(i, asset.values(), buffer);
             asset.time() = t_[i];
-            asset.values() = newValues;
+            asset.values().swap(buffer);
             // skip the very last adjustment
             if (i != iTo)
                 asset.adjustValues();
         }
     }
 
+    template <class Impl>
+    inline void TreeLattice<Impl>::rollback(
+              const std::vector<boost::shared_ptr<DiscretizedAsset> >& assets,
+              Time to) const {
+        partialRollback(assets,to);
+        for (Size k=0; k<assets.size(); ++k)
+            assets[k]->adjustValues();
+    }
+
+    template <class Impl>
+    void TreeLattice<Impl>::partialRollback(
+              const std::vector<boost::shared_ptr<DiscretizedAsset> >& assets,
+              Time to) const {
+
+        const Size nAssets = assets.size();
+        const Integer iTo = Integer(t_.index(to));
+        std::vector<Integer> iFrom(nAssets, iTo);
+        Integer iMax = iTo;
+        for (Size k=0; k<nAssets; ++k) {
+            QL_REQUIRE(assets[k], "null asset");
+            Time from = assets[k]->time();
+            if (close(from,to))
+                continue;
+            QL_REQUIRE(from > to,
+                       "cannot roll the asset back to" << to
+                       << " (it is already at t = " << from << ")");
+            iFrom[k] = Integer(t_.index(from));
+            iMax = std::max(iMax, iFrom[k]);
+        }
+
+        std::vector<Size> active;
+        std::vector<const Array*> values;
+        std::vector<Array*> newValues;
+        std::vector<Array> buffers(nAssets);
+        for (Integer i=iMax-1; i>=iTo; --i) {
+            const Size size = this->impl().size(i);
+
+            // assets join as soon as the rollback reaches their time
+            active.clear();
+            values.clear();
+            newValues.clear();
+            for (Size k=0; k<nAssets; ++k) {
+                if (iFrom[k] > i) {
+                    active.push_back(k);
+                    if (buffers[k].size() != size)
+                        Array(size).swap(buffers[k]);
+                    values.push_back(&assets[k]->values());
+                    newValues.push_back(&buffers[k]);
+                }
+            }
+
+            this->impl().stepbackAll(i, values, newValues);
+
+            for (Size m=0; m<active.size(); ++m) {
+                DiscretizedAsset& asset = *assets[active[m]];
+                asset.time() = t_[i];
+                asset.values().swap(buffers[active[m]]);
+            }
+            // skip the very last adjustment
+            if (i != iTo) {
+                for (Size m=0; m<active.size(); ++m)
+                    assets[active[m]]->adjustValues();
+            }
+        }
+    }
+
     template <class Impl>
     void TreeLattice<Impl>::stepback(Size i, const Array& values,
                                      Array& newValues) const {
-        #pragma omp parallel for
-        for (Size j=0; j<this->impl().size(i); j++) {
+        const Size size = this->impl().size(i);
+        #pragma omp parallel for if(size > detail::latticeParallelThreshold)
+        for (Size j=0; j<size; j++) {
             Real value = 0.0;
             for (Size l=0; l<n_; l++) {
                 value += this->impl().probability(i,j,l) *
@@ -178,6 +280,39 @@ namespace QuantLib {
         }
     }
 
+    template <class Impl>
+    void TreeLattice<Impl>::stepbackAll(
+                             Size i,
+                             const std::vector<const Array*>& values,
+                             const std::vector<Array*>& newValues) const {
+        const Size size = this->impl().size(i);
+        const Size nAssets = values.size();
+
+        // the transition data are shared by all the assets
+        std::vector<Size> descendants(size*n_);
+        std::vector<Real> probabilities(size*n_), discounts(size);
+        for (Size j=0; j<size; j++) {
+            discounts[j] = this->impl().discount(i,j);
+            for (Size l=0; l<n_; l++) {
+                descendants[j*n_+l] = this->impl().descendant(i,j,l);
+                probabilities[j*n_+l] = this->impl().probability(i,j,l);
+            }
+        }
+
+        #pragma omp parallel for \
+            if(nAssets*size > detail::latticeParallelThreshold)
+        for (Size m=0; m<nAssets; ++m) {
+            const Array& v = *values[m];
+            Array& result = *newValues[m];
+            for (Size j=0; j<size; j++) {
+                Real value = 0.0;
+                for (Size l=0; l<n_; l++)
+                    value += probabilities[j*n_+l] * v[descendants[j*n_+l]];
+                result[j] = value*discounts[j];
+            }
+        }
+    }
+
 }
 
 
@@ -26,6 +26,7 @@
 #define quantlib_trinomial_tree_hpp
 
 #include <ql/methods/lattices/tree.hpp>
+#include <ql/math/array.hpp>
 #include <ql/timegrid.hpp>
 
 namespace QuantLib {
@@ -52,6 +53,16 @@ namespace QuantLib {
         Real underlying(Size i, Size index) const;
         Size descendant(Size i, Size index, Size branch) const;
         Real probability(Size i, Size index, Size branch) const;
+        /*! sets newValues[j] to the expectation of the values at
+            level i+1 conditional on node j at level i, multiplied by
+            discounts[j]; this is equivalent to summing
+            probability(i,j,l)*values[descendant(i,j,l)] over the
+            branches, but runs over the branching data directly.
+        */
+        void stepback(Size i,
+                      const Array& values,
+                      const Array& discounts,
+                      Array& newValues) const;
 
       protected:
         std::vector<Branching> branchings_;
@@ -72,6 +83,9 @@ namespace QuantLib {
             Integer jMin() const;
             Integer jMax() const;
             void add(Integer k, Real p1, Real p2, Real p3);
+            void stepback(const Array& values,
+                          const Array& discounts,
+                          Array& newValues) const;
           private:
             std::vector<Integer> k_;
             std::vector<std::vector<Real> > probs_;
@@ -102,6 +116,13 @@ namespace QuantLib {
         return branchings_[i].probability(j, b);
     }
 
+    inline void TrinomialTree::stepback(Size i,
+                                        const Array& values,
+                                        const Array& discounts,
+                                        Array& newValues) const {
+        branchings_[i].stepback(values, discounts, newValues);
+    }
+
     inline TrinomialTree::Branching::Branching()
     : probs_(3), kMin_(QL_MAX_INTEGER), jMin_(QL_MAX_INTEGER),
                  kMax_(QL_MIN_INTEGER), jMax_(QL_MIN_INTEGER) {}
@@ -142,6 +163,25 @@ namespace QuantLib {
         jMax_ = kMax_ + 1;
     }
 
+    inline void TrinomialTree::Branching::stepback(const Array& values,
+                                                   const Array& discounts,
+                                                   Array& newValues) const {
+        // the lowest descendant of node j is k_[j]-jMin_-1; the
+        // loop has no branches and can be vectorized
+        const Integer offset = jMin_ + 1;
+        const Integer* k = &k_[0];
+        const Real* p0 = &probs_[0][0];
+        const Real* p1 = &probs_[1][0];
+        const Real* p2 = &probs_[2][0];
+        const Real* v = values.begin();
+        const Real* d = discounts.begin();
+        Real* result = newValues.begin();
+        for (Size j=0; j<k_.size(); j++) {
+            const Real* vj = v + (k[j] - offset);
+            result[j] = (p0[j]*vj[0] + p1[j]*vj[1] + p2[j]*vj[2])*d[j];
+        }
+    }
+
 }
 
 /* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
@@ -38,6 +38,8 @@
 
 #include <ql/methods/montecarlo/path.hpp>
 #include <ql/methods/montecarlo/sample.hpp>
+#include <ql/math/matrix.hpp>
+#include <algorithm>
 
 namespace QuantLib {
 
@@ -135,6 +137,23 @@ namespace QuantLib {
             }
             output[0] /= sqrtdt_[0];
         }
+
+        //! multi-path Brownian-bridge generator function
+        /*! Transforms the variates of several paths at once; the
+            result is the same as calling the single-path version
+            on each of them.  The i-th row of the matrices contains
+            the i-th variate, or variation, of all paths; therefore,
+            the paths are contiguous and the bridge operations are
+            applied to whole rows, which allows the compiler to
+            vectorize them.
+
+            \param variates  A matrix with size() rows and one column
+                             per path containing the input variates.
+            \param output    The matrix of variations; it is resized
+                             if needed, and must not be the same
+                             matrix as the input.
+        */
+        void transform(const Matrix& variates, Matrix& output) const;
       private:
         void initialize();
         Size size_;
@@ -144,6 +163,59 @@ namespace QuantLib {
         std::vector<Real> leftWeight_, rightWeight_, stdDev_;
     };
 
+    namespace detail {
+
+        /* The functions below work on a row of the multi-path
+           bridge.  The paths are processed in blocks of fixed size
+           through a local buffer, so that the compiler can vectorize
+           the loops without checking for aliasing. */
+
+        const Size bridgeBlock = 8;
+
+        // x = lw*left + rw*right + sd*z, or rw*right + sd*z if the
+        // left point is the origin (left is null)
+        inline void bridgeRow(Size n, Real* x,
+                              const Real* left, Real lw,
+                              const Real* right, Real rw,
+                              const Real* z, Real sd) {
+            Real buffer[bridgeBlock];
+            Size p = 0;
+            if (left) {
+                for (; p+bridgeBlock<=n; p+=bridgeBlock) {
+                    for (Size k=0; k<bridgeBlock; ++k)
+                        buffer[k] = lw * left[p+k] + rw * right[p+k]
+                                  + sd * z[p+k];
+                    std::copy(buffer, buffer+bridgeBlock, x+p);
+                }
+                for (; p<n; ++p)
+                    x[p] = lw * left[p] + rw * right[p] + sd * z[p];
+            } else {
+                for (; p+bridgeBlock<=n; p+=bridgeBlock) {
+                    for (Size k=0; k<bridgeBlock; ++k)
+                        buffer[k] = rw * right[p+k] + sd * z[p+k];
+                    std::copy(buffer, buffer+bridgeBlock, x+p);
+                }
+                for (; p<n; ++p)
+                    x[p] = rw * right[p] + sd * z[p];
+            }
+        }
+
+        // x = (x - previous)/dt
+        inline void variationRow(Size n, Real* x,
+                                 const Real* previous, Real dt) {
+            Real buffer[bridgeBlock];
+            Size p = 0;
+            for (; p+bridgeBlock<=n; p+=bridgeBlock) {
+                for (Size k=0; k<bridgeBlock; ++k)
+                    buffer[k] = (x[p+k] - previous[p+k]) / dt;
+                std::copy(buffer, buffer+bridgeBlock, x+p);
+            }
+            for (; p<n; ++p)
+                x[p] = (x[p] - previous[p]) / dt;
+        }
+
+    }
+
     // implementation
 
     inline BrownianBridge::BrownianBridge(Size steps)
@@ -172,6 +244,39 @@ namespace QuantLib {
     }
 
 
+    inline void BrownianBridge::transform(const Matrix& variates,
+                                          Matrix& output) const {
+        QL_REQUIRE(variates.rows() == size_,
+                   "incompatible sequence size");
+        QL_REQUIRE(&variates != &output,
+                   "input and output must be different matrices");
+        const Size paths = variates.columns();
+        if (output.rows() != size_ || output.columns() != paths)
+            output = Matrix(size_, paths);
+        if (paths == 0)
+            return;
+
+        // We use output to store the paths...
+        const Real* z = variates[0];
+        Real* x = output[size_-1];
+        for (Size p=0; p<paths; ++p)
+            x[p] = stdDev_[0] * z[p];
+        for (Size i=1; i<size_; ++i) {
+            const Size j = leftIndex_[i];
+            detail::bridgeRow(paths, output[bridgeIndex_[i]],
+                              j != 0 ? output[j-1] : 0, leftWeight_[i],
+                              output[rightIndex_[i]], rightWeight_[i],
+                              variates[i], stdDev_[i]);
+        }
+        // ...after which, we calculate the variations and
+        // normalize to unit times
+        for (Size i=size_-1; i>=1; --i)
+            detail::variationRow(paths, output[i], output[i-1], sqrtdt_[i]);
+        x = output[0];
+        for (Size p=0; p<paths; ++p)
+            x[p] /= sqrtdt_[0];
+    }
+
     inline void BrownianBridge::initialize() {
 
         sqrtdt_[0] = std::sqrt(t_[0]);
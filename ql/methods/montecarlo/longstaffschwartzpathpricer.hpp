@@ -28,7 +28,8 @@
 
 #include <ql/termstructures/yieldtermstructure.hpp>
 #include <ql/math/functional.hpp>
-#include <ql/math/generallinearleastsquares.hpp>
+#include <ql/math/matrixutilities/qrdecomposition.hpp>
+#include <ql/math/matrixutilities/svd.hpp>
 #include <ql/math/statistics/incrementalstatistics.hpp>
 #include <ql/methods/montecarlo/pathpricer.hpp>
 #include <ql/methods/montecarlo/earlyexercisepathpricer.hpp>
@@ -45,9 +46,37 @@
 #endif
 
 #include <boost/function.hpp>
+#include <boost/shared_array.hpp>
+#include <string>
 
 namespace QuantLib {
 
+    //! calibration settings for the Longstaff-Schwartz path pricer
+    struct LsmCalibration {
+        //! what is kept of the calibration paths
+        /*! With StorePaths, the paths are copied as they are given.
+            With StoreStates, only the exercise values and the
+            regression states on each time of the grid are kept, in
+            one buffer per time; this avoids storing the underlying
+            values and the copies of the time grid held by each
+            path, and the buffers are released date by date during
+            the calibration.
+        */
+        enum Storage { StorePaths, StoreStates };
+        //! regression of the continuation values
+        /*! SVD solves the least-squares problem by a singular value
+            decomposition of the full matrix of basis values, as
+            done by GeneralLinearLeastSquares.  QR uses a pivoted QR
+            decomposition of the same matrix.  NormalEquations only
+            accumulates the products of the basis values, and solves
+            the resulting small system; this is the fastest and
+            needs the least memory, but squares the condition number
+            of the problem and should be used with well-scaled states
+            and orthogonal polynomials.
+        */
+        enum Regression { SVD, QR, NormalEquations };
+    };
+
     //! Longstaff-Schwarz path pricer for early exercise options
     /*! References:
 
@@ -55,6 +84,15 @@ namespace QuantLib {
         by Simulation: A Simple Least-Squares Approach, The Review of
         Financial Studies, Volume 14, No. 1, 113-147
 
+        During calibration, states, basis functions and continuation
+        values are evaluated on chunks of paths which are processed
+        in parallel when OpenMP is enabled.  The path pricer and the
+        basis functions must therefore be safe to call concurrently.
+        Once calibrated, the pricer records the exercise statistics
+        of the paths it prices; Monte Carlo workers running in
+        parallel should thus use separate copies returned by
+        clone().
+
         \ingroup mcarlo
 
         \test the correctness of the returned value is tested by
@@ -68,13 +106,27 @@ namespace QuantLib {
         LongstaffSchwartzPathPricer(
             const TimeGrid& times,
             const boost::shared_ptr<EarlyExercisePathPricer<PathType> >& ,
-            const boost::shared_ptr<YieldTermStructure>& termStructure);
+            const boost::shared_ptr<YieldTermStructure>& termStructure,
+            LsmCalibration::Storage storage = LsmCalibration::StorePaths,
+            LsmCalibration::Regression regression = LsmCalibration::SVD);
 
         Real operator()(const PathType& path) const;
         virtual void calibrate();
 
         Real exerciseProbability() const;
 
+        //! copy sharing the calibration, for use by another worker
+        /*! The copy has its own exercise statistics, which can be
+            added to those of this pricer by
+            mergeExerciseProbability().
+
+            \pre the pricer must be calibrated.
+        */
+        virtual boost::shared_ptr<LongstaffSchwartzPathPricer> clone() const;
+        //! adds the exercise statistics collected by another pricer
+        void mergeExerciseProbability(
+                                const LongstaffSchwartzPathPricer& other);
+
       protected:
         virtual void post_processing(const Size i,
                                      const std::vector<StateType> &state,
@@ -86,40 +138,88 @@ namespace QuantLib {
 
         mutable QuantLib::IncrementalStatistics exerciseProbability_;
 
-        boost::scoped_array<Array> coeff_;
-        boost::scoped_array<DiscountFactor> dF_;
+        // shared with clones; read-only after calibration
+        boost::shared_array<Array> coeff_;
+        boost::shared_array<DiscountFactor> dF_;
 
         mutable std::vector<PathType> paths_;
         const   std::vector<boost::function1<Real, StateType> > v_;
 
         const Size len_;
+
+        const LsmCalibration::Storage storage_;
+        const LsmCalibration::Regression regression_;
+        // exercise values and states of the calibration paths on
+        // each time of the grid, when paths are not stored
+        mutable std::vector<std::vector<Real> > exercises_;
+        mutable std::vector<std::vector<StateType> > states_;
+
+      private:
+        Size calibrationSamples() const;
+        void calibrationValues(Size i,
+                               std::vector<Real>& exercise,
+                               std::vector<StateType>& state);
+        Disposable<Array> regression(const std::vector<StateType>& x,
+                                     const std::vector<Real>& y,
+                                     Matrix& basis) const;
     };
 
+    namespace detail {
+
+        // number of paths processed together in the calibration
+        const Size lsmChunkSize = 1024;
+
+        inline void checkLsmErrors(const std::vector<std::string>& errors) {
+            for (Size k=0; k<errors.size(); ++k)
+                QL_REQUIRE(errors[k].empty(),
+                           "Longstaff-Schwartz calibration failed: "
+                           << errors[k]);
+        }
+
+    }
+
     template <class PathType> inline
     LongstaffSchwartzPathPricer<PathType>::LongstaffSchwartzPathPricer(
         const TimeGrid& times,
         const boost::shared_ptr<EarlyExercisePathPricer<PathType> >&
             pathPricer,
-        const boost::shared_ptr<YieldTermStructure>& termStructure)
+        const boost::shared_ptr<YieldTermStructure>& termStructure,
+        LsmCalibration::Storage storage,
+        LsmCalibration::Regression regression)
     : calibrationPhase_(true),
       pathPricer_(pathPricer),
       coeff_     (new Array[times.size()-2]),
       dF_        (new DiscountFactor[times.size()-1]),
       v_         (pathPricer_->basisSystem()),
-      len_       (times.size()) {
+      len_       (times.size()),
+      storage_   (storage),
+      regression_(regression) {
 
         for (Size i=0; i<times.size()-1; ++i) {
             dF_[i] =   termStructure->discount(times[i+1])
                      / termStructure->discount(times[i]);
         }
+
+        if (storage_ == LsmCalibration::StoreStates) {
+            exercises_.resize(len_);
+            states_.resize(len_);
+        }
     }
 
     template <class PathType> inline
     Real LongstaffSchwartzPathPricer<PathType>::operator()
         (const PathType& path) const {
         if (calibrationPhase_) {
-            // store paths for the calibration
-            paths_.push_back(path);
+            if (storage_ == LsmCalibration::StoreStates) {
+                // store the values needed by the calibration
+                for (Size i=1; i<len_; ++i) {
+                    exercises_[i].push_back((*pathPricer_)(path, i));
+                    states_[i].push_back(pathPricer_->state(path, i));
+                }
+            } else {
+                // store paths for the calibration
+                paths_.push_back(path);
+            }
             // result doesn't matter
             return 0.0;
         }
@@ -156,60 +256,195 @@ namespace QuantLib {
     }
 
     template <class PathType> inline
-    void LongstaffSchwartzPathPricer<PathType>::calibrate() {
+    Size LongstaffSchwartzPathPricer<PathType>::calibrationSamples() const {
+        if (storage_ == LsmCalibration::StoreStates)
+            return len_ > 1 ? exercises_[len_-1].size() : 0;
+        else
+            return paths_.size();
+    }
+
+    template <class PathType> inline
+    void LongstaffSchwartzPathPricer<PathType>::calibrationValues(
+                                           Size i,
+                                           std::vector<Real>& exercise,
+                                           std::vector<StateType>& state) {
+        if (storage_ == LsmCalibration::StoreStates) {
+            // the buffers for time i are not needed any longer
+            exercise.swap(exercises_[i]);
+            state.swap(states_[i]);
+            std::vector<Real>().swap(exercises_[i]);
+            std::vector<StateType>().swap(states_[i]);
+            return;
+        }
+
         const Size n = paths_.size();
-        Array prices(n), exercise(n);
-        std::vector<StateType> p_state(n);
-        std::vector<Real> p_price(n), p_exercise(n);
-
-        for (Size i=0; i<n; ++i) {
-            p_state[i] = pathPricer_->state(paths_[i],len_-1);
-            prices[i] = p_price[i] = (*pathPricer_)(paths_[i], len_-1);
-            p_exercise[i] = prices[i];
+        exercise.resize(n);
+        state.resize(n);
+        const Size chunks = (n+detail::lsmChunkSize-1)/detail::lsmChunkSize;
+        std::vector<std::string> errors(chunks);
+        #pragma omp parallel for
+        for (Size c=0; c<chunks; ++c) {
+            // exceptions must not escape the parallel region
+            try {
+                const Size end = std::min(n, (c+1)*detail::lsmChunkSize);
+                for (Size j=c*detail::lsmChunkSize; j<end; ++j) {
+                    exercise[j] = (*pathPricer_)(paths_[j], i);
+                    state[j] = pathPricer_->state(paths_[j], i);
+                }
+            } catch (std::exception& e) {
+                errors[c] = e.what();
+            } catch (...) {
+                errors[c] = "unknown error";
+            }
         }
+        detail::checkLsmErrors(errors);
+    }
+
+    template <class PathType> inline
+    Disposable<Array> LongstaffSchwartzPathPricer<PathType>::regression(
+                                            const std::vector<StateType>& x,
+                                            const std::vector<Real>& y,
+                                            Matrix& basis) const {
+        const Size n = x.size(), m = v_.size();
+        const Size chunks = (n+detail::lsmChunkSize-1)/detail::lsmChunkSize;
+        const bool normalEquations =
+            (regression_ == LsmCalibration::NormalEquations);
+
+        // basis values, and partial sums of the normal equations
+        basis = Matrix(n, m);
+        std::vector<Matrix> ata(normalEquations ? chunks : 0,
+                                Matrix(m, m, 0.0));
+        std::vector<Array> aty(normalEquations ? chunks : 0,
+                               Array(m, 0.0));
+        std::vector<std::string> errors(chunks);
+        #pragma omp parallel for
+        for (Size c=0; c<chunks; ++c) {
+            // exceptions must not escape the parallel region
+            try {
+                const Size end = std::min(n, (c+1)*detail::lsmChunkSize);
+                for (Size j=c*detail::lsmChunkSize; j<end; ++j) {
+                    Real* b = basis[j];
+                    for (Size l=0; l<m; ++l)
+                        b[l] = v_[l](x[j]);
+                    if (normalEquations) {
+                        for (Size k=0; k<m; ++k) {
+                            for (Size l=0; l<=k; ++l)
+                                ata[c][k][l] += b[k]*b[l];
+                            aty[c][k] += b[k]*y[j];
+                        }
+                    }
+                }
+            } catch (std::exception& e) {
+                errors[c] = e.what();
+            } catch (...) {
+                errors[c] = "unknown error";
+            }
+        }
+        detail::checkLsmErrors(errors);
+
+        Array coefficients;
+        switch (regression_) {
+          case LsmCalibration::SVD: {
+              // the same pseudo-inverse as GeneralLinearLeastSquares,
+              // applied to the basis values computed above
+              QL_REQUIRE(n >= m, "sample set is too small");
+              const SVD svd(basis);
+              const Matrix& U = svd.U();
+              const Matrix& V = svd.V();
+              const Array& w = svd.singularValues();
+              const Real threshold = n*QL_EPSILON*w[0];
+              coefficients = Array(m, 0.0);
+              for (Size i=0; i<m; ++i) {
+                  if (w[i] > threshold) {
+                      const Real u = std::inner_product(U.column_begin(i),
+                                                        U.column_end(i),
+                                                        y.begin(), 0.0)/w[i];
+                      for (Size j=0; j<m; ++j)
+                          coefficients[j] += u*V[j][i];
+                  }
+              }
+              break;
+          }
+          case LsmCalibration::QR:
+            coefficients = qrSolve(basis, Array(y.begin(), y.end()));
+            break;
+          case LsmCalibration::NormalEquations: {
+              // partial sums are added in a fixed order, so that the
+              // results don't depend on the number of threads
+              Matrix a(m, m, 0.0);
+              Array b(m, 0.0);
+              for (Size c=0; c<chunks; ++c) {
+                  a += ata[c];
+                  b += aty[c];
+              }
+              for (Size k=0; k<m; ++k)
+                  for (Size l=0; l<k; ++l)
+                      a[l][k] = a[k][l];
+              // the pseudo-inverse copes with degenerate bases
+              coefficients = SVD(a).solveFor(b);
+              break;
+          }
+          default:
+            QL_FAIL("unknown regression type");
+        }
+        return coefficients;
+    }
+
+    template <class PathType> inline
+    void LongstaffSchwartzPathPricer<PathType>::calibrate() {
+        const Size n = calibrationSamples();
+        Array prices(n);
+        std::vector<StateType> p_state;
+        std::vector<Real> p_price(n), p_exercise;
+
+        calibrationValues(len_-1, p_exercise, p_state);
+        for (Size j=0; j<n; ++j)
+            prices[j] = p_price[j] = p_exercise[j];
 
         post_processing(len_ - 1, p_state, p_price, p_exercise);
 
         std::vector<Real>      y;
         std::vector<StateType> x;
+        std::vector<Size>      itm;
+        Matrix basis;
         for (Size i=len_-2; i>0; --i) {
+            calibrationValues(i, p_exercise, p_state);
+
             y.clear();
             x.clear();
-
-            //roll back step
+            itm.clear();
             for (Size j=0; j<n; ++j) {
-                exercise[j]=(*pathPricer_)(paths_[j], i);
-                if (exercise[j]>0.0) {
-                    x.push_back(pathPricer_->state(paths_[j], i));
+                if (p_exercise[j]>0.0) {
+                    itm.push_back(j);
+                    x.push_back(p_state[j]);
                     y.push_back(dF_[i]*prices[j]);
                 }
             }
 
             if (v_.size() <=  x.size()) {
-                coeff_[i-1] = GeneralLinearLeastSquares(x, y, v_).coefficients();
+                coeff_[i-1] = regression(x, y, basis);
             }
             else {
             // if number of itm paths is smaller then the number of
             // calibration functions then early exercise if exerciseValue > 0
                 coeff_[i-1] = Array(v_.size(), 0.0);
+                basis = Matrix(x.size(), v_.size(), 0.0);
             }
 
-            for (Size j=0, k=0; j<n; ++j) {
-                prices[j]*=dF_[i];
-                if (exercise[j]>0.0) {
-                    Real continuationValue = 0.0;
-                    for (Size l=0; l<v_.size(); ++l) {
-                        continuationValue += coeff_[i-1][l] * v_[l](x[k]);
-                    }
-                    if (continuationValue < exercise[j]) {
-                        prices[j] = exercise[j];
-                    }
-                    ++k;
+            //roll back step
+            prices *= dF_[i];
+            const Array& coeff = coeff_[i-1];
+            #pragma omp parallel for
+            for (Size k=0; k<itm.size(); ++k) {
+                const Real continuationValue =
+                    std::inner_product(coeff.begin(), coeff.end(),
+                                       basis.row_begin(k), 0.0);
+                const Size j = itm[k];
+                if (continuationValue < p_exercise[j]) {
+                    prices[j] = p_exercise[j];
                 }
-                p_state[j] = pathPricer_->state(paths_[j],i);
-                p_price[j] = prices[j];
-                p_exercise[j] = exercise[j];
             }
+            std::copy(prices.begin(), prices.end(), p_price.begin());
 
             post_processing(i, p_state, p_price, p_exercise);
         }
@@ -217,6 +452,8 @@ namespace QuantLib {
         // remove calibration paths and release memory
         std::vector<PathType> empty;
         paths_.swap(empty);
+        std::vector<std::vector<Real> >().swap(exercises_);
+        std::vector<std::vector<StateType> >().swap(states_);
         // entering the calculation phase
         calibrationPhase_ = false;
     }
@@ -226,6 +463,23 @@ namespace QuantLib {
         return exerciseProbability_.mean();
     }
 
+    template <class PathType> inline
+    boost::shared_ptr<LongstaffSchwartzPathPricer<PathType> >
+    LongstaffSchwartzPathPricer<PathType>::clone() const {
+        QL_REQUIRE(!calibrationPhase_,
+                   "Longstaff-Schwartz path pricer not calibrated");
+        boost::shared_ptr<LongstaffSchwartzPathPricer> copy(
+                                    new LongstaffSchwartzPathPricer(*this));
+        copy->exerciseProbability_.reset();
+        return copy;
+    }
+
+    template <class PathType> inline
+    void LongstaffSchwartzPathPricer<PathType>::mergeExerciseProbability(
+                                 const LongstaffSchwartzPathPricer& other) {
+        exerciseProbability_.merge(other.exerciseProbability_);
+    }
+
 
 }
 
@@ -27,7 +27,12 @@
 
 #include <ql/methods/montecarlo/mctraits.hpp>
 #include <ql/math/statistics/statistics.hpp>
+#include <ql/math/statistics/sequencestatistics.hpp>
+#include <ql/math/matrixutilities/svd.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <vector>
+#include <string>
 
 namespace QuantLib {
 
@@ -45,6 +50,12 @@ namespace QuantLib {
         provide the additional control option, namely the option path
         pricer and the option value.
 
+        Any number of further control variates can be added by
+        setControlVariates(); instead of subtracting their deviations
+        from their expectations as they are, the model multiplies
+        them by coefficients estimated on a pilot run so as to
+        minimize the variance of the samples.
+
         \ingroup mcarlo
     */
     template <template <class> class MC, class RNG, class S = Statistics>
@@ -57,7 +68,7 @@ namespace QuantLib {
         typedef typename path_generator_type::sample_type sample_type;
         typedef typename path_pricer_type::result_type result_type;
         typedef S stats_type;
-        // constructor
+        // constructors
         MonteCarloModel(
                   const boost::shared_ptr<path_generator_type>& pathGenerator,
                   const boost::shared_ptr<path_pricer_type>& pathPricer,
@@ -68,64 +79,336 @@ namespace QuantLib {
                   result_type cvOptionValue = result_type(),
                   const boost::shared_ptr<path_generator_type>& cvPathGenerator
                         = boost::shared_ptr<path_generator_type>())
-        : pathGenerator_(pathGenerator), pathPricer_(pathPricer),
+        : pathGenerators_(1, pathGenerator), pathPricers_(1, pathPricer),
           sampleAccumulator_(sampleAccumulator),
           isAntitheticVariate_(antitheticVariate),
-          cvPathPricer_(cvPathPricer), cvOptionValue_(cvOptionValue),
-          cvPathGenerator_(cvPathGenerator) {
-            if (!cvPathPricer_)
+          cvPathPricers_(1, cvPathPricer), cvOptionValue_(cvOptionValue),
+          cvPathGenerators_(1, cvPathGenerator) {
+            if (!cvPathPricer)
                 isControlVariate_ = false;
             else
                 isControlVariate_ = true;
         }
+        /*! Parallel mode: the samples requested by addSamples() are
+            split evenly among the workers, each one drawing paths
+            from its own generator and pricing them with its own
+            pricer.  Generators must produce independent streams;
+            pricers and control-variate pricers may be shared only
+            if they are reentrant.
+
+            Each worker adds its samples to an accumulator of its
+            own, default-constructed from the statistics type; these
+            are merged into the main accumulator in worker order by
+            means of its merge() method, so that the outcome is
+            reproducible for a given set of generators regardless of
+            thread scheduling.
+            Worker loops are run in parallel when OpenMP is enabled.
+            When the random-number traits set workerErrorEstimate,
+            the statistics of the samples drawn by each worker are
+            also kept separately, so that the error of randomized
+            quasi-Monte Carlo simulations can be estimated from the
+            spread of the worker means.
+        */
+        MonteCarloModel(
+            const std::vector<boost::shared_ptr<path_generator_type> >&
+                                                             pathGenerators,
+            const std::vector<boost::shared_ptr<path_pricer_type> >&
+                                                             pathPricers,
+            const stats_type& sampleAccumulator,
+            bool antitheticVariate,
+            const std::vector<boost::shared_ptr<path_pricer_type> >&
+                cvPathPricers =
+                    std::vector<boost::shared_ptr<path_pricer_type> >(),
+            result_type cvOptionValue = result_type(),
+            const std::vector<boost::shared_ptr<path_generator_type> >&
+                cvPathGenerators =
+                    std::vector<boost::shared_ptr<path_generator_type> >())
+        : pathGenerators_(pathGenerators), pathPricers_(pathPricers),
+          sampleAccumulator_(sampleAccumulator),
+          isAntitheticVariate_(antitheticVariate),
+          cvPathPricers_(cvPathPricers), cvOptionValue_(cvOptionValue),
+          cvPathGenerators_(cvPathGenerators) {
+            Size n = pathGenerators_.size();
+            QL_REQUIRE(n > 0, "no path generators given");
+            if (WorkerErrorEstimate<RNG>::value && n > 1)
+                workerAccumulators_.resize(n);
+            QL_REQUIRE(pathPricers_.size() == n,
+                       "number of path pricers (" << pathPricers_.size()
+                       << ") different from number of path generators ("
+                       << n << ")");
+            isControlVariate_ = !cvPathPricers_.empty();
+            if (isControlVariate_) {
+                QL_REQUIRE(cvPathPricers_.size() == n,
+                           "number of control-variate path pricers ("
+                           << cvPathPricers_.size()
+                           << ") different from number of path generators ("
+                           << n << ")");
+            }
+            if (cvPathGenerators_.empty())
+                cvPathGenerators_.resize(n);
+            QL_REQUIRE(cvPathGenerators_.size() == n,
+                       "number of control-variate path generators ("
+                       << cvPathGenerators_.size()
+                       << ") different from number of path generators ("
+                       << n << ")");
+        }
         void addSamples(Size samples);
         const stats_type& sampleAccumulator(void) const;
+        //! number of workers among which samples are split
+        Size workers() const { return pathGenerators_.size(); }
+        /*! statistics of the samples drawn by the i-th worker; they
+            are only kept when the random-number traits set
+            workerErrorEstimate.
+        */
+        const stats_type& workerAccumulator(Size i) const {
+            QL_REQUIRE(WorkerErrorEstimate<RNG>::value,
+                       "worker statistics not kept for these "
+                       "random-number traits");
+            QL_REQUIRE(i < workers(), "worker " << i << " out of range");
+            // a single worker draws all the samples
+            if (workers() == 1)
+                return sampleAccumulator_;
+            return workerAccumulators_[i];
+        }
+        //! \name Control variates with estimated coefficients
+        //@{
+        /*! The given path pricers, whose expectations are known,
+            are evaluated on the same paths as the main pricer (and
+            on their antithetic paths, if any); each sample \f$ y \f$
+            is then replaced by
+            \f[ y - \sum_k \beta_k (c_k - \mathrm{E}[c_k]). \f]
+            The coefficients \f$ \beta_k \f$ are null until
+            calibrateControlVariates() is called.  In parallel mode,
+            the pricers are shared among workers and must be
+            reentrant.
+
+            \pre no samples must have been added yet.
+        */
+        void setControlVariates(
+              const std::vector<boost::shared_ptr<path_pricer_type> >& pricers,
+              const std::vector<result_type>& expectations);
+        /*! Draws the given number of pilot samples and sets the
+            coefficients to those minimizing the variance of the
+            corrected samples, i.e., to the coefficients of the
+            least-squares regression of the price on the control
+            variates.  The regression goes through the pseudo-inverse
+            of their covariance, so that collinear control variates
+            (e.g., the same one added twice) share their coefficient
+            instead of making the system singular.
+
+            Pilot samples are drawn by the first worker in addition
+            to those added later, and are discarded: had they been
+            added to the accumulator, the coefficients would depend
+            on the samples they correct and bias the estimate.  The
+            following samples give an unbiased estimate, whose error
+            estimate is the standard error of the controlled
+            estimator.
+
+            \pre no samples must have been added yet.
+            \pre the path pricers must return scalar results.
+        */
+        void calibrateControlVariates(Size pilotSamples) {
+            calibrateControlVariates(pilotSamples,
+                                     boost::is_arithmetic<result_type>());
+        }
+        const std::vector<Real>& controlVariateCoefficients() const {
+            return controlCoefficients_;
+        }
+        //@}
       private:
-        boost::shared_ptr<path_generator_type> pathGenerator_;
-        boost::shared_ptr<path_pricer_type> pathPricer_;
+        void calibrateControlVariates(Size pilotSamples,
+                                      const boost::true_type&);
+        void calibrateControlVariates(Size,
+                                      const boost::false_type&) {
+            QL_FAIL("control variates with estimated coefficients "
+                    "require scalar results");
+        }
+        void nextSample(Size worker, result_type& price, Real& weight,
+                        std::vector<result_type>& controls) const;
+        result_type controlled(result_type price,
+                               const std::vector<result_type>& controls) const;
+        std::vector<boost::shared_ptr<path_generator_type> > pathGenerators_;
+        std::vector<boost::shared_ptr<path_pricer_type> > pathPricers_;
         stats_type sampleAccumulator_;
         bool isAntitheticVariate_;
-        boost::shared_ptr<path_pricer_type> cvPathPricer_;
+        std::vector<boost::shared_ptr<path_pricer_type> > cvPathPricers_;
         result_type cvOptionValue_;
         bool isControlVariate_;
-        boost::shared_ptr<path_generator_type> cvPathGenerator_;
+        std::vector<boost::shared_ptr<path_generator_type> > cvPathGenerators_;
+        std::vector<boost::shared_ptr<path_pricer_type> > controlPricers_;
+        std::vector<result_type> controlValues_;
+        std::vector<Real> controlCoefficients_;
+        std::vector<stats_type> workerAccumulators_;
     };
 
     // inline definitions
     template <template <class> class MC, class RNG, class S>
-    inline void MonteCarloModel<MC,RNG,S>::addSamples(Size samples) {
-        for(Size j = 1; j <= samples; j++) {
+    inline void MonteCarloModel<MC,RNG,S>::nextSample(Size w,
+                                                      result_type& price,
+                                                      Real& weight,
+                                  std::vector<result_type>& controls) const {
+        const path_generator_type& pathGenerator = *pathGenerators_[w];
+        const path_pricer_type& pathPricer = *pathPricers_[w];
+        const boost::shared_ptr<path_generator_type>& cvPathGenerator =
+            cvPathGenerators_[w];
 
-            const sample_type& path = pathGenerator_->next();
-            result_type price = (*pathPricer_)(path.value);
+        const sample_type& path = pathGenerator.next();
+        price = pathPricer(path.value);
+        for (Size k=0; k<controlPricers_.size(); ++k)
+            controls[k] = (*controlPricers_[k])(path.value);
+
+        if (isControlVariate_) {
+            const path_pricer_type& cvPathPricer = *cvPathPricers_[w];
+            if (!cvPathGenerator) {
+                price += cvOptionValue_-cvPathPricer(path.value);
+            }
+            else {
+                const sample_type& cvPath = cvPathGenerator->next();
+                price += cvOptionValue_-cvPathPricer(cvPath.value);
+            }
+        }
 
+        if (isAntitheticVariate_) {
+            const sample_type& atPath = pathGenerator.antithetic();
+            result_type price2 = pathPricer(atPath.value);
             if (isControlVariate_) {
-                if (!cvPathGenerator_) {
-                    price += cvOptionValue_-(*cvPathPricer_)(path.value);
-                }
+                const path_pricer_type& cvPathPricer = *cvPathPricers_[w];
+                if (!cvPathGenerator)
+                    price2 += cvOptionValue_-cvPathPricer(atPath.value);
                 else {
-                    const sample_type& cvPath = cvPathGenerator_->next();
-                    price += cvOptionValue_-(*cvPathPricer_)(cvPath.value);
+                    const sample_type& cvPath = cvPathGenerator->antithetic();
+                    price2 += cvOptionValue_-cvPathPricer(cvPath.value);
                 }
             }
 
-            if (isAntitheticVariate_) {
-                const sample_type& atPath = pathGenerator_->antithetic();
-                result_type price2 = (*pathPricer_)(atPath.value);
-                if (isControlVariate_) {
-                    if (!cvPathGenerator_)
-                        price2 += cvOptionValue_-(*cvPathPricer_)(atPath.value);
-                    else {
-                        const sample_type& cvPath = cvPathGenerator_->antithetic();
-                        price2 += cvOptionValue_-(*cvPathPricer_)(cvPath.value);
-                    }
-                }
+            price = (price+price2)/2.0;
+            for (Size k=0; k<controlPricers_.size(); ++k)
+                controls[k] =
+                    (controls[k] + (*controlPricers_[k])(atPath.value))/2.0;
+        }
+
+        weight = path.weight;
+    }
 
-                sampleAccumulator_.add((price+price2)/2.0, path.weight);
-            } else {
-                sampleAccumulator_.add(price, path.weight);
+    template <template <class> class MC, class RNG, class S>
+    inline typename MonteCarloModel<MC,RNG,S>::result_type
+    MonteCarloModel<MC,RNG,S>::controlled(
+                      result_type price,
+                      const std::vector<result_type>& controls) const {
+        for (Size k=0; k<controlCoefficients_.size(); ++k)
+            price -= controlCoefficients_[k]*(controls[k]-controlValues_[k]);
+        return price;
+    }
+
+    template <template <class> class MC, class RNG, class S>
+    inline void MonteCarloModel<MC,RNG,S>::addSamples(Size samples) {
+        const Size nWorkers = pathGenerators_.size();
+
+        if (nWorkers == 1) {
+            result_type price;
+            Real weight;
+            std::vector<result_type> controls(controlPricers_.size());
+            for(Size j = 1; j <= samples; j++) {
+                nextSample(0, price, weight, controls);
+                price = controlled(price, controls);
+                sampleAccumulator_.add(price, weight);
             }
+            return;
+        }
+
+        // each worker owns its accumulators, which are merged below
+        std::vector<stats_type> accumulators(nWorkers);
+        std::vector<std::string> errors(nWorkers);
+
+        #pragma omp parallel for schedule(static,1)
+        for (Size w=0; w<nWorkers; ++w) {
+            // exceptions must not escape the parallel region
+            try {
+                const Size n = samples/nWorkers +
+                               (w < samples%nWorkers ? 1 : 0);
+                result_type price;
+                Real weight;
+                std::vector<result_type> controls(controlPricers_.size());
+                for (Size j=0; j<n; ++j) {
+                    nextSample(w, price, weight, controls);
+                    price = controlled(price, controls);
+                    accumulators[w].add(price, weight);
+                }
+            } catch (std::exception& e) {
+                errors[w] = e.what();
+            } catch (...) {
+                errors[w] = "unknown error";
+            }
+        }
+
+        for (Size w=0; w<nWorkers; ++w)
+            QL_REQUIRE(errors[w].empty(),
+                       "worker " << w << " failed: " << errors[w]);
+
+        // merge in worker order to keep results reproducible
+        for (Size w=0; w<nWorkers; ++w) {
+            sampleAccumulator_.merge(accumulators[w]);
+            if (WorkerErrorEstimate<RNG>::value)
+                workerAccumulators_[w].merge(accumulators[w]);
+        }
+    }
+
+    template <template <class> class MC, class RNG, class S>
+    inline void MonteCarloModel<MC,RNG,S>::setControlVariates(
+              const std::vector<boost::shared_ptr<path_pricer_type> >& pricers,
+              const std::vector<result_type>& expectations) {
+        QL_REQUIRE(pricers.size() == expectations.size(),
+                   "number of control-variate path pricers ("
+                   << pricers.size()
+                   << ") different from number of expectations ("
+                   << expectations.size() << ")");
+        QL_REQUIRE(sampleAccumulator_.samples() == 0,
+                   "control variates must be set before adding samples");
+        for (Size k=0; k<pricers.size(); ++k)
+            QL_REQUIRE(pricers[k], "null control-variate path pricer");
+        controlPricers_ = pricers;
+        controlValues_ = expectations;
+        controlCoefficients_.clear();
+    }
+
+    template <template <class> class MC, class RNG, class S>
+    inline void MonteCarloModel<MC,RNG,S>::calibrateControlVariates(
+                                             Size pilotSamples,
+                                             const boost::true_type&) {
+        const Size n = controlPricers_.size();
+        QL_REQUIRE(n > 0, "no control variates given");
+        QL_REQUIRE(pilotSamples > n+1,
+                   "not enough pilot samples (" << pilotSamples
+                   << ") for " << n << " control variates");
+        QL_REQUIRE(sampleAccumulator_.samples() == 0,
+                   "control variates must be calibrated "
+                   "before adding samples");
+
+        // joint statistics of the price and of the control variates
+        SequenceStatisticsInc pilot(n+1);
+        std::vector<Real> sample(n+1);
+        result_type price;
+        Real weight;
+        std::vector<result_type> controls(n);
+        for (Size j=0; j<pilotSamples; ++j) {
+            nextSample(0, price, weight, controls);
+            sample[0] = price;
+            std::copy(controls.begin(), controls.end(), sample.begin()+1);
+            pilot.add(sample, weight);
+        }
+
+        // the coefficients solve the normal equations
+        // Cov(c,c) beta = Cov(c,y) in the least-squares sense
+        const Matrix covariance = pilot.covariance();
+        Matrix cc(n, n);
+        Array cy(n);
+        for (Size k=0; k<n; ++k) {
+            cy[k] = covariance[k+1][0];
+            for (Size l=0; l<n; ++l)
+                cc[k][l] = covariance[k+1][l+1];
         }
+        const Array beta = SVD(cc).solveFor(cy);
+        controlCoefficients_ = std::vector<Real>(beta.begin(), beta.end());
     }
 
     template <template <class> class MC, class RNG, class S>
@@ -0,0 +1,189 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file multilevelpathgenerator.hpp
+    \brief Generates pairs of fine and coarse paths for multi-level Monte Carlo
+*/
+
+#ifndef quantlib_montecarlo_multi_level_path_generator_hpp
+#define quantlib_montecarlo_multi_level_path_generator_hpp
+
+#include <ql/methods/montecarlo/path.hpp>
+#include <ql/methods/montecarlo/pathpricer.hpp>
+#include <ql/methods/montecarlo/sample.hpp>
+#include <ql/stochasticprocess.hpp>
+
+namespace QuantLib {
+
+    //! Fine and coarse paths driven by the same Brownian motion
+    /*! \ingroup mcarlo */
+    class CoupledPath {
+      public:
+        CoupledPath(const TimeGrid& fineGrid, const TimeGrid& coarseGrid)
+        : fine_(fineGrid), coarse_(coarseGrid) {}
+        //! \name read/write access to components
+        //@{
+        const Path& fine() const { return fine_; }
+        Path& fine() { return fine_; }
+        const Path& coarse() const { return coarse_; }
+        Path& coarse() { return coarse_; }
+        //@}
+      private:
+        Path fine_, coarse_;
+    };
+
+
+    //! Generates coupled fine and coarse paths
+    /*! The fine path is evolved over a uniform grid with the given
+        number of steps, the coarse one over a grid with a number of
+        steps dividing it; each coarse Brownian increment is the sum
+        of the fine increments over the same interval.  The
+        difference between a payoff on the fine path and the same
+        payoff on the coarse one has therefore a variance decreasing
+        with the step size, which is what multi-level Monte Carlo
+        relies upon.
+
+        Paths are evolved by means of StochasticProcess1D::evolve(),
+        and thus with the discretization of the process.
+
+        \ingroup mcarlo
+    */
+    template <class GSG>
+    class MultiLevelPathGenerator {
+      public:
+        typedef Sample<CoupledPath> sample_type;
+        MultiLevelPathGenerator(
+                          const boost::shared_ptr<StochasticProcess>&,
+                          Time length,
+                          Size fineSteps,
+                          Size coarseSteps,
+                          const GSG& generator);
+        //! \name inspectors
+        //@{
+        const sample_type& next() const;
+        const sample_type& antithetic() const;
+        Size size() const { return fineGrid_.size()-1; }
+        const TimeGrid& fineGrid() const { return fineGrid_; }
+        const TimeGrid& coarseGrid() const { return coarseGrid_; }
+        //@}
+      private:
+        const sample_type& next(bool antithetic) const;
+        GSG generator_;
+        TimeGrid fineGrid_, coarseGrid_;
+        Size ratio_;
+        boost::shared_ptr<StochasticProcess1D> process_;
+        mutable sample_type next_;
+    };
+
+
+    //! Prices the difference between fine and coarse paths
+    /*! The two pricers are usually the same payoff set up on the
+        fine and coarse time grids, respectively.
+
+        \ingroup mcarlo
+    */
+    class CoupledPathPricer : public PathPricer<CoupledPath> {
+      public:
+        CoupledPathPricer(
+                  const boost::shared_ptr<PathPricer<Path> >& finePricer,
+                  const boost::shared_ptr<PathPricer<Path> >& coarsePricer)
+        : finePricer_(finePricer), coarsePricer_(coarsePricer) {
+            QL_REQUIRE(finePricer_ && coarsePricer_, "null path pricer");
+        }
+        Real operator()(const CoupledPath& path) const {
+            return (*finePricer_)(path.fine())
+                 - (*coarsePricer_)(path.coarse());
+        }
+      private:
+        boost::shared_ptr<PathPricer<Path> > finePricer_, coarsePricer_;
+    };
+
+
+    // template definitions
+
+    template <class GSG>
+    MultiLevelPathGenerator<GSG>::MultiLevelPathGenerator(
+                          const boost::shared_ptr<StochasticProcess>& process,
+                          Time length,
+                          Size fineSteps,
+                          Size coarseSteps,
+                          const GSG& generator)
+    : generator_(generator), fineGrid_(length, fineSteps),
+      coarseGrid_(length, coarseSteps),
+      ratio_(coarseSteps > 0 ? fineSteps/coarseSteps : 0),
+      process_(boost::dynamic_pointer_cast<StochasticProcess1D>(process)),
+      next_(CoupledPath(fineGrid_, coarseGrid_), 1.0) {
+        QL_REQUIRE(process_, "one-dimensional process required");
+        QL_REQUIRE(coarseSteps > 0 && coarseSteps < fineSteps &&
+                   fineSteps % coarseSteps == 0,
+                   "coarse steps (" << coarseSteps
+                   << ") must be a proper divisor of fine steps ("
+                   << fineSteps << ")");
+        QL_REQUIRE(generator_.dimension() == fineSteps,
+                   "sequence generator dimensionality ("
+                   << generator_.dimension()
+                   << ") != fine steps (" << fineSteps << ")");
+    }
+
+    template <class GSG>
+    inline const typename MultiLevelPathGenerator<GSG>::sample_type&
+    MultiLevelPathGenerator<GSG>::next() const {
+        return next(false);
+    }
+
+    template <class GSG>
+    inline const typename MultiLevelPathGenerator<GSG>::sample_type&
+    MultiLevelPathGenerator<GSG>::antithetic() const {
+        return next(true);
+    }
+
+    template <class GSG>
+    const typename MultiLevelPathGenerator<GSG>::sample_type&
+    MultiLevelPathGenerator<GSG>::next(bool antithetic) const {
+
+        typedef typename GSG::sample_type sequence_type;
+        const sequence_type& sequence_ =
+            antithetic ? generator_.lastSequence()
+                       : generator_.nextSequence();
+        const std::vector<Real>& z = sequence_.value;
+
+        next_.weight = sequence_.weight;
+
+        Path& fine = next_.value.fine();
+        Path& coarse = next_.value.coarse();
+        fine.front() = coarse.front() = process_->x0();
+
+        const Real sign = antithetic ? -1.0 : 1.0;
+        const Real scale = sign/std::sqrt(Real(ratio_));
+        for (Size i=0; i<coarseGrid_.size()-1; ++i) {
+            Real dw = 0.0;
+            for (Size j=i*ratio_; j<(i+1)*ratio_; ++j) {
+                fine[j+1] = process_->evolve(fineGrid_[j], fine[j],
+                                             fineGrid_.dt(j), sign*z[j]);
+                dw += z[j];
+            }
+            coarse[i+1] = process_->evolve(coarseGrid_[i], coarse[i],
+                                           coarseGrid_.dt(i), scale*dw);
+        }
+
+        return next_;
+    }
+
+}
+
+
+#endif
@@ -27,6 +27,7 @@
 #ifndef quantlib_multi_path_generator_hpp
 #define quantlib_multi_path_generator_hpp
 
+#include <ql/methods/montecarlo/brownianbridge.hpp>
 #include <ql/methods/montecarlo/multipath.hpp>
 #include <ql/methods/montecarlo/sample.hpp>
 #include <ql/stochasticprocess.hpp>
@@ -42,6 +43,18 @@ namespace QuantLib {
         };
         \endcode
 
+        When the Brownian bridge is used, each factor is bridged
+        separately over the time grid; the first variates of each
+        sequence, one per factor, determine the final values of the
+        Brownian motions, the following ones the values at the
+        bridge points in order of construction.
+
+        Paths can also be generated in batches by means of the
+        nextBatch() method, which stores them as one contiguous
+        [time points x paths] block per asset; the evolution of the
+        whole batch over each time step is delegated to
+        StochasticProcess::evolveBatch().
+
         \ingroup mcarlo
 
         \test the generated paths are checked against cached results
@@ -50,18 +63,40 @@ namespace QuantLib {
     class MultiPathGenerator {
       public:
         typedef Sample<MultiPath> sample_type;
+        typedef std::vector<Matrix> batch_type;
         MultiPathGenerator(const boost::shared_ptr<StochasticProcess>&,
                            const TimeGrid&,
                            GSG generator,
                            bool brownianBridge = false);
         const sample_type& next() const;
         const sample_type& antithetic() const;
+        //! \name batch generation
+        //@{
+        /*! fills the given blocks, one per asset, each one sized as
+            [time points x paths], and the weights vector with the
+            corresponding weights.  The blocks must all have the same
+            number of columns. */
+        void nextBatch(batch_type& paths, std::vector<Real>& weights) const;
+        /*! fills the given blocks with the paths antithetic to the
+            ones returned by the last call to nextBatch(). */
+        void antitheticBatch(batch_type& paths,
+                             std::vector<Real>& weights) const;
+        //@}
       private:
         const sample_type& next(bool antithetic) const;
+        void nextBatch(batch_type& paths, std::vector<Real>& weights,
+                       bool antithetic) const;
         bool brownianBridge_;
         boost::shared_ptr<StochasticProcess> process_;
         GSG generator_;
         mutable sample_type next_;
+        BrownianBridge bb_;
+        mutable Array temp_, bridgeInput_, bridgeOutput_;
+        // batch buffers: [(time steps * factors) x paths] variates,
+        // bridged if required, and their weights
+        mutable Matrix batchVariates_, batchTemp_;
+        mutable Matrix batchBridgeInput_, batchBridgeOutput_;
+        mutable std::vector<Real> batchWeights_;
     };
 
 
@@ -74,7 +109,8 @@ namespace QuantLib {
                    GSG generator,
                    bool brownianBridge)
     : brownianBridge_(brownianBridge), process_(process),
-      generator_(generator), next_(MultiPath(process->size(), times), 1.0) {
+      generator_(generator), next_(MultiPath(process->size(), times), 1.0),
+      bb_(times) {
 
         QL_REQUIRE(generator_.dimension() ==
                    process->factors()*(times.size()-1),
@@ -85,6 +121,12 @@ namespace QuantLib {
                    << "times the number of time steps");
         QL_REQUIRE(times.size() > 1,
                    "no times given");
+
+        temp_ = Array(generator_.dimension());
+        if (brownianBridge_) {
+            bridgeInput_ = Array(times.size()-1);
+            bridgeOutput_ = Array(times.size()-1);
+        }
     }
 
     template <class GSG>
@@ -103,50 +145,167 @@ namespace QuantLib {
     const typename MultiPathGenerator<GSG>::sample_type&
     MultiPathGenerator<GSG>::next(bool antithetic) const {
 
+        typedef typename GSG::sample_type sequence_type;
+        const sequence_type& sequence_ =
+            antithetic ? generator_.lastSequence()
+                       : generator_.nextSequence();
+
+        Size m = process_->size();
+        Size n = process_->factors();
+
+        MultiPath& path = next_.value;
+        const Size steps = path.pathSize()-1;
+
         if (brownianBridge_) {
+            // the variates for the k-th bridge point of the l-th
+            // factor are at k*n+l, and so are the resulting variations
+            for (Size l=0; l<n; ++l) {
+                for (Size k=0; k<steps; ++k)
+                    bridgeInput_[k] = sequence_.value[k*n+l];
+                bb_.transform(bridgeInput_.begin(), bridgeInput_.end(),
+                              bridgeOutput_.begin());
+                for (Size k=0; k<steps; ++k)
+                    temp_[k*n+l] = bridgeOutput_[k];
+            }
+        } else {
+            std::copy(sequence_.value.begin(), sequence_.value.end(),
+                      temp_.begin());
+        }
+        if (antithetic)
+            std::transform(temp_.begin(), temp_.end(), temp_.begin(),
+                           std::negate<Real>());
+
+        Array asset = process_->initialValues();
+        for (Size j=0; j<m; j++)
+            path[j].front() = asset[j];
+
+        Array dw(n);
+        next_.weight = sequence_.weight;
+
+        const TimeGrid& timeGrid = path[0].timeGrid();
+        Time t, dt;
+        for (Size i = 1; i < path.pathSize(); i++) {
+            Size offset = (i-1)*n;
+            t = timeGrid[i-1];
+            dt = timeGrid.dt(i-1);
+            std::copy(temp_.begin()+offset, temp_.begin()+offset+n,
+                      dw.begin());
+
+            asset = process_->evolve(t, asset, dt, dw);
+            for (Size j=0; j<m; j++)
+                path[j][i] = asset[j];
+        }
+        return next_;
+    }
+
+    template <class GSG>
+    inline void MultiPathGenerator<GSG>::nextBatch(
+                                        batch_type& paths,
+                                        std::vector<Real>& weights) const {
+        nextBatch(paths, weights, false);
+    }
+
+    template <class GSG>
+    inline void MultiPathGenerator<GSG>::antitheticBatch(
+                                        batch_type& paths,
+                                        std::vector<Real>& weights) const {
+        nextBatch(paths, weights, true);
+    }
+
+    template <class GSG>
+    void MultiPathGenerator<GSG>::nextBatch(batch_type& paths,
+                                            std::vector<Real>& weights,
+                                            bool antithetic) const {
 
-            QL_FAIL("Brownian bridge not supported");
+        const Size m = process_->size();
+        const Size n = process_->factors();
+        const TimeGrid& timeGrid = next_.value[0].timeGrid();
+        const Size steps = timeGrid.size()-1;
+        const Size dimension = n*steps;
 
+        QL_REQUIRE(paths.size() == m,
+                   "number of batch blocks (" << paths.size()
+                   << ") != number of assets (" << m << ")");
+        const Size nPaths = paths[0].columns();
+        QL_REQUIRE(nPaths > 0, "empty batch");
+        for (Size k=0; k<m; ++k)
+            QL_REQUIRE(paths[k].rows() == timeGrid.size() &&
+                       paths[k].columns() == nPaths,
+                       "batch block " << k << " is "
+                       << paths[k].rows() << "x" << paths[k].columns()
+                       << ", " << timeGrid.size() << "x" << nPaths
+                       << " required");
+
+        if (antithetic) {
+            QL_REQUIRE(batchVariates_.columns() == nPaths &&
+                       batchVariates_.rows() == dimension,
+                       "batch size (" << nPaths << ") different from "
+                       "the one of the last generated batch ("
+                       << batchVariates_.columns() << ")");
         } else {
+            if (batchVariates_.columns() != nPaths ||
+                batchVariates_.rows() != dimension) {
+                batchVariates_ = Matrix(dimension, nPaths);
+                batchTemp_ = Matrix(n, nPaths);
+                batchWeights_.resize(nPaths);
+                if (brownianBridge_)
+                    batchBridgeInput_ = Matrix(steps, nPaths);
+            }
 
             typedef typename GSG::sample_type sequence_type;
-            const sequence_type& sequence_ =
-                antithetic ? generator_.lastSequence()
-                           : generator_.nextSequence();
+            for (Size j=0; j<nPaths; ++j) {
+                const sequence_type& sequence_ = generator_.nextSequence();
+                for (Size i=0; i<dimension; ++i)
+                    batchVariates_[i][j] = sequence_.value[i];
+                batchWeights_[j] = sequence_.weight;
+            }
+
+            if (brownianBridge_) {
+                // each factor is bridged over the whole batch, with
+                // the same layout as in next()
+                for (Size l=0; l<n; ++l) {
+                    for (Size k=0; k<steps; ++k)
+                        std::copy(batchVariates_.row_begin(k*n+l),
+                                  batchVariates_.row_end(k*n+l),
+                                  batchBridgeInput_.row_begin(k));
+                    bb_.transform(batchBridgeInput_, batchBridgeOutput_);
+                    for (Size k=0; k<steps; ++k)
+                        std::copy(batchBridgeOutput_.row_begin(k),
+                                  batchBridgeOutput_.row_end(k),
+                                  batchVariates_.row_begin(k*n+l));
+                }
+            }
+        }
 
-            Size m = process_->size();
-            Size n = process_->factors();
+        weights.resize(nPaths);
+        std::copy(batchWeights_.begin(), batchWeights_.end(),
+                  weights.begin());
 
-            MultiPath& path = next_.value;
+        Array asset = process_->initialValues();
+        for (Size k=0; k<m; ++k)
+            std::fill(paths[k].row_begin(0), paths[k].row_end(0), asset[k]);
 
-            Array asset = process_->initialValues();
-            for (Size j=0; j<m; j++)
-                path[j].front() = asset[j];
-
-            Array temp(n);
-            next_.weight = sequence_.weight;
-
-            const TimeGrid& timeGrid = path[0].timeGrid();
-            Time t, dt;
-            for (Size i = 1; i < path.pathSize(); i++) {
-                Size offset = (i-1)*n;
-                t = timeGrid[i-1];
-                dt = timeGrid.dt(i-1);
-                if (antithetic)
-                    std::transform(sequence_.value.begin()+offset,
-                                   sequence_.value.begin()+offset+n,
-                                   temp.begin(),
+        std::vector<const Real*> x0(m), dw(n);
+        std::vector<Real*> x(m);
+        for (Size i=1; i<timeGrid.size(); ++i) {
+            const Size offset = (i-1)*n;
+            for (Size l=0; l<n; ++l) {
+                if (antithetic) {
+                    std::transform(batchVariates_.row_begin(offset+l),
+                                   batchVariates_.row_end(offset+l),
+                                   batchTemp_.row_begin(l),
                                    std::negate<Real>());
-                else
-                    std::copy(sequence_.value.begin()+offset,
-                              sequence_.value.begin()+offset+n,
-                              temp.begin());
-
-                asset = process_->evolve(t, asset, dt, temp);
-                for (Size j=0; j<m; j++)
-                    path[j][i] = asset[j];
+                    dw[l] = batchTemp_.row_begin(l);
+                } else {
+                    dw[l] = batchVariates_.row_begin(offset+l);
+                }
+            }
+            for (Size k=0; k<m; ++k) {
+                x0[k] = paths[k].row_begin(i-1);
+                x[k] = paths[k].row_begin(i);
             }
-            return next_;
+            process_->evolveBatch(timeGrid[i-1], x0, timeGrid.dt(i-1),
+                                  dw, x, nPaths);
         }
     }
 
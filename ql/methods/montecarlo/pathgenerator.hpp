@@ -38,12 +38,21 @@ namespace QuantLib {
 
         \ingroup mcarlo
 
+        Paths can also be generated in batches by means of the
+        nextBatch() method, which stores them in a contiguous
+        [time points x paths] block; the values of all paths at a
+        given time are thus adjacent in memory, and the evolution of
+        the whole batch over each time step is delegated to
+        StochasticProcess1D::evolveBatch().  Buffers are reused
+        across calls as long as the batch size is unchanged.
+
         \test the generated paths are checked against cached results
     */
     template <class GSG>
     class PathGenerator {
       public:
         typedef Sample<Path> sample_type;
+        typedef Matrix batch_type;
         // constructors
         PathGenerator(const boost::shared_ptr<StochasticProcess>&,
                       Time length,
@@ -61,8 +70,21 @@ namespace QuantLib {
         Size size() const { return dimension_; }
         const TimeGrid& timeGrid() const { return timeGrid_; }
         //@}
+        //! \name batch generation
+        //@{
+        /*! fills the given [time points x paths] matrix with as many
+            paths as its columns, and the weights vector with the
+            corresponding weights. */
+        void nextBatch(batch_type& paths, std::vector<Real>& weights) const;
+        /*! fills the given matrix with the paths antithetic to the
+            ones returned by the last call to nextBatch(). */
+        void antitheticBatch(batch_type& paths,
+                             std::vector<Real>& weights) const;
+        //@}
       private:
         const sample_type& next(bool antithetic) const;
+        void nextBatch(batch_type& paths, std::vector<Real>& weights,
+                       bool antithetic) const;
         bool brownianBridge_;
         GSG generator_;
         Size dimension_;
@@ -71,6 +93,9 @@ namespace QuantLib {
         mutable sample_type next_;
         mutable std::vector<Real> temp_;
         BrownianBridge bb_;
+        // batch buffers: [time steps x paths] variates and their weights
+        mutable Matrix batchVariates_, batchBridgeInput_;
+        mutable std::vector<Real> batchWeights_, batchTemp_;
     };
 
 
@@ -154,6 +179,82 @@ namespace QuantLib {
         return next_;
     }
 
+    template <class GSG>
+    inline void PathGenerator<GSG>::nextBatch(
+                                        batch_type& paths,
+                                        std::vector<Real>& weights) const {
+        nextBatch(paths, weights, false);
+    }
+
+    template <class GSG>
+    inline void PathGenerator<GSG>::antitheticBatch(
+                                        batch_type& paths,
+                                        std::vector<Real>& weights) const {
+        nextBatch(paths, weights, true);
+    }
+
+    template <class GSG>
+    void PathGenerator<GSG>::nextBatch(batch_type& paths,
+                                       std::vector<Real>& weights,
+                                       bool antithetic) const {
+
+        const Size nPaths = paths.columns();
+        QL_REQUIRE(nPaths > 0, "empty batch");
+        QL_REQUIRE(paths.rows() == timeGrid_.size(),
+                   "batch rows (" << paths.rows()
+                   << ") != time points (" << timeGrid_.size() << ")");
+
+        if (antithetic) {
+            QL_REQUIRE(batchVariates_.columns() == nPaths &&
+                       batchVariates_.rows() == dimension_,
+                       "batch size (" << nPaths << ") different from "
+                       "the one of the last generated batch ("
+                       << batchVariates_.columns() << ")");
+        } else {
+            if (batchVariates_.columns() != nPaths ||
+                batchVariates_.rows() != dimension_) {
+                batchVariates_ = Matrix(dimension_, nPaths);
+                batchWeights_.resize(nPaths);
+                batchTemp_.resize(nPaths);
+                if (brownianBridge_)
+                    batchBridgeInput_ = Matrix(dimension_, nPaths);
+            }
+
+            // with the Brownian bridge, the sequences are bridged
+            // over the whole batch at once
+            Matrix& variates =
+                brownianBridge_ ? batchBridgeInput_ : batchVariates_;
+            typedef typename GSG::sample_type sequence_type;
+            for (Size j=0; j<nPaths; ++j) {
+                const sequence_type& sequence_ = generator_.nextSequence();
+                for (Size i=0; i<dimension_; ++i)
+                    variates[i][j] = sequence_.value[i];
+                batchWeights_[j] = sequence_.weight;
+            }
+            if (brownianBridge_)
+                bb_.transform(batchBridgeInput_, batchVariates_);
+        }
+
+        weights.resize(nPaths);
+        std::copy(batchWeights_.begin(), batchWeights_.end(),
+                  weights.begin());
+
+        std::fill(paths.row_begin(0), paths.row_end(0), process_->x0());
+
+        for (Size i=1; i<timeGrid_.size(); ++i) {
+            Time t = timeGrid_[i-1];
+            Time dt = timeGrid_.dt(i-1);
+            const Real* dw = batchVariates_.row_begin(i-1);
+            if (antithetic) {
+                std::transform(dw, dw+nPaths, batchTemp_.begin(),
+                               std::negate<Real>());
+                dw = &batchTemp_[0];
+            }
+            process_->evolveBatch(t, paths.row_begin(i-1), dt, dw,
+                                  paths.row_begin(i), nPaths);
+        }
+    }
+
 }
 
 
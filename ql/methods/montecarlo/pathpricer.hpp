@@ -28,6 +28,7 @@
 #include <ql/option.hpp>
 #include <ql/types.hpp>
 #include <functional>
+#include <vector>
 
 namespace QuantLib {
 
@@ -43,6 +44,22 @@ namespace QuantLib {
         virtual ValueType operator()(const PathType& path) const=0;
     };
 
+    //! base class for path-batch pricers
+    /*! Returns the values of an option on a batch of paths, as
+        generated by PathGenerator::nextBatch() or
+        MultiPathGenerator::nextBatch().  The number of paths in the
+        batch is given by the size of the passed vector.
+
+        \ingroup mcarlo
+    */
+    template<class BatchType, class ValueType=Real>
+    class BatchPathPricer {
+      public:
+        virtual ~BatchPathPricer() {}
+        virtual void operator()(const BatchType& paths,
+                                std::vector<ValueType>& values) const=0;
+    };
+
 }
 
 
@@ -240,28 +240,25 @@ namespace QuantLib {
         QL_REQUIRE(   (variates.size() == factors_*steps_),
                    "inconsistent variate vector");
 
-        const Size dim    = factors_*steps_;
         const Size nPaths = variates.front().size();
-        
-        std::vector<std::vector<Real> > 
+
+        std::vector<std::vector<Real> >
                        retVal(factors_, std::vector<Real>(nPaths*steps_));
-        
-        for (Size j=0; j < nPaths; ++j) {
-            std::vector<Real> sample(steps_*factors_);
-            for (Size k=0; k < dim; ++k) {
-                sample[k] = variates[k][j];
-            }
-            for (Size i=0; i<factors_; ++i) {
-                bridge_.transform(boost::make_permutation_iterator(
-                                                  sample.begin(),
-                                                  orderedIndices_[i].begin()),
-                          boost::make_permutation_iterator(
-                                                  sample.begin(),
-                                                  orderedIndices_[i].end()),
-                          retVal[i].begin()+j*steps_);
+
+        // all paths are bridged together, one factor at a time
+        Matrix sample(steps_, nPaths), bridged(steps_, nPaths);
+        for (Size i=0; i<factors_; ++i) {
+            for (Size k=0; k < steps_; ++k) {
+                const std::vector<Real>& v = variates[orderedIndices_[i][k]];
+                QL_REQUIRE(v.size() == nPaths, "inconsistent variate vector");
+                std::copy(v.begin(), v.end(), sample.row_begin(k));
             }
+            bridge_.transform(sample, bridged);
+            for (Size j=0; j < nPaths; ++j)
+                for (Size k=0; k < steps_; ++k)
+                    retVal[i][j*steps_+k] = bridged[k][j];
         }
-        
+
         return retVal;
     }
 
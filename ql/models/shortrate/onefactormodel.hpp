@@ -63,6 +63,17 @@ namespace QuantLib {
         //! Compute short rate from state variable
         virtual Rate shortRate(Time t, Real variable) const = 0;
 
+        //! Derivative of the short rate w.r.t. the fitting parameter
+        /*! Dynamics depending on a term-structure fitting parameter
+            \f$ \theta(t) \f$ can return \f$ \partial r/\partial
+            \theta \f$ at the given time and state, which allows the
+            tree to fit \f$ \theta \f$ by Newton iterations instead
+            of a Brent search.  The default returns Null<Real>().
+        */
+        virtual Real shortRateDerivative(Time, Real) const {
+            return Null<Real>();
+        }
+
         //! Returns the risk-neutral dynamics of the state variable
         const boost::shared_ptr<StochasticProcess1D>& process() {
             return process_;
@@ -79,7 +90,15 @@ namespace QuantLib {
         ShortRateTree(const boost::shared_ptr<TrinomialTree>& tree,
                       const boost::shared_ptr<ShortRateDynamics>& dynamics,
                       const TimeGrid& timeGrid);
-        //! Tree build-up + numerical fitting to term-structure
+        /*! Tree build-up + numerical fitting to term-structure
+
+            At each level, the fitting parameter is found by Newton
+            iterations on the logarithm of the fitted discount bond
+            if the dynamics provide the derivative of the short rate
+            w.r.t. the parameter, and by a Brent search otherwise.
+            When the parameter shifts the short rate, the logarithm
+            is linear in it and Newton converges in one step.
+        */
         ShortRateTree(const boost::shared_ptr<TrinomialTree>& tree,
                       const boost::shared_ptr<ShortRateDynamics>& dynamics,
                       const boost::shared_ptr
@@ -103,9 +122,28 @@ namespace QuantLib {
         Real probability(Size i, Size index, Size branch) const {
             return tree_->probability(i, index, branch);
         }
+        /*! uses the branching data of the trinomial tree and the
+            discount factors of the level, which are calculated the
+            first time the level is rolled back and cached.
+        */
+        void stepback(Size i, const Array& values, Array& newValues) const {
+            tree_->stepback(i, values, discounts(i), newValues);
+        }
+        //! as stepback(), sharing the cached discounts between assets
+        void stepbackAll(Size i,
+                         const std::vector<const Array*>& values,
+                         const std::vector<Array*>& newValues) const {
+            const Array& d = discounts(i);
+            #pragma omp parallel for \
+                if(values.size()*size(i) > detail::latticeParallelThreshold)
+            for (Size m=0; m<values.size(); ++m)
+                tree_->stepback(i, *values[m], d, *newValues[m]);
+        }
       private:
+        const Array& discounts(Size i) const;
         boost::shared_ptr<TrinomialTree> tree_;
         boost::shared_ptr<ShortRateDynamics> dynamics_;
+        mutable std::vector<Array> discounts_;
         class Helper;
     };
 
@@ -192,6 +230,43 @@ namespace QuantLib {
             return value;
         }
 
+        // Newton iterations on the log of the fitted bond price; the
+        // derivative is computed in the same pass over the nodes.
+        // Returns false if the dynamics don't provide the derivative
+        // or if the iterations leave the given range.
+        bool solve(Real accuracy, Size maxIterations,
+                   Real& theta, Real thetaMin, Real thetaMax) const {
+            const Time t = tree_.timeGrid()[i_];
+            const Time dt = tree_.timeGrid().dt(i_);
+            const ShortRateDynamics& dynamics = *tree_.dynamics_;
+            for (Size k=0; k<maxIterations; ++k) {
+                theta_->change(theta);
+                Real price = 0.0, derivative = 0.0;
+                for (Size j=0; j<size_; j++) {
+                    Real sensitivity = dynamics.shortRateDerivative(
+                                             t, tree_.underlying(i_,j));
+                    if (sensitivity == Null<Real>())
+                        return false;
+                    Real value = statePrices_[j]*tree_.discount(i_,j);
+                    price += value;
+                    derivative += value*sensitivity;
+                }
+                if (!(price > 0.0 && derivative > 0.0))
+                    return false;
+                // f = log(price/P), f' = -dt*derivative/price
+                Real dx = price*std::log(price/discountBondPrice_)
+                        / (dt*derivative);
+                theta += dx;
+                if (theta < thetaMin || theta > thetaMax)
+                    return false;
+                if (std::fabs(dx) < accuracy) {
+                    theta_->change(theta);
+                    return true;
+                }
+            }
+            return false;
+        }
+
       private:
         Size size_;
         Size i_;
@@ -208,7 +283,7 @@ namespace QuantLib {
                 <TermStructureFittingParameter::NumericalImpl>& theta,
             const TimeGrid& timeGrid)
     : TreeLattice1D<OneFactorModel::ShortRateTree>(timeGrid, tree->size(1)),
-      tree_(tree), dynamics_(dynamics) {
+      tree_(tree), dynamics_(dynamics), discounts_(timeGrid.size()-1) {
 
         theta->reset();
         Real value = 1.0;
@@ -217,9 +292,14 @@ namespace QuantLib {
         for (Size i=0; i<(timeGrid.size() - 1); i++) {
             Real discountBond = theta->termStructure()->discount(t_[i+1]);
             Helper finder(i, discountBond, theta, *this);
+            Real guess = value;
+            if (finder.solve(1e-7, 20, value, vMin, vMax)) {
+                theta->change(value);
+                continue;
+            }
             Brent s1d;
             s1d.setMaxEvaluations(1000);
-            value = s1d.solve(finder, 1e-7, value, vMin, vMax);
+            value = s1d.solve(finder, 1e-7, guess, vMin, vMax);
             // vMin = value - 1.0;
             // vMax = value + 1.0;
             theta->change(value);
@@ -231,7 +311,19 @@ namespace QuantLib {
                          const boost::shared_ptr<ShortRateDynamics>& dynamics,
                          const TimeGrid& timeGrid)
     : TreeLattice1D<OneFactorModel::ShortRateTree>(timeGrid, tree->size(1)),
-      tree_(tree), dynamics_(dynamics) {}
+      tree_(tree), dynamics_(dynamics), discounts_(timeGrid.size()-1) {}
+
+    inline const Array&
+    OneFactorModel::ShortRateTree::discounts(Size i) const {
+        Array& result = discounts_[i];
+        if (result.empty()) {
+            // the fitting parameter, if any, is final by now
+            result = Array(size(i));
+            for (Size j=0; j<result.size(); j++)
+                result[j] = discount(i, j);
+        }
+        return result;
+    }
 
     inline OneFactorModel::OneFactorModel(Size nArguments)
     : ShortRateModel(nArguments) {}
@@ -27,6 +27,8 @@
 
 #include <ql/timegrid.hpp>
 #include <ql/math/array.hpp>
+#include <boost/shared_ptr.hpp>
+#include <vector>
 
 namespace QuantLib {
 
@@ -83,6 +85,31 @@ namespace QuantLib {
         virtual void partialRollback(DiscretizedAsset&,
                                      Time to) const = 0;
 
+        /*! Roll back a set of assets together until the given time,
+            performing any needed adjustment.  Assets can start from
+            different times; each one joins the others when they
+            reach its own time.  At each step, all the assets are
+            rolled back before they are adjusted, in the given
+            order; an option must therefore precede its underlying
+            in the set, so that it is exercised before the
+            underlying performs its post-adjustment.
+        */
+        virtual void rollback(
+              const std::vector<boost::shared_ptr<DiscretizedAsset> >&,
+              Time to) const;
+
+        /*! Roll back a set of assets together as above, but do not
+            perform the final adjustment.
+
+            The default implementation rolls back each asset by one
+            step of the time grid at a time, using the single-asset
+            methods above; derived classes can override it to share
+            the work of a step between the assets.
+        */
+        virtual void partialRollback(
+              const std::vector<boost::shared_ptr<DiscretizedAsset> >&,
+              Time to) const;
+
         //! computes the present value of an asset.
         virtual Real presentValue(DiscretizedAsset&) const = 0;
 
@@ -1,5 +1,6 @@
 #include <ql/patterns/curiouslyrecurring.hpp>
 #include <ql/patterns/lazyobject.hpp>
+#include <ql/patterns/lazyobjectscheduler.hpp>
 #include <ql/patterns/observable.hpp>
 #include <ql/patterns/singleton.hpp>
 #include <ql/patterns/visitor.hpp>
@@ -0,0 +1,254 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file lazyobjectscheduler.hpp
+    \brief dependency-ordered recalculation of lazy objects
+*/
+
+#ifndef quantlib_lazy_object_scheduler_hpp
+#define quantlib_lazy_object_scheduler_hpp
+
+#include <ql/patterns/lazyobject.hpp>
+#include <ql/pricingengine.hpp>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace QuantLib {
+
+    //! Recalculates a network of lazy objects in dependency order
+    /*! The scheduler walks the observer graph from the given objects
+        and collects those which need recalculation, together with
+        the lazy objects they depend upon.  Dependencies are found
+        through registrations: an object depends on the lazy objects
+        it is registered with, either directly or through observers
+        which are not lazy objects themselves (e.g., the links of
+        relinkable handles).
+
+        The collected objects are sorted into levels, each one
+        depending only on objects in previous levels.  calculate()
+        runs the levels in order; the objects in a level are
+        calculated in parallel when OpenMP is enabled, except for
+        those registered with the same pricing engine, whose
+        arguments and results they share: these are calculated one
+        after the other by the same thread.  A term
+        structure shared by many instruments is thus calculated once
+        before any of them, and each instrument only reads its
+        cached results.  Afterwards, methods such as
+        Instrument::NPV() return the results as usual.
+
+        \warning Objects in the same level and not sharing a
+                 pricing engine are calculated concurrently. Their
+                 calculations must only use lazy objects and engines
+                 they are registered with, and must not modify any
+                 other state shared with other objects, including
+                 registrations and notifications.
+
+        \ingroup patterns
+    */
+    class LazyObjectScheduler {
+      public:
+        LazyObjectScheduler() {}
+        explicit LazyObjectScheduler(
+                const std::vector<boost::shared_ptr<LazyObject> >& objects)
+        : objects_(objects) {}
+        //! adds an object to be kept up to date
+        void add(const boost::shared_ptr<LazyObject>& object) {
+            objects_.push_back(object);
+        }
+        /*! returns the objects needing recalculation, grouped so that
+            the objects in each level depend only on objects in
+            previous levels.
+        */
+        std::vector<std::vector<LazyObject*> > levels() const;
+        /*! splits a level into groups of objects which can be
+            calculated concurrently with the other groups, i.e.,
+            which share no pricing engine with them.
+        */
+        static std::vector<std::vector<LazyObject*> >
+        groups(const std::vector<LazyObject*>& objects);
+        /*! calculates the objects needing recalculation and returns
+            their number.  If any calculation fails, the later levels
+            are not calculated and the first error is reported.
+        */
+        Size calculate() const;
+      private:
+        typedef std::map<const LazyObject*, Integer> level_map;
+        Integer level(LazyObject* object,
+                      level_map& levels,
+                      std::vector<std::vector<LazyObject*> >& result) const;
+        void dependencies(const Observer* observer,
+                          Integer& level,
+                          std::set<const Observable*>& visited,
+                          level_map& levels,
+                          std::vector<std::vector<LazyObject*> >& result)
+                                                                      const;
+        static Size root(std::vector<Size>& parent, Size i);
+        std::vector<boost::shared_ptr<LazyObject> > objects_;
+    };
+
+
+    // inline definitions
+
+    inline std::vector<std::vector<LazyObject*> >
+    LazyObjectScheduler::levels() const {
+        level_map levels;
+        std::vector<std::vector<LazyObject*> > result;
+        for (Size i=0; i<objects_.size(); ++i) {
+            if (objects_[i])
+                level(objects_[i].get(), levels, result);
+        }
+        return result;
+    }
+
+    inline Integer LazyObjectScheduler::level(
+                      LazyObject* object,
+                      level_map& levels,
+                      std::vector<std::vector<LazyObject*> >& result) const {
+        // up-to-date or frozen objects won't be recalculated, and
+        // neither will their dependencies on their behalf
+        if (object->calculated_ || object->frozen_)
+            return -1;
+
+        // objects being visited are marked with -2 so that cycles
+        // are broken instead of followed
+        std::pair<level_map::iterator, bool> visit =
+            levels.insert(std::make_pair(object, -2));
+        if (!visit.second)
+            return std::max<Integer>(visit.first->second, -1);
+
+        Integer l = 0;
+        std::set<const Observable*> visited;
+        dependencies(object, l, visited, levels, result);
+
+        levels[object] = l;
+        if (result.size() <= Size(l))
+            result.resize(l+1);
+        result[l].push_back(object);
+        return l;
+    }
+
+    inline void LazyObjectScheduler::dependencies(
+                     const Observer* observer,
+                     Integer& l,
+                     std::set<const Observable*>& visited,
+                     level_map& levels,
+                     std::vector<std::vector<LazyObject*> >& result) const {
+        const Observer::set_type& observables = observer->observables();
+        for (Observer::set_type::const_iterator i = observables.begin();
+             i != observables.end(); ++i) {
+            if (!visited.insert(i->get()).second)
+                continue;
+            if (LazyObject* lazy = dynamic_cast<LazyObject*>(i->get())) {
+                l = std::max(l, level(lazy, levels, result)+1);
+            } else if (const Observer* o =
+                                   dynamic_cast<const Observer*>(i->get())) {
+                // look through forwarding observers, such as links
+                dependencies(o, l, visited, levels, result);
+            }
+        }
+    }
+
+    inline Size LazyObjectScheduler::root(std::vector<Size>& parent,
+                                          Size i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    inline std::vector<std::vector<LazyObject*> >
+    LazyObjectScheduler::groups(const std::vector<LazyObject*>& objects) {
+        // objects sharing an engine are joined, together with the
+        // ones sharing their other engines, if any
+        typedef std::map<const PricingEngine*, Size> user_map;
+        user_map users;
+        std::vector<Size> parent(objects.size());
+        for (Size i=0; i<objects.size(); ++i) {
+            parent[i] = i;
+            const Observer::set_type& observables =
+                objects[i]->observables();
+            for (Observer::set_type::const_iterator j = observables.begin();
+                 j != observables.end(); ++j) {
+                const PricingEngine* engine =
+                    dynamic_cast<const PricingEngine*>(j->get());
+                if (engine == 0)
+                    continue;
+                std::pair<user_map::iterator, bool> user =
+                    users.insert(std::make_pair(engine, i));
+                if (!user.second)
+                    parent[root(parent, i)] =
+                        root(parent, user.first->second);
+            }
+        }
+
+        std::map<Size, Size> index;
+        std::vector<std::vector<LazyObject*> > result;
+        for (Size i=0; i<objects.size(); ++i) {
+            std::pair<std::map<Size, Size>::iterator, bool> group =
+                index.insert(std::make_pair(root(parent, i), result.size()));
+            if (group.second)
+                result.push_back(std::vector<LazyObject*>());
+            result[group.first->second].push_back(objects[i]);
+        }
+        return result;
+    }
+
+    inline Size LazyObjectScheduler::calculate() const {
+        const std::vector<std::vector<LazyObject*> > schedule = levels();
+
+        Size calculated = 0;
+        for (Size k=0; k<schedule.size(); ++k) {
+            const std::vector<std::vector<LazyObject*> > objects =
+                groups(schedule[k]);
+            std::vector<std::string> errors(objects.size());
+
+            #pragma omp parallel for schedule(dynamic)
+            for (Size i=0; i<objects.size(); ++i) {
+                // exceptions must not escape the parallel region
+                for (Size j=0; j<objects[i].size(); ++j) {
+                    try {
+                        objects[i][j]->calculate();
+                    } catch (std::exception& e) {
+                        if (errors[i].empty())
+                            errors[i] = e.what();
+                    } catch (...) {
+                        if (errors[i].empty())
+                            errors[i] = "unknown error";
+                    }
+                }
+            }
+
+            // dependents of a failed object would retry its
+            // calculation concurrently, so later levels are skipped
+            for (Size i=0; i<objects.size(); ++i)
+                QL_REQUIRE(errors[i].empty(),
+                           "could not calculate one or more objects: "
+                           << errors[i]);
+
+            calculated += schedule[k].size();
+        }
+        return calculated;
+    }
+
+}
+
+
+#endif
@@ -50,11 +50,13 @@ namespace QuantLib {
 
     class Observer;
     class Observable;
+    class DeferredUpdates;
 
     //! global repository for run-time library settings
     class ObservableSettings : public Singleton<ObservableSettings> {
         friend class Singleton<ObservableSettings>;
         friend class Observable;
+        friend class DeferredUpdates;
       public:
         void disableUpdates(bool deferred=false) {
             updatesEnabled_  = false;
@@ -77,6 +79,11 @@ namespace QuantLib {
         typedef set_type::iterator iterator;
         set_type deferredObservers_;
 
+        // observers deferred by the DeferredUpdates instance active
+        // on the current thread, if any
+        static set_type*& threadDeferredObservers();
+        static void notifyDeferredObservers(set_type& observers);
+
         bool updatesEnabled_,  updatesDeferred_;
     };
 
@@ -129,6 +136,8 @@ namespace QuantLib {
         void registerWithObservables(const boost::shared_ptr<Observer>&);
         Size unregisterWith(const boost::shared_ptr<Observable>&);
         void unregisterWithAll();
+        //! the observables this instance is registered with
+        const set_type& observables() const;
 
         /*! This method must be implemented in derived classes. An
             instance of %Observer does not call this method directly:
@@ -185,6 +194,9 @@ namespace QuantLib {
     inline Size Observable::unregisterObserver(Observer* o) {
         if (settings_.updatesDeferred())
             settings_.unregisterDeferredObserver(o);
+        if (ObservableSettings::set_type* deferred =
+                ObservableSettings::threadDeferredObservers())
+            deferred->erase(o);
 
         return observers_.erase(o);
     }
@@ -242,6 +254,10 @@ namespace QuantLib {
         observables_.clear();
     }
 
+    inline const Observer::set_type& Observer::observables() const {
+        return observables_;
+    }
+
 }
 
 // implementation
@@ -253,12 +269,22 @@ namespace QuantLib {
         updatesDeferred_ = false;
 
         // if there are outstanding deferred updates, do the notification
-        if (deferredObservers_.size()) {
+        notifyDeferredObservers(deferredObservers_);
+    }
+
+    inline ObservableSettings::set_type*&
+    ObservableSettings::threadDeferredObservers() {
+        static QL_THREAD_LOCAL set_type* observers = 0;
+        return observers;
+    }
+
+    inline void ObservableSettings::notifyDeferredObservers(
+                                                       set_type& observers) {
+        if (observers.size()) {
             bool successful = true;
             std::string errMsg;
 
-            for (iterator i=deferredObservers_.begin();
-                i!=deferredObservers_.end(); ++i) {
+            for (iterator i=observers.begin(); i!=observers.end(); ++i) {
                 try {
                     (*i)->update();
                 } catch (std::exception& e) {
@@ -269,7 +295,7 @@ namespace QuantLib {
                 }
             }
 
-            deferredObservers_.clear();
+            observers.clear();
 
             QL_ENSURE(successful,
                   "could not notify one or more observers: " << errMsg);
@@ -278,7 +304,12 @@ namespace QuantLib {
 
 
     inline void Observable::notifyObservers() {
-        if (!settings_.updatesEnabled()) {
+        if (ObservableSettings::set_type* deferred =
+                ObservableSettings::threadDeferredObservers()) {
+            // a DeferredUpdates instance is active on this thread
+            deferred->insert(observers_.begin(), observers_.end());
+        }
+        else if (!settings_.updatesEnabled()) {
             // if updates are only deferred, flag this for later notification
             // these are held centrally by the settings singleton
             settings_.registerDeferredObservers(observers_);
@@ -318,17 +349,33 @@ namespace QuantLib {
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/thread_only.hpp>
 #include <boost/smart_ptr/owner_less.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <algorithm>
+#include <iterator>
 #include <set>
+#include <vector>
 
 namespace QuantLib {
 
     class Observable;
     class ObservableSettings;
+    class DeferredUpdates;
 
     //! Object that gets notified when a given observable changes
-    /*! \ingroup patterns */
+    /*! The destructor of an observer waits for the notifications
+        in progress on other threads to complete.  An observer
+        which is not owned by a shared pointer can be destroyed
+        from within its own update() method, as long as the latter
+        doesn't access the data members afterwards.  Since the
+        destructors of derived classes run before the wait, observers
+        notified from other threads should be owned by shared
+        pointers; the same holds for observers registering in their
+        constructors.
+
+        \ingroup patterns
+    */
     class Observer : public boost::enable_shared_from_this<Observer> {
         friend class Observable;
         friend class ObservableSettings;
@@ -350,6 +397,8 @@ namespace QuantLib {
         void registerWithObservables(const boost::shared_ptr<Observer>&);
         Size unregisterWith(const boost::shared_ptr<Observable>&);
         void unregisterWithAll();
+        //! a copy of the observables this instance is registered with
+        set_type observables() const;
         /*! This method must be implemented in derived classes. An
             instance of %Observer does not call this method directly:
             instead, it will be called by the observables the instance
@@ -358,20 +407,30 @@ namespace QuantLib {
         virtual void update() = 0;
       private:
 
+        /* Notifications go through the proxy without taking any
+           lock: each one is counted while in flight, and
+           deactivate() waits for the ones in flight to complete
+           before the observer can be destroyed.
+        */
         class Proxy {
           public:
             Proxy(Observer* const observer)
              : active_  (true),
+               inFlight_(0),
                observer_(observer) {
             }
 
             void update() const {
-                boost::lock_guard<boost::recursive_mutex> lock(mutex_);
-                if (active_) {
+                // released after inFlight_ is decremented, so that
+                // the observer can be destroyed here if this is the
+                // last reference to it
+                boost::shared_ptr<Observer> obs;
+                InFlight guard(this);
+                if (active_.load()) {
                     const boost::weak_ptr<Observer> o
                         = observer_->weak_from_this();
                     if (!o._empty()) {
-                        const boost::shared_ptr<Observer> obs(o.lock());
+                        obs = o.lock();
                         if (obs)
                             obs->update();
                     }
@@ -382,13 +441,52 @@ namespace QuantLib {
             }
 
             void deactivate() {
-                boost::lock_guard<boost::recursive_mutex> lock(mutex_);
-                active_ = false;
+                active_.store(false);
+                // notifications in progress on this thread, i.e.,
+                // the ones whose update() is destroying the observer,
+                // can't complete before this returns and are not
+                // waited for; the others are, spinning for a while
+                // and then yielding to let their threads run.
+                const Size own = InFlight::onThisThread(this);
+                for (Size k=0; inFlight_.load() > own; ++k) {
+                    if (k >= 16)
+                        boost::this_thread::yield();
+                }
             }
 
-        private:
-            bool active_;
-            mutable boost::recursive_mutex mutex_;
+          private:
+            // counts a notification while in flight, and keeps track
+            // of the ones in progress on each thread
+            class InFlight {
+              public:
+                explicit InFlight(const Proxy* proxy)
+                : proxy_(proxy), previous_(innermost()) {
+                    ++proxy_->inFlight_;
+                    innermost() = this;
+                }
+                ~InFlight() {
+                    innermost() = previous_;
+                    --proxy_->inFlight_;
+                }
+                static Size onThisThread(const Proxy* proxy) {
+                    Size n = 0;
+                    for (const InFlight* f = innermost(); f != 0;
+                         f = f->previous_)
+                        if (f->proxy_ == proxy)
+                            ++n;
+                    return n;
+                }
+              private:
+                static const InFlight*& innermost() {
+                    static QL_THREAD_LOCAL const InFlight* current = 0;
+                    return current;
+                }
+                const Proxy* proxy_;
+                const InFlight* previous_;
+            };
+
+            boost::atomic<bool> active_;
+            mutable boost::atomic<Size> inFlight_;
             Observer* const observer_;
         };
 
@@ -398,18 +496,21 @@ namespace QuantLib {
         set_type observables_;
     };
 
-	namespace detail {
-		class Signal;
-	}
-
     //! Object that notifies its changes to a set of observers
-    /*! \ingroup patterns */
+    /*! The registered observers are kept in an immutable list which
+        is replaced as a whole when an observer registers or
+        unregisters. Notifications work on a snapshot of the list
+        and don't take any lock, so that many threads can notify
+        concurrently; registrations are serialized, and cost a copy
+        of the list.
+
+        \ingroup patterns
+    */
     class Observable {
         friend class Observer;
       public:
-        typedef boost::unordered_set<boost::shared_ptr<Observer::Proxy> >
-            set_type;
-        typedef set_type::iterator iterator;
+        typedef std::vector<boost::shared_ptr<Observer::Proxy> > set_type;
+        typedef set_type::const_iterator iterator;
 
         // constructors, assignment, destructor
         Observable();
@@ -424,10 +525,8 @@ namespace QuantLib {
         void registerObserver(const boost::shared_ptr<Observer::Proxy>&);
         void unregisterObserver(const boost::shared_ptr<Observer::Proxy>&);
 
-        boost::shared_ptr<detail::Signal> sig_;
-
-        set_type observers_;
-        mutable boost::recursive_mutex mutex_;
+        boost::shared_ptr<const set_type> observers_;
+        mutable boost::mutex mutex_;
 
         ObservableSettings& settings_;
     };
@@ -436,6 +535,7 @@ namespace QuantLib {
     class ObservableSettings : public Singleton<ObservableSettings> {
         friend class Singleton<ObservableSettings>;
         friend class Observable;
+        friend class DeferredUpdates;
 
     public:
         void disableUpdates(bool deferred=false) {
@@ -458,6 +558,11 @@ namespace QuantLib {
         void unregisterDeferredObserver(
             const boost::shared_ptr<Observer::Proxy>& proxy);
 
+        // observers deferred by the DeferredUpdates instance active
+        // on the current thread, if any
+        static set_type*& threadDeferredObservers();
+        static void notifyDeferredObservers(set_type& observers);
+
         set_type deferredObservers_;
         mutable boost::mutex mutex_;
 
@@ -479,17 +584,34 @@ namespace QuantLib {
     }
 
     inline void ObservableSettings::enableUpdates() {
-        boost::lock_guard<boost::mutex> lock(mutex_);
+        set_type deferred;
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            updatesType_ = UpdatesEnabled;
+            // the notification is done outside the lock, so that
+            // observers can safely register or unregister
+            deferred.swap(deferredObservers_);
+        }
 
         // if there are outstanding deferred updates, do the notification
-        updatesType_ = UpdatesEnabled;
+        notifyDeferredObservers(deferred);
+    }
+
+    inline ObservableSettings::set_type*&
+    ObservableSettings::threadDeferredObservers() {
+        static QL_THREAD_LOCAL set_type* observers = 0;
+        return observers;
+    }
 
-        if (deferredObservers_.size()) {
+    inline void ObservableSettings::notifyDeferredObservers(
+                                                       set_type& observers) {
+        set_type deferred;
+        deferred.swap(observers);
+        if (deferred.size()) {
             bool successful = true;
             std::string errMsg;
 
-            for (iterator i=deferredObservers_.begin();
-                i!=deferredObservers_.end(); ++i) {
+            for (iterator i=deferred.begin(); i!=deferred.end(); ++i) {
                 try {
                     const boost::shared_ptr<Observer::Proxy> proxy = i->lock();
                     if (proxy)
@@ -502,8 +624,6 @@ namespace QuantLib {
                 }
             }
 
-            deferredObservers_.clear();
-
             QL_ENSURE(successful,
                   "could not notify one or more observers: " << errMsg);
         }
@@ -613,56 +733,47 @@ namespace QuantLib {
         observables_.clear();
     }
 
-    // implementation
-
-    #include <boost/signals2/signal_type.hpp>
-
-    namespace QuantLib {
-
-    namespace detail {
-
-        class Signal {
-          public:
-            typedef boost::signals2::signal_type<
-                void(),
-                boost::signals2::keywords::mutex_type<boost::recursive_mutex> >
-                ::type signal_type;
-
-            void connect(const signal_type::slot_type& slot) {
-                sig_.connect(slot);
-            }
+    inline Observer::set_type Observer::observables() const {
+        boost::lock_guard<boost::recursive_mutex> lock(mutex_);
+        return observables_;
+    }
 
-            template <class T>
-            void disconnect(const T& slot) {
-                sig_.disconnect(slot);
-            }
+}
 
-            void operator()() const {
-                sig_.operator()();
-            }
-          private:
-            signal_type sig_;
-        };
+// implementation
 
-    }
+namespace QuantLib {
 
     inline void Observable::registerObserver(
         const boost::shared_ptr<Observer::Proxy>& observerProxy) {
-        {
-            boost::lock_guard<boost::recursive_mutex> lock(mutex_);
-            observers_.insert(observerProxy);
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        const set_type& current = *observers_;
+        if (std::find(current.begin(), current.end(), observerProxy)
+            == current.end()) {
+            boost::shared_ptr<set_type> observers(new set_type);
+            observers->reserve(current.size()+1);
+            observers->assign(current.begin(), current.end());
+            observers->push_back(observerProxy);
+            boost::atomic_store(&observers_,
+                                boost::shared_ptr<const set_type>(observers));
         }
-
-        detail::Signal::signal_type::slot_type slot(&Observer::Proxy::update,
-                                    observerProxy.get());
-        sig_->connect(slot.track(observerProxy));
     }
 
     inline void Observable::unregisterObserver(
         const boost::shared_ptr<Observer::Proxy>& observerProxy) {
         {
-            boost::lock_guard<boost::recursive_mutex> lock(mutex_);
-            observers_.erase(observerProxy);
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            const set_type& current = *observers_;
+            if (std::find(current.begin(), current.end(), observerProxy)
+                != current.end()) {
+                boost::shared_ptr<set_type> observers(new set_type);
+                observers->reserve(current.size()-1);
+                std::remove_copy(current.begin(), current.end(),
+                                 std::back_inserter(*observers),
+                                 observerProxy);
+                boost::atomic_store(
+                    &observers_, boost::shared_ptr<const set_type>(observers));
+            }
         }
 
         if (settings_.updatesDeferred()) {
@@ -671,39 +782,122 @@ namespace QuantLib {
                 settings_.unregisterDeferredObserver(observerProxy);
             }
         }
-
-        sig_->disconnect(boost::bind(&Observer::Proxy::update,
-                             observerProxy.get()));
     }
 
     inline void Observable::notifyObservers() {
-        if (settings_.updatesEnabled()) {
-            return sig_->operator()();
+        // the snapshot stays valid even if observers register or
+        // unregister while it is being notified
+        const boost::shared_ptr<const set_type> observers =
+            boost::atomic_load(&observers_);
+
+        if (ObservableSettings::set_type* deferred =
+                ObservableSettings::threadDeferredObservers()) {
+            // a DeferredUpdates instance is active on this thread;
+            // its set is not shared with other threads
+            deferred->insert(observers->begin(), observers->end());
+            return;
         }
 
-        boost::lock_guard<boost::mutex> sLock(settings_.mutex_);
-        if (settings_.updatesEnabled()) {
-            return sig_->operator()();
+        if (!settings_.updatesEnabled()) {
+            boost::lock_guard<boost::mutex> sLock(settings_.mutex_);
+            if (settings_.updatesDeferred()) {
+                // if updates are only deferred, flag this for later
+                // notification; these are held centrally by the
+                // settings singleton
+                settings_.registerDeferredObservers(*observers);
+                return;
+            }
+            if (!settings_.updatesEnabled())
+                return;
         }
-        else if (settings_.updatesDeferred()) {
-            boost::lock_guard<boost::recursive_mutex> lock(mutex_);
-            // if updates are only deferred, flag this for later notification
-            // these are held centrally by the settings singleton
-            settings_.registerDeferredObservers(observers_);
+
+        if (observers->size()) {
+            bool successful = true;
+            std::string errMsg;
+            for (iterator i=observers->begin(); i!=observers->end(); ++i) {
+                try {
+                    (*i)->update();
+                } catch (std::exception& e) {
+                    // see the single-threaded implementation above
+                    successful = false;
+                    errMsg = e.what();
+                } catch (...) {
+                    successful = false;
+                }
+            }
+            QL_ENSURE(successful,
+                  "could not notify one or more observers: " << errMsg);
         }
     }
 
     inline Observable::Observable()
-    : sig_(new detail::Signal()),
+    : observers_(new set_type),
       settings_(ObservableSettings::instance()) { }
 
     inline Observable::Observable(const Observable&)
-    : sig_(new detail::Signal()),
+    : observers_(new set_type),
       settings_(ObservableSettings::instance()) {
         // the observer set is not copied; no observer asked to
         // register with this object
     }
 
 }
+
+// end implementation
+
 #endif
+
+namespace QuantLib {
+
+    //! Coalesces the notifications sent during its lifetime
+    /*! The notifications sent from the current thread are deferred
+        while an instance is alive; when it is destroyed, or when
+        flush() is called, each observer that was notified in the
+        meantime receives a single update(), however many times its
+        observables changed.  A burst of quote changes can thus be
+        applied in one tick, and each lazy object is invalidated
+        once instead of once per change.
+
+        Notifications sent from other threads are not affected, and
+        neither are the settings of ObservableSettings.  Only the
+        outermost instance on a thread has an effect; an instance
+        created while updates are disabled has none.  An instance
+        must be destroyed on the thread that created it.
+
+        \warning errors raised by observers while flushing from the
+                 destructor are lost; call flush() explicitly to have
+                 them reported.
+
+        \ingroup patterns
+    */
+    class DeferredUpdates {
+      public:
+        DeferredUpdates()
+        : active_(!ObservableSettings::threadDeferredObservers()
+                  && ObservableSettings::instance().updatesEnabled()) {
+            if (active_)
+                ObservableSettings::threadDeferredObservers() = &observers_;
+        }
+        ~DeferredUpdates() {
+            try {
+                flush();
+            } catch (...) {}
+        }
+        //! sends the pending notifications and stops deferring them
+        void flush() {
+            if (active_) {
+                active_ = false;
+                ObservableSettings::threadDeferredObservers() = 0;
+                ObservableSettings::notifyDeferredObservers(observers_);
+            }
+        }
+      private:
+        DeferredUpdates(const DeferredUpdates&);
+        DeferredUpdates& operator=(const DeferredUpdates&);
+        bool active_;
+        ObservableSettings::set_type observers_;
+    };
+
+}
+
 #endif
@@ -26,7 +26,21 @@
 
 #include <ql/qldefines.hpp>
 
-#ifdef QL_ENABLE_SINGLETON_THREAD_SAFE_INIT
+#if defined(QL_ENABLE_THREAD_LOCAL_SESSIONS)
+    #if defined(QL_ENABLE_SESSIONS)
+        #error Thread-local sessions cannot be enabled together with QL_ENABLE_SESSIONS
+    #endif
+    #if (_MANAGED == 1) || (_M_CEE == 1)
+        #error Thread-local sessions are not supported when compiling with CLR support
+    #endif
+    #include <boost/thread/tss.hpp>
+    // each thread creates its own instances, so that their
+    // initialization doesn't need to be synchronized
+    #define QL_SINGLETON_THREAD_LOCAL
+#endif
+
+#if defined(QL_ENABLE_SINGLETON_THREAD_SAFE_INIT) \
+    && !defined(QL_SINGLETON_THREAD_LOCAL)
     #if defined(QL_ENABLE_SESSIONS)
         #ifdef BOOST_MSVC
             #pragma message(\
@@ -105,6 +119,15 @@ namespace QuantLib {
         as a single implemementation point should synchronization
         features be added.
 
+        When QL_ENABLE_THREAD_LOCAL_SESSIONS is defined, each thread
+        gets its own instance, created on first access and destroyed
+        when the thread exits.
+
+        \warning In thread-local mode, objects keeping a reference
+                 to an instance (e.g., observables to their
+                 ObservableSettings) must not outlive the thread that
+                 created them.
+
         \ingroup patterns
     */
     template <class T>
@@ -120,6 +143,13 @@ namespace QuantLib {
         static boost::mutex mutex_;
     #endif
 
+    #if defined(QL_SINGLETON_THREAD_LOCAL)
+      private:
+        static QL_THREAD_LOCAL T* instance_;
+        // owns the instance of each thread and deletes it on exit
+        static boost::thread_specific_ptr<T>& threadInstances();
+    #endif
+
       public:
         //! access to the unique instance
         static T& instance();
@@ -138,12 +168,33 @@ namespace QuantLib {
     template <class T>  boost::atomic<T*> Singleton<T>::instance_;
     template <class T> boost::mutex Singleton<T>::mutex_;
     #endif
+
+    #if defined(QL_SINGLETON_THREAD_LOCAL)
+    template <class T> QL_THREAD_LOCAL T* Singleton<T>::instance_ = 0;
+
+    template <class T>
+    boost::thread_specific_ptr<T>& Singleton<T>::threadInstances() {
+        static boost::thread_specific_ptr<T> instances;
+        return instances;
+    }
+    #endif
     
     // template definitions
 
     template <class T>
     T& Singleton<T>::instance() {
 
+        #if defined(QL_SINGLETON_THREAD_LOCAL)
+
+        T* instance = instance_;
+        if (!instance) {
+            instance = new T;
+            threadInstances().reset(instance);
+            instance_ = instance;
+        }
+
+        #else
+
         #if (QL_MANAGED == 0) && !defined(QL_SINGLETON_THREAD_SAFE_INIT)
         static std::map<Integer, boost::shared_ptr<T> > instances_;
         #endif
@@ -176,6 +227,8 @@ namespace QuantLib {
 
         #endif
 
+        #endif
+
         return *instance;
     }
 
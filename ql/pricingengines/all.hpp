@@ -7,6 +7,7 @@
 //#include <ql/pricingengines/greeks.hpp>
 #include <ql/pricingengines/latticeshortratemodelengine.hpp>
 #include <ql/pricingengines/mclongstaffschwartzengine.hpp>
+#include <ql/pricingengines/mcmultilevelsimulation.hpp>
 #include <ql/pricingengines/mcsimulation.hpp>
 //
 //#include <ql/pricingengines/asian/all.hpp>
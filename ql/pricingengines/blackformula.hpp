@@ -34,6 +34,7 @@
 
 #include <ql/option.hpp>
 #include <ql/instruments/payoffs.hpp>
+#include <ql/math/array.hpp>
 
 namespace QuantLib {
 
@@ -211,6 +212,34 @@ namespace QuantLib {
         Real accuracy = 1.0e-6,
         Natural maxIterations = 100);
 
+    /*! Black 1976 implied standard deviation,
+        i.e. volatility*sqrt(timeToMaturity)
+
+        "Let's Be Rational"
+        P. Jäckel, Wilmott (2015), pp. 40-53
+
+        The price is normalized and mapped to an out-of-the-money
+        call; a rational cubic interpolation of the (suitably
+        transformed) normalized Black function provides the initial
+        guess, which is refined by at most two Householder steps of
+        third order.  The result is accurate to close to machine
+        precision for any attainable price, without requiring a
+        guess or an accuracy.
+    */
+    Real blackFormulaImpliedStdDevLetsBeRational(Option::Type optionType,
+                                                 Real strike,
+                                                 Real forward,
+                                                 Real blackPrice,
+                                                 Real discount = 1.0,
+                                                 Real displacement = 0.0);
+
+    Real blackFormulaImpliedStdDevLetsBeRational(
+                        const boost::shared_ptr<PlainVanillaPayoff>& payoff,
+                        Real forward,
+                        Real blackPrice,
+                        Real discount = 1.0,
+                        Real displacement = 0.0);
+
     /*! Black 1976 probability of being in the money (in the bond martingale
         measure), i.e. N(d2).
         It is a risk-neutral probability, not the real world one.
@@ -335,6 +364,22 @@ namespace QuantLib {
                                    Real bachelierPrice,
                                    Real discount = 1.0);
 
+    /*! Bachelier implied volatility
+
+        The approximation above is refined by at most two Householder
+        steps of third order on the logarithm of the out-of-the-money
+        time value, in the same spirit as
+        blackFormulaImpliedStdDevLetsBeRational; the result is
+        accurate to close to machine precision.
+    */
+    Real bachelierBlackFormulaImpliedVolLetsBeRational(
+                                   Option::Type optionType,
+                                   Real strike,
+                                   Real forward,
+                                   Real tte,
+                                   Real bachelierPrice,
+                                   Real discount = 1.0);
+
     /*! Bachelier formula for standard deviation derivative
         \warning instead of volatility it uses standard deviation, i.e.
                  volatility*sqrt(timeToMaturity), and it returns the
@@ -353,6 +398,91 @@ namespace QuantLib {
                                                 Real stdDev,
                                                 Real discount = 1.0);
 
+
+    /*! \name Batch versions
+        The functions below apply the corresponding scalar formula to
+        many options at once; the i-th result corresponds to the i-th
+        element of the input arrays, which must have the same size.
+        Parameters are validated in a first pass, and the
+        calculations are performed in separate passes over
+        contiguous arrays so that the compiler can vectorize them;
+        a single normal distribution is used for the whole batch.
+    */
+    //@{
+    /*! Black 1976 formula
+        \warning instead of volatility it uses standard deviation,
+                 i.e. volatility*sqrt(timeToMaturity)
+    */
+    Disposable<Array> blackFormula(Option::Type optionType,
+                                   const Array& strikes,
+                                   const Array& forwards,
+                                   const Array& stdDevs,
+                                   Real discount = 1.0,
+                                   Real displacement = 0.0);
+
+    /*! Black 1976 formula for standard deviation derivative
+        \warning instead of volatility it uses standard deviation,
+                 i.e. volatility*sqrt(timeToMaturity)
+    */
+    Disposable<Array> blackFormulaStdDevDerivative(
+                                   const Array& strikes,
+                                   const Array& forwards,
+                                   const Array& stdDevs,
+                                   Real discount = 1.0,
+                                   Real displacement = 0.0);
+
+    /*! Black 1976 implied standard deviation,
+        i.e. volatility*sqrt(timeToMaturity)
+
+        All options are solved together by safeguarded Newton
+        iterations, starting from the approximation of Corrado and
+        Miller; the iteration stops for each option as soon as its
+        step is smaller than the required accuracy.  As in the
+        scalar version, maxIterations bounds the number of function
+        evaluations, including the two at the ends of the bracket.
+    */
+    Disposable<Array> blackFormulaImpliedStdDev(
+                                   Option::Type optionType,
+                                   const Array& strikes,
+                                   const Array& forwards,
+                                   const Array& blackPrices,
+                                   Real discount = 1.0,
+                                   Real displacement = 0.0,
+                                   Real accuracy = 1.0e-6,
+                                   Natural maxIterations = 100);
+
+    /*! Bachelier formula
+        \warning it uses standard deviation of the normal
+                 distribution, i.e. absolute volatility*sqrt(T)
+    */
+    Disposable<Array> bachelierBlackFormula(Option::Type optionType,
+                                            const Array& strikes,
+                                            const Array& forwards,
+                                            const Array& stdDevs,
+                                            Real discount = 1.0);
+
+    /*! Bachelier formula for standard deviation derivative
+        \warning it uses standard deviation of the normal
+                 distribution, i.e. absolute volatility*sqrt(T)
+    */
+    Disposable<Array> bachelierBlackFormulaStdDevDerivative(
+                                            const Array& strikes,
+                                            const Array& forwards,
+                                            const Array& stdDevs,
+                                            Real discount = 1.0);
+
+    /*! Bachelier implied volatility, computed with the same
+        closed-form approximation as the scalar version
+    */
+    Disposable<Array> bachelierBlackFormulaImpliedVol(
+                                            Option::Type optionType,
+                                            const Array& strikes,
+                                            const Array& forwards,
+                                            Real tte,
+                                            const Array& bachelierPrices,
+                                            Real discount = 1.0);
+    //@}
+
 }
 
 
@@ -397,6 +527,9 @@ namespace QuantLib {
 #endif
 
 #include <boost/math/special_functions/sign.hpp>
+#include <boost/math/special_functions/erf.hpp>
+#include <boost/math/special_functions/expm1.hpp>
+#include <boost/math/special_functions/log1p.hpp>
 
 namespace {
     inline void checkParameters(QuantLib::Real strike,
@@ -879,6 +1012,465 @@ namespace QuantLib {
     }
 
 
+    namespace detail {
+
+        /* Helpers for blackFormulaImpliedStdDevLetsBeRational, after
+           P. Jäckel's reference implementation.  They work on the
+           normalized Black call b(x,s) = exp(x/2)N(x/s+s/2)
+           - exp(-x/2)N(x/s-s/2), with x = ln(F/K) and s the standard
+           deviation, which equals the undiscounted call price divided
+           by sqrt(FK).
+        */
+        namespace letsberational {
+
+            const Real minimumControlParameter = -(1.0-1.0e-8);
+            const Real maximumControlParameter =
+                2.0/(QL_EPSILON*QL_EPSILON);
+
+            inline bool belowHorizon(Real x) {
+                return std::fabs(x) < QL_MIN_POSITIVE_REAL;
+            }
+
+            // exp(z*z)*erfc(z) for non-negative z
+            inline Real erfcx(Real z) {
+                if (z < 7.0)
+                    return std::exp(z*z)*boost::math::erfc(z);
+                // asymptotic expansion, converging to machine
+                // precision before its terms start to grow
+                const Real w = 0.5/(z*z);
+                Real term = 1.0, sum = 1.0;
+                for (Size k=1; std::fabs(term) > QL_EPSILON*sum; ++k) {
+                    term *= -(2.0*k-1.0)*w;
+                    sum += term;
+                }
+                return M_1_SQRTPI*sum/z;
+            }
+
+            inline Real cumulativeNormal(Real z) {
+                return 0.5*boost::math::erfc(-M_SQRT1_2*z);
+            }
+
+            inline Real inverseCumulativeNormal(Real p) {
+                return -M_SQRT2*boost::math::erfc_inv(2.0*p);
+            }
+
+            // b(x,s) for x <= 0 and s > 0
+            inline Real normalisedOtmCall(Real x, Real s) {
+                const Real h = x/s, t = 0.5*s;
+                const Real a1 = -M_SQRT1_2*(h+t), a2 = M_SQRT1_2*(t-h);
+                if (a1 >= 7.0) {
+                    // both terms from the asymptotic expansion of
+                    // erfcx, taking their differences without
+                    // cancellation
+                    const Real lr = boost::math::log1p(-M_SQRT2*t/a2);
+                    const Real w = 0.5/(a1*a1);
+                    Real c = 1.0/a1, sum = 0.0;
+                    for (Size k=0; k<100; ++k) {
+                        const Real term =
+                            -c*boost::math::expm1((2.0*k+1.0)*lr);
+                        sum += term;
+                        if (std::fabs(term) <= QL_EPSILON*sum)
+                            break;
+                        c *= -(2.0*k+1.0)*w;
+                    }
+                    return 0.5*M_1_SQRTPI*std::exp(-0.5*(h*h+t*t))*sum;
+                } else if (t < 0.21) {
+                    // Taylor expansion in t, whose coefficients
+                    // follow from w' = h w + n(h) exp(-t^2/2) for
+                    // w(t) = exp(ht)N(h+t); b = w(t) - w(-t).
+                    Real u = 1.0 + h*M_SQRTPI*M_SQRT1_2*erfcx(-M_SQRT1_2*h);
+                    Real e = 1.0, tk = t, sum = u*tk;
+                    for (Size k=1; k<100; k+=2) {
+                        // from u_k to u_{k+2}
+                        e *= -Real(k);
+                        u = h*h*u + e;
+                        tk *= t*t/((k+1.0)*(k+2.0));
+                        const Real term = u*tk;
+                        sum += term;
+                        if (std::fabs(term) <= QL_EPSILON*std::fabs(sum))
+                            break;
+                    }
+                    return 2.0*M_SQRT1_2*M_1_SQRTPI*std::exp(-0.5*h*h)*sum;
+                } else {
+                    const Real e = std::exp(-0.5*(h*h+t*t));
+                    const Real b1 = (a1 < 0.0) ?
+                        std::exp(0.5*x)*boost::math::erfc(a1) :
+                        e*erfcx(a1);
+                    return 0.5*(b1 - e*erfcx(a2));
+                }
+            }
+
+            inline Real normalisedBlackCall(Real x, Real s) {
+                if (x > 0.0)
+                    return 2.0*std::sinh(0.5*x) + normalisedBlackCall(-x, s);
+                if (s <= std::fabs(x)*QL_MIN_POSITIVE_REAL)
+                    return 0.0;
+                return normalisedOtmCall(x, s);
+            }
+
+            inline Real normalisedVega(Real x, Real s) {
+                const Real h = x/s, t = 0.5*s;
+                return M_SQRT1_2*M_1_SQRTPI*std::exp(-0.5*(h*h+t*t));
+            }
+
+            inline Real householderFactor(Real newton, Real halley,
+                                          Real hh3) {
+                return (1.0+0.5*halley*newton)
+                    / (1.0+newton*(halley+hh3*newton/6.0));
+            }
+
+            // Delbourgo-Gregory rational cubic interpolation
+            inline Real rationalCubicInterpolation(Real x,
+                                                   Real xl, Real xr,
+                                                   Real yl, Real yr,
+                                                   Real dl, Real dr,
+                                                   Real r) {
+                const Real h = xr-xl;
+                if (std::fabs(h) <= 0.0)
+                    return 0.5*(yl+yr);
+                const Real t = (x-xl)/h;
+                if (!(r >= maximumControlParameter)) {
+                    const Real omt = 1.0-t, t2 = t*t, omt2 = omt*omt;
+                    return (yr*t2*t + (r*yr-h*dr)*t2*omt
+                            + (r*yl+h*dl)*t*omt2 + yl*omt2*omt)
+                        / (1.0+(r-3.0)*t*omt);
+                }
+                return yr*t + yl*(1.0-t);
+            }
+
+            inline Real controlParameterForSecondDerivative(
+                                    Real xl, Real xr, Real yl, Real yr,
+                                    Real dl, Real dr,
+                                    Real secondDerivative, bool leftSide) {
+                const Real h = xr-xl;
+                const Real numerator = 0.5*h*secondDerivative + (dr-dl);
+                if (belowHorizon(numerator))
+                    return 0.0;
+                const Real denominator =
+                    leftSide ? (yr-yl)/h-dl : dr-(yr-yl)/h;
+                if (belowHorizon(denominator))
+                    return numerator > 0.0 ?
+                        maximumControlParameter : minimumControlParameter;
+                return numerator/denominator;
+            }
+
+            // smallest control parameter preserving the shape
+            // implied by the slopes at the ends of the interval
+            inline Real minimumControlParameterForShape(Real dl, Real dr,
+                                                        Real s,
+                                                        bool preferShape) {
+                const bool monotonic = dl*s >= 0.0 && dr*s >= 0.0;
+                const bool convex = dl <= s && s <= dr;
+                const bool concave = dl >= s && s >= dr;
+                if (!monotonic && !convex && !concave)
+                    return minimumControlParameter;
+                Real r1 = -QL_MAX_REAL, r2 = r1;
+                if (monotonic) {
+                    if (!belowHorizon(s))
+                        r1 = (dr+dl)/s;
+                    else if (preferShape)
+                        r1 = maximumControlParameter;
+                }
+                if (convex || concave) {
+                    if (!(belowHorizon(s-dl) || belowHorizon(dr-s)))
+                        r2 = std::max(std::fabs((dr-dl)/(dr-s)),
+                                      std::fabs((dr-dl)/(s-dl)));
+                    else if (preferShape)
+                        r2 = maximumControlParameter;
+                } else if (monotonic && preferShape) {
+                    r2 = maximumControlParameter;
+                }
+                return std::max(minimumControlParameter, std::max(r1, r2));
+            }
+
+            inline Real convexControlParameter(Real xl, Real xr,
+                                               Real yl, Real yr,
+                                               Real dl, Real dr,
+                                               Real secondDerivative,
+                                               bool leftSide,
+                                               bool preferShape) {
+                const Real r = controlParameterForSecondDerivative(
+                         xl, xr, yl, yr, dl, dr, secondDerivative, leftSide);
+                const Real rMin = minimumControlParameterForShape(
+                                      dl, dr, (yr-yl)/(xr-xl), preferShape);
+                return std::max(r, rMin);
+            }
+
+            /* f(s) = 2pi/sqrt(27) |x| N(-z)^3 with z = |x|/(sqrt(3)s),
+               which behaves like b(x,s) for small prices; derivatives
+               are taken with respect to b.
+            */
+            inline void lowerMap(Real x, Real s,
+                                 Real& f, Real& fp, Real& fpp) {
+                const Real ax = std::fabs(x), z = ax/(M_SQRT3*s);
+                const Real y = z*z, s2 = s*s;
+                const Real Phi = cumulativeNormal(-z);
+                // N(-z)/n(z), without underflow
+                const Real mills = M_SQRTPI*M_SQRT1_2*erfcx(M_SQRT1_2*z);
+                fpp = M_PI/6.0*y/(s2*s)*Phi
+                    * (8.0*M_SQRT3*s*ax + (3.0*s2*(s2-8.0)-8.0*x*x)*mills)
+                    * std::exp(2.0*y+0.25*s2);
+                if (belowHorizon(s)) {
+                    fp = 1.0;
+                    f = 0.0;
+                } else {
+                    const Real Phi2 = Phi*Phi;
+                    fp = 2.0*M_PI*y*Phi2*std::exp(y+0.125*s2);
+                    f = belowHorizon(x) ? 0.0 :
+                        2.0*M_PI/std::sqrt(27.0)*ax*Phi2*Phi;
+                }
+            }
+
+            inline Real inverseLowerMap(Real x, Real f) {
+                if (belowHorizon(f))
+                    return 0.0;
+                const Real p = std::pow(
+                    f/(2.0*M_PI/std::sqrt(27.0)*std::fabs(x)), 1.0/3.0);
+                return std::fabs(x/(M_SQRT3*inverseCumulativeNormal(p)));
+            }
+
+            /* f(s) = N(-s/2), which behaves like b_max - b(x,s) for
+               large prices; derivatives are taken with respect to b.
+            */
+            inline void upperMap(Real x, Real s,
+                                 Real& f, Real& fp, Real& fpp) {
+                f = cumulativeNormal(-0.5*s);
+                if (belowHorizon(x)) {
+                    fp = -0.5;
+                    fpp = 0.0;
+                } else {
+                    const Real w = (x/s)*(x/s);
+                    fp = -0.5*std::exp(0.5*w);
+                    fpp = M_SQRTPI*M_SQRT1_2
+                        * std::exp(w+0.125*s*s)*w/s;
+                }
+            }
+
+            inline Real inverseUpperMap(Real f) {
+                return -2.0*inverseCumulativeNormal(f);
+            }
+
+            /* standard deviation for the normalized price beta of an
+               out-of-the-money call, i.e., x <= 0 and
+               0 <= beta < exp(x/2), using at most n iterations
+            */
+            inline Real normalisedImpliedStdDev(Real beta, Real x,
+                                                Size n) {
+                if (beta <= QL_MIN_POSITIVE_REAL)
+                    return 0.0;
+                const Real bMax = std::exp(0.5*x);
+
+                // objective functions, selected by the branches
+                enum Objective { Lower, Middle, Upper };
+                Objective objective = Middle;
+
+                Real s, f = -QL_MAX_REAL;
+                Real sLeft = QL_MIN_POSITIVE_REAL, sRight = QL_MAX_REAL;
+                const Real sc = std::sqrt(std::fabs(2.0*x)),
+                           bc = normalisedBlackCall(x, sc),
+                           vc = normalisedVega(x, sc);
+                if (beta < bc) {
+                    const Real sl = sc - bc/vc,
+                               bl = normalisedBlackCall(x, sl);
+                    if (beta < bl) {
+                        Real fl, dfl, d2fl;
+                        lowerMap(x, sl, fl, dfl, d2fl);
+                        const Real r = convexControlParameter(
+                            0.0, bl, 0.0, fl, 1.0, dfl, d2fl, false, true);
+                        f = rationalCubicInterpolation(
+                                          beta, 0.0, bl, 0.0, fl, 1.0, dfl, r);
+                        if (!(f > 0.0)) {
+                            // quadratic interpolation instead, using
+                            // f(0) = 0, f'(0) = 1 and f(bl)
+                            const Real u = beta/bl;
+                            f = (fl*u + bl*(1.0-u))*u;
+                        }
+                        s = inverseLowerMap(x, f);
+                        sRight = sl;
+                        objective = Lower;
+                    } else {
+                        const Real vl = normalisedVega(x, sl);
+                        const Real r = convexControlParameter(
+                                       bl, bc, sl, sc, 1.0/vl, 1.0/vc, 0.0,
+                                       false, false);
+                        s = rationalCubicInterpolation(
+                                beta, bl, bc, sl, sc, 1.0/vl, 1.0/vc, r);
+                        sLeft = sl;
+                        sRight = sc;
+                    }
+                } else {
+                    const Real su = vc > QL_MIN_POSITIVE_REAL ?
+                                    sc + (bMax-bc)/vc : sc,
+                               bu = normalisedBlackCall(x, su);
+                    if (beta <= bu) {
+                        const Real vu = normalisedVega(x, su);
+                        const Real r = convexControlParameter(
+                                       bc, bu, sc, su, 1.0/vc, 1.0/vu, 0.0,
+                                       true, false);
+                        s = rationalCubicInterpolation(
+                                beta, bc, bu, sc, su, 1.0/vc, 1.0/vu, r);
+                        sLeft = sc;
+                        sRight = su;
+                    } else {
+                        Real fu, dfu, d2fu;
+                        upperMap(x, su, fu, dfu, d2fu);
+                        const Real sqrtMax = std::sqrt(QL_MAX_REAL);
+                        if (d2fu > -sqrtMax && d2fu < sqrtMax) {
+                            const Real r = convexControlParameter(
+                                bu, bMax, fu, 0.0, dfu, -0.5, d2fu,
+                                true, true);
+                            f = rationalCubicInterpolation(
+                                    beta, bu, bMax, fu, 0.0, dfu, -0.5, r);
+                        }
+                        if (f <= 0.0) {
+                            // quadratic interpolation instead, using
+                            // f(bu), f(bMax) = 0 and f'(bMax) = -1/2
+                            const Real h = bMax-bu, u = (beta-bu)/h;
+                            f = (fu*(1.0-u) + 0.5*h*u)*(1.0-u);
+                        }
+                        s = inverseUpperMap(f);
+                        sLeft = su;
+                        if (beta > 0.5*bMax)
+                            objective = Upper;
+                    }
+                }
+
+                /* Householder iterations of third order,
+                   s' = s + nu (1 + eta nu/2) / (1 + nu (eta + tau nu/6))
+                   with nu = -g/g', eta = g''/g' and tau = g'''/g' for
+                   g(s) = 1/ln(b) - 1/ln(beta) in the lowest branch,
+                   g(s) = ln(bMax-beta) - ln(bMax-b) in the highest
+                   and g(s) = b - beta otherwise.  The bracket falls
+                   back to bisection in case of trouble.
+                */
+                Real ds = s, dsPrevious = 0.0;
+                Size reversals = 0;
+                for (Size i=0; i<n && std::fabs(ds)>QL_EPSILON*s; ++i) {
+                    if (ds*dsPrevious < 0.0)
+                        ++reversals;
+                    if (i > 0 && (reversals == 3
+                                  || !(s > sLeft && s < sRight))) {
+                        s = 0.5*(sLeft+sRight);
+                        if (sRight-sLeft <= QL_EPSILON*s)
+                            break;
+                        reversals = 0;
+                        ds = 0.0;
+                    }
+                    dsPrevious = ds;
+                    const Real b = normalisedBlackCall(x, s),
+                               bp = normalisedVega(x, s);
+                    if (b > beta && s < sRight)
+                        sRight = s;
+                    else if (b < beta && s > sLeft)
+                        sLeft = s;
+                    // b''/b' and b'''/b'
+                    const Real bHalley = (x/s)*(x/s)/s - 0.25*s;
+                    const Real bHh3 = bHalley*bHalley
+                        - 3.0*(x/(s*s))*(x/(s*s)) - 0.25;
+                    if (objective == Lower) {
+                        if (b <= 0.0 || bp <= 0.0) {
+                            ds = 0.5*(sLeft+sRight) - s;
+                        } else {
+                            const Real lnB = std::log(b),
+                                       lnBeta = std::log(beta),
+                                       bpob = bp/b;
+                            const Real newton =
+                                (lnBeta-lnB)*lnB/lnBeta/bpob;
+                            const Real halley =
+                                bHalley - bpob*(1.0+2.0/lnB);
+                            const Real hh3 = bHh3
+                                + 2.0*bpob*bpob*(1.0+3.0/lnB*(1.0+1.0/lnB))
+                                - 3.0*bHalley*bpob*(1.0+2.0/lnB);
+                            ds = newton*householderFactor(newton, halley,
+                                                          hh3);
+                        }
+                    } else if (objective == Upper) {
+                        if (b >= bMax || bp <= QL_MIN_POSITIVE_REAL) {
+                            ds = 0.5*(sLeft+sRight) - s;
+                        } else {
+                            const Real g = std::log((bMax-beta)/(bMax-b)),
+                                       gp = bp/(bMax-b);
+                            const Real newton = -g/gp,
+                                       halley = bHalley + gp,
+                                       hh3 = bHh3 + gp*(2.0*gp+3.0*bHalley);
+                            ds = newton*householderFactor(newton, halley,
+                                                          hh3);
+                        }
+                    } else {
+                        const Real newton = (beta-b)/bp;
+                        ds = newton*householderFactor(newton, bHalley,
+                                                      bHh3);
+                    }
+                    ds = std::max(-0.5*s, ds);
+                    s += ds;
+                }
+                return s;
+            }
+
+        }
+
+    }
+
+    inline Real blackFormulaImpliedStdDevLetsBeRational(
+                                                 Option::Type optionType,
+                                                 Real strike,
+                                                 Real forward,
+                                                 Real blackPrice,
+                                                 Real discount,
+                                                 Real displacement) {
+        checkParameters(strike, forward, displacement);
+
+        QL_REQUIRE(discount>0.0,
+                   "discount (" << discount << ") must be positive");
+
+        QL_REQUIRE(blackPrice>=0.0,
+                   "option price (" << blackPrice << ") must be non-negative");
+        // check the price of the "other" option implied by put-call paity
+        Real otherOptionPrice = blackPrice - optionType*(forward-strike)*discount;
+        QL_REQUIRE(otherOptionPrice>=0.0,
+                   "negative " << Option::Type(-1*optionType) <<
+                   " price (" << otherOptionPrice <<
+                   ") implied by put-call parity. No solution exists for " <<
+                   optionType << " strike " << strike <<
+                   ", forward " << forward <<
+                   ", price " << blackPrice <<
+                   ", deflator " << discount);
+
+        strike = strike + displacement;
+        forward = forward + displacement;
+        QL_REQUIRE(strike>0.0,
+                   "strike + displacement (" << strike << ") must be positive");
+
+        // the out-of-the-money option, seen as a call
+        // with non-positive log-moneyness
+        Real x = std::log(forward/strike);
+        Real price = blackPrice;
+        if (optionType*x > 0.0)
+            price = otherOptionPrice;
+        x = -std::fabs(x);
+
+        const Real beta = price/(discount*std::sqrt(forward*strike));
+        QL_REQUIRE(beta < std::exp(0.5*x),
+                   "option price (" << blackPrice << ") is above the maximum"
+                   " attainable for " << optionType << " strike "
+                   << strike - displacement << ", forward "
+                   << forward - displacement << ", deflator " << discount);
+
+        return detail::letsberational::normalisedImpliedStdDev(beta, x, 2);
+    }
+
+    inline Real blackFormulaImpliedStdDevLetsBeRational(
+                        const boost::shared_ptr<PlainVanillaPayoff>& payoff,
+                        Real forward,
+                        Real blackPrice,
+                        Real discount,
+                        Real displacement) {
+        return blackFormulaImpliedStdDevLetsBeRational(
+            payoff->optionType(), payoff->strike(),
+            forward, blackPrice, discount, displacement);
+    }
+
+
     inline Real blackFormulaCashItmProbability(Option::Type optionType,
                                         Real strike,
                                         Real forward,
@@ -1095,6 +1687,89 @@ namespace QuantLib {
     }
 
 
+    namespace detail {
+
+        namespace letsberational {
+
+            /* 1 + u N(u)/n(u) for u <= 0, so that the out-of-the-money
+               Bachelier time value is s n(u) times this factor for
+               u = -|F-K|/s
+            */
+            inline Real bachelierTimeValueFactor(Real u) {
+                const Real z = -M_SQRT1_2*u;
+                if (z < 7.0)
+                    return 1.0 + u*M_SQRTPI*M_SQRT1_2*erfcx(z);
+                // asymptotic expansion, avoiding the cancellation
+                const Real w = 1.0/(u*u);
+                Real term = w, sum = w;
+                for (Size k=2; std::fabs(term) > QL_EPSILON*sum; ++k) {
+                    term *= -(2.0*k-1.0)*w;
+                    sum += term;
+                }
+                return sum;
+            }
+
+        }
+
+    }
+
+    inline Real bachelierBlackFormulaImpliedVolLetsBeRational(
+                                   Option::Type optionType,
+                                   Real strike,
+                                   Real forward,
+                                   Real tte,
+                                   Real bachelierPrice,
+                                   Real discount) {
+        QL_REQUIRE(tte>0.0,
+                   "tte (" << tte << ") must be positive");
+        QL_REQUIRE(discount>0.0,
+                   "discount (" << discount << ") must be positive");
+        QL_REQUIRE(bachelierPrice>=0.0,
+                   "option price (" << bachelierPrice
+                   << ") must be non-negative");
+
+        const Real timeValue = bachelierPrice/discount
+            - std::max(optionType*(forward-strike), 0.0);
+        QL_REQUIRE(timeValue>=0.0,
+                   "option price (" << bachelierPrice << ") is below the"
+                   " intrinsic value for " << optionType << " strike "
+                   << strike << ", forward " << forward
+                   << ", deflator " << discount);
+        if (timeValue==0.0)
+            return 0.0;
+
+        Real s = bachelierBlackFormulaImpliedVol(
+               optionType, strike, forward, 1.0, bachelierPrice, discount);
+        if (!(s > 0.0))
+            s = timeValue*M_SQRT2*M_SQRTPI;
+
+        /* Householder iterations of third order on
+           g(s) = ln v(s) - ln v, with v(s) = s n(u) (1 + u N(u)/n(u))
+           the time value of the out-of-the-money option and
+           u = -|F-K|/s.  With p = v'/v = 1/(s (1 + u N(u)/n(u))),
+           v''/v' = u^2/s and v'''/v' = u^2 (u^2-3)/s^2.
+        */
+        const Real m = std::fabs(forward-strike);
+        const Real lnTimeValue = std::log(timeValue);
+        for (Size i=0; i<2; ++i) {
+            const Real u = -m/s;
+            const Real r = detail::letsberational::bachelierTimeValueFactor(u);
+            const Real g = std::log(s*r) - 0.5*u*u
+                - std::log(M_SQRT2*M_SQRTPI) - lnTimeValue;
+            const Real p = 1.0/(s*r), u2s = u*u/s;
+            const Real newton = -g/p, halley = u2s - p;
+            const Real hh3 = u2s*(u*u-3.0)/s - 3.0*u2s*p + 2.0*p*p;
+            const Real ds = std::max(-0.5*s,
+                newton*detail::letsberational::householderFactor(
+                                                    newton, halley, hh3));
+            s += ds;
+            if (std::fabs(ds) <= QL_EPSILON*s)
+                break;
+        }
+        return s/std::sqrt(tte);
+    }
+
+
         inline Real bachelierBlackFormulaStdDevDerivative(Rate strike,
                                       Rate forward,
                                       Real stdDev,
@@ -1123,6 +1798,334 @@ namespace QuantLib {
     }
 
 
+    namespace detail {
+
+        inline void checkBatchSizes(const Array& strikes,
+                                    const Array& forwards,
+                                    const Array& values) {
+            QL_REQUIRE(forwards.size() == strikes.size(),
+                       "number of forwards (" << forwards.size()
+                       << ") different from number of strikes ("
+                       << strikes.size() << ")");
+            QL_REQUIRE(values.size() == strikes.size(),
+                       "array size (" << values.size()
+                       << ") different from number of strikes ("
+                       << strikes.size() << ")");
+        }
+
+        // replaces x[i] with N(x[i]); a single distribution object
+        // is used for the whole batch
+        inline void cumulativeNormal(Array& x) {
+            const CumulativeNormalDistribution N;
+            for (Size i=0; i<x.size(); ++i)
+                x[i] = N(x[i]);
+        }
+
+        /* undiscounted Black price and standard-deviation derivative
+           for (displaced) strikes and forwards and for an option type
+           given for each option as +1 or -1; derivatives are only
+           calculated if requested.  Degenerate options, with null
+           strike or standard deviation, are given zero arguments
+           here and are left to the caller.
+        */
+        inline void blackBatch(const Array& w,
+                               const Array& strikes,
+                               const Array& forwards,
+                               const Array& stdDevs,
+                               Array& prices,
+                               Array* stdDevDerivatives = 0) {
+            const Size n = strikes.size();
+            Array d1(n), d2(n);
+            for (Size i=0; i<n; ++i) {
+                const Real k = strikes[i], s = stdDevs[i];
+                const bool regular = (k != 0.0 && s != 0.0);
+                const Real d = regular ?
+                    std::log(forwards[i]/k)/s + 0.5*s : 0.0;
+                d1[i] = w[i]*d;
+                d2[i] = w[i]*(d - s);
+            }
+            if (stdDevDerivatives != 0) {
+                Array& v = *stdDevDerivatives;
+                for (Size i=0; i<n; ++i) {
+                    const Real d = w[i]*d1[i];
+                    v[i] = (strikes[i] != 0.0 && stdDevs[i] != 0.0) ?
+                        forwards[i]*M_1_SQRTPI*M_SQRT1_2*std::exp(-0.5*d*d)
+                        : 0.0;
+                }
+            }
+            cumulativeNormal(d1);
+            cumulativeNormal(d2);
+            for (Size i=0; i<n; ++i)
+                prices[i] = w[i]*(forwards[i]*d1[i] - strikes[i]*d2[i]);
+        }
+
+    }
+
+    inline Disposable<Array> blackFormula(Option::Type optionType,
+                                          const Array& strikes,
+                                          const Array& forwards,
+                                          const Array& stdDevs,
+                                          Real discount,
+                                          Real displacement) {
+        detail::checkBatchSizes(strikes, forwards, stdDevs);
+        QL_REQUIRE(discount>0.0,
+                   "discount (" << discount << ") must be positive");
+        const Size n = strikes.size();
+        for (Size i=0; i<n; ++i) {
+            checkParameters(strikes[i], forwards[i], displacement);
+            QL_REQUIRE(stdDevs[i]>=0.0,
+                       "stdDev (" << stdDevs[i] << ") must be non-negative");
+        }
+
+        const Array k = strikes + displacement, f = forwards + displacement;
+        const Array w(n, Real(optionType));
+        Array prices(n);
+        detail::blackBatch(w, k, f, stdDevs, prices);
+
+        Array result(n);
+        for (Size i=0; i<n; ++i) {
+            if (stdDevs[i]==0.0)
+                result[i] = std::max((forwards[i]-strikes[i])*optionType,
+                                     Real(0.0))*discount;
+            else if (k[i]==0.0)
+                result[i] = (optionType==Option::Call ? f[i]*discount : 0.0);
+            else
+                result[i] = discount*prices[i];
+            QL_ENSURE(result[i]>=0.0,
+                      "negative value (" << result[i] << ") for " <<
+                      stdDevs[i] << " stdDev, " <<
+                      optionType << " option, " <<
+                      strikes[i] << " strike , " <<
+                      forwards[i] << " forward");
+        }
+        return result;
+    }
+
+    inline Disposable<Array> blackFormulaStdDevDerivative(
+                                                 const Array& strikes,
+                                                 const Array& forwards,
+                                                 const Array& stdDevs,
+                                                 Real discount,
+                                                 Real displacement) {
+        detail::checkBatchSizes(strikes, forwards, stdDevs);
+        QL_REQUIRE(discount>0.0,
+                   "discount (" << discount << ") must be positive");
+        const Size n = strikes.size();
+        for (Size i=0; i<n; ++i) {
+            checkParameters(strikes[i], forwards[i], displacement);
+            QL_REQUIRE(stdDevs[i]>=0.0,
+                       "stdDev (" << stdDevs[i] << ") must be non-negative");
+        }
+
+        Array result(n);
+        for (Size i=0; i<n; ++i) {
+            const Real k = strikes[i] + displacement,
+                       f = forwards[i] + displacement,
+                       s = stdDevs[i];
+            const bool regular = (k != 0.0 && s != 0.0);
+            const Real d1 = regular ? std::log(f/k)/s + 0.5*s : 0.0;
+            result[i] = regular ?
+                discount*f*M_1_SQRTPI*M_SQRT1_2*std::exp(-0.5*d1*d1) : 0.0;
+        }
+        return result;
+    }
+
+    inline Disposable<Array> blackFormulaImpliedStdDev(
+                                                 Option::Type optionType,
+                                                 const Array& strikes,
+                                                 const Array& forwards,
+                                                 const Array& blackPrices,
+                                                 Real discount,
+                                                 Real displacement,
+                                                 Real accuracy,
+                                                 Natural maxIterations) {
+        detail::checkBatchSizes(strikes, forwards, blackPrices);
+        QL_REQUIRE(discount>0.0,
+                   "discount (" << discount << ") must be positive");
+        QL_REQUIRE(accuracy>0.0,
+                   "accuracy (" << accuracy << ") must be positive");
+        accuracy = std::max(accuracy, QL_EPSILON);
+        const Size n = strikes.size();
+
+        // as in the scalar version, each option is replaced by the
+        // out-of-the-money one, which is numerically more robust
+        Array w(n), k(n), f(n), target(n);
+        for (Size i=0; i<n; ++i) {
+            checkParameters(strikes[i], forwards[i], displacement);
+            QL_REQUIRE(blackPrices[i]>=0.0,
+                       "option price (" << blackPrices[i]
+                       << ") must be non-negative");
+            Real price = blackPrices[i];
+            Real otherOptionPrice =
+                price - optionType*(forwards[i]-strikes[i])*discount;
+            QL_REQUIRE(otherOptionPrice>=0.0,
+                       "negative " << Option::Type(-1*optionType) <<
+                       " price (" << otherOptionPrice <<
+                       ") implied by put-call parity. No solution exists for " <<
+                       optionType << " strike " << strikes[i] <<
+                       ", forward " << forwards[i] <<
+                       ", price " << price <<
+                       ", deflator " << discount);
+            Option::Type type = optionType;
+            if ((type==Option::Put && strikes[i]>forwards[i]) ||
+                (type==Option::Call && strikes[i]<forwards[i])) {
+                type = Option::Type(-1*type);
+                price = otherOptionPrice;
+            }
+            w[i] = type;
+            k[i] = strikes[i] + displacement;
+            f[i] = forwards[i] + displacement;
+            target[i] = price/discount;
+        }
+
+        // the root must be bracketed by the same bounds used by the
+        // scalar version
+        const Real minStdDev = 0.0, maxStdDev = 24.0;
+        Array lower(n, minStdDev), upper(n, maxStdDev);
+        Array prices(n);
+        detail::blackBatch(w, k, f, upper, prices);
+        Array stdDevs(n);
+        std::vector<Size> active;
+        active.reserve(n);
+        for (Size i=0; i<n; ++i) {
+            QL_REQUIRE(prices[i] >= target[i],
+                       "root not bracketed: price " << target[i]*discount
+                       << " exceeds the one for stdDev " << maxStdDev
+                       << " for strike " << strikes[i]);
+            if (target[i] == 0.0 || k[i] == 0.0) {
+                // out-of-the-money option with no time value
+                stdDevs[i] = 0.0;
+            } else {
+                Real guess = blackFormulaImpliedStdDevApproximation(
+                    Option::Type(Integer(w[i])), strikes[i], forwards[i],
+                    target[i]*discount, discount, displacement);
+                if (!(guess > minStdDev && guess < maxStdDev))
+                    guess = 0.5*(minStdDev+maxStdDev);
+                stdDevs[i] = guess;
+                active.push_back(i);
+            }
+        }
+
+        // safeguarded Newton iterations, performed on the options
+        // not converged yet, gathered into contiguous arrays; the
+        // evaluations are counted as by the scalar solver, starting
+        // with the two bracketing ones
+        for (Natural evaluations=2;
+             evaluations<maxIterations && !active.empty(); ++evaluations) {
+            const Size m = active.size();
+            Array wa(m), ka(m), fa(m), sa(m), pa(m), va(m);
+            for (Size j=0; j<m; ++j) {
+                const Size i = active[j];
+                wa[j] = w[i]; ka[j] = k[i]; fa[j] = f[i]; sa[j] = stdDevs[i];
+            }
+            detail::blackBatch(wa, ka, fa, sa, pa, &va);
+
+            Size stillActive = 0;
+            for (Size j=0; j<m; ++j) {
+                const Size i = active[j];
+                const Real s = sa[j], error = pa[j] - target[i];
+                if (error == 0.0)
+                    continue;
+                if (error < 0.0)
+                    lower[i] = s;
+                else
+                    upper[i] = s;
+                Real next = (va[j] > 0.0) ? s - error/va[j] : lower[i]-1.0;
+                // bisect when Newton's step leaves the bracket
+                if (!(next > lower[i] && next < upper[i]))
+                    next = 0.5*(lower[i]+upper[i]);
+                stdDevs[i] = next;
+                if (std::fabs(next-s) >= accuracy)
+                    active[stillActive++] = i;
+            }
+            active.resize(stillActive);
+        }
+        QL_REQUIRE(active.empty(),
+                   "maximum number of function evaluations ("
+                   << maxIterations << ") exceeded for "
+                   << active.size() << " options");
+
+        return stdDevs;
+    }
+
+    inline Disposable<Array> bachelierBlackFormula(Option::Type optionType,
+                                                   const Array& strikes,
+                                                   const Array& forwards,
+                                                   const Array& stdDevs,
+                                                   Real discount) {
+        detail::checkBatchSizes(strikes, forwards, stdDevs);
+        QL_REQUIRE(discount>0.0,
+                   "discount (" << discount << ") must be positive");
+        const Size n = strikes.size();
+        for (Size i=0; i<n; ++i)
+            QL_REQUIRE(stdDevs[i]>=0.0,
+                       "stdDev (" << stdDevs[i] << ") must be non-negative");
+
+        Array d(n), h(n), density(n);
+        for (Size i=0; i<n; ++i) {
+            const Real s = stdDevs[i];
+            d[i] = (forwards[i]-strikes[i])*optionType;
+            h[i] = (s != 0.0) ? d[i]/s : 0.0;
+            density[i] = M_1_SQRTPI*M_SQRT1_2*std::exp(-0.5*h[i]*h[i]);
+        }
+        detail::cumulativeNormal(h);
+
+        Array result(n);
+        for (Size i=0; i<n; ++i) {
+            const Real s = stdDevs[i];
+            result[i] = (s != 0.0) ?
+                discount*(s*density[i] + d[i]*h[i]) :
+                discount*std::max(d[i], 0.0);
+            QL_ENSURE(result[i]>=0.0,
+                      "negative value (" << result[i] << ") for " <<
+                      s << " stdDev, " <<
+                      optionType << " option, " <<
+                      strikes[i] << " strike , " <<
+                      forwards[i] << " forward");
+        }
+        return result;
+    }
+
+    inline Disposable<Array> bachelierBlackFormulaStdDevDerivative(
+                                                 const Array& strikes,
+                                                 const Array& forwards,
+                                                 const Array& stdDevs,
+                                                 Real discount) {
+        detail::checkBatchSizes(strikes, forwards, stdDevs);
+        QL_REQUIRE(discount>0.0,
+                   "discount (" << discount << ") must be positive");
+        const Size n = strikes.size();
+        for (Size i=0; i<n; ++i)
+            QL_REQUIRE(stdDevs[i]>=0.0,
+                       "stdDev (" << stdDevs[i] << ") must be non-negative");
+
+        Array result(n);
+        for (Size i=0; i<n; ++i) {
+            const Real s = stdDevs[i];
+            const Real d1 = (s != 0.0) ? (forwards[i]-strikes[i])/s : 0.0;
+            result[i] = (s != 0.0) ?
+                discount*M_1_SQRTPI*M_SQRT1_2*std::exp(-0.5*d1*d1) : 0.0;
+        }
+        return result;
+    }
+
+    inline Disposable<Array> bachelierBlackFormulaImpliedVol(
+                                                 Option::Type optionType,
+                                                 const Array& strikes,
+                                                 const Array& forwards,
+                                                 Real tte,
+                                                 const Array& bachelierPrices,
+                                                 Real discount) {
+        detail::checkBatchSizes(strikes, forwards, bachelierPrices);
+        Array result(strikes.size());
+        for (Size i=0; i<strikes.size(); ++i)
+            result[i] = bachelierBlackFormulaImpliedVol(
+                optionType, strikes[i], forwards[i], tte,
+                bachelierPrices[i], discount);
+        return result;
+    }
+
+
 }
 
 #endif
\ No newline at end of file
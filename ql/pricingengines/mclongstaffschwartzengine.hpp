@@ -30,6 +30,7 @@
 #include <ql/exercise.hpp>
 #include <ql/pricingengines/mcsimulation.hpp>
 #include <ql/methods/montecarlo/longstaffschwartzpathpricer.hpp>
+#include <ql/math/randomnumbers/mt19937uniformrng.hpp>
 
 #include <boost/make_shared.hpp>
 
@@ -69,7 +70,14 @@ namespace QuantLib {
           calibration and pricing; note however that this has no effect
           for low discrepancy RNGs usually, it is therefore recommended
           to use pseudo random generators for the calibration phase always
-          (and possibly quasi monte carlo in the subsequent pricing). */
+          (and possibly quasi monte carlo in the subsequent pricing).
+
+          If more than one thread is given, pricing samples are split
+          among as many workers; the first uses the pricing seed, the
+          others use seeds derived from it and copies of the
+          calibrated path pricer.  Calibration paths are
+          always generated on a single thread; the regressions are run
+          in parallel by the path pricer when OpenMP is enabled. */
         MCLongstaffSchwartzEngine(
             const boost::shared_ptr<StochasticProcess>& process,
             Size timeSteps,
@@ -84,7 +92,8 @@ namespace QuantLib {
             Size nCalibrationSamples = Null<Size>(),
             boost::optional<bool> brownianBridgeCalibration = boost::none,
             boost::optional<bool> antitheticVariateCalibration = boost::none,
-            BigNatural seedCalibration = Null<Size>());
+            BigNatural seedCalibration = Null<Size>(),
+            Size threads = 1);
 
         void calculate() const;
 
@@ -95,6 +104,9 @@ namespace QuantLib {
         TimeGrid timeGrid() const;
         boost::shared_ptr<path_pricer_type> pathPricer() const;
         boost::shared_ptr<path_generator_type> pathGenerator() const;
+        boost::shared_ptr<path_generator_type>
+        workerPathGenerator(Size i) const;
+        boost::shared_ptr<path_pricer_type> workerPathPricer(Size i) const;
 
         boost::shared_ptr<StochasticProcess> process_;
         const Size timeSteps_;
@@ -111,6 +123,8 @@ namespace QuantLib {
 
         mutable boost::shared_ptr<LongstaffSchwartzPathPricer<path_type> >
             pathPricer_;
+        mutable std::vector<boost::shared_ptr<
+                   LongstaffSchwartzPathPricer<path_type> > > workerPricers_;
         mutable boost::shared_ptr<MonteCarloModel<MC, RNG_Calibration, S> >
             mcModelCalibration_;
     };
@@ -132,8 +146,9 @@ namespace QuantLib {
             Size nCalibrationSamples,
             boost::optional<bool> brownianBridgeCalibration,
             boost::optional<bool> antitheticVariateCalibration,
-            BigNatural seedCalibration)
-    : McSimulation<MC,RNG,S> (antitheticVariate, controlVariate),
+            BigNatural seedCalibration,
+            Size threads)
+    : McSimulation<MC,RNG,S> (antitheticVariate, controlVariate, threads),
       process_            (process),
       timeSteps_          (timeSteps),
       timeStepsPerYear_   (timeStepsPerYear),
@@ -201,15 +216,18 @@ namespace QuantLib {
         mcModelCalibration_->addSamples(nCalibrationSamples_);
         pathPricer_->calibrate();
         // pricing
+        workerPricers_.clear();
         McSimulation<MC,RNG,S>::calculate(requiredTolerance_,
                                           requiredSamples_,
                                           maxSamples_);
+        for (Size i=0; i<workerPricers_.size(); ++i)
+            pathPricer_->mergeExerciseProbability(*workerPricers_[i]);
+        workerPricers_.clear();
         this->results_.value = this->mcModel_->sampleAccumulator().mean();
         this->results_.additionalResults["exerciseProbability"] =
             this->pathPricer_->exerciseProbability();
         if (RNG::allowsErrorEstimate) {
-            this->results_.errorEstimate =
-                this->mcModel_->sampleAccumulator().errorEstimate();
+            this->results_.errorEstimate = this->errorEstimate();
         }
     }
 
@@ -259,6 +277,49 @@ namespace QuantLib {
                                            grid, generator, brownianBridge_));
     }
 
+    template <class GenericEngine, template <class> class MC, class RNG,
+              class S, class RNG_Calibration>
+    inline boost::shared_ptr<typename MCLongstaffSchwartzEngine<
+        GenericEngine, MC, RNG, S, RNG_Calibration>::path_generator_type>
+    MCLongstaffSchwartzEngine<GenericEngine, MC, RNG, S,
+                              RNG_Calibration>::workerPathGenerator(Size i)
+                                                                      const {
+
+        // worker 0 reproduces the single-threaded stream; the others
+        // use seeds drawn from a generator initialized with seed_
+        BigNatural seed = seed_;
+        if (seed_ != 0 && i > 0) {
+            MersenneTwisterUniformRng seeder(seed_);
+            for (Size k=0; k<i; ++k)
+                seed = seeder.nextInt32();
+        }
+
+        Size dimensions = process_->factors();
+        TimeGrid grid = this->timeGrid();
+        typename RNG::rsg_type generator =
+            RNG::make_sequence_generator(dimensions*(grid.size()-1),seed);
+        return boost::shared_ptr<path_generator_type>(
+                   new path_generator_type(process_,
+                                           grid, generator, brownianBridge_));
+    }
+
+    template <class GenericEngine, template <class> class MC, class RNG,
+              class S, class RNG_Calibration>
+    inline boost::shared_ptr<typename MCLongstaffSchwartzEngine<
+        GenericEngine, MC, RNG, S, RNG_Calibration>::path_pricer_type>
+    MCLongstaffSchwartzEngine<GenericEngine, MC, RNG, S,
+                              RNG_Calibration>::workerPathPricer(Size i)
+                                                                      const {
+
+        // the pricer keeps exercise statistics, so each worker gets
+        // its own copy; they are merged at the end of calculate()
+        QL_REQUIRE(pathPricer_, "path pricer unknown");
+        if (i == 0)
+            return pathPricer_;
+        workerPricers_.push_back(pathPricer_->clone());
+        return workerPricers_.back();
+    }
+
 }
 
 
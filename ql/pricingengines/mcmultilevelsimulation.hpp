@@ -0,0 +1,342 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file mcmultilevelsimulation.hpp
+    \brief framework for multi-level Monte Carlo engines
+*/
+
+#ifndef quantlib_multi_level_montecarlo_engine_hpp
+#define quantlib_multi_level_montecarlo_engine_hpp
+
+#include <ql/methods/montecarlo/montecarlomodel.hpp>
+#include <cmath>
+
+namespace QuantLib {
+
+    //! base class for multi-level Monte Carlo engines
+    /*! The value of a payoff on the finest time grid \f$ L \f$ is
+        written as the telescopic sum
+        \f[
+            E[P_L] = E[P_0] + \sum_{l=1}^{L} E[P_l - P_{l-1}],
+        \f]
+        where \f$ P_l \f$ is the payoff on a grid with \f$ n_0 M^l \f$
+        steps; each term is estimated by an independent simulation,
+        the corrections on fine and coarse paths driven by the same
+        Brownian increments (see MultiLevelPathGenerator).  Since the
+        variance of the corrections decreases with the step size, most
+        samples are drawn on the cheap coarse levels.
+
+        When a tolerance is required, it is taken as the target
+        root-mean-square error: the number of samples on each level
+        is chosen from the observed variances so as to minimize the
+        cost for a statistical error of \f$ \epsilon/\sqrt{2} \f$,
+        and levels are added until the estimated discretization bias
+        (assuming first-order weak convergence, as for the Euler
+        scheme) is below \f$ \epsilon/\sqrt{2} \f$ as well.
+
+        For more details see M.B. Giles, "Multilevel Monte Carlo path
+        simulation", Operations Research, 56(3), 2008.
+
+        The interface mirrors the one of McSimulation.
+    */
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class McMultiLevelSimulation {
+      public:
+        typedef MonteCarloModel<SingleVariate,RNG,S> base_model_type;
+        typedef MonteCarloModel<MultiLevelVariate,RNG,S>
+            correction_model_type;
+        typedef typename base_model_type::path_pricer_type path_pricer_type;
+        typedef S stats_type;
+        typedef Real result_type;
+
+        virtual ~McMultiLevelSimulation() {}
+        /*! add levels and samples until the required root-mean-square
+            error is reached */
+        result_type value(Real tolerance,
+                          Size maxSamples = QL_MAX_INTEGER,
+                          Size minSamples = 1023) const;
+        /*! simulate all levels, with the given number of samples on
+            the coarsest one and a number decreasing as the inverse
+            of the number of steps on the finer ones */
+        result_type valueWithSamples(Size samples) const;
+        //! statistical error estimated using the samples simulated so far
+        result_type errorEstimate() const;
+        //! number of levels simulated so far
+        Size levels() const {
+            return baseModel_ ? 1 + correctionModels_.size() : 0;
+        }
+        //! accumulator of the samples of the given level
+        const stats_type& sampleAccumulator(Size level) const;
+        //! number of time steps simulated so far
+        Real cost() const;
+        //! basic calculate method provided to inherited pricing engines
+        void calculate(Real requiredTolerance,
+                       Size requiredSamples,
+                       Size maxSamples) const;
+      protected:
+        /*! The coarsest level has the given number of steps; each
+            level multiplies it by the refinement factor.  Each level
+            draws from its own sequence generator, seeded with the
+            given seed plus the level.
+        */
+        McMultiLevelSimulation(Size coarsestSteps,
+                               Size refinement,
+                               Size maxLevels,
+                               bool antitheticVariate,
+                               BigNatural seed)
+        : coarsestSteps_(coarsestSteps), refinement_(refinement),
+          maxLevels_(maxLevels), antitheticVariate_(antitheticVariate),
+          seed_(seed) {
+            QL_REQUIRE(coarsestSteps > 0, "at least one time step required");
+            QL_REQUIRE(refinement > 1, "refinement factor must be at least 2");
+            QL_REQUIRE(maxLevels > 0, "at least one level required");
+        }
+        virtual boost::shared_ptr<StochasticProcess> process() const = 0;
+        virtual Time maturity() const = 0;
+        //! path pricer for paths on the given time grid
+        virtual boost::shared_ptr<path_pricer_type>
+        pathPricer(const TimeGrid&) const = 0;
+        //! number of time steps of the given level
+        Size timeSteps(Size level) const;
+      private:
+        Size levelSamples(Size level) const {
+            return sampleAccumulator(level).samples();
+        }
+        void addLevel() const;
+        void addSamples(Size level, Size samples) const;
+        Size coarsestSteps_, refinement_, maxLevels_;
+        bool antitheticVariate_;
+        BigNatural seed_;
+        mutable boost::shared_ptr<base_model_type> baseModel_;
+        mutable std::vector<boost::shared_ptr<correction_model_type> >
+            correctionModels_;
+    };
+
+
+    // inline definitions
+
+    template <class RNG, class S>
+    inline Size McMultiLevelSimulation<RNG,S>::timeSteps(Size level) const {
+        Size steps = coarsestSteps_;
+        for (Size l=0; l<level; ++l)
+            steps *= refinement_;
+        return steps;
+    }
+
+    template <class RNG, class S>
+    inline const typename McMultiLevelSimulation<RNG,S>::stats_type&
+    McMultiLevelSimulation<RNG,S>::sampleAccumulator(Size level) const {
+        QL_REQUIRE(level < levels(),
+                   "level " << level << " not simulated ("
+                   << levels() << " levels available)");
+        return level == 0 ? baseModel_->sampleAccumulator()
+                          : correctionModels_[level-1]->sampleAccumulator();
+    }
+
+    template <class RNG, class S>
+    inline Real McMultiLevelSimulation<RNG,S>::cost() const {
+        // a correction sample evolves both a fine and a coarse path
+        Real result = Real(levelSamples(0))*timeSteps(0);
+        for (Size l=1; l<levels(); ++l)
+            result += Real(levelSamples(l))*(timeSteps(l) + timeSteps(l-1));
+        return antitheticVariate_ ? 2.0*result : result;
+    }
+
+    template <class RNG, class S>
+    inline void McMultiLevelSimulation<RNG,S>::addLevel() const {
+        const Size level = levels();
+        QL_REQUIRE(level < maxLevels_,
+                   "max number of levels (" << maxLevels_ << ") reached");
+        const Size steps = timeSteps(level), coarseSteps = timeSteps(level-1);
+        const BigNatural seed = (seed_ == 0 ? 0 : seed_ + level);
+        const TimeGrid fineGrid(maturity(), steps),
+                       coarseGrid(maturity(), coarseSteps);
+        const boost::shared_ptr<typename correction_model_type::
+                                path_generator_type> generator(
+            new typename correction_model_type::path_generator_type(
+                process(), maturity(), steps, coarseSteps,
+                RNG::make_sequence_generator(steps, seed)));
+        const boost::shared_ptr<typename correction_model_type::
+                                path_pricer_type> pricer(
+            new CoupledPathPricer(pathPricer(fineGrid),
+                                  pathPricer(coarseGrid)));
+        correctionModels_.push_back(
+            boost::shared_ptr<correction_model_type>(
+                new correction_model_type(generator, pricer, S(),
+                                          antitheticVariate_)));
+    }
+
+    template <class RNG, class S>
+    inline void McMultiLevelSimulation<RNG,S>::addSamples(
+                                             Size level, Size samples) const {
+        if (level == 0)
+            baseModel_->addSamples(samples);
+        else
+            correctionModels_[level-1]->addSamples(samples);
+    }
+
+    template <class RNG, class S>
+    inline typename McMultiLevelSimulation<RNG,S>::result_type
+    McMultiLevelSimulation<RNG,S>::value(Real tolerance,
+                                         Size maxSamples,
+                                         Size minSamples) const {
+        QL_REQUIRE(tolerance > 0.0, "non-positive tolerance");
+        QL_REQUIRE(minSamples > 1, "at least two samples per level required");
+
+        // start with three levels at most, as suggested by Giles
+        while (levels() < std::min<Size>(3, maxLevels_))
+            addLevel();
+
+        Size total = 0;
+        for (Size l=0; l<levels(); ++l)
+            total += levelSamples(l);
+
+        const Real M = Real(refinement_);
+        const Real targetVariance = 0.5*tolerance*tolerance;
+        for (;;) {
+            // samples needed on each level for the statistical error
+            const Size L = levels();
+            std::vector<Real> V(L), C(L);
+            Real sum = 0.0;
+            for (Size l=0; l<L; ++l) {
+                if (levelSamples(l) < minSamples) {
+                    const Size n = minSamples - levelSamples(l);
+                    QL_REQUIRE(total + n <= maxSamples,
+                               "max number of samples (" << maxSamples
+                               << ") reached");
+                    total += n;
+                    addSamples(l, n);
+                }
+                V[l] = sampleAccumulator(l).variance();
+                C[l] = Real(timeSteps(l)) +
+                       (l > 0 ? Real(timeSteps(l-1)) : 0.0);
+                sum += std::sqrt(V[l]*C[l]);
+            }
+            bool added = false;
+            for (Size l=0; l<L; ++l) {
+                const Real optimal = std::ceil(std::sqrt(V[l]/C[l])*sum
+                                               /targetVariance);
+                if (optimal > Real(levelSamples(l))) {
+                    const Size n = Size(std::min<Real>(
+                                 optimal - levelSamples(l), Real(maxSamples)));
+                    QL_REQUIRE(n <= maxSamples - total,
+                               "max number of samples (" << maxSamples
+                               << ") reached, while error ("
+                               << errorEstimate()
+                               << ") is still above tolerance ("
+                               << tolerance << ")");
+                    total += n;
+                    addSamples(l, n);
+                    added = true;
+                }
+            }
+            // the allocation is recomputed with the new variances
+            if (added)
+                continue;
+
+            // the bias is estimated from the last two corrections
+            if (L == 1)
+                break;
+            Real bias = std::fabs(sampleAccumulator(L-1).mean());
+            if (L > 2)
+                bias = std::max(bias,
+                                std::fabs(sampleAccumulator(L-2).mean())/M);
+            bias /= M - 1.0;
+            if (bias*bias <= targetVariance)
+                break;
+            QL_REQUIRE(L < maxLevels_,
+                       "max number of levels (" << maxLevels_
+                       << ") reached, while estimated bias (" << bias
+                       << ") is still above tolerance ("
+                       << std::sqrt(targetVariance) << ")");
+            addLevel();
+        }
+
+        Real result = 0.0;
+        for (Size l=0; l<levels(); ++l)
+            result += sampleAccumulator(l).mean();
+        return result;
+    }
+
+    template <class RNG, class S>
+    inline typename McMultiLevelSimulation<RNG,S>::result_type
+    McMultiLevelSimulation<RNG,S>::valueWithSamples(Size samples) const {
+        while (levels() < maxLevels_)
+            addLevel();
+
+        Real result = 0.0;
+        Size n = samples;
+        for (Size l=0; l<levels(); ++l) {
+            QL_REQUIRE(n >= levelSamples(l),
+                       "number of already simulated samples ("
+                       << levelSamples(l) << ") on level " << l
+                       << " greater than requested samples (" << n << ")");
+            addSamples(l, n - levelSamples(l));
+            result += sampleAccumulator(l).mean();
+            n = std::max<Size>((n + refinement_ - 1)/refinement_, 2);
+        }
+        return result;
+    }
+
+    template <class RNG, class S>
+    inline typename McMultiLevelSimulation<RNG,S>::result_type
+    McMultiLevelSimulation<RNG,S>::errorEstimate() const {
+        Real variance = 0.0;
+        for (Size l=0; l<levels(); ++l) {
+            const Real error = sampleAccumulator(l).errorEstimate();
+            variance += error*error;
+        }
+        return std::sqrt(variance);
+    }
+
+    template <class RNG, class S>
+    inline void McMultiLevelSimulation<RNG,S>::calculate(
+                                                   Real requiredTolerance,
+                                                   Size requiredSamples,
+                                                   Size maxSamples) const {
+
+        QL_REQUIRE(requiredTolerance != Null<Real>() ||
+                   requiredSamples != Null<Size>(),
+                   "neither tolerance nor number of samples set");
+
+        const Size steps = timeSteps(0);
+        baseModel_ = boost::shared_ptr<base_model_type>(
+            new base_model_type(
+                boost::shared_ptr<typename base_model_type::
+                                  path_generator_type>(
+                    new typename base_model_type::path_generator_type(
+                        process(), maturity(), steps,
+                        RNG::make_sequence_generator(steps, seed_),
+                        false)),
+                pathPricer(TimeGrid(maturity(), steps)), S(),
+                antitheticVariate_));
+        correctionModels_.clear();
+
+        if (requiredTolerance != Null<Real>()) {
+            if (maxSamples != Null<Size>())
+                this->value(requiredTolerance, maxSamples);
+            else
+                this->value(requiredTolerance);
+        } else {
+            this->valueWithSamples(requiredSamples);
+        }
+    }
+
+}
+
+
+#endif
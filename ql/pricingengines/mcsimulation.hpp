@@ -28,6 +28,8 @@
 
 #include <ql/grid.hpp>
 #include <ql/methods/montecarlo/montecarlomodel.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/type_traits/integral_constant.hpp>
 
 namespace QuantLib {
 
@@ -36,6 +38,31 @@ namespace QuantLib {
         class from McSimulation gives an easy way to write a Monte
         Carlo engine.
 
+        Besides the control variate provided by the engine, any
+        number of control variates with known expectations can be
+        attached with addControlVariate(); their coefficients are
+        estimated on a pilot run at the start of each calculation.
+        The pilot samples are drawn in addition to the required ones
+        and are not counted in the estimate, which would otherwise
+        be biased; the coefficients can only be estimated for scalar
+        results.
+
+        When a tolerance is required, samples are added in batches
+        sized after the current error estimate, and the simulation
+        stops as soon as the tolerance is met.  A sample or time
+        budget can also be set, after which the best estimate
+        obtained so far is returned instead of raising an error as
+        when the maximum number of samples is reached.  A sample
+        budget gives reproducible results; a time budget adapts to
+        the speed of the machine, but its results depend on its
+        load and are not reproducible.
+
+        With randomized quasi-Monte Carlo traits (see
+        GenericRandomizedLowDiscrepancy) each worker draws from an
+        independent randomization of the low-discrepancy sequence,
+        and the error is estimated from the spread of the worker
+        means rather than from the spread of the samples.
+
         See McVanillaEngine as an example.
     */
 
@@ -51,13 +78,20 @@ namespace QuantLib {
         typedef typename MonteCarloModel<MC,RNG,S>::result_type result_type;
 
         virtual ~McSimulation() {}
-        //! add samples until the required absolute tolerance is reached
+        /*! add samples until the required absolute tolerance is
+            reached, or until the sample or time budget is exhausted */
         result_type value(Real tolerance,
                           Size maxSamples = QL_MAX_INTEGER,
                           Size minSamples = 1023) const;
-        //! simulate a fixed number of samples
+        /*! simulate a fixed number of samples, or as many as
+            possible within the sample or time budget */
         result_type valueWithSamples(Size samples) const;
-        //! error estimated using the samples simulated so far
+        /*! error estimated using the samples simulated so far; if
+            control variates are used, this is the standard error of
+            the controlled estimator.  For randomized quasi-Monte
+            Carlo, it is the standard error of the mean of the
+            independent randomizations run by the workers.
+        */
         result_type errorEstimate() const;
         //! access to the sample accumulator for richer statistics
         const stats_type& sampleAccumulator(void) const;
@@ -65,14 +99,92 @@ namespace QuantLib {
         void calculate(Real requiredTolerance,
                        Size requiredSamples,
                        Size maxSamples) const;
+        //! \name Control variates with estimated coefficients
+        //@{
+        /*! adds a control variate, i.e., a path pricer whose
+            expectation is known; it is evaluated on the same paths
+            as the engine's path pricer and must be reentrant if
+            more than one thread is used.
+        */
+        void addControlVariate(
+                        const boost::shared_ptr<path_pricer_type>& pricer,
+                        result_type expectation);
+        /*! number of pilot samples used to estimate the coefficients;
+            they are drawn before, and discarded from, the samples
+            required by each calculation.
+        */
+        void setControlVariatePilotSamples(Size samples) {
+            pilotSamples_ = samples;
+        }
+        //! coefficients estimated in the last calculation
+        const std::vector<Real>& controlVariateCoefficients() const {
+            QL_REQUIRE(mcModel_, "no simulation performed");
+            return mcModel_->controlVariateCoefficients();
+        }
+        //@}
+        /*! sets the number of samples allowed to each calculation,
+            not counting the pilot samples of the control variates;
+            Null<Size>() removes the limit.
+        */
+        void setSampleBudget(Size samples) {
+            QL_REQUIRE(samples != 0, "null sample budget");
+            sampleBudget_ = samples;
+        }
+        /*! sets the wall-clock time, in seconds, allowed to each
+            calculation; Null<Real>() removes the limit.  At least
+            one batch of samples is simulated regardless of the
+            budget.
+
+            \warning the number of samples simulated depends on the
+                     load of the machine, so that results are not
+                     reproducible; use a sample budget when they
+                     need to be.
+        */
+        void setTimeBudget(Real seconds) {
+            QL_REQUIRE(seconds == Null<Real>() || seconds > 0.0,
+                       "non-positive time budget (" << seconds << ")");
+            timeBudget_ = seconds;
+        }
       protected:
+        /*! If more than one thread is requested, samples are split
+            among as many workers, each one using the path generator
+            and pricer returned by workerPathGenerator() and
+            workerPathPricer().  Results depend on the number of
+            threads but not on scheduling.
+        */
         McSimulation(bool antitheticVariate,
-                     bool controlVariate)
+                     bool controlVariate,
+                     Size threads = 1)
         : antitheticVariate_(antitheticVariate),
-          controlVariate_(controlVariate) {}
+          controlVariate_(controlVariate), threads_(threads),
+          pilotSamples_(1000), sampleBudget_(Null<Size>()),
+          timeBudget_(Null<Real>()) {
+            QL_REQUIRE(threads > 0, "at least one thread required");
+        }
         virtual boost::shared_ptr<path_pricer_type> pathPricer() const = 0;
         virtual boost::shared_ptr<path_generator_type> pathGenerator()
                                                                    const = 0;
+        /*! Path generator for the i-th worker in parallel mode.
+            Engines supporting more than one thread must override it
+            so that each worker draws from an independent stream.
+        */
+        virtual boost::shared_ptr<path_generator_type>
+        workerPathGenerator(Size i) const {
+            QL_REQUIRE(i == 0,
+                       "engine does not provide independent "
+                       "path-generator streams");
+            return pathGenerator();
+        }
+        /*! Path pricer for the i-th worker in parallel mode.  The
+            default implementation calls pathPricer() once for each
+            worker; engines whose pathPricer() returns the same
+            instance on each call must override it so that workers
+            don't share a pricer, unless the latter is reentrant.
+        */
+        virtual boost::shared_ptr<path_pricer_type>
+        workerPathPricer(Size) const {
+            return pathPricer();
+        }
         virtual TimeGrid timeGrid() const = 0;
         virtual boost::shared_ptr<path_pricer_type> controlPathPricer() const {
             return boost::shared_ptr<path_pricer_type>();
@@ -87,6 +199,22 @@ namespace QuantLib {
         virtual result_type controlVariateValue() const {
             return Null<result_type>();
         }
+        /*! Control variates whose coefficients are to be estimated.
+            The default implementation returns those added by
+            addControlVariate(); engines can override it to provide
+            their own.
+        */
+        virtual void controlVariates(
+                   std::vector<boost::shared_ptr<path_pricer_type> >& pricers,
+                   std::vector<result_type>& expectations) const {
+            pricers = controlPricers_;
+            expectations = controlValues_;
+        }
+        /*! adds the given number of samples, or as many as the
+            sample and time budgets allow; returns the number of
+            samples added.
+        */
+        Size addSamples(Size samples) const;
         template <class Sequence>
         static Real maxError(const Sequence& sequence) {
             return *std::max_element(sequence.begin(), sequence.end());
@@ -97,42 +225,106 @@ namespace QuantLib {
         
         mutable boost::shared_ptr<MonteCarloModel<MC,RNG,S> > mcModel_;
         bool antitheticVariate_, controlVariate_;
+        Size threads_;
+        std::vector<boost::shared_ptr<path_pricer_type> > controlPricers_;
+        std::vector<result_type> controlValues_;
+        Size pilotSamples_, sampleBudget_;
+        Real timeBudget_;
+        mutable boost::posix_time::ptime deadline_;
+      private:
+        // dispatched on the workerErrorEstimate trait
+        result_type errorEstimate(const boost::false_type&) const;
+        result_type errorEstimate(const boost::true_type&) const;
     };
 
 
     // inline definitions
+    template <template <class> class MC, class RNG, class S>
+    inline Size McSimulation<MC,RNG,S>::addSamples(Size samples) const {
+        using namespace boost::posix_time;
+
+        if (sampleBudget_ != Null<Size>()) {
+            const Size simulated = mcModel_->sampleAccumulator().samples();
+            samples = std::min(samples, simulated < sampleBudget_ ?
+                                        sampleBudget_ - simulated : 0);
+            if (samples == 0)
+                return 0;
+        }
+
+        if (deadline_.is_not_a_date_time()) {
+            mcModel_->addSamples(samples);
+            return samples;
+        }
+
+        // the first batch measures the speed of the simulation; the
+        // following ones are limited by the remaining time, and grow
+        // at most geometrically so that the speed is measured again
+        const ptime start = microsec_clock::universal_time();
+        Size added = 0, batch = std::min<Size>(samples, 64);
+        while (batch > 0) {
+            mcModel_->addSamples(batch);
+            added += batch;
+
+            const ptime now = microsec_clock::universal_time();
+            if (now >= deadline_)
+                break;
+            const Real elapsed = (now - start).total_microseconds()*1.0e-6;
+            const Real remaining =
+                (deadline_ - now).total_microseconds()*1.0e-6;
+            batch = std::min(samples - added, added);
+            if (elapsed > 0.0)
+                batch = std::min<Size>(batch,
+                                       Size(added*remaining/elapsed));
+        }
+        return added;
+    }
+
+
     template <template <class> class MC, class RNG, class S>
     inline typename McSimulation<MC,RNG,S>::result_type
         McSimulation<MC,RNG,S>::value(Real tolerance,
-                                              Size maxSamples,
-                                              Size minSamples) const {
+                                      Size maxSamples,
+                                      Size minSamples) const {
         Size sampleNumber =
             mcModel_->sampleAccumulator().samples();
         if (sampleNumber<minSamples) {
-            mcModel_->addSamples(minSamples-sampleNumber);
-            sampleNumber = mcModel_->sampleAccumulator().samples();
+            const Size missing = minSamples-sampleNumber;
+            sampleNumber += addSamples(missing);
+            if (sampleNumber < minSamples)
+                return result_type(mcModel_->sampleAccumulator().mean());
         }
 
-        Size nextBatch;
+        Size nextBatch, added;
         Real order;
-        result_type error(mcModel_->sampleAccumulator().errorEstimate());
+        result_type error(errorEstimate());
         while (maxError(error) > tolerance) {
             QL_REQUIRE(sampleNumber<maxSamples,
                        "max number of samples (" << maxSamples
                        << ") reached, while error (" << error
                        << ") is still above tolerance (" << tolerance << ")");
 
-            // conservative estimate of how many samples are needed
-            order = maxError(error*error)/tolerance/tolerance;
-            nextBatch =
-                Size(std::max<Real>(static_cast<Real>(sampleNumber)*order*0.8 - static_cast<Real>(sampleNumber),
-                                    static_cast<Real>(minSamples)));
+            // the error decreases as the inverse square root of the
+            // number of samples; the samples needed are extrapolated
+            // from the current estimate, but at most doubled so that
+            // the estimate is refined on the way.  A lower bound
+            // avoids tiny batches when close to the tolerance.
+            const Real maxErr = maxError(error);
+            order = maxErr*maxErr/tolerance/tolerance;
+            nextBatch = Size(std::ceil(std::min<Real>(
+                static_cast<Real>(sampleNumber)*(order-1.0),
+                static_cast<Real>(sampleNumber))));
+            nextBatch = std::max(nextBatch,
+                                 std::max<Size>(sampleNumber/16, 1));
 
             // do not exceed maxSamples
             nextBatch = std::min(nextBatch, maxSamples-sampleNumber);
-            sampleNumber += nextBatch;
-            mcModel_->addSamples(nextBatch);
-            error = result_type(mcModel_->sampleAccumulator().errorEstimate());
+            added = addSamples(nextBatch);
+            sampleNumber += added;
+            error = errorEstimate();
+
+            // the sample or time budget is exhausted
+            if (added < nextBatch)
+                break;
         }
 
         return result_type(mcModel_->sampleAccumulator().mean());
@@ -149,7 +341,7 @@ namespace QuantLib {
                    "number of already simulated samples (" << sampleNumber
                    << ") greater than requested samples (" << samples << ")");
 
-        mcModel_->addSamples(samples-sampleNumber);
+        addSamples(samples-sampleNumber);
 
         return result_type(mcModel_->sampleAccumulator().mean());
     }
@@ -164,9 +356,52 @@ namespace QuantLib {
                    requiredSamples != Null<Size>(),
                    "neither tolerance nor number of samples set");
 
+        using namespace boost::posix_time;
+        if (timeBudget_ != Null<Real>())
+            deadline_ = microsec_clock::universal_time() +
+                        microseconds(boost::int64_t(timeBudget_*1.0e6));
+        else
+            deadline_ = ptime(not_a_date_time);
+
         //! Initialize the one-factor Monte Carlo
-        if (this->controlVariate_) {
+        if (threads_ > 1) {
+
+            std::vector<boost::shared_ptr<path_generator_type> >
+                generators(threads_);
+            std::vector<boost::shared_ptr<path_pricer_type> >
+                pricers(threads_), controlPPs;
+            for (Size i=0; i<threads_; ++i) {
+                generators[i] = this->workerPathGenerator(i);
+                pricers[i] = this->workerPathPricer(i);
+            }
+
+            result_type controlVariateValue = result_type();
+            if (this->controlVariate_) {
+                controlVariateValue = this->controlVariateValue();
+                QL_REQUIRE(controlVariateValue != Null<result_type>(),
+                           "engine does not provide "
+                           "control-variation price");
+
+                QL_REQUIRE(!this->controlPathGenerator(),
+                           "separate control-variation path generator "
+                           "not supported with multiple threads");
+                // one control pricer per worker, as for the main one
+                controlPPs.resize(threads_);
+                for (Size i=0; i<threads_; ++i) {
+                    controlPPs[i] = this->controlPathPricer();
+                    QL_REQUIRE(controlPPs[i],
+                               "engine does not provide "
+                               "control-variation path pricer");
+                }
+            }
 
+            this->mcModel_ =
+                boost::shared_ptr<MonteCarloModel<MC,RNG,S> >(
+                    new MonteCarloModel<MC,RNG,S>(
+                           generators, pricers, stats_type(),
+                           this->antitheticVariate_, controlPPs,
+                           controlVariateValue));
+        } else if (this->controlVariate_) {
             result_type controlVariateValue = this->controlVariateValue();
             QL_REQUIRE(controlVariateValue != Null<result_type>(),
                        "engine does not provide "
@@ -195,6 +430,14 @@ namespace QuantLib {
                            this->antitheticVariate_));
         }
 
+        std::vector<boost::shared_ptr<path_pricer_type> > controlPricers;
+        std::vector<result_type> controlValues;
+        this->controlVariates(controlPricers, controlValues);
+        if (!controlPricers.empty()) {
+            this->mcModel_->setControlVariates(controlPricers, controlValues);
+            this->mcModel_->calibrateControlVariates(pilotSamples_);
+        }
+
         if (requiredTolerance != Null<Real>()) {
             if (maxSamples != Null<Size>())
                 this->value(requiredTolerance, maxSamples);
@@ -206,12 +449,51 @@ namespace QuantLib {
 
     }
 
+    template <template <class> class MC, class RNG, class S>
+    inline void McSimulation<MC,RNG,S>::addControlVariate(
+                        const boost::shared_ptr<path_pricer_type>& pricer,
+                        result_type expectation) {
+        QL_REQUIRE(pricer, "null control-variate path pricer");
+        controlPricers_.push_back(pricer);
+        controlValues_.push_back(expectation);
+    }
+
     template <template <class> class MC, class RNG, class S>
     inline typename McSimulation<MC,RNG,S>::result_type
         McSimulation<MC,RNG,S>::errorEstimate() const {
+        return errorEstimate(
+            boost::integral_constant<bool,
+                                     WorkerErrorEstimate<RNG>::value != 0>());
+    }
+
+    template <template <class> class MC, class RNG, class S>
+    inline typename McSimulation<MC,RNG,S>::result_type
+        McSimulation<MC,RNG,S>::errorEstimate(const boost::false_type&) const {
         return mcModel_->sampleAccumulator().errorEstimate();
     }
 
+    template <template <class> class MC, class RNG, class S>
+    inline typename McSimulation<MC,RNG,S>::result_type
+        McSimulation<MC,RNG,S>::errorEstimate(const boost::true_type&) const {
+        // the worker means are independent and identically
+        // distributed, while the samples of each worker are not
+        const Size n = mcModel_->workers();
+        QL_REQUIRE(n > 1,
+                   "at least two workers required to estimate the error "
+                   "of randomized quasi-Monte Carlo simulations");
+        Real mean = 0.0;
+        for (Size w=0; w<n; ++w)
+            mean += mcModel_->workerAccumulator(w).mean();
+        mean /= n;
+        Real variance = 0.0;
+        for (Size w=0; w<n; ++w) {
+            const Real d = mcModel_->workerAccumulator(w).mean() - mean;
+            variance += d*d;
+        }
+        variance /= n-1;
+        return std::sqrt(variance/n);
+    }
+
     template <template <class> class MC, class RNG, class S>
     inline const typename McSimulation<MC,RNG,S>::stats_type&
     McSimulation<MC,RNG,S>::sampleAccumulator() const {
@@ -18,6 +18,7 @@
 //#include <ql/pricingengines/vanilla/jumpdiffusionengine.hpp>
 //#include <ql/pricingengines/vanilla/juquadraticengine.hpp>
 #include <ql/pricingengines/vanilla/fdamericanengine.hpp>
+#include <ql/pricingengines/vanilla/fdbatchvanillaengine.hpp>
 //#include <ql/pricingengines/vanilla/fdbatesvanillaengine.hpp>
 #include <ql/pricingengines/vanilla/fdbermudanengine.hpp>
 //#include <ql/pricingengines/vanilla/fdblackscholesvanillaengine.hpp>
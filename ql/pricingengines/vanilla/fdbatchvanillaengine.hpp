@@ -0,0 +1,339 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file fdbatchvanillaengine.hpp
+    \brief Finite-differences engine for sets of vanilla options
+*/
+
+#ifndef quantlib_fd_batch_vanilla_engine_hpp
+#define quantlib_fd_batch_vanilla_engine_hpp
+
+#include <ql/pricingengines/vanilla/fdvanillaengine.hpp>
+#include <ql/instruments/payoffs.hpp>
+#include <ql/exercise.hpp>
+
+namespace QuantLib {
+
+    //! Finite-differences engine for sets of vanilla options
+    /*! European and American options on the same underlying are
+        priced together on a single log grid, wide enough for all the
+        strikes and for the longest maturity, and with a single
+        Black-Scholes-Merton operator.  The values of the options are
+        the columns of a matrix whose rows are the grid points; each
+        Crank-Nicolson step applies the operator and solves the
+        tridiagonal system for all of them, reusing the same
+        factorization.  Each option joins the rollback at its own
+        maturity, and American options are exercised from then on.
+
+        As in FDAmericanEngine, the value of American options is
+        corrected by the difference between the Black-Scholes value
+        and the finite-differences one of the corresponding European
+        option, which is rolled back as well.
+
+        The given time steps are distributed over the longest
+        maturity.  Unless a time-dependent operator is required, the
+        operator between two consecutive maturities uses the forward
+        rates and the forward variance over that interval; each
+        option thus sees the rates and variance integrated up to its
+        own maturity, as it would if priced alone, and European
+        options are consistent with their Black-Scholes values on
+        any term structures.
+
+        \ingroup vanillaengines
+    */
+    class FDBatchVanillaEngine : public FDVanillaEngine {
+      public:
+        FDBatchVanillaEngine(
+             const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+             Size timeSteps = 100, Size gridPoints = 100,
+             bool timeDependent = false)
+        : FDVanillaEngine(process, timeSteps, gridPoints, timeDependent) {}
+        //! prices the options with the given payoffs and exercises
+        void calculate(
+             const std::vector<boost::shared_ptr<StrikedTypePayoff> >&,
+             const std::vector<boost::shared_ptr<Exercise> >&) const;
+        //! \name Results
+        //@{
+        const std::vector<Real>& values() const { return values_; }
+        const std::vector<Real>& deltas() const { return deltas_; }
+        const std::vector<Real>& gammas() const { return gammas_; }
+        //@}
+      private:
+        TridiagonalOperator forwardOperator(Time t1, Time t2) const;
+        mutable std::vector<Real> values_, deltas_, gammas_;
+    };
+
+}
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/pricingengines/blackcalculator.hpp>
+#include <ql/methods/finitedifferences/pde.hpp>
+#include <algorithm>
+
+namespace QuantLib {
+
+    namespace detail {
+
+        // Black-Scholes-Merton coefficients averaged over an interval
+        class ForwardPdeBSM : public PdeSecondOrderParabolic {
+          public:
+            ForwardPdeBSM(Rate r, Rate q, Volatility sigma)
+            : sigma_(sigma), nu_(r-q-0.5*sigma*sigma), r_(r) {}
+            Real diffusion(Time, Real) const { return sigma_; }
+            Real drift(Time, Real) const { return nu_; }
+            Real discount(Time, Real) const { return r_; }
+          private:
+            Real sigma_, nu_, r_;
+        };
+
+    }
+
+    inline TridiagonalOperator FDBatchVanillaEngine::forwardOperator(
+                                                   Time t1, Time t2) const {
+        const Rate r = process_->riskFreeRate()->forwardRate(
+                                    t1, t2, Continuous, NoFrequency, true);
+        const Rate q = process_->dividendYield()->forwardRate(
+                                    t1, t2, Continuous, NoFrequency, true);
+        const Real variance = process_->blackVolatility()->
+            blackForwardVariance(t1, t2,
+                                 process_->stateVariable()->value(), true);
+        const Array& grid = intrinsicValues_.grid();
+        TridiagonalOperator L(grid.size());
+        detail::ForwardPdeBSM(r, q, std::sqrt(variance/(t2-t1)))
+            .generateOperator(t2, LogGrid(grid), L);
+        return L;
+    }
+
+    inline void FDBatchVanillaEngine::calculate(
+             const std::vector<boost::shared_ptr<StrikedTypePayoff> >& payoffs,
+             const std::vector<boost::shared_ptr<Exercise> >& exercises)
+                                                                      const {
+
+        const Size m = payoffs.size();
+        QL_REQUIRE(m > 0, "no options given");
+        QL_REQUIRE(exercises.size() == m,
+                   "number of exercises (" << exercises.size()
+                   << ") different from number of payoffs (" << m << ")");
+
+        std::vector<Time> maturities(m);
+        for (Size k=0; k<m; ++k) {
+            QL_REQUIRE(payoffs[k], "null payoff given");
+            QL_REQUIRE(exercises[k], "null exercise given");
+            QL_REQUIRE(exercises[k]->type() == Exercise::European ||
+                       exercises[k]->type() == Exercise::American,
+                       "only European and American options allowed");
+            maturities[k] = process_->time(exercises[k]->lastDate());
+            QL_REQUIRE(maturities[k] > 0.0, "expired option given");
+            if (k == 0 || maturities[k] > getResidualTime())
+                exerciseDate_ = exercises[k]->lastDate();
+        }
+
+        // common grid and operator
+        setGridLimits(process_->stateVariable()->value(),
+                      getResidualTime());
+        for (Size k=0; k<m; ++k) {
+            payoff_ = payoffs[k];
+            ensureStrikeInGrid();
+        }
+        intrinsicValues_.setLogGrid(sMin_, sMax_);
+        initializeOperator();
+
+        // Columns are sorted by decreasing maturity, so that the
+        // options in the rollback are always the first ones; the
+        // control of an American option follows it.
+        std::vector<std::pair<Time,Size> > order(m);
+        for (Size k=0; k<m; ++k)
+            order[k] = std::make_pair(-maturities[k], k);
+        std::sort(order.begin(), order.end());
+        std::vector<Size> column(m), control(m, Null<Size>());
+        Size columns = 0;
+        for (Size i=0; i<m; ++i) {
+            Size k = order[i].second;
+            column[k] = columns++;
+            if (exercises[k]->type() == Exercise::American)
+                control[k] = columns++;
+        }
+
+        const Size n = intrinsicValues_.size();
+        Matrix initial(n, columns), floor(n, columns, -QL_MAX_REAL);
+        std::vector<Real> lower(columns), upper(columns);
+        std::vector<Time> joinTimes(columns);
+        for (Size k=0; k<m; ++k) {
+            intrinsicValues_.sample(*payoffs[k]);
+            const Array& values = intrinsicValues_.values();
+            Size c = column[k];
+            for (Size j=0; j<n; ++j)
+                initial[j][c] = values[j];
+            // Neumann conditions as in FDVanillaEngine
+            lower[c] = values[1] - values[0];
+            upper[c] = values[n-1] - values[n-2];
+            joinTimes[c] = maturities[k];
+            if (control[k] != Null<Size>()) {
+                for (Size j=0; j<n; ++j)
+                    initial[j][control[k]] = floor[j][c] = values[j];
+                lower[control[k]] = lower[c];
+                upper[control[k]] = upper[c];
+                joinTimes[control[k]] = maturities[k];
+            }
+        }
+
+        // the rollback stops at each maturity, where options join
+        std::vector<Time> stoppingTimes = maturities;
+        stoppingTimes.push_back(0.0);
+        std::sort(stoppingTimes.begin(), stoppingTimes.end());
+        stoppingTimes.erase(std::unique(stoppingTimes.begin(),
+                                        stoppingTimes.end()),
+                            stoppingTimes.end());
+        const Time maxMaturity = stoppingTimes.back();
+
+        TridiagonalOperator& L = finiteDifferenceOperator_;
+        const TridiagonalOperator I = TridiagonalOperator::identity(n);
+        TridiagonalOperator explicitPart, implicitPart;
+        const Real theta = 0.5;
+
+        Matrix prices, buffer;
+        Size active = 0;
+        for (Size s=stoppingTimes.size()-1; s>0; --s) {
+            const Time from = stoppingTimes[s], to = stoppingTimes[s-1];
+
+            // add the options maturing here
+            Size joining = active;
+            while (joining < columns && joinTimes[joining] == from)
+                ++joining;
+            Matrix newPrices(n, joining);
+            for (Size j=0; j<n; ++j) {
+                if (active > 0)
+                    std::copy(prices.row_begin(j),
+                              prices.row_begin(j)+active,
+                              newPrices.row_begin(j));
+                std::copy(initial.row_begin(j)+active,
+                          initial.row_begin(j)+joining,
+                          newPrices.row_begin(j)+active);
+            }
+            prices.swap(newPrices);
+            buffer = Matrix(n, joining);
+            active = joining;
+
+            const Size steps = std::max<Size>(
+                       1, Size(timeSteps_*(from-to)/maxMaturity + 0.5));
+            const Time dt = (from-to)/steps;
+            if (!L.isTimeDependent()) {
+                L = forwardOperator(to, from);
+                explicitPart = I-((1.0-theta) * dt)*L;
+                implicitPart = I+(theta * dt)*L;
+            }
+
+            Time t = from;
+            for (Size i=0; i<steps; ++i, t -= dt) {
+                Time now = t;
+
+                // explicit part
+                if (L.isTimeDependent()) {
+                    L.setTime(now);
+                    explicitPart = I-((1.0-theta) * dt)*L;
+                }
+                explicitPart.setFirstRow(-1.0,1.0);
+                explicitPart.setLastRow(-1.0,1.0);
+                explicitPart.applyTo(prices, buffer);
+                for (Size k=0; k<active; ++k) {
+                    buffer[0][k] = buffer[1][k] - lower[k];
+                    buffer[n-1][k] = buffer[n-2][k] + upper[k];
+                }
+
+                // implicit part
+                if (L.isTimeDependent()) {
+                    L.setTime(now-dt);
+                    implicitPart = I+(theta * dt)*L;
+                }
+                implicitPart.setFirstRow(-1.0,1.0);
+                implicitPart.setLastRow(-1.0,1.0);
+                for (Size k=0; k<active; ++k) {
+                    buffer[0][k] = lower[k];
+                    buffer[n-1][k] = upper[k];
+                }
+                implicitPart.solveFor(buffer, prices);
+
+                // early exercise; the floor is the intrinsic value
+                // for American options and -inf for the others
+                for (Size j=0; j<n; ++j) {
+                    Matrix::row_iterator p = prices[j];
+                    Matrix::const_row_iterator f = floor[j];
+                    for (Size k=0; k<active; ++k)
+                        p[k] = std::max(p[k], f[k]);
+                }
+            }
+        }
+
+        values_.resize(m);
+        deltas_.resize(m);
+        gammas_.resize(m);
+        const Real spot = process_->stateVariable()->value();
+        SampledCurve curve(intrinsicValues_.grid());
+        for (Size k=0; k<m; ++k) {
+            for (Size j=0; j<n; ++j)
+                curve.values()[j] = prices[j][column[k]];
+            values_[k] = curve.valueAtCenter();
+            deltas_[k] = curve.firstDerivativeAtCenter();
+            gammas_[k] = curve.secondDerivativeAtCenter();
+            if (control[k] == Null<Size>())
+                continue;
+
+            const Real value = values_[k], delta = deltas_[k],
+                       gamma = gammas_[k];
+            for (Size j=0; j<n; ++j)
+                curve.values()[j] = prices[j][control[k]];
+            const Date exerciseDate = exercises[k]->lastDate();
+            Real variance =
+                process_->blackVolatility()->blackVariance(
+                                       exerciseDate, payoffs[k]->strike());
+            DiscountFactor dividendDiscount =
+                process_->dividendYield()->discount(exerciseDate);
+            DiscountFactor riskFreeDiscount =
+                process_->riskFreeRate()->discount(exerciseDate);
+            Real forwardPrice = spot * dividendDiscount / riskFreeDiscount;
+            BlackCalculator black(payoffs[k], forwardPrice,
+                                  std::sqrt(variance), riskFreeDiscount);
+
+            values_[k] = value - curve.valueAtCenter() + black.value();
+            deltas_[k] = delta - curve.firstDerivativeAtCenter()
+                       + black.delta(spot);
+            gammas_[k] = gamma - curve.secondDerivativeAtCenter()
+                       + black.gamma(spot);
+        }
+    }
+
+}
+
+
+#endif
@@ -77,6 +77,8 @@ namespace QuantLib {
         Real stdDeviation(Time t0, Real x0, Time dt) const;
         Real variance(Time t0, Real x0, Time dt) const;
         Real evolve(Time t0, Real x0, Time dt, Real dw) const;
+        void evolveBatch(Time t0, const Real* x0, Time dt,
+                         const Real* dw, Real* x, Size n) const;
         //@}
         Time time(const Date&) const;
         //! \name Observer interface
@@ -324,6 +326,29 @@ namespace QuantLib {
                                  stdDeviation(t0, x0, dt) * dw);
     }
 
+    inline void GeneralizedBlackScholesProcess::evolveBatch(
+                                            Time t0, const Real* x0, Time dt,
+                                            const Real* dw, Real* x,
+                                            Size n) const {
+        localVolatility(); // trigger update
+        if (isStrikeIndependent_ && !forceDiscretization_) {
+            // exact value for curves; drift and variance are the
+            // same for all paths, so the loop below vectorizes
+            Real var = variance(t0, 0.0, dt);
+            Real drift = (riskFreeRate_->forwardRate(t0, t0 + dt, Continuous,
+                                                     NoFrequency, true) -
+                          dividendYield_->forwardRate(t0, t0 + dt, Continuous,
+                                                      NoFrequency, true)) *
+                             dt -
+                         0.5 * var;
+            Real stdDev = std::sqrt(var);
+            for (Size k=0; k<n; ++k)
+                x[k] = x0[k] * std::exp(stdDev * dw[k] + drift);
+        } else {
+            StochasticProcess1D::evolveBatch(t0, x0, dt, dw, x, n);
+        }
+    }
+
     inline Time GeneralizedBlackScholesProcess::time(const Date& d) const {
         return riskFreeRate_->dayCounter().yearFraction(
                                            riskFreeRate_->referenceDate(), d);
@@ -194,5 +194,12 @@
 #define QL_DEPRECATED
 #endif
 
+// thread-local storage for variables of built-in type
+#if defined(BOOST_MSVC)       // Microsoft Visual C++
+#define QL_THREAD_LOCAL __declspec(thread)
+#else
+#define QL_THREAD_LOCAL __thread
+#endif
+
 
 #endif
@@ -123,6 +123,22 @@ namespace QuantLib {
                                          const Array& x0,
                                          Time dt,
                                          const Array& dw) const;
+        /*! evolves a batch of \f$ n \f$ states over the same time
+            interval.  The \f$ i \f$-th components of the initial
+            and final states are the \f$ n \f$ contiguous values
+            starting at x0[i] and x[i], respectively, and the
+            \f$ j \f$-th components of the Brownian increments are
+            the ones starting at dw[j].  The output may coincide with
+            the input.  By default, it calls evolve() for each state;
+            derived classes can override it so as to work on whole
+            components and avoid allocating a result per state.
+        */
+        virtual void evolveBatch(Time t0,
+                                 const std::vector<const Real*>& x0,
+                                 Time dt,
+                                 const std::vector<const Real*>& dw,
+                                 const std::vector<Real*>& x,
+                                 Size n) const;
         /*! applies a change to the asset value. By default, it
             returns \f$ \mathrm{x} + \Delta \mathrm{x} \f$.
         */
@@ -216,6 +232,16 @@ namespace QuantLib {
             standard deviation.
         */
         virtual Real evolve(Time t0, Real x0, Time dt, Real dw) const;
+        /*! evolves a batch of \f$ n \f$ asset values over the same
+            time interval, i.e., sets \f$ x_k \f$ to the result of
+            evolve() applied to \f$ x_{0,k} \f$ and
+            \f$ \Delta w_k \f$.  The output may coincide with the
+            input.  By default, it calls evolve() for each value;
+            derived classes can override it so that quantities not
+            depending on the state are computed once per batch.
+        */
+        virtual void evolveBatch(Time t0, const Real* x0, Time dt,
+                                 const Real* dw, Real* x, Size n) const;
         /*! applies a change to the asset value. By default, it
             returns \f$ x + \Delta x \f$.
         */
@@ -239,6 +265,9 @@ namespace QuantLib {
                                       Time dt) const;
         Disposable<Array> evolve(Time t0, const Array& x0,
                                  Time dt, const Array& dw) const;
+        void evolveBatch(Time t0, const std::vector<const Real*>& x0,
+                         Time dt, const std::vector<const Real*>& dw,
+                         const std::vector<Real*>& x, Size n) const;
         Disposable<Array> apply(const Array& x0, const Array& dx) const;
     };
 
@@ -310,6 +339,20 @@ namespace QuantLib {
         return a;
     }
 
+    inline void StochasticProcess1D::evolveBatch(
+                                        Time t0,
+                                        const std::vector<const Real*>& x0,
+                                        Time dt,
+                                        const std::vector<const Real*>& dw,
+                                        const std::vector<Real*>& x,
+                                        Size n) const {
+        #if defined(QL_EXTRA_SAFETY_CHECKS)
+        QL_REQUIRE(x0.size() == 1 && x.size() == 1, "1-D state required");
+        QL_REQUIRE(dw.size() == 1, "1-D increment required");
+        #endif
+        evolveBatch(t0, x0[0], dt, dw[0], x[0], n);
+    }
+
     inline Disposable<Array> StochasticProcess1D::apply(
                                                       const Array& x0,
                                                       const Array& dx) const {
@@ -359,6 +402,32 @@ namespace QuantLib {
         return apply(expectation(t0,x0,dt), stdDeviation(t0,x0,dt)*dw);
     }
 
+    inline void StochasticProcess::evolveBatch(
+                                        Time t0,
+                                        const std::vector<const Real*>& x0,
+                                        Time dt,
+                                        const std::vector<const Real*>& dw,
+                                        const std::vector<Real*>& x,
+                                        Size n) const {
+        const Size m = size(), f = factors();
+        QL_REQUIRE(x0.size() == m && x.size() == m,
+                   "state components (" << x0.size() << ", " << x.size()
+                   << ") != process size (" << m << ")");
+        QL_REQUIRE(dw.size() == f,
+                   "Brownian components (" << dw.size()
+                   << ") != process factors (" << f << ")");
+        Array state(m), increment(f);
+        for (Size k=0; k<n; ++k) {
+            for (Size i=0; i<m; ++i)
+                state[i] = x0[i][k];
+            for (Size j=0; j<f; ++j)
+                increment[j] = dw[j][k];
+            state = evolve(t0, state, dt, increment);
+            for (Size i=0; i<m; ++i)
+                x[i][k] = state[i];
+        }
+    }
+
     inline Disposable<Array> StochasticProcess::apply(const Array& x0,
                                                const Array& dx) const {
         return x0 + dx;
@@ -398,6 +467,13 @@ namespace QuantLib {
         return apply(expectation(t0,x0,dt), stdDeviation(t0,x0,dt)*dw);
     }
 
+    inline void StochasticProcess1D::evolveBatch(Time t0, const Real* x0,
+                                                 Time dt, const Real* dw,
+                                                 Real* x, Size n) const {
+        for (Size k=0; k<n; ++k)
+            x[k] = evolve(t0, x0[k], dt, dw[k]);
+    }
+
     inline Real StochasticProcess1D::apply(Real x0, Real dx) const {
         return x0 + dx;
     }
@@ -72,6 +72,17 @@
 //#   define QL_ENABLE_SESSIONS
 #endif
 
+/* Define this to have singletons return a different instance for
+   each thread, so that each thread works as a separate session with
+   its own settings and evaluation date. No sessionId() function is
+   needed, and accessing an instance only costs a thread-local load.
+   You will have to link with the Boost.Thread library, which
+   deletes the instances when their threads exit.  This cannot be
+   enabled together with QL_ENABLE_SESSIONS. */
+#ifndef QL_ENABLE_THREAD_LOCAL_SESSIONS
+//#   define QL_ENABLE_THREAD_LOCAL_SESSIONS
+#endif
+
 /* Define this to enable the thread-safe observer pattern. You should
    enable it if you want to use QuantLib via the SWIG layer within
    the JVM or .NET eco system or any environment with an
@@ -86,6 +97,15 @@
 //#    define QL_HIGH_RESOLUTION_DATE
 #endif
 
+/* Define this to have matrix products and Cholesky decompositions
+   use the system BLAS and LAPACK libraries instead of the built-in
+   kernels.  You will have to link with the libraries providing
+   dgemm, dgemv and dpotrf (e.g., -llapack -lblas or -lopenblas).
+   Real must be double. */
+#ifndef QL_USE_BLAS
+//#   define QL_USE_BLAS
+#endif
+
 /* Define this to enable the parallel unit test runner */
 #ifndef QL_ENABLE_PARALLEL_UNIT_TEST_RUNNER
 //#    define QL_ENABLE_PARALLEL_UNIT_TEST_RUNNER
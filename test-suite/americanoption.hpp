@@ -0,0 +1,248 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef quantlib_test_american_option_hpp
+#define quantlib_test_american_option_hpp
+
+#include <boost/test/unit_test.hpp>
+
+/* remember to document new and/or updated tests in the Doxygen
+   comment block of the corresponding class */
+
+class AmericanOptionTest {
+  public:
+    static void testFdBatchEngine();
+    static void testFdBatchEngineTermStructures();
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <ql/instruments/vanillaoption.hpp>
+#include <ql/pricingengines/vanilla/fdamericanengine.hpp>
+#include <ql/pricingengines/vanilla/fdbatchvanillaengine.hpp>
+#include <ql/pricingengines/vanilla/analyticeuropeanengine.hpp>
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/termstructures/yield/zeroyieldstructure.hpp>
+#include <ql/termstructures/volatility/equityfx/blackvariancecurve.hpp>
+#include <ql/time/calendars/nullcalendar.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    // zero rates growing linearly with time
+    class SlopedZeroCurve : public ZeroYieldStructure {
+      public:
+        SlopedZeroCurve(const Date& referenceDate, Rate shortRate,
+                        Rate slope, const DayCounter& dc)
+        : ZeroYieldStructure(referenceDate, NullCalendar(), dc),
+          shortRate_(shortRate), slope_(slope) {}
+        Date maxDate() const { return Date::maxDate(); }
+      protected:
+        Rate zeroYieldImpl(Time t) const { return shortRate_ + slope_*t; }
+      private:
+        Rate shortRate_, slope_;
+    };
+
+}
+
+void AmericanOptionTest::testFdBatchEngine() {
+
+    BOOST_TEST_MESSAGE("Testing batched finite-difference engine...");
+
+    SavedSettings backup;
+
+    const Date today = Settings::instance().evaluationDate();
+    const DayCounter dc = Actual365Fixed();
+    const boost::shared_ptr<GeneralizedBlackScholesProcess> process(
+        new BlackScholesMertonProcess(
+            Handle<Quote>(boost::shared_ptr<Quote>(new SimpleQuote(100.0))),
+            Handle<YieldTermStructure>(flatRate(today, 0.02, dc)),
+            Handle<YieldTermStructure>(flatRate(today, 0.05, dc)),
+            Handle<BlackVolTermStructure>(flatVol(today, 0.20, dc))));
+
+    // a few puts and calls on a surface of strikes and maturities,
+    // with a European option among them
+    std::vector<boost::shared_ptr<StrikedTypePayoff> > payoffs;
+    std::vector<boost::shared_ptr<Exercise> > exercises;
+    const Real strikes[] = { 80.0, 95.0, 100.0, 110.0, 125.0 };
+    const Integer days[] = { 91, 182, 365 };
+    for (Size i=0; i<LENGTH(days); ++i) {
+        for (Size j=0; j<LENGTH(strikes); ++j) {
+            Option::Type type = (j % 2 == 0 ? Option::Put : Option::Call);
+            payoffs.push_back(boost::shared_ptr<StrikedTypePayoff>(
+                                new PlainVanillaPayoff(type, strikes[j])));
+            exercises.push_back(boost::shared_ptr<Exercise>(
+                   new AmericanExercise(today, today + days[i])));
+        }
+    }
+    payoffs.push_back(boost::shared_ptr<StrikedTypePayoff>(
+                                new PlainVanillaPayoff(Option::Put, 105.0)));
+    exercises.push_back(boost::shared_ptr<Exercise>(
+                                new EuropeanExercise(today + 273)));
+
+    const Size timeSteps = 200, gridPoints = 400;
+
+    // a single American option is priced as by FDAmericanEngine (up
+    // to the rounding of the forward rates and variance, which are
+    // the same as the instantaneous ones on flat term structures)...
+    for (Size k=0; k<payoffs.size()-1; k += 4) {
+        FDBatchVanillaEngine batch(process, timeSteps, gridPoints);
+        batch.calculate(
+            std::vector<boost::shared_ptr<StrikedTypePayoff> >(1, payoffs[k]),
+            std::vector<boost::shared_ptr<Exercise> >(1, exercises[k]));
+
+        VanillaOption option(payoffs[k], exercises[k]);
+        option.setPricingEngine(boost::shared_ptr<PricingEngine>(
+            new FDAmericanEngine<CrankNicolson>(process, timeSteps,
+                                                gridPoints)));
+
+        const Real tolerance = 1.0e-10;
+        if (std::fabs(batch.values()[0] - option.NPV()) > tolerance
+            || std::fabs(batch.deltas()[0] - option.delta()) > tolerance
+            || std::fabs(batch.gammas()[0] - option.gamma()) > tolerance)
+            BOOST_FAIL("failed to reproduce single-option results:"
+                       << "\n    option:           " << k
+                       << std::setprecision(12)
+                       << "\n    value:            " << batch.values()[0]
+                       << "\n    expected value:   " << option.NPV()
+                       << "\n    delta:            " << batch.deltas()[0]
+                       << "\n    expected delta:   " << option.delta()
+                       << "\n    gamma:            " << batch.gammas()[0]
+                       << "\n    expected gamma:   " << option.gamma());
+    }
+
+    // ...and the options priced together are close to the ones
+    // priced separately (the European one, analytically)
+    FDBatchVanillaEngine batch(process, timeSteps, gridPoints);
+    batch.calculate(payoffs, exercises);
+    for (Size k=0; k<payoffs.size(); ++k) {
+        VanillaOption option(payoffs[k], exercises[k]);
+        if (exercises[k]->type() == Exercise::American)
+            option.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                new FDAmericanEngine<CrankNicolson>(process, timeSteps,
+                                                    gridPoints)));
+        else
+            option.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                                     new AnalyticEuropeanEngine(process)));
+
+        const Real tolerance = 2.0e-3;
+        if (std::fabs(batch.values()[k] - option.NPV()) > tolerance
+            || std::fabs(batch.deltas()[k] - option.delta()) > tolerance)
+            BOOST_FAIL("failed to reproduce results in batch:"
+                       << "\n    option:         " << k
+                       << "\n    value:          " << batch.values()[k]
+                       << "\n    expected value: " << option.NPV()
+                       << "\n    delta:          " << batch.deltas()[k]
+                       << "\n    expected delta: " << option.delta());
+    }
+}
+
+
+void AmericanOptionTest::testFdBatchEngineTermStructures() {
+
+    BOOST_TEST_MESSAGE("Testing batched finite-difference engine "
+                       "on term structures...");
+
+    SavedSettings backup;
+
+    const Date today = Settings::instance().evaluationDate();
+    const DayCounter dc = Actual365Fixed();
+    const Integer days[] = { 91, 182, 365, 730 };
+    std::vector<Date> volDates;
+    std::vector<Volatility> vols;
+    for (Size i=0; i<LENGTH(days); ++i) {
+        volDates.push_back(today + days[i]);
+        vols.push_back(0.15 + 0.05*i);
+    }
+    const boost::shared_ptr<GeneralizedBlackScholesProcess> process(
+        new BlackScholesMertonProcess(
+            Handle<Quote>(boost::shared_ptr<Quote>(new SimpleQuote(100.0))),
+            Handle<YieldTermStructure>(boost::shared_ptr<YieldTermStructure>(
+                         new SlopedZeroCurve(today, 0.01, 0.005, dc))),
+            Handle<YieldTermStructure>(boost::shared_ptr<YieldTermStructure>(
+                         new SlopedZeroCurve(today, 0.02, 0.01, dc))),
+            Handle<BlackVolTermStructure>(
+                boost::shared_ptr<BlackVolTermStructure>(
+                    new BlackVarianceCurve(today, volDates, vols, dc)))));
+
+    // European options maturing before the last one see the rates
+    // and variance up to their own maturity
+    std::vector<boost::shared_ptr<StrikedTypePayoff> > payoffs;
+    std::vector<boost::shared_ptr<Exercise> > exercises;
+    const Real strikes[] = { 90.0, 100.0, 110.0 };
+    for (Size i=0; i<LENGTH(days); ++i) {
+        for (Size j=0; j<LENGTH(strikes); ++j) {
+            Option::Type type = (j % 2 == 0 ? Option::Put : Option::Call);
+            payoffs.push_back(boost::shared_ptr<StrikedTypePayoff>(
+                                new PlainVanillaPayoff(type, strikes[j])));
+            exercises.push_back(boost::shared_ptr<Exercise>(
+                                new EuropeanExercise(today + days[i])));
+        }
+    }
+
+    FDBatchVanillaEngine batch(process, 400, 400);
+    batch.calculate(payoffs, exercises);
+    for (Size k=0; k<payoffs.size(); ++k) {
+        VanillaOption option(payoffs[k], exercises[k]);
+        option.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                                     new AnalyticEuropeanEngine(process)));
+
+        const Real tolerance = 1.0e-2;
+        if (std::fabs(batch.values()[k] - option.NPV()) > tolerance
+            || std::fabs(batch.deltas()[k] - option.delta()) > tolerance)
+            BOOST_FAIL("failed to reproduce results on term structures:"
+                       << "\n    option:         " << k
+                       << "\n    value:          " << batch.values()[k]
+                       << "\n    expected value: " << option.NPV()
+                       << "\n    delta:          " << batch.deltas()[k]
+                       << "\n    expected delta: " << option.delta());
+    }
+}
+
+
+test_suite* AmericanOptionTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("American option tests");
+    suite->add(QUANTLIB_TEST_CASE(&AmericanOptionTest::testFdBatchEngine));
+    suite->add(QUANTLIB_TEST_CASE(
+                   &AmericanOptionTest::testFdBatchEngineTermStructures));
+    return suite;
+}
+
+
+#endif
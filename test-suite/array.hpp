@@ -29,6 +29,9 @@ class ArrayTest {
   public:
     static void testConstruction();
     static void testArrayFunctions();
+    static void testArrayExpressions();
+    static void testExpressionAllocations();
+    static void testExpressionThroughput();
     static boost::unit_test_framework::test_suite* suite();
 };
 
@@ -54,10 +57,56 @@ class ArrayTest {
 #include "utilities.hpp"
 #include <ql/math/array.hpp>
 #include <ql/utilities/dataformatters.hpp>
+#include <new>
 
 using namespace QuantLib;
 using namespace boost::unit_test_framework;
 
+namespace {
+
+    // array allocations are counted only while this flag is set,
+    // which is done by a single-threaded test
+    bool countArrayAllocations = false;
+    Size arrayAllocations = 0;
+
+}
+
+/* Arrays allocate their storage through operator new[], which is
+   replaced here so that the number of temporaries created by an
+   expression can be checked. */
+
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define ARRAY_TEST_THROW_BAD_ALLOC
+#define ARRAY_TEST_THROW_NOTHING noexcept
+#else
+#define ARRAY_TEST_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define ARRAY_TEST_THROW_NOTHING throw()
+#endif
+
+/* the forwarding below would be reported as a mismatch once the
+   replacements are inlined */
+#if defined(__GNUC__) && (__GNUC__ >= 11)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new[](std::size_t size) ARRAY_TEST_THROW_BAD_ALLOC {
+    if (countArrayAllocations)
+        ++arrayAllocations;
+    return ::operator new(size);
+}
+
+void operator delete[](void* p) ARRAY_TEST_THROW_NOTHING {
+    ::operator delete(p);
+}
+
+#if defined(__GNUC__) && (__GNUC__ >= 11)
+#pragma GCC diagnostic pop
+#endif
+
+#undef ARRAY_TEST_THROW_BAD_ALLOC
+#undef ARRAY_TEST_THROW_NOTHING
+
 class FSquared : std::unary_function<Real,Real> {
   public:
     Real operator()(Real x) const { return x*x; }
@@ -241,10 +290,169 @@ void ArrayTest::testArrayFunctions() {
 
 }
 
+namespace {
+
+    Disposable<Array> combination(const Array& x, const Array& y) {
+        return 2.0*x - y;
+    }
+
+}
+
+void ArrayTest::testArrayExpressions() {
+
+    BOOST_TEST_MESSAGE("Testing array expressions...");
+
+    const Size n = 7;
+    Array x(n), y(n), z(n);
+    for (Size i=0; i<n; ++i) {
+        x[i] = std::sin(Real(i))+1.1;
+        y[i] = std::cos(Real(i))+1.2;
+        z[i] = Real(i)/n;
+    }
+    const Real a = 0.3, b = -1.7;
+
+    Array r = a*x + b*y - z;
+    Array expected(n);
+    for (Size i=0; i<n; ++i)
+        expected[i] = a*x[i] + b*y[i] - z[i];
+    if (r != expected)
+        BOOST_ERROR("wrong result of fused expression:"
+                    << "\n    calculated: " << r
+                    << "\n    expected:   " << expected);
+
+    // assigning an expression to an array of the right size
+    // reuses its storage, even if the array is an operand
+    const Real* data = r.begin();
+    r = Sqrt(Abs(r - x/y)) * Exp(-z) + 1.0/(r*r + 1.0);
+    for (Size i=0; i<n; ++i)
+        expected[i] = std::sqrt(std::fabs(expected[i] - x[i]/y[i]))
+            * std::exp(-z[i]) + 1.0/(expected[i]*expected[i] + 1.0);
+    if (r.begin() != data)
+        BOOST_ERROR("array reallocated by expression assignment");
+    for (Size i=0; i<n; ++i) {
+        if (std::fabs(r[i]-expected[i]) > 10*QL_EPSILON)
+            BOOST_ERROR("wrong result of aliased expression at " << i
+                        << ":\n    calculated: " << r[i]
+                        << "\n    expected:   " << expected[i]);
+    }
+
+    r += x*y;
+    r -= 2.0*x;
+    r *= y - 1.0;
+    r /= x + 1.0;
+    if (r.begin() != data)
+        BOOST_ERROR("array reallocated by compound assignment");
+    for (Size i=0; i<n; ++i) {
+        expected[i] = (expected[i] + x[i]*y[i] - 2.0*x[i])
+            * (y[i] - 1.0) / (x[i] + 1.0);
+        if (std::fabs(r[i]-expected[i]) > 10*QL_EPSILON)
+            BOOST_ERROR("wrong result of compound assignment at " << i
+                        << ":\n    calculated: " << r[i]
+                        << "\n    expected:   " << expected[i]);
+    }
+
+    // expressions can be returned as disposable arrays and used
+    // wherever an array is expected
+    const Array c = combination(x, y);
+    const Real dot = DotProduct(x - y, z), norm = Norm2(x + y);
+    Real expectedDot = 0.0, expectedNorm = 0.0;
+    for (Size i=0; i<n; ++i) {
+        if (c[i] != 2.0*x[i] - y[i])
+            BOOST_ERROR("wrong disposable expression at " << i);
+        expectedDot += (x[i] - y[i])*z[i];
+        expectedNorm += (x[i] + y[i])*(x[i] + y[i]);
+    }
+    if (std::fabs(dot - expectedDot) > 10*QL_EPSILON
+        || std::fabs(norm - std::sqrt(expectedNorm)) > 10*QL_EPSILON)
+        BOOST_ERROR("wrong dot product or norm of expressions");
+
+    // assignment to an array of different size reallocates it
+    Array s;
+    s = x + y;
+    if (s.size() != n || s[n-1] != x[n-1] + y[n-1])
+        BOOST_ERROR("wrong assignment of expression to empty array");
+
+    BOOST_CHECK_THROW(Array(x + Array(n+1)), Error);
+    BOOST_CHECK_THROW(r += Array(n+1), Error);
+}
+
+void ArrayTest::testExpressionAllocations() {
+
+    BOOST_TEST_MESSAGE("Testing allocations of array expressions...");
+
+    const Size n = 100;
+    Array x(n, 1.0, 0.01), y(n, 2.0, -0.01), z(n, 0.5), r(n);
+    const Real a = 0.3, b = -1.7;
+
+    // before expression templates, each operator returned a newly
+    // allocated array; materializing each subexpression reproduces
+    // that evaluation
+    countArrayAllocations = true;
+    arrayAllocations = 0;
+    {
+        Array ax(a*x), by(b*y);
+        Array sum(ax + by);
+        Array difference(sum - z);
+        r.swap(difference);
+    }
+    const Size before = arrayAllocations;
+
+    arrayAllocations = 0;
+    r = a*x + b*y - z;
+    r += x*y;
+    r = Sqrt(Abs(r - x/y)) * Exp(-z) + 1.0/(r*r + 1.0);
+    const Size after = arrayAllocations;
+
+    arrayAllocations = 0;
+    Array s = a*x + b*y - z;
+    const Size constructed = arrayAllocations;
+    countArrayAllocations = false;
+
+    BOOST_TEST_MESSAGE("    allocations with temporaries: " << before
+                       << "\n    allocations with expressions: " << after);
+    if (before != 4)
+        BOOST_ERROR("unexpected number of allocations with temporaries:"
+                    << "\n    calculated: " << before
+                    << "\n    expected:   " << 4);
+    if (after != 0)
+        BOOST_ERROR("array expressions assigned to arrays of the right "
+                    "size allocated " << after << " temporaries");
+    if (constructed != 1)
+        BOOST_ERROR("array constructed from an expression allocated "
+                    << constructed << " times instead of once");
+    if (s.size() != n || s[n-1] != a*x[n-1] + b*y[n-1] - z[n-1])
+        BOOST_ERROR("wrong array constructed from an expression");
+}
+
+namespace {
+
+    const Size expressionSize = 1000;
+    const Size expressionSamples = 100000;
+
+}
+
+void ArrayTest::testExpressionThroughput() {
+
+    BOOST_TEST_MESSAGE("Testing throughput of array expressions...");
+
+    Array x(expressionSize, 1.0, 0.001), y(expressionSize, 2.0, -0.001),
+          z(expressionSize, 0.5), r(expressionSize);
+    Real sum = 0.0;
+    for (Size l=0; l<expressionSamples; ++l) {
+        const Real a = 1.0/(l+1.0), b = 1.0 - a;
+        r = a*x + b*y - z;
+        sum += r[l % expressionSize];
+    }
+    if (!(sum > 0.0))
+        BOOST_ERROR("unexpected sum of results: " << sum);
+}
+
 test_suite* ArrayTest::suite() {
     test_suite* suite = BOOST_TEST_SUITE("array tests");
     suite->add(QUANTLIB_TEST_CASE(&ArrayTest::testConstruction));
     suite->add(QUANTLIB_TEST_CASE(&ArrayTest::testArrayFunctions));
+    suite->add(QUANTLIB_TEST_CASE(&ArrayTest::testArrayExpressions));
+    suite->add(QUANTLIB_TEST_CASE(&ArrayTest::testExpressionAllocations));
     return suite;
 }
 
@@ -28,6 +28,13 @@ class BlackFormulaTest {
   public:
     static void testBachelierImpliedVol();
     static void testChambersImpliedVol();
+    static void testBatchFormulas();
+    static void testScalarThroughput();
+    static void testBatchThroughput();
+    static void testLetsBeRationalImpliedStdDev();
+    static void testLetsBeRationalBachelierImpliedVol();
+    static void testImpliedStdDevThroughput();
+    static void testLetsBeRationalThroughput();
     static boost::unit_test_framework::test_suite* suite();
 };
 
@@ -149,6 +156,350 @@ void BlackFormulaTest::testChambersImpliedVol() {
     }
 }
 
+namespace {
+
+    // strikes across the smile for a few forwards
+    void batchSample(Array& strikes, Array& forwards, Array& stdDevs) {
+        Real f[] = { 0.01, 0.03, 0.05 };
+        Real s[] = { 0.05, 0.20, 0.60, 1.50 };
+        const Size nStrikes = 41;
+        const Size n = LENGTH(f)*LENGTH(s)*nStrikes;
+        strikes = Array(n);
+        forwards = Array(n);
+        stdDevs = Array(n);
+        Size l = 0;
+        for (Size i=0; i<LENGTH(f); ++i) {
+            for (Size j=0; j<LENGTH(s); ++j) {
+                for (Size k=0; k<nStrikes; ++k, ++l) {
+                    forwards[l] = f[i];
+                    stdDevs[l] = s[j];
+                    strikes[l] = f[i]*std::exp(s[j]*(k-20.0)/10.0);
+                }
+            }
+        }
+    }
+
+    const Size throughputSamples = 2000;
+    const Size impliedThroughputSamples = 200;
+
+}
+
+void BlackFormulaTest::testBatchFormulas() {
+
+    BOOST_TEST_MESSAGE("Testing batch Black and Bachelier formulas...");
+
+    Array strikes, forwards, stdDevs;
+    batchSample(strikes, forwards, stdDevs);
+    const Size n = strikes.size();
+
+    Option::Type types[] = { Option::Call, Option::Put };
+    Real displacements[] = { 0.0, 0.01 };
+    const Real discount = 0.95, tte = 5.0;
+    const Real tolerance = 1.0e-14, volTolerance = 1.0e-6;
+
+    for (Size i=0; i<LENGTH(types); ++i) {
+        Option::Type type = types[i];
+        for (Size j=0; j<LENGTH(displacements); ++j) {
+            Real displacement = displacements[j];
+
+            Array prices = blackFormula(type, strikes, forwards, stdDevs,
+                                        discount, displacement);
+            Array vegas = blackFormulaStdDevDerivative(
+                 strikes, forwards, stdDevs, discount, displacement);
+            Array implied = blackFormulaImpliedStdDev(
+                 type, strikes, forwards, prices, discount, displacement,
+                 1.0e-10);
+
+            for (Size k=0; k<n; ++k) {
+                Real price = blackFormula(type, strikes[k], forwards[k],
+                                          stdDevs[k], discount, displacement);
+                Real vega = blackFormulaStdDevDerivative(
+                    strikes[k], forwards[k], stdDevs[k], discount,
+                    displacement);
+                if (std::fabs(prices[k]-price) > tolerance
+                    || std::fabs(vegas[k]-vega) > tolerance)
+                    BOOST_ERROR("batch Black formula mismatch for "
+                                << type << " option:"
+                                << "\n    strike:       " << strikes[k]
+                                << "\n    forward:      " << forwards[k]
+                                << "\n    stdDev:       " << stdDevs[k]
+                                << "\n    displacement: " << displacement
+                                << "\n    price:        " << prices[k]
+                                << "\n    expected:     " << price
+                                << "\n    vega:         " << vegas[k]
+                                << "\n    expected:     " << vega);
+                // implied vols are only well defined where the
+                // price is sensitive enough to them
+                if (vega > 1.0e-6
+                    && std::fabs(implied[k]-stdDevs[k]) > volTolerance)
+                    BOOST_ERROR("batch implied stdDev mismatch for "
+                                << type << " option:"
+                                << "\n    strike:       " << strikes[k]
+                                << "\n    forward:      " << forwards[k]
+                                << "\n    displacement: " << displacement
+                                << "\n    implied:      " << implied[k]
+                                << "\n    expected:     " << stdDevs[k]);
+            }
+        }
+
+        Array bpStdDevs = 0.01*stdDevs;
+        Array prices = bachelierBlackFormula(type, strikes, forwards,
+                                             bpStdDevs, discount);
+        Array vegas = bachelierBlackFormulaStdDevDerivative(
+                                  strikes, forwards, bpStdDevs, discount);
+        Array implied = bachelierBlackFormulaImpliedVol(
+                                  type, strikes, forwards, tte, prices,
+                                  discount);
+        for (Size k=0; k<n; ++k) {
+            Real price = bachelierBlackFormula(type, strikes[k], forwards[k],
+                                               bpStdDevs[k], discount);
+            Real vega = bachelierBlackFormulaStdDevDerivative(
+                         strikes[k], forwards[k], bpStdDevs[k], discount);
+            Real vol = bachelierBlackFormulaImpliedVol(
+                         type, strikes[k], forwards[k], tte, price, discount);
+            if (std::fabs(prices[k]-price) > tolerance
+                || std::fabs(vegas[k]-vega) > tolerance
+                || implied[k] != vol)
+                BOOST_ERROR("batch Bachelier formula mismatch for "
+                            << type << " option:"
+                            << "\n    strike:     " << strikes[k]
+                            << "\n    forward:    " << forwards[k]
+                            << "\n    stdDev:     " << bpStdDevs[k]
+                            << "\n    price:      " << prices[k]
+                            << "\n    expected:   " << price
+                            << "\n    vega:       " << vegas[k]
+                            << "\n    expected:   " << vega
+                            << "\n    vol:        " << implied[k]
+                            << "\n    expected:   " << vol);
+        }
+    }
+
+    // the solver settings are checked as in the scalar version
+    const Array prices = blackFormula(Option::Call, strikes, forwards,
+                                      stdDevs, discount);
+    BOOST_CHECK_THROW(blackFormulaImpliedStdDev(
+                          Option::Call, strikes, forwards, prices,
+                          discount, 0.0, 0.0),
+                      Error);
+    BOOST_CHECK_THROW(blackFormulaImpliedStdDev(
+                          Option::Call, strikes, forwards, prices,
+                          discount, 0.0, 1.0e-10, 2),
+                      Error);
+}
+
+void BlackFormulaTest::testScalarThroughput() {
+
+    BOOST_TEST_MESSAGE("Testing throughput of scalar Black formulas...");
+
+    Array strikes, forwards, stdDevs;
+    batchSample(strikes, forwards, stdDevs);
+
+    Real sum = 0.0;
+    for (Size l=0; l<throughputSamples; ++l) {
+        for (Size k=0; k<strikes.size(); ++k) {
+            sum += blackFormula(Option::Call, strikes[k], forwards[k],
+                                stdDevs[k]);
+            sum += blackFormulaStdDevDerivative(strikes[k], forwards[k],
+                                                stdDevs[k]);
+        }
+    }
+    if (!(sum > 0.0))
+        BOOST_ERROR("unexpected sum of prices and vegas: " << sum);
+}
+
+void BlackFormulaTest::testBatchThroughput() {
+
+    BOOST_TEST_MESSAGE("Testing throughput of batch Black formulas...");
+
+    Array strikes, forwards, stdDevs;
+    batchSample(strikes, forwards, stdDevs);
+
+    Real sum = 0.0;
+    for (Size l=0; l<throughputSamples; ++l) {
+        Array prices = blackFormula(Option::Call, strikes, forwards, stdDevs);
+        Array vegas = blackFormulaStdDevDerivative(strikes, forwards,
+                                                   stdDevs);
+        sum += std::accumulate(prices.begin(), prices.end(), 0.0)
+             + std::accumulate(vegas.begin(), vegas.end(), 0.0);
+    }
+    if (!(sum > 0.0))
+        BOOST_ERROR("unexpected sum of prices and vegas: " << sum);
+}
+
+void BlackFormulaTest::testLetsBeRationalImpliedStdDev() {
+
+    BOOST_TEST_MESSAGE("Testing Let's Be Rational implied stdDev...");
+
+    Option::Type types[] = { Option::Call, Option::Put };
+    Real displacements[] = { 0.0, 0.01 };
+    Real moneyness[] = { -3.0, -1.0, -0.2, 0.0, 0.2, 1.0, 3.0 };
+    Real stdDevs[] = { 0.01, 0.05, 0.20, 0.60, 1.00, 2.00, 4.00 };
+    const Real forward = 0.03, discount = 0.95;
+    const Real tolerance = 1.0e-10;
+
+    // maximum errors of the existing approximations and
+    // solvers, for comparison
+    Real approximation = 0.0, radoicicStefanica = 0.0, newton = 0.0,
+         letsBeRational = 0.0;
+
+    for (Size i=0; i<LENGTH(types); ++i) {
+      for (Size j=0; j<LENGTH(displacements); ++j) {
+        for (Size k=0; k<LENGTH(moneyness); ++k) {
+          for (Size l=0; l<LENGTH(stdDevs); ++l) {
+            const Real displacement = displacements[j];
+            const Real strike =
+                (forward+displacement)*std::exp(moneyness[k])-displacement;
+            const Real stdDev = stdDevs[l];
+            const Real price = blackFormula(types[i], strike, forward,
+                                            stdDev, discount, displacement);
+            // stdDevs are only well defined where the price is
+            // sensitive enough to them
+            const Real vega = blackFormulaStdDevDerivative(
+                         strike, forward, stdDev, discount, displacement);
+            if (vega < 1.0e-4*forward)
+                continue;
+
+            const Real implied = blackFormulaImpliedStdDevLetsBeRational(
+                types[i], strike, forward, price, discount, displacement);
+            const Real error = std::fabs(implied-stdDev);
+            if (error > tolerance)
+                BOOST_ERROR("failed to reproduce stdDev for "
+                            << types[i] << " option:"
+                            << "\n    strike:       " << strike
+                            << "\n    forward:      " << forward
+                            << "\n    displacement: " << displacement
+                            << "\n    price:        " << price
+                            << "\n    implied:      " << implied
+                            << "\n    expected:     " << stdDev
+                            << "\n    error:        " << error);
+            letsBeRational = std::max(letsBeRational, error);
+
+            approximation = std::max(approximation, std::fabs(stdDev -
+                blackFormulaImpliedStdDevApproximation(
+                    types[i], strike, forward, price, discount,
+                    displacement)));
+            radoicicStefanica = std::max(radoicicStefanica, std::fabs(stdDev
+                - blackFormulaImpliedStdDevApproximationRS(
+                    types[i], strike, forward, price, discount,
+                    displacement)));
+            newton = std::max(newton, std::fabs(stdDev -
+                blackFormulaImpliedStdDev(types[i], strike, forward, price,
+                                          discount, displacement)));
+          }
+        }
+      }
+    }
+
+    BOOST_TEST_MESSAGE("    maximum stdDev errors:"
+                       << "\n    Brenner-Subrahmanyan:  " << approximation
+                       << "\n    Radoicic-Stefanica:    " << radoicicStefanica
+                       << "\n    Newton (1e-6):         " << newton
+                       << "\n    Let's Be Rational:     " << letsBeRational);
+
+    // prices out of range
+    const Real strike = 0.04;
+    const Real maxPrice = discount*forward;
+    BOOST_CHECK_THROW(blackFormulaImpliedStdDevLetsBeRational(
+                          Option::Call, strike, forward, 1.01*maxPrice,
+                          discount),
+                      Error);
+    const Real intrinsic = discount*(strike-forward);
+    BOOST_CHECK_THROW(blackFormulaImpliedStdDevLetsBeRational(
+                          Option::Put, strike, forward, 0.9*intrinsic,
+                          discount),
+                      Error);
+    if (blackFormulaImpliedStdDevLetsBeRational(
+              Option::Put, strike, forward, intrinsic, discount) != 0.0)
+        BOOST_ERROR("non-null stdDev implied by intrinsic value");
+}
+
+void BlackFormulaTest::testLetsBeRationalBachelierImpliedVol() {
+
+    BOOST_TEST_MESSAGE("Testing Let's Be Rational Bachelier implied vol...");
+
+    Option::Type types[] = { Option::Call, Option::Put };
+    Real d[] = { -8.0, -3.0, -1.0, -0.1, 0.0, 0.1, 1.0, 3.0, 8.0 };
+    Real bpvols[] = { 0.0001, 0.005, 0.01, 0.05 };
+    const Real forward = 0.01, tte = 10.0, discount = 0.95;
+    const Real tolerance = 1.0e-13;
+
+    Real approximation = 0.0, letsBeRational = 0.0;
+    for (Size i=0; i<LENGTH(types); ++i) {
+        for (Size j=0; j<LENGTH(d); ++j) {
+            for (Size k=0; k<LENGTH(bpvols); ++k) {
+                const Real stdDev = bpvols[k]*std::sqrt(tte);
+                const Real strike = forward - d[j]*stdDev;
+                const Real price = bachelierBlackFormula(
+                         types[i], strike, forward, stdDev, discount);
+                const Real implied =
+                    bachelierBlackFormulaImpliedVolLetsBeRational(
+                         types[i], strike, forward, tte, price, discount);
+                const Real error = std::fabs(implied/bpvols[k]-1.0);
+                // deep in the money, the time value is lost in the
+                // price and only the approximation can be checked
+                if (d[j]*types[i] < 5.0) {
+                    if (error > tolerance)
+                        BOOST_ERROR("failed to reproduce Bachelier vol for "
+                                    << types[i] << " option:"
+                                    << "\n    strike:   " << strike
+                                    << "\n    forward:  " << forward
+                                    << "\n    implied:  " << implied
+                                    << "\n    expected: " << bpvols[k]
+                                    << "\n    error:    " << error);
+                    letsBeRational = std::max(letsBeRational, error);
+                    approximation = std::max(approximation,
+                        std::fabs(bachelierBlackFormulaImpliedVol(
+                            types[i], strike, forward, tte, price,
+                            discount)/bpvols[k]-1.0));
+                }
+            }
+        }
+    }
+
+    BOOST_TEST_MESSAGE("    maximum relative vol errors:"
+                       << "\n    Choi-Kim-Kwak:      " << approximation
+                       << "\n    Let's Be Rational:  " << letsBeRational);
+}
+
+void BlackFormulaTest::testImpliedStdDevThroughput() {
+
+    BOOST_TEST_MESSAGE("Testing throughput of Newton implied stdDev...");
+
+    Array strikes, forwards, stdDevs;
+    batchSample(strikes, forwards, stdDevs);
+    Array prices = blackFormula(Option::Call, strikes, forwards, stdDevs);
+
+    Real sum = 0.0;
+    for (Size l=0; l<impliedThroughputSamples; ++l) {
+        for (Size k=0; k<strikes.size(); ++k)
+            sum += blackFormulaImpliedStdDev(Option::Call, strikes[k],
+                                             forwards[k], prices[k],
+                                             1.0, 0.0, Null<Real>(),
+                                             1.0e-12);
+    }
+    if (!(sum > 0.0))
+        BOOST_ERROR("unexpected sum of implied stdDevs: " << sum);
+}
+
+void BlackFormulaTest::testLetsBeRationalThroughput() {
+
+    BOOST_TEST_MESSAGE("Testing throughput of Let's Be Rational "
+                       "implied stdDev...");
+
+    Array strikes, forwards, stdDevs;
+    batchSample(strikes, forwards, stdDevs);
+    Array prices = blackFormula(Option::Call, strikes, forwards, stdDevs);
+
+    Real sum = 0.0;
+    for (Size l=0; l<impliedThroughputSamples; ++l) {
+        for (Size k=0; k<strikes.size(); ++k)
+            sum += blackFormulaImpliedStdDevLetsBeRational(
+                       Option::Call, strikes[k], forwards[k], prices[k]);
+    }
+    if (!(sum > 0.0))
+        BOOST_ERROR("unexpected sum of implied stdDevs: " << sum);
+}
+
 test_suite* BlackFormulaTest::suite() {
     test_suite* suite = BOOST_TEST_SUITE("Black formula tests");
 
@@ -156,6 +507,12 @@ test_suite* BlackFormulaTest::suite() {
         &BlackFormulaTest::testBachelierImpliedVol));
     suite->add(QUANTLIB_TEST_CASE(
         &BlackFormulaTest::testChambersImpliedVol));
+    suite->add(QUANTLIB_TEST_CASE(
+        &BlackFormulaTest::testBatchFormulas));
+    suite->add(QUANTLIB_TEST_CASE(
+        &BlackFormulaTest::testLetsBeRationalImpliedStdDev));
+    suite->add(QUANTLIB_TEST_CASE(
+        &BlackFormulaTest::testLetsBeRationalBachelierImpliedVol));
 
     return suite;
 }
@@ -0,0 +1,189 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef quantlib_test_brownian_bridge_hpp
+#define quantlib_test_brownian_bridge_hpp
+
+#include <boost/test/unit_test.hpp>
+
+/* remember to document new and/or updated tests in the Doxygen
+   comment block of the corresponding class */
+
+class BrownianBridgeTest {
+  public:
+    static void testMultiPathTransform();
+    static void testMultiFactorTransform();
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <ql/methods/montecarlo/brownianbridge.hpp>
+#include <ql/models/marketmodels/browniangenerators/sobolbrowniangenerator.hpp>
+#include <ql/math/randomnumbers/mt19937uniformrng.hpp>
+#include <boost/iterator/permutation_iterator.hpp>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    // the results might differ in the last bits if the compiler
+    // contracts multiplications and additions differently
+    const Real bridgeTolerance = 1.0e-13;
+
+}
+
+
+void BrownianBridgeTest::testMultiPathTransform() {
+
+    BOOST_TEST_MESSAGE("Testing multi-path Brownian-bridge transform...");
+
+    MersenneTwisterUniformRng rng(42);
+
+    // irregular times, and numbers of paths across the block size
+    std::vector<Time> times;
+    Time t = 0.0;
+    for (Size i=0; i<13; ++i) {
+        t += 0.05 + rng.nextReal();
+        times.push_back(t);
+    }
+    const BrownianBridge bridges[] = {
+        BrownianBridge(times), BrownianBridge(1), BrownianBridge(16)
+    };
+    const Size paths[] = { 1, 7, 8, 9, 64, 101 };
+
+    for (Size b=0; b<LENGTH(bridges); ++b) {
+        const BrownianBridge& bridge = bridges[b];
+        const Size steps = bridge.size();
+        for (Size l=0; l<LENGTH(paths); ++l) {
+            const Size n = paths[l];
+            Matrix variates(steps, n), output;
+            for (Size i=0; i<steps; ++i)
+                for (Size j=0; j<n; ++j)
+                    variates[i][j] = rng.nextReal() - 0.5;
+
+            bridge.transform(variates, output);
+
+            std::vector<Real> input(steps), expected(steps);
+            for (Size j=0; j<n; ++j) {
+                for (Size i=0; i<steps; ++i)
+                    input[i] = variates[i][j];
+                bridge.transform(input.begin(), input.end(),
+                                 expected.begin());
+                for (Size i=0; i<steps; ++i) {
+                    if (std::fabs(output[i][j]-expected[i]) > bridgeTolerance)
+                        BOOST_FAIL("wrong variation for " << steps
+                                   << " steps and " << n << " paths:"
+                                   << "\n    step:       " << i
+                                   << "\n    path:       " << j
+                                   << "\n    calculated: " << output[i][j]
+                                   << "\n    expected:   " << expected[i]);
+                }
+            }
+        }
+    }
+
+    Matrix wrongSize(3, 4);
+    BOOST_CHECK_THROW(bridges[1].transform(wrongSize, wrongSize), Error);
+    Matrix sameMatrix(1, 4);
+    BOOST_CHECK_THROW(bridges[1].transform(sameMatrix, sameMatrix), Error);
+}
+
+
+void BrownianBridgeTest::testMultiFactorTransform() {
+
+    BOOST_TEST_MESSAGE("Testing multi-path transform of "
+                       "Sobol Brownian generator...");
+
+    const Size factors = 3, steps = 10, paths = 37;
+    const SobolBrownianGenerator::Ordering orderings[] = {
+        SobolBrownianGenerator::Factors,
+        SobolBrownianGenerator::Steps,
+        SobolBrownianGenerator::Diagonal
+    };
+
+    MersenneTwisterUniformRng rng(42);
+    std::vector<std::vector<Real> > variates(factors*steps,
+                                             std::vector<Real>(paths));
+    for (Size k=0; k<factors*steps; ++k)
+        for (Size j=0; j<paths; ++j)
+            variates[k][j] = rng.nextReal() - 0.5;
+
+    BrownianBridge bridge(steps);
+    for (Size o=0; o<LENGTH(orderings); ++o) {
+        SobolBrownianGenerator generator(factors, steps, orderings[o]);
+        const std::vector<std::vector<Real> > result =
+            generator.transform(variates);
+        const std::vector<std::vector<Size> >& indices =
+            generator.orderedIndices();
+
+        std::vector<Real> sample(factors*steps), expected(steps);
+        for (Size j=0; j<paths; ++j) {
+            for (Size k=0; k<factors*steps; ++k)
+                sample[k] = variates[k][j];
+            for (Size i=0; i<factors; ++i) {
+                bridge.transform(
+                    boost::make_permutation_iterator(sample.begin(),
+                                                     indices[i].begin()),
+                    boost::make_permutation_iterator(sample.begin(),
+                                                     indices[i].end()),
+                    expected.begin());
+                for (Size k=0; k<steps; ++k) {
+                    const Real calculated = result[i][j*steps+k];
+                    if (std::fabs(calculated-expected[k]) > bridgeTolerance)
+                        BOOST_FAIL("wrong variation for ordering " << o
+                                   << ":\n    factor:     " << i
+                                   << "\n    path:       " << j
+                                   << "\n    step:       " << k
+                                   << "\n    calculated: " << calculated
+                                   << "\n    expected:   " << expected[k]);
+                }
+            }
+        }
+    }
+}
+
+
+test_suite* BrownianBridgeTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Brownian bridge tests");
+    suite->add(QUANTLIB_TEST_CASE(
+                             &BrownianBridgeTest::testMultiPathTransform));
+    suite->add(QUANTLIB_TEST_CASE(
+                             &BrownianBridgeTest::testMultiFactorTransform));
+    return suite;
+}
+
+
+#endif
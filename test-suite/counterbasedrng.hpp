@@ -0,0 +1,286 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef quantlib_test_counter_based_rng_hpp
+#define quantlib_test_counter_based_rng_hpp
+
+#include <boost/test/unit_test.hpp>
+
+/* remember to document new and/or updated tests in the Doxygen
+   comment block of the corresponding class */
+
+class CounterBasedRngTest {
+  public:
+    static void testKnownValues();
+    static void testJumpAhead();
+    static void testParallelStreams();
+    static void testThroughput();
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <ql/math/randomnumbers/counterbaseduniformrng.hpp>
+#include <ql/math/randomnumbers/rngtraits.hpp>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    typedef boost::uint32_t word;
+
+    struct KnownAnswer {
+        word counter[4], key[4], result[4];
+    };
+
+    template <class Bijection>
+    void checkKnownAnswers(const std::string& name,
+                           const KnownAnswer* answers, Size n) {
+        for (Size i=0; i<n; ++i) {
+            word x[4];
+            std::copy(answers[i].counter, answers[i].counter+4, x);
+            Bijection::apply(1, &x[0], &x[1], &x[2], &x[3], answers[i].key);
+            for (Size j=0; j<4; ++j)
+                if (x[j] != answers[i].result[j])
+                    BOOST_FAIL("wrong " << name << " value for case " << i
+                               << ", word " << j << ":"
+                               << "\n    calculated: " << x[j]
+                               << "\n    expected:   "
+                               << answers[i].result[j]);
+        }
+    }
+
+    template <class RNG>
+    void checkJumps(const std::string& name) {
+        const BigNatural seed = 42, stream = 7;
+        const Size n = 1003;
+        RNG rng(seed, stream);
+        std::vector<Real> sequence(n);
+        for (Size i=0; i<n; ++i)
+            sequence[i] = rng.nextReal();
+        if (rng.index() != n)
+            BOOST_FAIL("wrong " << name << " index after " << n << " draws:"
+                       << "\n    calculated: " << rng.index());
+
+        // jumps to any position...
+        const Size positions[] = { 0, 1, 3, 4, 5, 257, 1000 };
+        for (Size k=0; k<LENGTH(positions); ++k) {
+            RNG jumped(seed, 0);
+            jumped.jump(stream, positions[k]);
+            for (Size i=positions[k]; i<n; ++i) {
+                const Real x = jumped.nextReal();
+                if (x != sequence[i])
+                    BOOST_FAIL("wrong " << name << " value at index " << i
+                               << " after jumping to " << positions[k]
+                               << "\n    calculated: " << x
+                               << "\n    expected:   " << sequence[i]);
+            }
+        }
+
+        // ...and bulk generation from any position reproduce the
+        // sequential draws
+        const Size lengths[] = { 1, 2, 3, 5, 255, 300 };
+        RNG filled(seed, stream);
+        std::vector<Real> buffer(n);
+        Size i = 0, k = 0;
+        while (i < n) {
+            const Size l = std::min(lengths[k++ % LENGTH(lengths)], n-i);
+            filled.fill(&buffer[i], l);
+            i += l;
+            filled.discard(k % 3);
+            i += k % 3;
+        }
+        i = 0; k = 0;
+        while (i < n) {
+            const Size l = std::min(lengths[k++ % LENGTH(lengths)], n-i);
+            for (Size j=i; j<i+l; ++j)
+                if (buffer[j] != sequence[j])
+                    BOOST_FAIL("wrong " << name << " bulk value at index "
+                               << j << "\n    calculated: " << buffer[j]
+                               << "\n    expected:   " << sequence[j]);
+            i += l + k % 3;
+        }
+
+        // different streams and seeds give different sequences
+        RNG other(seed, stream+1), reseeded(seed+1, stream);
+        Size same = 0;
+        for (Size j=0; j<n; ++j) {
+            if (other.nextReal() == sequence[j])
+                ++same;
+            if (reseeded.nextReal() == sequence[j])
+                ++same;
+        }
+        if (same > 1)
+            BOOST_FAIL(name << " streams overlap in " << same << " values");
+    }
+
+}
+
+
+void CounterBasedRngTest::testKnownValues() {
+
+    BOOST_TEST_MESSAGE("Testing counter-based random number generators "
+                       "against known good values...");
+
+    // the following values are provided by the Random123 authors
+    static const KnownAnswer philox[] = {
+        { { 0x00000000UL, 0x00000000UL, 0x00000000UL, 0x00000000UL },
+          { 0x00000000UL, 0x00000000UL, 0x00000000UL, 0x00000000UL },
+          { 0x6627e8d5UL, 0xe169c58dUL, 0xbc57ac4cUL, 0x9b00dbd8UL } },
+        { { 0xffffffffUL, 0xffffffffUL, 0xffffffffUL, 0xffffffffUL },
+          { 0xffffffffUL, 0xffffffffUL, 0x00000000UL, 0x00000000UL },
+          { 0x408f276dUL, 0x41c83b0eUL, 0xa20bc7c6UL, 0x6d5451fdUL } },
+        { { 0x243f6a88UL, 0x85a308d3UL, 0x13198a2eUL, 0x03707344UL },
+          { 0xa4093822UL, 0x299f31d0UL, 0x00000000UL, 0x00000000UL },
+          { 0xd16cfe09UL, 0x94fdccebUL, 0x5001e420UL, 0x24126ea1UL } }
+    };
+    static const KnownAnswer threefry[] = {
+        { { 0x00000000UL, 0x00000000UL, 0x00000000UL, 0x00000000UL },
+          { 0x00000000UL, 0x00000000UL, 0x00000000UL, 0x00000000UL },
+          { 0x9c6ca96aUL, 0xe17eae66UL, 0xfc10ecd4UL, 0x5256a7d8UL } },
+        { { 0xffffffffUL, 0xffffffffUL, 0xffffffffUL, 0xffffffffUL },
+          { 0xffffffffUL, 0xffffffffUL, 0xffffffffUL, 0xffffffffUL },
+          { 0x2a881696UL, 0x57012287UL, 0xf6c7446eUL, 0xa16a6732UL } },
+        { { 0x243f6a88UL, 0x85a308d3UL, 0x13198a2eUL, 0x03707344UL },
+          { 0xa4093822UL, 0x299f31d0UL, 0x082efa98UL, 0xec4e6c89UL },
+          { 0x59cd1dbbUL, 0xb8879579UL, 0x86b5d00cUL, 0xac8b6d84UL } }
+    };
+    checkKnownAnswers<detail::Philox4x32>("Philox", philox, LENGTH(philox));
+    checkKnownAnswers<detail::Threefry4x32>("Threefry",
+                                            threefry, LENGTH(threefry));
+
+    // the generator uses the seed as key, and the stream and the
+    // block number as counter
+    const word seed = 0x299f31d0UL, stream = 0x13198a2eUL;
+    PhiloxUniformRng rng(seed, stream);
+    rng.discard(4*5);
+    word x[4] = { 5, 0, stream, 0 }, key[4] = { seed, 0, 0, 0 };
+    detail::Philox4x32::apply(1, &x[0], &x[1], &x[2], &x[3], key);
+    for (Size j=0; j<4; ++j) {
+        const unsigned long y = rng.nextInt32();
+        if (y != x[j])
+            BOOST_FAIL("wrong Philox generator value " << j << ":"
+                       << "\n    calculated: " << y
+                       << "\n    expected:   " << x[j]);
+    }
+}
+
+
+void CounterBasedRngTest::testJumpAhead() {
+
+    BOOST_TEST_MESSAGE("Testing jump-ahead and bulk generation of "
+                       "counter-based random number generators...");
+
+    checkJumps<PhiloxUniformRng>("Philox");
+    checkJumps<ThreefryUniformRng>("Threefry");
+}
+
+
+void CounterBasedRngTest::testParallelStreams() {
+
+    BOOST_TEST_MESSAGE("Testing reproducibility of parallel "
+                       "counter-based random sequences...");
+
+    const Size paths = 1000, dimension = 37;
+    const BigNatural seed = 1234;
+
+    // each path is drawn from its own position in the stream...
+    std::vector<Real> parallel(paths*dimension);
+    #pragma omp parallel for
+    for (Size i=0; i<paths; ++i) {
+        PhiloxPseudoRandom::rsg_type rsg =
+            PhiloxPseudoRandom::make_sequence_generator(dimension, seed,
+                                                        0, i*dimension);
+        const std::vector<Real>& values = rsg.nextSequence().value;
+        std::copy(values.begin(), values.end(),
+                  parallel.begin() + i*dimension);
+    }
+
+    // ...and the results are those of the sequential draws
+    PhiloxPseudoRandom::rsg_type rsg =
+        PhiloxPseudoRandom::make_sequence_generator(dimension, seed, 0);
+    PhiloxUniformRng rng(seed);
+    InverseCumulativeNormal invNormal;
+    for (Size i=0; i<paths; ++i) {
+        const std::vector<Real>& values = rsg.nextSequence().value;
+        for (Size j=0; j<dimension; ++j) {
+            const Real expected = invNormal(rng.nextReal());
+            if (values[j] != expected || parallel[i*dimension+j] != expected)
+                BOOST_FAIL("wrong value for path " << i << ", dimension "
+                           << j << ":"
+                           << "\n    sequential: " << values[j]
+                           << "\n    parallel:   " << parallel[i*dimension+j]
+                           << "\n    expected:   " << expected);
+        }
+    }
+}
+
+
+void CounterBasedRngTest::testThroughput() {
+
+    BOOST_TEST_MESSAGE("Testing throughput of counter-based "
+                       "random number generators...");
+
+    const Size n = 1 << 16, repetitions = 256;
+    std::vector<Real> buffer(n);
+    PhiloxUniformRng philox(42);
+    ThreefryUniformRng threefry(42);
+    MersenneTwisterUniformRng mt(42);
+    Real sum = 0.0;
+    for (Size k=0; k<repetitions; ++k) {
+        philox.fill(&buffer[0], n);
+        sum += buffer[n-1];
+        threefry.fill(&buffer[0], n);
+        sum += buffer[n-1];
+        for (Size i=0; i<n; ++i)
+            buffer[i] = mt.nextReal();
+        sum += buffer[n-1];
+    }
+
+    if (!(sum > 0.0 && sum < 3.0*repetitions))
+        BOOST_FAIL("unexpected sum of samples: " << sum);
+}
+
+
+test_suite* CounterBasedRngTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Counter-based RNG tests");
+    suite->add(QUANTLIB_TEST_CASE(&CounterBasedRngTest::testKnownValues));
+    suite->add(QUANTLIB_TEST_CASE(&CounterBasedRngTest::testJumpAhead));
+    suite->add(QUANTLIB_TEST_CASE(&CounterBasedRngTest::testParallelStreams));
+    return suite;
+}
+
+
+#endif
@@ -38,6 +38,8 @@ class DistributionTest {
     static void testBivariateCumulativeStudent();
     static void testBivariateCumulativeStudentVsBivariate();
     static void testInvCDFviaStochasticCollocation();
+    static void testInverseCumulativeNormalTransform();
+    static void testInverseCumulativeNormalThroughput();
     static boost::unit_test_framework::test_suite* suite(SpeedLevel);
 };
 
@@ -73,6 +75,8 @@ class DistributionTest {
 #include <ql/math/distributions/chisquaredistribution.hpp>
 #include <ql/math/distributions/poissondistribution.hpp>
 #include <ql/math/randomnumbers/stochasticcollocationinvcdf.hpp>
+#include <ql/math/randomnumbers/inversecumulativersg.hpp>
+#include <ql/math/randomnumbers/sobolrsg.hpp>
 #include <ql/math/comparison.hpp>
 #include <ql/math/functional.hpp>
 
@@ -753,6 +757,90 @@ void DistributionTest::testInvCDFviaStochasticCollocation() {
     }
 }
 
+void DistributionTest::testInverseCumulativeNormalTransform() {
+
+    BOOST_TEST_MESSAGE("Testing bulk inverse cumulative normal transform...");
+
+    // central region, tails, region boundaries and extreme values
+    std::vector<Real> x;
+    const Size n = 10007;
+    for (Size i=1; i<n; ++i)
+        x.push_back(Real(i)/n);
+    const Real special[] = { 1.0e-300, 1.0e-12, 0.02425, 0.0242501,
+                             0.97575, 0.9757501, 1.0-1.0e-12 };
+    for (Size i=0; i<LENGTH(special); ++i)
+        x.push_back(special[i]);
+
+    const Real averages[] = { 0.0, 1.5 }, sigmas[] = { 1.0, 0.3 };
+    for (Size k=0; k<LENGTH(averages); ++k) {
+        const InverseCumulativeNormal invCum(averages[k], sigmas[k]);
+        std::vector<Real> y(x.size()), inPlace(x);
+        invCum.transform(&x[0], &x[0]+x.size(), &y[0]);
+        invCum.transform(&inPlace[0], &inPlace[0]+x.size(), &inPlace[0]);
+        for (Size i=0; i<x.size(); ++i) {
+            const Real expected = invCum(x[i]);
+            const Real tolerance = 1.0e-14*std::max(1.0, std::fabs(expected));
+            if (std::fabs(y[i]-expected) > tolerance
+                || std::fabs(inPlace[i]-expected) > tolerance)
+                BOOST_FAIL("bulk inverse cumulative normal at " << x[i]
+                           << " with average " << averages[k]
+                           << " and sigma " << sigmas[k] << ":"
+                           << std::setprecision(16)
+                           << "\n    calculated: " << y[i]
+                           << "\n    in place:   " << inPlace[i]
+                           << "\n    expected:   " << expected);
+        }
+    }
+
+    // the sequence generator uses the bulk transform
+    const Size dimension = 500;
+    InverseCumulativeRsg<SobolRsg, InverseCumulativeNormal>
+        rsg(SobolRsg(dimension, 42));
+    SobolRsg sobol(dimension, 42);
+    const InverseCumulativeNormal invCum;
+    for (Size j=0; j<10; ++j) {
+        const std::vector<Real>& u = sobol.nextSequence().value;
+        const std::vector<Real>& z = rsg.nextSequence().value;
+        for (Size i=0; i<dimension; ++i)
+            if (std::fabs(z[i]-invCum(u[i]))
+                > 1.0e-14*std::max(1.0, std::fabs(z[i])))
+                BOOST_FAIL("wrong Gaussian Sobol sample " << j
+                           << " in dimension " << i << ":"
+                           << std::setprecision(16)
+                           << "\n    calculated: " << z[i]
+                           << "\n    expected:   " << invCum(u[i]));
+    }
+}
+
+void DistributionTest::testInverseCumulativeNormalThroughput() {
+
+    BOOST_TEST_MESSAGE("Testing throughput of bulk inverse cumulative "
+                       "normal transform...");
+
+    // 500-dimensional Gaussian Sobol sequences, as in QMC pricing
+    const Size dimension = 500, samples = 20000;
+    InverseCumulativeRsg<SobolRsg, InverseCumulativeNormal>
+        rsg(SobolRsg(dimension, 42));
+    Real sum = 0.0;
+    for (Size j=0; j<samples; ++j)
+        sum += rsg.nextSequence().value[j % dimension];
+
+    // a large array transformed at once
+    const Size n = 1000000;
+    std::vector<Real> x(n), y(n);
+    for (Size i=0; i<n; ++i)
+        x[i] = (i+0.5)/n;
+    const InverseCumulativeNormal invCum;
+    for (Size k=0; k<10; ++k) {
+        invCum.transform(&x[0], &x[0]+n, &y[0]);
+        sum += y[k];
+    }
+
+    if (!(std::fabs(sum) < Real(samples)))
+        BOOST_FAIL("unexpected sum of samples: " << sum);
+}
+
+
 test_suite* DistributionTest::suite(SpeedLevel speed) {
     test_suite* suite = BOOST_TEST_SUITE("Distribution tests");
 
@@ -766,6 +854,8 @@ test_suite* DistributionTest::suite(SpeedLevel speed) {
                           &DistributionTest::testBivariateCumulativeStudent));
     suite->add(QUANTLIB_TEST_CASE(
                    &DistributionTest::testInvCDFviaStochasticCollocation));
+    suite->add(QUANTLIB_TEST_CASE(
+                   &DistributionTest::testInverseCumulativeNormalTransform));
 
     if (speed <= Fast) {
         suite->add(QUANTLIB_TEST_CASE(
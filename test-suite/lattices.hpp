@@ -0,0 +1,419 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef quantlib_test_lattices_hpp
+#define quantlib_test_lattices_hpp
+
+#include <boost/test/unit_test.hpp>
+
+/* remember to document new and/or updated tests in the Doxygen
+   comment block of the corresponding class */
+
+class LatticeTest {
+  public:
+    static void testShortRateTreeRollback();
+    static void testBatchedRollback();
+    static void testFittedShortRateTree();
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <ql/models/shortrate/onefactormodel.hpp>
+#include <ql/discretizedasset.hpp>
+#include <ql/stochasticprocess.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    // Ornstein-Uhlenbeck process with exact moments
+    class MeanRevertingProcess : public StochasticProcess1D {
+      public:
+        MeanRevertingProcess(Real speed, Volatility sigma)
+        : speed_(speed), sigma_(sigma) {}
+        Real x0() const { return 0.0; }
+        Real drift(Time, Real x) const { return -speed_*x; }
+        Real diffusion(Time, Real) const { return sigma_; }
+        Real expectation(Time, Real x0, Time dt) const {
+            return x0*std::exp(-speed_*dt);
+        }
+        Real variance(Time, Real, Time dt) const {
+            return 0.5*sigma_*sigma_/speed_*(1.0-std::exp(-2.0*speed_*dt));
+        }
+        Real stdDeviation(Time t, Real x0, Time dt) const {
+            return std::sqrt(variance(t, x0, dt));
+        }
+      private:
+        Real speed_;
+        Volatility sigma_;
+    };
+
+    // the short rate is the state variable plus a time-dependent shift
+    class ShiftedDynamics : public OneFactorModel::ShortRateDynamics {
+      public:
+        ShiftedDynamics(const boost::shared_ptr<StochasticProcess1D>& p)
+        : ShortRateDynamics(p) {}
+        Real variable(Time t, Rate r) const { return r - shift(t); }
+        Rate shortRate(Time t, Real x) const { return x + shift(t); }
+      private:
+        static Rate shift(Time t) { return 0.02 + 0.003*t; }
+    };
+
+    // the short rate is the state variable shifted by a fitting
+    // parameter, or the exponential thereof
+    class FittedDynamics : public OneFactorModel::ShortRateDynamics {
+      public:
+        FittedDynamics(const boost::shared_ptr<StochasticProcess1D>& p,
+                       const Parameter& theta,
+                       bool lognormal,
+                       bool withDerivative)
+        : ShortRateDynamics(p), theta_(theta), lognormal_(lognormal),
+          withDerivative_(withDerivative) {}
+        Real variable(Time t, Rate r) const {
+            return (lognormal_ ? std::log(r) : r) - theta_(t);
+        }
+        Rate shortRate(Time t, Real x) const {
+            return lognormal_ ? std::exp(x + theta_(t)) : x + theta_(t);
+        }
+        Real shortRateDerivative(Time t, Real x) const {
+            if (!withDerivative_)
+                return Null<Real>();
+            return lognormal_ ? shortRate(t, x) : 1.0;
+        }
+      private:
+        Parameter theta_;
+        bool lognormal_, withDerivative_;
+    };
+
+    // plain rollback through the generic lattice interface
+    Disposable<Array> referenceRollback(
+                          const OneFactorModel::ShortRateTree& lattice,
+                          Size steps) {
+        Array values(lattice.size(steps), 1.0);
+        for (Size i=steps; i>0; --i) {
+            Array newValues(lattice.size(i-1), 0.0);
+            for (Size j=0; j<newValues.size(); ++j) {
+                for (Size l=0; l<3; ++l)
+                    newValues[j] += lattice.probability(i-1,j,l) *
+                                    values[lattice.descendant(i-1,j,l)];
+                newValues[j] *= lattice.discount(i-1,j);
+            }
+            values.swap(newValues);
+        }
+        return values;
+    }
+
+    // Bermudan call on a discretized asset
+    class BermudanCallOption : public DiscretizedAsset {
+      public:
+        BermudanCallOption(
+                  const boost::shared_ptr<DiscretizedAsset>& underlying,
+                  Real strike,
+                  const std::vector<Time>& exerciseTimes)
+        : underlying_(underlying), strike_(strike),
+          exerciseTimes_(exerciseTimes) {}
+        void reset(Size size) {
+            values_ = Array(size, 0.0);
+            adjustValues();
+        }
+        std::vector<Time> mandatoryTimes() const { return exerciseTimes_; }
+      protected:
+        void postAdjustValuesImpl() {
+            underlying_->partialRollback(time());
+            for (Size i=0; i<exerciseTimes_.size(); ++i) {
+                if (isOnTime(exerciseTimes_[i])) {
+                    const Array& underlying = underlying_->values();
+                    for (Size j=0; j<values_.size(); ++j)
+                        values_[j] = std::max(values_[j],
+                                              underlying[j] - strike_);
+                }
+            }
+        }
+      private:
+        boost::shared_ptr<DiscretizedAsset> underlying_;
+        Real strike_;
+        std::vector<Time> exerciseTimes_;
+    };
+
+    // a lattice relying on the default implementation of batched
+    // rollbacks, as lattices defined outside the library would do
+    class ForwardingLattice : public Lattice {
+      public:
+        explicit ForwardingLattice(const boost::shared_ptr<Lattice>& lattice)
+        : Lattice(lattice->timeGrid()), lattice_(lattice) {}
+        void initialize(DiscretizedAsset& asset, Time t) const {
+            lattice_->initialize(asset, t);
+        }
+        void rollback(DiscretizedAsset& asset, Time to) const {
+            lattice_->rollback(asset, to);
+        }
+        void partialRollback(DiscretizedAsset& asset, Time to) const {
+            lattice_->partialRollback(asset, to);
+        }
+        Real presentValue(DiscretizedAsset& asset) const {
+            return lattice_->presentValue(asset);
+        }
+        Disposable<Array> grid(Time t) const {
+            return lattice_->grid(t);
+        }
+      private:
+        boost::shared_ptr<Lattice> lattice_;
+    };
+
+    // a Bermudan option on a bond, plus bonds of different maturities
+    std::vector<boost::shared_ptr<DiscretizedAsset> > bondPortfolio(
+                              const boost::shared_ptr<Lattice>& lattice) {
+        std::vector<boost::shared_ptr<DiscretizedAsset> > assets;
+        const boost::shared_ptr<DiscretizedAsset> underlying(
+                                              new DiscretizedDiscountBond);
+        underlying->initialize(lattice, 10.0);
+        std::vector<Time> exerciseTimes;
+        for (Size i=1; i<5; ++i)
+            exerciseTimes.push_back(2.0*i);
+        // the option precedes its underlying
+        assets.push_back(boost::shared_ptr<DiscretizedAsset>(
+                   new BermudanCallOption(underlying, 0.85, exerciseTimes)));
+        assets.back()->initialize(lattice, exerciseTimes.back());
+        assets.push_back(underlying);
+        for (Size i=1; i<10; i+=2) {
+            assets.push_back(boost::shared_ptr<DiscretizedAsset>(
+                                              new DiscretizedDiscountBond));
+            assets.back()->initialize(lattice, Time(i));
+        }
+        return assets;
+    }
+
+}
+
+
+void LatticeTest::testShortRateTreeRollback() {
+
+    BOOST_TEST_MESSAGE("Testing rollback on short-rate trees...");
+
+    const Time maturity = 10.0;
+    const Size steps = 1000;
+    const TimeGrid grid(maturity, steps);
+    const boost::shared_ptr<StochasticProcess1D> process(
+                                   new MeanRevertingProcess(0.1, 0.01));
+    const boost::shared_ptr<TrinomialTree> trinomial(
+                                   new TrinomialTree(process, grid));
+    const boost::shared_ptr<OneFactorModel::ShortRateTree> lattice(
+        new OneFactorModel::ShortRateTree(
+            trinomial,
+            boost::shared_ptr<OneFactorModel::ShortRateDynamics>(
+                                            new ShiftedDynamics(process)),
+            grid));
+
+    const Real expected = referenceRollback(*lattice, steps)[0];
+
+    // rolling back over the flat branching data gives the same
+    // results as the generic interface, also when reusing the
+    // cached discount factors...
+    for (Size k=0; k<2; ++k) {
+        DiscretizedDiscountBond bond;
+        bond.initialize(lattice, maturity);
+        bond.rollback(0.0);
+        const Real calculated = bond.presentValue();
+        if (std::fabs(calculated - expected) > 1.0e-14)
+            BOOST_FAIL("failed to reproduce generic rollback:"
+                       << "\n    calculated: " << calculated
+                       << "\n    expected:   " << expected
+                       << "\n    run:        " << k);
+    }
+
+    // ...and consistent with the Arrow-Debreu prices
+    DiscretizedDiscountBond bond;
+    bond.initialize(lattice, maturity);
+    bond.partialRollback(4.0);
+    const Real presentValue = lattice->presentValue(bond);
+    if (std::fabs(presentValue - expected) > 1.0e-12)
+        BOOST_FAIL("rollback inconsistent with state prices:"
+                   << "\n    state prices: " << presentValue
+                   << "\n    rollback:     " << expected);
+}
+
+
+void LatticeTest::testBatchedRollback() {
+
+    BOOST_TEST_MESSAGE("Testing batched rollback of several assets...");
+
+    std::vector<Time> times;
+    for (Size i=1; i<=10; ++i)
+        times.push_back(Time(i));
+    const TimeGrid grid(times.begin(), times.end(), 400);
+    const boost::shared_ptr<StochasticProcess1D> process(
+                                   new MeanRevertingProcess(0.1, 0.01));
+    const boost::shared_ptr<Lattice> tree(
+        new OneFactorModel::ShortRateTree(
+            boost::shared_ptr<TrinomialTree>(new TrinomialTree(process,
+                                                               grid)),
+            boost::shared_ptr<OneFactorModel::ShortRateDynamics>(
+                                            new ShiftedDynamics(process)),
+            grid));
+    // the second lattice uses the default implementation
+    const boost::shared_ptr<Lattice> lattices[] = {
+        tree, boost::shared_ptr<Lattice>(new ForwardingLattice(tree))
+    };
+
+    const Time targets[] = { 0.0, 0.5 };
+    for (Size n=0; n<2*LENGTH(targets); ++n) {
+        const boost::shared_ptr<Lattice>& lattice = lattices[n/2];
+        const Time to = targets[n%2];
+
+        std::vector<boost::shared_ptr<DiscretizedAsset> > single =
+            bondPortfolio(lattice);
+        // the underlying is rolled back by the option
+        single[0]->rollback(to);
+        for (Size k=2; k<single.size(); ++k)
+            single[k]->rollback(to);
+        single[1]->partialRollback(to);
+        single[1]->adjustValues();
+
+        std::vector<boost::shared_ptr<DiscretizedAsset> > batched =
+            bondPortfolio(lattice);
+        lattice->rollback(batched, to);
+
+        // rolling back the assets together gives the same values as
+        // rolling them back one by one
+        for (Size k=0; k<batched.size(); ++k) {
+            if (!close(batched[k]->time(), to))
+                BOOST_FAIL("asset " << k << " not rolled back to " << to
+                           << "\n    time: " << batched[k]->time());
+            const Array& calculated = batched[k]->values();
+            const Array& expected = single[k]->values();
+            QL_REQUIRE(calculated.size() == expected.size(),
+                       "size mismatch for asset " << k);
+            for (Size j=0; j<calculated.size(); ++j) {
+                if (std::fabs(calculated[j] - expected[j]) > 1.0e-15)
+                    BOOST_FAIL("failed to reproduce single rollback:"
+                               << "\n    lattice:    " << n/2
+                               << "\n    asset:      " << k
+                               << "\n    node:       " << j
+                               << "\n    time:       " << to
+                               << "\n    calculated: " << calculated[j]
+                               << "\n    expected:   " << expected[j]);
+            }
+        }
+    }
+
+    // assets cannot be rolled forward
+    for (Size n=0; n<LENGTH(lattices); ++n) {
+        std::vector<boost::shared_ptr<DiscretizedAsset> > assets =
+            bondPortfolio(lattices[n]);
+        lattices[n]->rollback(assets, 1.0);
+        BOOST_CHECK_THROW(lattices[n]->rollback(assets, 2.0), Error);
+    }
+}
+
+
+void LatticeTest::testFittedShortRateTree() {
+
+    BOOST_TEST_MESSAGE("Testing term-structure fitting of short-rate trees...");
+
+    const Date today = Settings::instance().evaluationDate();
+    const Handle<YieldTermStructure> termStructure(
+                               flatRate(today, 0.04, Actual365Fixed()));
+    const TimeGrid grid(10.0, 200);
+
+    const bool lognormal[] = { false, true };
+    const Volatility sigma[] = { 0.01, 0.20 };
+    for (Size n=0; n<LENGTH(lognormal); ++n) {
+        const boost::shared_ptr<StochasticProcess1D> process(
+                                 new MeanRevertingProcess(0.1, sigma[n]));
+        const boost::shared_ptr<TrinomialTree> trinomial(
+                                 new TrinomialTree(process, grid));
+
+        // the same tree is fitted by Newton iterations and by Brent
+        std::vector<boost::shared_ptr<Lattice> > lattices;
+        for (Size k=0; k<2; ++k) {
+            TermStructureFittingParameter theta(termStructure);
+            const boost::shared_ptr<
+                TermStructureFittingParameter::NumericalImpl> impl =
+                boost::dynamic_pointer_cast<
+                    TermStructureFittingParameter::NumericalImpl>(
+                                                 theta.implementation());
+            const boost::shared_ptr<OneFactorModel::ShortRateDynamics>
+                dynamics(new FittedDynamics(process, theta,
+                                            lognormal[n], k == 0));
+            lattices.push_back(boost::shared_ptr<Lattice>(
+                new OneFactorModel::ShortRateTree(trinomial, dynamics,
+                                                  impl, grid)));
+        }
+
+        for (Size i=1; i<grid.size(); i+=7) {
+            const Time maturity = grid[i];
+            const DiscountFactor expected =
+                termStructure->discount(maturity);
+            Real prices[2];
+            for (Size k=0; k<2; ++k) {
+                DiscretizedDiscountBond bond;
+                bond.initialize(lattices[k], maturity);
+                bond.rollback(0.0);
+                prices[k] = bond.presentValue();
+            }
+            // both fits reproduce the term structure...
+            for (Size k=0; k<2; ++k) {
+                if (std::fabs(prices[k] - expected) > 1.0e-7)
+                    BOOST_FAIL("failed to fit term structure:"
+                               << "\n    lognormal:  " << lognormal[n]
+                               << "\n    Newton:     " << (k == 0)
+                               << "\n    maturity:   " << maturity
+                               << "\n    calculated: " << prices[k]
+                               << "\n    expected:   " << expected);
+            }
+            // ...and agree with each other
+            if (std::fabs(prices[0] - prices[1]) > 1.0e-8)
+                BOOST_FAIL("Newton and Brent fits disagree:"
+                           << "\n    lognormal: " << lognormal[n]
+                           << "\n    maturity:  " << maturity
+                           << "\n    Newton:    " << prices[0]
+                           << "\n    Brent:     " << prices[1]);
+        }
+    }
+}
+
+
+test_suite* LatticeTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Lattice tests");
+    suite->add(QUANTLIB_TEST_CASE(&LatticeTest::testShortRateTreeRollback));
+    suite->add(QUANTLIB_TEST_CASE(&LatticeTest::testBatchedRollback));
+    suite->add(QUANTLIB_TEST_CASE(&LatticeTest::testFittedShortRateTree));
+    return suite;
+}
+
+
+#endif
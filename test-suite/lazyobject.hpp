@@ -0,0 +1,279 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef quantlib_test_lazy_object_hpp
+#define quantlib_test_lazy_object_hpp
+
+#include <boost/test/unit_test.hpp>
+
+/* remember to document new and/or updated tests in the Doxygen
+   comment block of the corresponding class */
+
+class LazyObjectTest {
+  public:
+    static void testScheduledRecalculation();
+    static void testSharedEngines();
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <ql/patterns/lazyobjectscheduler.hpp>
+#include <ql/instrument.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/handle.hpp>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    // a lazy value depending on a quote and, optionally, on
+    // another lazy value seen through a relinkable handle
+    class LazyValue : public LazyObject {
+      public:
+        LazyValue(const boost::shared_ptr<SimpleQuote>& quote,
+                  const Handle<LazyValue>& base = Handle<LazyValue>())
+        : quote_(quote), base_(base), calculations_(0) {
+            registerWith(quote_);
+            registerWith(base_);
+        }
+        Real value() const {
+            calculate();
+            return value_;
+        }
+        Size calculations() const { return calculations_; }
+      private:
+        void performCalculations() const {
+            ++calculations_;
+            value_ = quote_->value();
+            if (!base_.empty())
+                value_ += base_->value();
+        }
+        boost::shared_ptr<SimpleQuote> quote_;
+        Handle<LazyValue> base_;
+        mutable Real value_;
+        mutable Size calculations_;
+    };
+
+    // an instrument worth a multiple of a lazy value
+    class ScaledValue : public Instrument {
+      public:
+        class arguments : public PricingEngine::arguments {
+          public:
+            arguments() : factor(Null<Real>()) {}
+            void validate() const {
+                QL_REQUIRE(factor != Null<Real>(), "no factor given");
+            }
+            Real factor;
+        };
+        class engine
+            : public GenericEngine<arguments, Instrument::results> {};
+        explicit ScaledValue(Real factor) : factor_(factor) {}
+        bool isExpired() const { return false; }
+        void setupArguments(PricingEngine::arguments* args) const {
+            arguments* a = dynamic_cast<arguments*>(args);
+            QL_REQUIRE(a != 0, "wrong argument type");
+            a->factor = factor_;
+        }
+      private:
+        Real factor_;
+    };
+
+    // records whether it was used by more than one thread at once
+    class ScaledValueEngine : public ScaledValue::engine {
+      public:
+        explicit ScaledValueEngine(const boost::shared_ptr<LazyValue>& base)
+        : base_(base), busy_(false), overlapped_(false) {
+            registerWith(base_);
+        }
+        void calculate() const {
+            if (busy_)
+                overlapped_ = true;
+            busy_ = true;
+            // a few steps, so that concurrent uses would interleave
+            results_.value = 0.0;
+            for (Size i=0; i<1000; ++i)
+                results_.value += arguments_.factor*base_->value()/1000;
+            busy_ = false;
+        }
+        bool overlapped() const { return overlapped_; }
+      private:
+        boost::shared_ptr<LazyValue> base_;
+        mutable bool busy_;
+        mutable bool overlapped_;
+    };
+
+}
+
+
+void LazyObjectTest::testScheduledRecalculation() {
+
+    BOOST_TEST_MESSAGE("Testing scheduled recalculation of lazy objects...");
+
+    const boost::shared_ptr<SimpleQuote> curveQuote(new SimpleQuote(1.0));
+    const boost::shared_ptr<LazyValue> curve(new LazyValue(curveQuote));
+    RelinkableHandle<LazyValue> curveHandle(curve);
+
+    const Size n = 20;
+    std::vector<boost::shared_ptr<SimpleQuote> > quotes;
+    std::vector<boost::shared_ptr<LazyValue> > instruments;
+    LazyObjectScheduler scheduler;
+    for (Size i=0; i<n; ++i) {
+        quotes.push_back(
+              boost::shared_ptr<SimpleQuote>(new SimpleQuote(Real(i))));
+        instruments.push_back(boost::shared_ptr<LazyValue>(
+                                    new LazyValue(quotes[i], curveHandle)));
+        scheduler.add(instruments[i]);
+    }
+
+    std::vector<std::vector<LazyObject*> > levels = scheduler.levels();
+    if (levels.size() != 2
+        || levels[0].size() != 1 || levels[0][0] != curve.get()
+        || levels[1].size() != n) {
+        BOOST_FAIL("wrong dependency levels:"
+                   << "\n    levels:      " << levels.size()
+                   << "\n    expected:    " << 2);
+    }
+
+    Size calculated = scheduler.calculate();
+    if (calculated != n+1) {
+        BOOST_FAIL("wrong number of calculated objects:"
+                   << "\n    calculated:  " << calculated
+                   << "\n    expected:    " << n+1);
+    }
+    for (Size i=0; i<n; ++i) {
+        if (instruments[i]->value() != 1.0+i
+            || instruments[i]->calculations() != 1) {
+            BOOST_FAIL("wrong result for object " << i << ":"
+                       << "\n    value:        " << instruments[i]->value()
+                       << "\n    expected:     " << 1.0+i
+                       << "\n    calculations: "
+                       << instruments[i]->calculations());
+        }
+    }
+    if (curve->calculations() != 1)
+        BOOST_FAIL("shared dependency calculated more than once");
+
+    // nothing to do when up to date
+    if (scheduler.calculate() != 0)
+        BOOST_FAIL("up-to-date objects recalculated");
+
+    // a change of the shared dependency invalidates all objects...
+    curveQuote->setValue(2.0);
+    if (scheduler.calculate() != n+1 || curve->calculations() != 2)
+        BOOST_FAIL("shared dependency not recalculated once");
+
+    // ...while a local change only invalidates one
+    quotes[3]->setValue(10.0);
+    levels = scheduler.levels();
+    if (levels.size() != 1 || levels[0].size() != 1
+        || levels[0][0] != instruments[3].get()) {
+        BOOST_FAIL("wrong dependency levels after local change");
+    }
+    scheduler.calculate();
+    if (instruments[3]->value() != 12.0 || curve->calculations() != 2)
+        BOOST_FAIL("wrong result after local change");
+}
+
+
+void LazyObjectTest::testSharedEngines() {
+
+    BOOST_TEST_MESSAGE("Testing scheduled recalculation of instruments "
+                       "sharing pricing engines...");
+
+    const boost::shared_ptr<SimpleQuote> quote(new SimpleQuote(2.0));
+    const boost::shared_ptr<LazyValue> base(new LazyValue(quote));
+
+    // two shared engines and one used by a single instrument
+    std::vector<boost::shared_ptr<ScaledValueEngine> > engines;
+    for (Size i=0; i<3; ++i)
+        engines.push_back(boost::shared_ptr<ScaledValueEngine>(
+                                             new ScaledValueEngine(base)));
+
+    const Size n = 200;
+    std::vector<boost::shared_ptr<ScaledValue> > instruments;
+    LazyObjectScheduler scheduler;
+    for (Size i=0; i<n; ++i) {
+        instruments.push_back(boost::shared_ptr<ScaledValue>(
+                                             new ScaledValue(1.0+i)));
+        instruments[i]->setPricingEngine(i == 0 ? engines[2]
+                                                : engines[i%2]);
+        scheduler.add(instruments[i]);
+    }
+
+    const std::vector<std::vector<LazyObject*> > levels = scheduler.levels();
+    if (levels.size() != 2 || levels[1].size() != n)
+        BOOST_FAIL("wrong dependency levels:"
+                   << "\n    levels:      " << levels.size()
+                   << "\n    expected:    " << 2);
+    const Size groups = LazyObjectScheduler::groups(levels[1]).size();
+    if (groups != 3)
+        BOOST_FAIL("wrong number of engine groups:"
+                   << "\n    groups:      " << groups
+                   << "\n    expected:    " << 3);
+
+    for (Size k=0; k<2; ++k) {
+        quote->setValue(3.0+k);
+        const Size calculated = scheduler.calculate();
+        if (calculated != n+1)
+            BOOST_FAIL("wrong number of calculated objects:"
+                       << "\n    calculated:  " << calculated
+                       << "\n    expected:    " << n+1);
+        for (Size i=0; i<engines.size(); ++i) {
+            if (engines[i]->overlapped())
+                BOOST_FAIL("engine " << i << " used concurrently");
+        }
+        for (Size i=0; i<n; ++i) {
+            const Real expected = (1.0+i)*quote->value();
+            const Real npv = instruments[i]->NPV();
+            if (std::fabs(npv - expected) > 1.0e-12*expected)
+                BOOST_FAIL("wrong value for instrument " << i << ":"
+                           << "\n    value:       " << npv
+                           << "\n    expected:    " << expected);
+        }
+    }
+}
+
+
+test_suite* LazyObjectTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("LazyObject tests");
+    suite->add(QUANTLIB_TEST_CASE(
+                            &LazyObjectTest::testScheduledRecalculation));
+    suite->add(QUANTLIB_TEST_CASE(&LazyObjectTest::testSharedEngines));
+    return suite;
+}
+
+
+#endif
@@ -48,8 +48,11 @@ class LowDiscrepancyTest {
     static void testRandomizedLowDiscrepancySequence();
 
     static void testSobolSkipping();
+    static void testSobolBatchedDraws();
+    static void testSobolBrownianBridgeDefaults();
 
     static void testRandomizedLattices();
+    static void testRandomizedQuasiMonteCarlo();
 
     static boost::unit_test_framework::test_suite* suite();
 };
@@ -85,10 +88,17 @@ class LowDiscrepancyTest {
 #include <ql/math/randomnumbers/randomizedlds.hpp>
 #include <ql/math/randomnumbers/randomsequencegenerator.hpp>
 #include <ql/math/randomnumbers/sobolrsg.hpp>
+#include <ql/math/randomnumbers/sobolbrownianbridgersg.hpp>
 #include <ql/utilities/dataformatters.hpp>
 #include <boost/progress.hpp>
 #include <ql/math/randomnumbers/latticerules.hpp>
 #include <ql/math/randomnumbers/latticersg.hpp>
+#include <ql/math/randomnumbers/randomizedrngtraits.hpp>
+#include <ql/pricingengines/mcsimulation.hpp>
+#include <ql/pricingengines/blackformula.hpp>
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
 
 //#define PRINT_ONLY
 #ifdef PRINT_ONLY
@@ -232,6 +242,178 @@ void LowDiscrepancyTest::testRandomizedLattices()
 }
 
 
+namespace {
+
+    class TerminalCallPathPricer : public PathPricer<Path> {
+      public:
+        TerminalCallPathPricer(Real strike, DiscountFactor discount)
+        : strike_(strike), discount_(discount) {}
+        Real operator()(const Path& path) const {
+            return discount_*std::max<Real>(path.back() - strike_, 0.0);
+        }
+      private:
+        Real strike_;
+        DiscountFactor discount_;
+    };
+
+    // each worker runs an independent randomization
+    template <class RNG>
+    class RandomizedCallSimulation : public McSimulation<SingleVariate,RNG> {
+      public:
+        typedef McSimulation<SingleVariate,RNG> simulation_type;
+        typedef typename simulation_type::path_generator_type
+            path_generator_type;
+        typedef typename simulation_type::path_pricer_type
+            path_pricer_type;
+        RandomizedCallSimulation(
+               const boost::shared_ptr<GeneralizedBlackScholesProcess>& p,
+               Real strike, Time maturity, Size steps, Size randomizations)
+        : simulation_type(false, false, randomizations),
+          process_(p), strike_(strike), maturity_(maturity), steps_(steps) {}
+        Real value() const {
+            return this->mcModel_->sampleAccumulator().mean();
+        }
+        Size samples() const {
+            return this->mcModel_->sampleAccumulator().samples();
+        }
+        Size workerSamples(Size i) const {
+            return this->mcModel_->workerAccumulator(i).samples();
+        }
+      protected:
+        TimeGrid timeGrid() const { return TimeGrid(maturity_, steps_); }
+        boost::shared_ptr<path_generator_type> pathGenerator() const {
+            return workerPathGenerator(0);
+        }
+        boost::shared_ptr<path_generator_type>
+        workerPathGenerator(Size i) const {
+            return boost::shared_ptr<path_generator_type>(
+                new path_generator_type(
+                        process_, timeGrid(),
+                        RNG::make_sequence_generator(steps_, 1234 + i),
+                        true));
+        }
+        boost::shared_ptr<path_pricer_type> pathPricer() const {
+            return boost::shared_ptr<path_pricer_type>(
+                new TerminalCallPathPricer(
+                          strike_, process_->riskFreeRate()->discount(
+                                                             maturity_)));
+        }
+      private:
+        boost::shared_ptr<GeneralizedBlackScholesProcess> process_;
+        Real strike_;
+        Time maturity_;
+        Size steps_;
+    };
+
+    template <class RNG>
+    void testRandomizedCall(
+               const std::string& name,
+               const boost::shared_ptr<GeneralizedBlackScholesProcess>& p,
+               Real strike, Time maturity, Real expected,
+               Real pseudoRandomError, Real minImprovement) {
+        const Size randomizations = 16, points = 1024, steps = 8;
+
+        // the randomizations give an unbiased estimate with an
+        // error bar...
+        RandomizedCallSimulation<RNG> simulation(p, strike, maturity,
+                                                 steps, randomizations);
+        simulation.calculate(Null<Real>(), randomizations*points,
+                             Null<Size>());
+        const Real value = simulation.value();
+        const Real error = simulation.errorEstimate();
+        if (std::fabs(value - expected) > 4.0*error)
+            BOOST_ERROR("randomized " << name << " estimate out of range:"
+                        << "\n    calculated:     " << value
+                        << "\n    expected:       " << expected
+                        << "\n    error estimate: " << error);
+
+        // ...which is much smaller than the pseudo-random one
+        if (error*minImprovement > pseudoRandomError)
+            BOOST_ERROR("randomized " << name << " error too large:"
+                        << "\n    error estimate:       " << error
+                        << "\n    pseudo-random error:  "
+                        << pseudoRandomError
+                        << "\n    required improvement: "
+                        << minImprovement);
+    }
+
+}
+
+
+void LowDiscrepancyTest::testRandomizedQuasiMonteCarlo() {
+
+    BOOST_TEST_MESSAGE("Testing randomized quasi-Monte Carlo simulations...");
+
+    SavedSettings backup;
+
+    const Date today = Settings::instance().evaluationDate();
+    const DayCounter dc = Actual365Fixed();
+    const Real s0 = 100.0, strike = 100.0;
+    const Rate r = 0.05, q = 0.02;
+    const Volatility sigma = 0.20;
+    const boost::shared_ptr<GeneralizedBlackScholesProcess> process(
+        new BlackScholesMertonProcess(
+            Handle<Quote>(boost::shared_ptr<Quote>(new SimpleQuote(s0))),
+            Handle<YieldTermStructure>(flatRate(today, q, dc)),
+            Handle<YieldTermStructure>(flatRate(today, r, dc)),
+            Handle<BlackVolTermStructure>(flatVol(today, sigma, dc))));
+    const Time maturity = 1.0;
+    const DiscountFactor discount = process->riskFreeRate()->discount(1.0);
+    const Real forward =
+        s0*process->dividendYield()->discount(1.0)/discount;
+    const Real expected = blackFormula(Option::Call, strike, forward,
+                                       sigma*std::sqrt(maturity), discount);
+
+    // reference: the same number of pseudo-random paths
+    RandomizedCallSimulation<PseudoRandom> reference(process, strike,
+                                                     maturity, 8, 1);
+    reference.calculate(Null<Real>(), 16*1024, Null<Size>());
+    const Real pseudoRandomError = reference.errorEstimate();
+
+    testRandomizedCall<RandomizedLowDiscrepancy>(
+        "Sobol", process, strike, maturity, expected,
+        pseudoRandomError, 8.0);
+    testRandomizedCall<RandomizedHalton>(
+        "Halton", process, strike, maturity, expected,
+        pseudoRandomError, 8.0);
+    testRandomizedCall<RandomizedFaure>(
+        "Faure", process, strike, maturity, expected,
+        pseudoRandomError, 3.0);
+    testRandomizedCall<RandomizedLattice>(
+        "lattice", process, strike, maturity, expected,
+        pseudoRandomError, 8.0);
+
+    // a tolerance can be required...
+    const Real tolerance = 0.002;
+    RandomizedCallSimulation<RandomizedLowDiscrepancy> simulation(
+                                     process, strike, maturity, 8, 16);
+    simulation.calculate(tolerance, Null<Size>(), Null<Size>());
+    if (simulation.errorEstimate() > tolerance)
+        BOOST_ERROR("failed to reach required tolerance:"
+                    << "\n    error estimate: "
+                    << simulation.errorEstimate()
+                    << "\n    tolerance:      " << tolerance);
+
+    // ...but not without independent randomizations
+    RandomizedCallSimulation<RandomizedLowDiscrepancy> single(
+                                     process, strike, maturity, 8, 1);
+    single.calculate(Null<Real>(), 1024, Null<Size>());
+    BOOST_CHECK_THROW(single.errorEstimate(), Error);
+
+    // the worker statistics cover all samples...
+    Size workerSamples = 0;
+    for (Size i=0; i<16; ++i)
+        workerSamples += simulation.workerSamples(i);
+    if (workerSamples != simulation.samples())
+        BOOST_ERROR("worker statistics don't cover all samples:"
+                    << "\n    worker samples: " << workerSamples
+                    << "\n    samples:        " << simulation.samples());
+
+    // ...and are only kept for randomized traits
+    BOOST_CHECK_THROW(reference.workerSamples(0), Error);
+}
+
+
 void LowDiscrepancyTest::testSobol() {
 
     BOOST_TEST_MESSAGE("Testing Sobol sequences up to dimension "
@@ -1149,6 +1331,75 @@ void LowDiscrepancyTest::testSobolSkipping() {
     }
 }
 
+void LowDiscrepancyTest::testSobolBatchedDraws() {
+
+    BOOST_TEST_MESSAGE("Testing batched Sobol sequence draws...");
+
+    Size dimensionality[] = { 1, 10, 100 };
+    Size batch[] = { 1, 7, 512 };
+
+    for (Size i=0; i<LENGTH(dimensionality); i++) {
+        for (Size j=0; j<LENGTH(batch); j++) {
+            SobolRsg rsg1(dimensionality[i], 42, SobolRsg::JoeKuoD6);
+            SobolRsg rsg2(dimensionality[i], 42, SobolRsg::JoeKuoD6);
+
+            // draw two batches, so that the second one starts
+            // halfway through the sequence
+            std::vector<Real> points;
+            for (Size l=0; l<2; l++) {
+                rsg2.nextSequences(batch[j], points);
+                for (Size m=0; m<batch[j]; m++) {
+                    const std::vector<Real>& s1 = rsg1.nextSequence().value;
+                    for (Size n=0; n<s1.size(); n++) {
+                        Real found = points[m*dimensionality[i]+n];
+                        if (s1[n] != found) {
+                            BOOST_ERROR("Mismatch in batched draw:"
+                                        << "\n  size:     "
+                                        << dimensionality[i]
+                                        << "\n  batch:    " << batch[j]
+                                        << "\n  at point: "
+                                        << l*batch[j]+m
+                                        << "\n  at index: " << n
+                                        << "\n  expected: " << s1[n]
+                                        << "\n  found:    " << found);
+                        }
+                    }
+                }
+            }
+
+            if (rsg1.lastSequence().value != rsg2.lastSequence().value)
+                BOOST_ERROR("last sequence not updated by batched draw"
+                            << "\n  size:  " << dimensionality[i]
+                            << "\n  batch: " << batch[j]);
+        }
+    }
+}
+
+
+void LowDiscrepancyTest::testSobolBrownianBridgeDefaults() {
+
+    BOOST_TEST_MESSAGE("Testing Sobol Brownian-bridge generator "
+                       "with default direction integers...");
+
+    const Size factors = 2, steps = 10;
+    SobolBrownianBridgeRsg rsg(factors, steps);
+    SobolBrownianBridgeRsg expected(factors, steps,
+                                    SobolBrownianGenerator::Diagonal, 0,
+                                    SobolRsg::JoeKuoD6);
+
+    if (rsg.dimension() != factors*steps)
+        BOOST_FAIL("wrong dimension: " << rsg.dimension()
+                   << " instead of " << factors*steps);
+
+    for (Size i=0; i<10; i++) {
+        const std::vector<Real>& s1 = rsg.nextSequence().value;
+        const std::vector<Real>& s2 = expected.nextSequence().value;
+        if (s1 != s2)
+            BOOST_FAIL("default direction integers are not Joe-Kuo D6 "
+                       "at sample " << i);
+    }
+}
+
 
 test_suite* LowDiscrepancyTest::suite() {
     test_suite* suite = BOOST_TEST_SUITE("Low-discrepancy sequence tests");
@@ -1187,9 +1438,15 @@ test_suite* LowDiscrepancyTest::suite() {
            &LowDiscrepancyTest::testSobolLevitanLemieuxSobolDiscrepancy));
 
     suite->add(QUANTLIB_TEST_CASE(&LowDiscrepancyTest::testSobolSkipping));
+    suite->add(QUANTLIB_TEST_CASE(
+           &LowDiscrepancyTest::testSobolBatchedDraws));
+    suite->add(QUANTLIB_TEST_CASE(
+           &LowDiscrepancyTest::testSobolBrownianBridgeDefaults));
 
     suite->add(QUANTLIB_TEST_CASE(
            &LowDiscrepancyTest::testRandomizedLowDiscrepancySequence));
+    suite->add(QUANTLIB_TEST_CASE(
+           &LowDiscrepancyTest::testRandomizedQuasiMonteCarlo));
 
     return suite;
 }
@@ -41,6 +41,9 @@ class MatricesTest {
     static void testCholeskyDecomposition();
     static void testMoorePenroseInverse();
     static void testIterativeSolvers();
+    static void testMatrixExpressions();
+    static void testBlockedKernels();
+    static void testKernelThroughput();
     static boost::unit_test_framework::test_suite* suite();
 };
 
@@ -719,6 +722,206 @@ void MatricesTest::testIterativeSolvers() {
     #endif
 }
 
+void MatricesTest::testMatrixExpressions() {
+    BOOST_TEST_MESSAGE("Testing matrix expressions...");
+
+    setupMatrix();
+
+    const Real tol = 10*QL_EPSILON;
+
+    Matrix m = 2.0*M1 - M2/4.0 + transpose(M2)*3.0;
+    for (Size i=0; i<N; ++i) {
+        for (Size j=0; j<N; ++j) {
+            const Real expected = 2.0*M1[i][j] - M2[i][j]/4.0
+                + 3.0*M2[j][i];
+            if (std::fabs(m[i][j]-expected) > tol)
+                BOOST_FAIL("wrong result of matrix expression at ("
+                           << i << ", " << j << ")"
+                           << "\n calculated: " << m[i][j]
+                           << "\n expected:   " << expected);
+        }
+    }
+
+    // elementwise expressions are evaluated in place...
+    const Real* data = m.begin();
+    m = m - M1;
+    m += M2*0.5;
+    if (m.begin() != data)
+        BOOST_FAIL("matrix reallocated by expression assignment");
+
+    // ...unless the result is transposed
+    Matrix t = M7;
+    t = transpose(t) - t;
+    Matrix u = M7;
+    u -= transpose(u);
+    for (Size i=0; i<N; ++i) {
+        for (Size j=0; j<N; ++j) {
+            const Real expected = M7[j][i] - M7[i][j];
+            if (t[i][j] != expected || u[i][j] != -expected)
+                BOOST_FAIL("wrong result of transposed self-assignment at ("
+                           << i << ", " << j << ")"
+                           << "\n calculated: " << t[i][j]
+                           << ", " << u[i][j]
+                           << "\n expected:   " << expected
+                           << ", " << -expected);
+        }
+    }
+
+    const Matrix t3 = transpose(M3);
+    if (t3.rows() != M3.columns() || t3.columns() != M3.rows())
+        BOOST_FAIL("wrong size of transposed matrix");
+    for (Size i=0; i<M3.rows(); ++i)
+        for (Size j=0; j<M3.columns(); ++j)
+            if (t3[j][i] != M3[i][j])
+                BOOST_FAIL("wrong transposed matrix");
+
+    BOOST_CHECK_THROW(Matrix(M1 + M3), Error);
+}
+
+void MatricesTest::testBlockedKernels() {
+    BOOST_TEST_MESSAGE("Testing blocked matrix product "
+                       "and Cholesky kernels...");
+
+    MersenneTwisterUniformRng rng(1234);
+
+    // sizes across the block boundaries of the kernels
+    const Size sizes[] = { 1, 3, 5, 63, 67, 130 };
+    for (Size l=0; l<LENGTH(sizes); ++l) {
+        const Size n = sizes[l], m = sizes[(l+2) % LENGTH(sizes)];
+
+        Matrix a(m, n), b(n, m+1);
+        Array x(n), y(m);
+        for (Size i=0; i<m; ++i) {
+            y[i] = rng.next().value - 0.5;
+            for (Size j=0; j<n; ++j)
+                a[i][j] = rng.next().value - 0.5;
+        }
+        for (Size i=0; i<n; ++i) {
+            x[i] = rng.next().value - 0.5;
+            for (Size j=0; j<=m; ++j)
+                b[i][j] = rng.next().value - 0.5;
+        }
+
+        const Real tol = 1.0e-13*n;
+
+        const Matrix c = a*b;
+        for (Size i=0; i<m; ++i) {
+            for (Size j=0; j<=m; ++j) {
+                Real expected = 0.0;
+                for (Size k=0; k<n; ++k)
+                    expected += a[i][k]*b[k][j];
+                if (std::fabs(c[i][j]-expected) > tol)
+                    BOOST_FAIL("wrong matrix product for " << m << "x" << n
+                               << " times " << n << "x" << m+1
+                               << " matrix at (" << i << ", " << j << ")"
+                               << "\n calculated: " << c[i][j]
+                               << "\n expected:   " << expected);
+            }
+        }
+
+        const Array ax = a*x, ya = y*a;
+        for (Size i=0; i<m; ++i) {
+            Real expected = 0.0;
+            for (Size k=0; k<n; ++k)
+                expected += a[i][k]*x[k];
+            if (std::fabs(ax[i]-expected) > tol)
+                BOOST_FAIL("wrong matrix-vector product for " << m << "x"
+                           << n << " matrix at " << i
+                           << "\n calculated: " << ax[i]
+                           << "\n expected:   " << expected);
+        }
+        for (Size j=0; j<n; ++j) {
+            Real expected = 0.0;
+            for (Size k=0; k<m; ++k)
+                expected += y[k]*a[k][j];
+            if (std::fabs(ya[j]-expected) > tol)
+                BOOST_FAIL("wrong vector-matrix product for " << m << "x"
+                           << n << " matrix at " << j
+                           << "\n calculated: " << ya[j]
+                           << "\n expected:   " << expected);
+        }
+
+        const Matrix t = transpose(b);
+        for (Size i=0; i<n; ++i)
+            for (Size j=0; j<=m; ++j)
+                if (t[j][i] != b[i][j])
+                    BOOST_FAIL("wrong transpose of " << n << "x" << m+1
+                               << " matrix at (" << j << ", " << i << ")");
+
+        // a positive-definite matrix...
+        Matrix s = b*transpose(b);
+        for (Size i=0; i<n; ++i)
+            s[i][i] += 1.0;
+        const Matrix lower = CholeskyDecomposition(s);
+        const Matrix s2 = lower*transpose(lower);
+        for (Size i=0; i<n; ++i) {
+            for (Size j=0; j<n; ++j) {
+                if (j > i && lower[i][j] != 0.0)
+                    BOOST_FAIL("Cholesky decomposition of " << n << "x" << n
+                               << " matrix not lower triangular");
+                if (std::fabs(s2[i][j]-s[i][j]) > tol*(m+1))
+                    BOOST_FAIL("failed to verify Cholesky decomposition of "
+                               << n << "x" << n << " matrix at ("
+                               << i << ", " << j << ")"
+                               << "\n original:   " << s[i][j]
+                               << "\n replicated: " << s2[i][j]);
+            }
+        }
+
+        // ...and a semi-definite one, whose decomposition is exact
+        Array v(n);
+        for (Size i=0; i<n; ++i)
+            v[i] = Real(i % 5) - 2.0;
+        const Matrix r = outerProduct(v, v);
+        if (n > 1)
+            BOOST_CHECK_THROW(CholeskyDecomposition(r), Error);
+        const Matrix flexible = CholeskyDecomposition(r, true);
+        for (Size i=0; i<n; ++i)
+            for (Size j=0; j<n; ++j)
+                if (flexible[i][j] != (j == 0 ? -v[i] : 0.0))
+                    BOOST_FAIL("wrong flexible Cholesky decomposition of "
+                               << n << "x" << n << " matrix at ("
+                               << i << ", " << j << ")"
+                               << "\n calculated: " << flexible[i][j]
+                               << "\n expected:   "
+                               << (j == 0 ? -v[i] : 0.0));
+    }
+}
+
+namespace {
+
+    // the sizes of the correlation matrices used in pseudo square
+    // roots and factor reductions
+    const Size kernelSizes[] = { 200, 500, 1000, 2000 };
+
+}
+
+void MatricesTest::testKernelThroughput() {
+    BOOST_TEST_MESSAGE("Testing throughput of matrix kernels...");
+
+    MersenneTwisterUniformRng rng(42);
+
+    for (Size l=0; l<LENGTH(kernelSizes); ++l) {
+        const Size n = kernelSizes[l];
+        Matrix a(n, n);
+        for (Size i=0; i<n; ++i)
+            for (Size j=0; j<n; ++j)
+                a[i][j] = rng.next().value - 0.5;
+
+        Matrix s = a*transpose(a);
+        for (Size i=0; i<n; ++i)
+            s[i][i] += 1.0;
+        const Matrix lower = CholeskyDecomposition(s);
+
+        const Array x(n, 1.0, 1.0/n);
+        const Array y = s*x, z = x*lower;
+
+        if (!(lower[n-1][n-1] > 0.0) || !(y[0] == y[0]) || !(z[0] == z[0]))
+            BOOST_FAIL("unexpected result for " << n << "x" << n
+                       << " matrices");
+    }
+}
+
 test_suite* MatricesTest::suite() {
     test_suite* suite = BOOST_TEST_SUITE("Matrix tests");
 
@@ -736,6 +939,8 @@ test_suite* MatricesTest::suite() {
     suite->add(QUANTLIB_TEST_CASE(&MatricesTest::testCholeskyDecomposition));
     suite->add(QUANTLIB_TEST_CASE(&MatricesTest::testMoorePenroseInverse));
     suite->add(QUANTLIB_TEST_CASE(&MatricesTest::testIterativeSolvers));
+    suite->add(QUANTLIB_TEST_CASE(&MatricesTest::testMatrixExpressions));
+    suite->add(QUANTLIB_TEST_CASE(&MatricesTest::testBlockedKernels));
     return suite;
 }
 
@@ -0,0 +1,647 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef quantlib_test_mc_longstaff_schwartz_engine_hpp
+#define quantlib_test_mc_longstaff_schwartz_engine_hpp
+
+#include <boost/test/unit_test.hpp>
+
+/* remember to document new and/or updated tests in the Doxygen
+   comment block of the corresponding class */
+
+class MCLongstaffSchwartzEngineTest {
+  public:
+    static void testCalibrationModes();
+    static void testControlVariates();
+    static void testAdaptiveSampling();
+    static void testParallelSamples();
+    static void testSequenceResults();
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <ql/methods/montecarlo/longstaffschwartzpathpricer.hpp>
+#include <ql/methods/montecarlo/lsmbasissystem.hpp>
+#include <ql/methods/montecarlo/montecarlomodel.hpp>
+#include <ql/pricingengines/blackformula.hpp>
+#include <ql/pricingengines/mcsimulation.hpp>
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
+#include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    // American put on a single underlying
+    class AmericanPutPathPricer : public EarlyExercisePathPricer<Path> {
+      public:
+        explicit AmericanPutPathPricer(Real strike) : strike_(strike) {}
+        Real operator()(const Path& path, Size t) const {
+            return std::max<Real>(strike_ - path[t], 0.0);
+        }
+        Real state(const Path& path, Size t) const {
+            return path[t]/strike_;
+        }
+        std::vector<boost::function1<Real, Real> > basisSystem() const {
+            return LsmBasisSystem::pathBasisSystem(3, LsmBasisSystem::Monomial);
+        }
+      private:
+        Real strike_;
+    };
+
+    // European put and discounted underlying, used as control variates
+    class EuropeanPutPathPricer : public PathPricer<Path> {
+      public:
+        EuropeanPutPathPricer(Real strike, DiscountFactor discount)
+        : strike_(strike), discount_(discount) {}
+        Real operator()(const Path& path) const {
+            return discount_*std::max<Real>(strike_ - path.back(), 0.0);
+        }
+      private:
+        Real strike_;
+        DiscountFactor discount_;
+    };
+
+    class DiscountedSpotPathPricer : public PathPricer<Path> {
+      public:
+        explicit DiscountedSpotPathPricer(DiscountFactor discount)
+        : discount_(discount) {}
+        Real operator()(const Path& path) const {
+            return discount_*path.back();
+        }
+      private:
+        DiscountFactor discount_;
+    };
+
+    struct AmericanPutData {
+        boost::shared_ptr<YieldTermStructure> riskFree;
+        boost::shared_ptr<BlackScholesMertonProcess> process;
+        TimeGrid grid;
+    };
+
+    AmericanPutData americanPutData() {
+        const Date today = Settings::instance().evaluationDate();
+        const DayCounter dc = Actual365Fixed();
+        AmericanPutData data;
+        data.riskFree = flatRate(today, 0.06, dc);
+        data.process = boost::shared_ptr<BlackScholesMertonProcess>(
+            new BlackScholesMertonProcess(
+                Handle<Quote>(boost::shared_ptr<Quote>(new SimpleQuote(36.0))),
+                Handle<YieldTermStructure>(flatRate(today, 0.0, dc)),
+                Handle<YieldTermStructure>(data.riskFree),
+                Handle<BlackVolTermStructure>(flatVol(today, 0.20, dc))));
+        data.grid = TimeGrid(1.0, 50);
+        return data;
+    }
+
+    typedef SingleVariate<PseudoRandom>::path_generator_type
+        AmericanPutPathGenerator;
+
+    boost::shared_ptr<AmericanPutPathGenerator> americanPutPathGenerator(
+                                                 const AmericanPutData& data,
+                                                 BigNatural seed) {
+        return boost::shared_ptr<AmericanPutPathGenerator>(
+            new AmericanPutPathGenerator(
+                data.process, data.grid,
+                PseudoRandom::make_sequence_generator(data.grid.size()-1,
+                                                      seed),
+                false));
+    }
+
+    boost::shared_ptr<LongstaffSchwartzPathPricer<Path> >
+    americanPutPricer(const AmericanPutData& data,
+                      LsmCalibration::Storage storage,
+                      LsmCalibration::Regression regression) {
+        const boost::shared_ptr<LongstaffSchwartzPathPricer<Path> > pricer(
+            new LongstaffSchwartzPathPricer<Path>(
+                data.grid,
+                boost::shared_ptr<EarlyExercisePathPricer<Path> >(
+                                           new AmericanPutPathPricer(40.0)),
+                data.riskFree, storage, regression));
+
+        MonteCarloModel<SingleVariate, PseudoRandom> calibration(
+            americanPutPathGenerator(data, 42), pricer, Statistics(), true);
+        calibration.addSamples(4096);
+        pricer->calibrate();
+        return pricer;
+    }
+
+    Real americanPutValue(LsmCalibration::Storage storage,
+                          LsmCalibration::Regression regression) {
+        const AmericanPutData data = americanPutData();
+        MonteCarloModel<SingleVariate, PseudoRandom> pricing(
+            americanPutPathGenerator(data, 1234),
+            americanPutPricer(data, storage, regression),
+            Statistics(), true);
+        pricing.addSamples(8192);
+        return pricing.sampleAccumulator().mean();
+    }
+
+    // minimal simulation pricing with a given path pricer
+    class PutSimulation : public McSimulation<SingleVariate, PseudoRandom> {
+      public:
+        PutSimulation(const AmericanPutData& data,
+                      const boost::shared_ptr<path_pricer_type>& pricer)
+        : McSimulation<SingleVariate, PseudoRandom>(false, false),
+          data_(data), pricer_(pricer) {}
+        Real value() const { return sampleAccumulator().mean(); }
+        Size samples() const { return sampleAccumulator().samples(); }
+      protected:
+        boost::shared_ptr<path_pricer_type> pathPricer() const {
+            return pricer_;
+        }
+        boost::shared_ptr<path_generator_type> pathGenerator() const {
+            return americanPutPathGenerator(data_, 1234);
+        }
+        TimeGrid timeGrid() const { return data_.grid; }
+      private:
+        AmericanPutData data_;
+        boost::shared_ptr<path_pricer_type> pricer_;
+    };
+
+    // European put and call priced together on each path
+    class PutCallPathPricer : public PathPricer<Path, Array> {
+      public:
+        PutCallPathPricer(Real strike, DiscountFactor discount)
+        : strike_(strike), discount_(discount) {}
+        Array operator()(const Path& path) const {
+            Array values(2);
+            values[0] = discount_*std::max<Real>(strike_ - path.back(), 0.0);
+            values[1] = discount_*std::max<Real>(path.back() - strike_, 0.0);
+            return values;
+        }
+      private:
+        Real strike_;
+        DiscountFactor discount_;
+    };
+
+    template <class RNG>
+    struct PutCallVariate {
+        typedef RNG rng_traits;
+        typedef Path path_type;
+        typedef PathPricer<path_type, Array> path_pricer_type;
+        typedef typename RNG::rsg_type rsg_type;
+        typedef PathGenerator<rsg_type> path_generator_type;
+        enum { allowsErrorEstimate = RNG::allowsErrorEstimate };
+    };
+
+    class PutCallStatistics : public SequenceStatistics {
+      public:
+        explicit PutCallStatistics(Size dimension = 0)
+        : SequenceStatistics(dimension) {}
+        Array mean() const {
+            const std::vector<Real> m = SequenceStatistics::mean();
+            return Array(m.begin(), m.end());
+        }
+        Array errorEstimate() const {
+            const std::vector<Real> e = SequenceStatistics::errorEstimate();
+            return Array(e.begin(), e.end());
+        }
+    };
+
+    class PutCallSimulation
+        : public McSimulation<PutCallVariate, PseudoRandom,
+                              PutCallStatistics> {
+      public:
+        typedef McSimulation<PutCallVariate, PseudoRandom,
+                             PutCallStatistics> simulation_type;
+        PutCallSimulation(const AmericanPutData& data, Real strike)
+        : simulation_type(false, false), data_(data), strike_(strike) {}
+        Array value() const { return sampleAccumulator().mean(); }
+      protected:
+        boost::shared_ptr<path_pricer_type> pathPricer() const {
+            return boost::shared_ptr<path_pricer_type>(
+                new PutCallPathPricer(strike_,
+                                      data_.riskFree->discount(1.0)));
+        }
+        boost::shared_ptr<path_generator_type> pathGenerator() const {
+            return americanPutPathGenerator(data_, 1234);
+        }
+        TimeGrid timeGrid() const { return data_.grid; }
+      private:
+        AmericanPutData data_;
+        Real strike_;
+    };
+
+}
+
+
+void MCLongstaffSchwartzEngineTest::testCalibrationModes() {
+
+    BOOST_TEST_MESSAGE("Testing Longstaff-Schwartz calibration modes...");
+
+    SavedSettings backup;
+
+    const Real stored =
+        americanPutValue(LsmCalibration::StorePaths, LsmCalibration::SVD);
+
+    // Longstaff and Schwartz, 2001, table 1
+    const Real expected = 4.478, tolerance = 0.05;
+    if (std::fabs(stored - expected) > tolerance)
+        BOOST_FAIL("failed to reproduce American put value:"
+                   << "\n    calculated: " << stored
+                   << "\n    expected:   " << expected
+                   << "\n    tolerance:  " << tolerance);
+
+    // the same values are used whether or not paths are stored
+    const Real compact =
+        americanPutValue(LsmCalibration::StoreStates, LsmCalibration::SVD);
+    if (compact != stored)
+        BOOST_FAIL("stored states give a different value:"
+                   << "\n    stored paths:  " << stored
+                   << "\n    stored states: " << compact);
+
+    // other regressions solve the same least-squares problems
+    const LsmCalibration::Regression regressions[] = {
+        LsmCalibration::QR, LsmCalibration::NormalEquations
+    };
+    const char* names[] = { "QR", "normal equations" };
+    for (Size i=0; i<LENGTH(regressions); ++i) {
+        const Real calculated =
+            americanPutValue(LsmCalibration::StoreStates, regressions[i]);
+        if (std::fabs(calculated - stored) > 1.0e-3)
+            BOOST_FAIL("failed to reproduce SVD regression with "
+                       << names[i] << ":"
+                       << "\n    calculated: " << calculated
+                       << "\n    expected:   " << stored);
+    }
+}
+
+
+void MCLongstaffSchwartzEngineTest::testControlVariates() {
+
+    BOOST_TEST_MESSAGE("Testing Monte Carlo simulation "
+                       "with control variates...");
+
+    SavedSettings backup;
+
+    const AmericanPutData data = americanPutData();
+    const Real strike = 40.0, spot = data.process->x0();
+    const DiscountFactor discount = data.riskFree->discount(1.0);
+    const Real stdDev = 0.20;
+    const Real europeanValue =
+        blackFormula(Option::Put, strike, spot/discount, stdDev, discount);
+
+    const boost::shared_ptr<PathPricer<Path> > european(
+                              new EuropeanPutPathPricer(strike, discount));
+    const boost::shared_ptr<PathPricer<Path> > discountedSpot(
+                              new DiscountedSpotPathPricer(discount));
+    const boost::shared_ptr<PathPricer<Path> > american =
+        americanPutPricer(data, LsmCalibration::StorePaths,
+                          LsmCalibration::SVD);
+    const Size samples = 8191;
+
+    PutSimulation plain(data, american);
+    plain.calculate(Null<Real>(), samples, Null<Size>());
+
+    // the European put reduces the error on the American one...
+    PutSimulation controlled(data, american);
+    controlled.addControlVariate(european, europeanValue);
+    controlled.calculate(Null<Real>(), samples, Null<Size>());
+    const Real expected = 4.478, tolerance = 0.05;
+    if (std::fabs(controlled.value() - expected) > tolerance)
+        BOOST_FAIL("failed to reproduce American put value "
+                   "with control variate:"
+                   << "\n    calculated: " << controlled.value()
+                   << "\n    expected:   " << expected
+                   << "\n    tolerance:  " << tolerance);
+    if (controlled.errorEstimate() > 0.9*plain.errorEstimate())
+        BOOST_FAIL("control variate failed to reduce error estimate:"
+                   << "\n    without control variate: "
+                   << plain.errorEstimate()
+                   << "\n    with control variate:    "
+                   << controlled.errorEstimate()
+                   << "\n    coefficient:             "
+                   << controlled.controlVariateCoefficients()[0]);
+
+    // ...so that fewer samples are needed for a given tolerance...
+    const Real requiredTolerance = 0.02;
+    PutSimulation plainTolerance(data, american);
+    plainTolerance.calculate(requiredTolerance, Null<Size>(), Null<Size>());
+    PutSimulation controlledTolerance(data, american);
+    controlledTolerance.addControlVariate(european, europeanValue);
+    controlledTolerance.calculate(requiredTolerance, Null<Size>(),
+                                  Null<Size>());
+    if (controlledTolerance.errorEstimate() > requiredTolerance
+        || controlledTolerance.samples() > 0.8*plainTolerance.samples())
+        BOOST_FAIL("control variate failed to reduce required samples:"
+                   << "\n    without control variate: "
+                   << plainTolerance.samples()
+                   << "\n    with control variate:    "
+                   << controlledTolerance.samples()
+                   << "\n    error estimate:          "
+                   << controlledTolerance.errorEstimate());
+
+    // ...and further control variates do not increase it
+    PutSimulation twoControls(data, american);
+    twoControls.addControlVariate(european, europeanValue);
+    twoControls.addControlVariate(discountedSpot, spot);
+    twoControls.calculate(Null<Real>(), samples, Null<Size>());
+    if (twoControls.errorEstimate() > 1.01*controlled.errorEstimate())
+        BOOST_FAIL("second control variate increased error estimate:"
+                   << "\n    one control variate:  "
+                   << controlled.errorEstimate()
+                   << "\n    two control variates: "
+                   << twoControls.errorEstimate());
+
+    // a payoff used as its own control variate is priced exactly
+    PutSimulation exact(data, european);
+    exact.addControlVariate(european, europeanValue);
+    exact.calculate(Null<Real>(), samples, Null<Size>());
+    const Real beta = exact.controlVariateCoefficients()[0];
+    if (std::fabs(beta - 1.0) > 1.0e-12
+        || std::fabs(exact.value() - europeanValue) > 1.0e-12
+        || exact.errorEstimate() > 1.0e-12)
+        BOOST_FAIL("failed to price European put with itself "
+                   "as control variate:"
+                   << "\n    calculated:     " << exact.value()
+                   << "\n    expected:       " << europeanValue
+                   << "\n    error estimate: " << exact.errorEstimate()
+                   << "\n    coefficient:    " << beta);
+
+    // collinear control variates split the coefficient of a single one
+    PutSimulation duplicated(data, american);
+    duplicated.addControlVariate(european, europeanValue);
+    duplicated.addControlVariate(european, europeanValue);
+    duplicated.calculate(Null<Real>(), samples, Null<Size>());
+    const std::vector<Real>& betas =
+        duplicated.controlVariateCoefficients();
+    const Real single = controlled.controlVariateCoefficients()[0];
+    if (std::fabs(betas[0] + betas[1] - single) > 1.0e-10
+        || std::fabs(duplicated.value() - controlled.value()) > 1.0e-10)
+        BOOST_FAIL("failed to handle collinear control variates:"
+                   << "\n    calculated:   " << duplicated.value()
+                   << "\n    expected:     " << controlled.value()
+                   << "\n    coefficients: " << betas[0]
+                   << ", " << betas[1]
+                   << "\n    expected sum: " << single);
+}
+
+
+void MCLongstaffSchwartzEngineTest::testAdaptiveSampling() {
+
+    BOOST_TEST_MESSAGE("Testing adaptive sample sizing "
+                       "of Monte Carlo simulations...");
+
+    SavedSettings backup;
+
+    const AmericanPutData data = americanPutData();
+    const DiscountFactor discount = data.riskFree->discount(1.0);
+    const boost::shared_ptr<PathPricer<Path> > european(
+                              new EuropeanPutPathPricer(40.0, discount));
+
+    // the simulation stops soon after reaching the tolerance...
+    const Real tolerances[] = { 0.05, 0.03, 0.02 };
+    for (Size i=0; i<LENGTH(tolerances); ++i) {
+        PutSimulation simulation(data, european);
+        simulation.calculate(tolerances[i], Null<Size>(), Null<Size>());
+        const Real error = simulation.errorEstimate();
+        if (error > tolerances[i] || error < 0.9*tolerances[i])
+            BOOST_FAIL("failed to stop at required tolerance:"
+                       << "\n    error estimate: " << error
+                       << "\n    tolerance:      " << tolerances[i]
+                       << "\n    samples:        " << simulation.samples());
+    }
+
+    // ...or fails if more samples than allowed are needed...
+    PutSimulation limited(data, european);
+    BOOST_CHECK_THROW(limited.calculate(0.001, Null<Size>(), 4096), Error);
+
+    // ...while it returns its best estimate within a time budget,
+    // even when the tolerance or the samples required are out of
+    // reach; the elapsed time is not checked, as it depends on the
+    // load of the machine running the test
+    const Real budget = 1.0e-3;
+    PutSimulation timed(data, european);
+    timed.setTimeBudget(budget);
+    timed.calculate(1.0e-6, Null<Size>(), Null<Size>());
+    if (timed.samples() == 0 || timed.errorEstimate() <= 1.0e-6
+        || !boost::math::isfinite(timed.value()))
+        BOOST_FAIL("failed to stop at time budget for given tolerance:"
+                   << "\n    value:          " << timed.value()
+                   << "\n    error estimate: " << timed.errorEstimate()
+                   << "\n    samples:        " << timed.samples());
+    const Size required = 1000000000;
+    PutSimulation timedSamples(data, european);
+    timedSamples.setTimeBudget(budget);
+    timedSamples.calculate(Null<Real>(), required, Null<Size>());
+    if (timedSamples.samples() == 0 || timedSamples.samples() >= required
+        || !boost::math::isfinite(timedSamples.value()))
+        BOOST_FAIL("failed to stop at time budget for given samples:"
+                   << "\n    value:          " << timedSamples.value()
+                   << "\n    samples:        " << timedSamples.samples()
+                   << "\n    required:       " << required);
+
+    // ...or within a sample budget, in which case the results are
+    // those of a fixed number of samples
+    const Size sampleBudget = 5000;
+    PutSimulation sampled(data, european), reference(data, european);
+    sampled.setSampleBudget(sampleBudget);
+    sampled.calculate(1.0e-6, Null<Size>(), Null<Size>());
+    reference.calculate(Null<Real>(), sampleBudget, Null<Size>());
+    if (sampled.samples() != sampleBudget
+        || sampled.value() != reference.value()
+        || sampled.errorEstimate() != reference.errorEstimate())
+        BOOST_FAIL("failed to stop at sample budget:"
+                   << "\n    value:          " << sampled.value()
+                   << "\n    error estimate: " << sampled.errorEstimate()
+                   << "\n    samples:        " << sampled.samples()
+                   << "\n    expected value: " << reference.value()
+                   << "\n    expected error: "
+                   << reference.errorEstimate());
+    PutSimulation sampledSamples(data, european);
+    sampledSamples.setSampleBudget(sampleBudget);
+    sampledSamples.calculate(Null<Real>(), required, Null<Size>());
+    if (sampledSamples.samples() != sampleBudget
+        || sampledSamples.value() != reference.value())
+        BOOST_FAIL("failed to stop at sample budget for given samples:"
+                   << "\n    value:          " << sampledSamples.value()
+                   << "\n    samples:        " << sampledSamples.samples()
+                   << "\n    expected value: " << reference.value());
+
+    // ...which do not change the results if not exhausted
+    const Size samples = 8191;
+    PutSimulation fixed(data, european), budgeted(data, european);
+    fixed.calculate(Null<Real>(), samples, Null<Size>());
+    budgeted.setTimeBudget(60.0);
+    budgeted.setSampleBudget(10000);
+    budgeted.calculate(Null<Real>(), samples, Null<Size>());
+    if (budgeted.samples() != samples || budgeted.value() != fixed.value())
+        BOOST_FAIL("budgets changed simulation results:"
+                   << "\n    without budget: " << fixed.value()
+                   << " (" << fixed.samples() << " samples)"
+                   << "\n    with budget:    " << budgeted.value()
+                   << " (" << budgeted.samples() << " samples)");
+}
+
+
+void MCLongstaffSchwartzEngineTest::testParallelSamples() {
+
+    BOOST_TEST_MESSAGE("Testing Monte Carlo simulations "
+                       "split among workers...");
+
+    SavedSettings backup;
+
+    const AmericanPutData data = americanPutData();
+    const boost::shared_ptr<LongstaffSchwartzPathPricer<Path> > pricer =
+        americanPutPricer(data, LsmCalibration::StorePaths,
+                          LsmCalibration::SVD);
+    const Size samples = 8191, workers = 4;
+
+    MonteCarloModel<SingleVariate, PseudoRandom> serial(
+        americanPutPathGenerator(data, 1234), pricer, Statistics(), true);
+    serial.addSamples(samples);
+
+    // each worker draws its share of the same stream and prices it
+    // with its own copy of the calibrated pricer
+    std::vector<boost::shared_ptr<AmericanPutPathGenerator> >
+        generators(workers);
+    std::vector<boost::shared_ptr<LongstaffSchwartzPathPricer<Path> > >
+        clones(workers);
+    std::vector<boost::shared_ptr<PathPricer<Path> > > pricers(workers);
+    Size drawn = 0;
+    for (Size w=0; w<workers; ++w) {
+        generators[w] = americanPutPathGenerator(data, 1234);
+        for (Size j=0; j<drawn; ++j)
+            generators[w]->next();
+        drawn += samples/workers + (w < samples%workers ? 1 : 0);
+        pricers[w] = clones[w] = pricer->clone();
+    }
+    MonteCarloModel<SingleVariate, PseudoRandom> parallel(
+        generators, pricers, Statistics(), true);
+    parallel.addSamples(samples);
+
+    const Statistics& expected = serial.sampleAccumulator();
+    const Statistics& calculated = parallel.sampleAccumulator();
+    if (calculated.samples() != expected.samples()
+        || calculated.mean() != expected.mean()
+        || calculated.errorEstimate() != expected.errorEstimate())
+        BOOST_FAIL("failed to reproduce single-worker results:"
+                   << "\n    single worker:  " << expected.mean()
+                   << " +/- " << expected.errorEstimate()
+                   << " (" << expected.samples() << " samples)"
+                   << "\n    " << workers << " workers:      "
+                   << calculated.mean()
+                   << " +/- " << calculated.errorEstimate()
+                   << " (" << calculated.samples() << " samples)");
+
+    // the exercise statistics of the copies add up to the serial ones
+    const boost::shared_ptr<LongstaffSchwartzPathPricer<Path> > merged =
+        pricer->clone();
+    for (Size w=0; w<workers; ++w)
+        merged->mergeExerciseProbability(*clones[w]);
+    if (std::fabs(merged->exerciseProbability()
+                  - pricer->exerciseProbability()) > 1.0e-12)
+        BOOST_FAIL("failed to reproduce single-worker "
+                   "exercise probability:"
+                   << "\n    single worker: "
+                   << pricer->exerciseProbability()
+                   << "\n    " << workers << " workers:     "
+                   << merged->exerciseProbability());
+}
+
+
+void MCLongstaffSchwartzEngineTest::testSequenceResults() {
+
+    BOOST_TEST_MESSAGE("Testing Monte Carlo simulation "
+                       "with sequence results...");
+
+    SavedSettings backup;
+
+    const AmericanPutData data = americanPutData();
+    const Real strike = 40.0;
+    const DiscountFactor discount = data.riskFree->discount(1.0);
+    const Size samples = 8191;
+
+    PutSimulation put(data, boost::shared_ptr<PathPricer<Path> >(
+                              new EuropeanPutPathPricer(strike, discount)));
+    put.calculate(Null<Real>(), samples, Null<Size>());
+
+    // each component is priced as it would be alone...
+    PutCallSimulation putCall(data, strike);
+    putCall.calculate(Null<Real>(), samples, Null<Size>());
+    if (std::fabs(putCall.value()[0] - put.value()) > 1.0e-12
+        || std::fabs(putCall.errorEstimate()[0] - put.errorEstimate())
+                                                                > 1.0e-12)
+        BOOST_FAIL("failed to reproduce scalar results:"
+                   << "\n    calculated:     " << putCall.value()[0]
+                   << "\n    expected:       " << put.value()
+                   << "\n    error estimate: " << putCall.errorEstimate()[0]
+                   << "\n    expected:       " << put.errorEstimate());
+
+    // ...a tolerance applies to the largest error...
+    const Real tolerance = 0.05;
+    PutCallSimulation adaptive(data, strike);
+    adaptive.calculate(tolerance, Null<Size>(), Null<Size>());
+    const Array errors = adaptive.errorEstimate();
+    if (std::max(errors[0], errors[1]) > tolerance)
+        BOOST_FAIL("failed to reach required tolerance:"
+                   << "\n    error estimates: " << errors
+                   << "\n    tolerance:       " << tolerance);
+
+    // ...and control variates with estimated coefficients are not
+    // available
+    PutCallSimulation controlled(data, strike);
+    controlled.addControlVariate(
+        boost::shared_ptr<PathPricer<Path, Array> >(
+                               new PutCallPathPricer(strike, discount)),
+        Array(2, 0.0));
+    BOOST_CHECK_THROW(
+        controlled.calculate(Null<Real>(), samples, Null<Size>()), Error);
+}
+
+
+test_suite* MCLongstaffSchwartzEngineTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Longstaff Schwartz MC engine tests");
+    suite->add(QUANTLIB_TEST_CASE(
+                         &MCLongstaffSchwartzEngineTest::testCalibrationModes));
+    suite->add(QUANTLIB_TEST_CASE(
+                         &MCLongstaffSchwartzEngineTest::testControlVariates));
+    suite->add(QUANTLIB_TEST_CASE(
+                         &MCLongstaffSchwartzEngineTest::testAdaptiveSampling));
+    suite->add(QUANTLIB_TEST_CASE(
+                         &MCLongstaffSchwartzEngineTest::testParallelSamples));
+    suite->add(QUANTLIB_TEST_CASE(
+                         &MCLongstaffSchwartzEngineTest::testSequenceResults));
+    return suite;
+}
+
+
+#endif
@@ -0,0 +1,256 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef quantlib_test_multi_level_monte_carlo_hpp
+#define quantlib_test_multi_level_monte_carlo_hpp
+
+#include <boost/test/unit_test.hpp>
+
+/* remember to document new and/or updated tests in the Doxygen
+   comment block of the corresponding class */
+
+class MultiLevelMonteCarloTest {
+  public:
+    static void testCoupledPaths();
+    static void testMultiLevelEstimator();
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <ql/pricingengines/mcmultilevelsimulation.hpp>
+#include <ql/pricingengines/blackformula.hpp>
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/processes/eulerdiscretization.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    // geometric Brownian motion discretized with the Euler scheme on
+    // the asset value, whose weak error is of first order
+    class EulerGeometricBrownianProcess : public StochasticProcess1D {
+      public:
+        EulerGeometricBrownianProcess(Real x0, Rate mu, Volatility sigma)
+        : StochasticProcess1D(boost::shared_ptr<discretization>(
+                                                 new EulerDiscretization)),
+          x0_(x0), mu_(mu), sigma_(sigma) {}
+        Real x0() const { return x0_; }
+        Real drift(Time, Real x) const { return mu_*x; }
+        Real diffusion(Time, Real x) const { return sigma_*x; }
+      private:
+        Real x0_;
+        Rate mu_;
+        Volatility sigma_;
+    };
+
+    class DiscountedCallPathPricer : public PathPricer<Path> {
+      public:
+        DiscountedCallPathPricer(Real strike, DiscountFactor discount)
+        : strike_(strike), discount_(discount) {}
+        Real operator()(const Path& path) const {
+            return discount_*std::max<Real>(path.back() - strike_, 0.0);
+        }
+      private:
+        Real strike_;
+        DiscountFactor discount_;
+    };
+
+    class MultiLevelCallSimulation
+        : public McMultiLevelSimulation<PseudoRandom> {
+      public:
+        MultiLevelCallSimulation(
+                  const boost::shared_ptr<StochasticProcess>& process,
+                  Real strike, Rate r, Time maturity, Size maxLevels)
+        : McMultiLevelSimulation<PseudoRandom>(1, 2, maxLevels, false, 42),
+          process_(process), strike_(strike), r_(r), maturity_(maturity) {}
+        Real value() const {
+            Real result = 0.0;
+            for (Size l=0; l<levels(); ++l)
+                result += sampleAccumulator(l).mean();
+            return result;
+        }
+      protected:
+        boost::shared_ptr<StochasticProcess> process() const {
+            return process_;
+        }
+        Time maturity() const { return maturity_; }
+        boost::shared_ptr<path_pricer_type> pathPricer(const TimeGrid&) const {
+            return boost::shared_ptr<path_pricer_type>(
+                new DiscountedCallPathPricer(strike_,
+                                             std::exp(-r_*maturity_)));
+        }
+      private:
+        boost::shared_ptr<StochasticProcess> process_;
+        Real strike_;
+        Rate r_;
+        Time maturity_;
+    };
+
+}
+
+
+void MultiLevelMonteCarloTest::testCoupledPaths() {
+
+    BOOST_TEST_MESSAGE("Testing coupled fine and coarse paths...");
+
+    SavedSettings backup;
+
+    const Date today = Settings::instance().evaluationDate();
+    const DayCounter dc = Actual365Fixed();
+    const boost::shared_ptr<StochasticProcess> process(
+        new BlackScholesMertonProcess(
+            Handle<Quote>(boost::shared_ptr<Quote>(new SimpleQuote(100.0))),
+            Handle<YieldTermStructure>(flatRate(today, 0.02, dc)),
+            Handle<YieldTermStructure>(flatRate(today, 0.05, dc)),
+            Handle<BlackVolTermStructure>(flatVol(today, 0.20, dc))));
+
+    const Time length = 2.0;
+    const Size fineSteps = 12, coarseSteps = 4;
+    MultiLevelPathGenerator<PseudoRandom::rsg_type> coupled(
+        process, length, fineSteps, coarseSteps,
+        PseudoRandom::make_sequence_generator(fineSteps, 42));
+    PathGenerator<PseudoRandom::rsg_type> single(
+        process, length, fineSteps,
+        PseudoRandom::make_sequence_generator(fineSteps, 42), false);
+
+    for (Size i=0; i<100; ++i) {
+        const bool antithetic = (i % 2 == 1);
+        const CoupledPath& paths = antithetic ? coupled.antithetic().value
+                                              : coupled.next().value;
+        const Path& path = antithetic ? single.antithetic().value
+                                      : single.next().value;
+
+        // the fine path is the one of a plain generator...
+        for (Size j=0; j<=fineSteps; ++j)
+            if (paths.fine()[j] != path[j])
+                BOOST_FAIL("wrong fine path value at step " << j
+                           << " of path " << i << ":"
+                           << "\n    calculated: " << paths.fine()[j]
+                           << "\n    expected:   " << path[j]);
+
+        // ...and, as the process is evolved exactly, the coarse path
+        // samples the fine one at its own time points
+        const Size ratio = fineSteps/coarseSteps;
+        for (Size j=0; j<=coarseSteps; ++j) {
+            const Real expected = paths.fine()[j*ratio];
+            if (std::fabs(paths.coarse()[j] - expected) > 1.0e-12*expected)
+                BOOST_FAIL("wrong coarse path value at step " << j
+                           << " of path " << i << ":"
+                           << "\n    calculated: " << paths.coarse()[j]
+                           << "\n    expected:   " << expected);
+        }
+    }
+}
+
+
+void MultiLevelMonteCarloTest::testMultiLevelEstimator() {
+
+    BOOST_TEST_MESSAGE("Testing multi-level Monte Carlo estimator...");
+
+    const Real s0 = 100.0, strike = 100.0;
+    const Rate r = 0.05;
+    const Volatility sigma = 0.20;
+    const Time maturity = 1.0;
+    const boost::shared_ptr<StochasticProcess> process(
+                  new EulerGeometricBrownianProcess(s0, r, sigma));
+    const DiscountFactor discount = std::exp(-r*maturity);
+    const Real expected =
+        blackFormula(Option::Call, strike, s0/discount,
+                     sigma*std::sqrt(maturity), discount);
+
+    const Real tolerance = 0.02;
+    MultiLevelCallSimulation simulation(process, strike, r, maturity, 12);
+    simulation.calculate(tolerance, Null<Size>(), Null<Size>());
+    const Size levels = simulation.levels();
+
+    // the root-mean-square error is within tolerance...
+    const Real error = simulation.errorEstimate();
+    if (error > tolerance/std::sqrt(2.0)
+        || std::fabs(simulation.value() - expected) > 3.0*tolerance)
+        BOOST_FAIL("failed to reach required tolerance:"
+                   << "\n    calculated:     " << simulation.value()
+                   << "\n    expected:       " << expected
+                   << "\n    error estimate: " << error
+                   << "\n    tolerance:      " << tolerance
+                   << "\n    levels:         " << levels);
+
+    // ...thanks to corrections whose variance decreases with the
+    // step size...
+    for (Size l=2; l<levels; ++l) {
+        const Real v1 = simulation.sampleAccumulator(l-1).variance(),
+                   v2 = simulation.sampleAccumulator(l).variance();
+        if (v2 > 0.75*v1)
+            BOOST_FAIL("variance of corrections not decreasing:"
+                       << "\n    level " << l-1 << ": " << v1
+                       << "\n    level " << l << ":   " << v2);
+    }
+
+    // ...at a fraction of the cost of a plain simulation on the
+    // finest grid with the same statistical error
+    const Real variance = simulation.sampleAccumulator(0).variance();
+    const Real plainCost = 2.0*variance/(tolerance*tolerance)
+                         * (1 << (levels-1));
+    if (simulation.cost() > plainCost/3.0)
+        BOOST_FAIL("multi-level simulation too expensive:"
+                   << "\n    multi-level cost: " << simulation.cost()
+                   << "\n    plain cost:       " << plainCost
+                   << "\n    levels:           " << levels);
+
+    // fixed numbers of samples give reproducible results
+    MultiLevelCallSimulation fixed1(process, strike, r, maturity, 4),
+                             fixed2(process, strike, r, maturity, 4);
+    fixed1.calculate(Null<Real>(), 10000, Null<Size>());
+    fixed2.calculate(Null<Real>(), 10000, Null<Size>());
+    if (fixed1.levels() != 4 || fixed1.value() != fixed2.value()
+        || fixed1.sampleAccumulator(3).samples() != 1250)
+        BOOST_FAIL("failed to reproduce multi-level simulation:"
+                   << "\n    first:  " << fixed1.value()
+                   << "\n    second: " << fixed2.value());
+}
+
+
+test_suite* MultiLevelMonteCarloTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Multi-level Monte Carlo tests");
+    suite->add(QUANTLIB_TEST_CASE(&MultiLevelMonteCarloTest::testCoupledPaths));
+    suite->add(QUANTLIB_TEST_CASE(
+                          &MultiLevelMonteCarloTest::testMultiLevelEstimator));
+    return suite;
+}
+
+
+#endif
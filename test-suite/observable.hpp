@@ -0,0 +1,591 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2015 Klaus Spanderen
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef quantlib_test_observable_hpp
+#define quantlib_test_observable_hpp
+
+#include <boost/test/unit_test.hpp>
+
+/* remember to document new and/or updated tests in the Doxygen
+   comment block of the corresponding class */
+
+class ObservableTest {
+  public:
+    static void testObservableSettings();
+    static void testDeferredUpdates();
+    #ifdef QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN
+    static void testConcurrentNotifications();
+    static void testSelfDestruction();
+    #endif
+    static void testNotificationThroughput();
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2015 Klaus Spanderen
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <ql/patterns/lazyobject.hpp>
+#include <ql/quotes/simplequote.hpp>
+#ifdef QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/signals2/signal_type.hpp>
+#endif
+#include <ctime>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    class UpdateCounter : public Observer {
+      public:
+        UpdateCounter() : counter_(0) {}
+        void update() { ++counter_; }
+        Size counter() const { return counter_; }
+      private:
+        Size counter_;
+    };
+
+    class SumOfQuotes : public LazyObject {
+      public:
+        explicit SumOfQuotes(
+                     const std::vector<boost::shared_ptr<SimpleQuote> >& q)
+        : quotes_(q), calculations_(0) {
+            for (Size i=0; i<quotes_.size(); ++i)
+                registerWith(quotes_[i]);
+        }
+        Real value() const {
+            calculate();
+            return value_;
+        }
+        Size calculations() const { return calculations_; }
+      private:
+        void performCalculations() const {
+            ++calculations_;
+            value_ = 0.0;
+            for (Size i=0; i<quotes_.size(); ++i)
+                value_ += quotes_[i]->value();
+        }
+        std::vector<boost::shared_ptr<SimpleQuote> > quotes_;
+        mutable Real value_;
+        mutable Size calculations_;
+    };
+
+    std::vector<boost::shared_ptr<SimpleQuote> > observedQuotes(Size n) {
+        std::vector<boost::shared_ptr<SimpleQuote> > quotes;
+        for (Size i=0; i<n; ++i)
+            quotes.push_back(
+                  boost::shared_ptr<SimpleQuote>(new SimpleQuote(1.0)));
+        return quotes;
+    }
+
+    #ifdef QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN
+
+    class AtomicUpdateCounter : public Observer {
+      public:
+        AtomicUpdateCounter() : counter_(0) {}
+        void update() { ++counter_; }
+        Size counter() const { return counter_.load(); }
+      private:
+        boost::atomic<Size> counter_;
+    };
+
+    // changes the quotes over and over
+    class QuoteChanger {
+      public:
+        QuoteChanger(const std::vector<boost::shared_ptr<SimpleQuote> >& q,
+                     Size changes, bool deferred)
+        : quotes_(q), changes_(changes), deferred_(deferred) {}
+        void operator()() const {
+            for (Size k=0; k<changes_; ++k) {
+                if (deferred_) {
+                    DeferredUpdates tick;
+                    for (Size i=0; i<quotes_.size(); ++i)
+                        quotes_[i]->setValue(Real(k));
+                } else {
+                    quotes_[k%quotes_.size()]->setValue(Real(k));
+                }
+            }
+        }
+      private:
+        std::vector<boost::shared_ptr<SimpleQuote> > quotes_;
+        Size changes_;
+        bool deferred_;
+    };
+
+    // creates observers, registers them and destroys them while
+    // notifications are in progress.  The observers are owned by
+    // shared pointers and register after construction, since other
+    // threads could otherwise notify them while partially built or
+    // destroyed.
+    class ObserverChurner {
+      public:
+        ObserverChurner(const std::vector<boost::shared_ptr<SimpleQuote> >& q,
+                        Size rounds)
+        : quotes_(q), rounds_(rounds) {}
+        void operator()() const {
+            for (Size k=0; k<rounds_; ++k) {
+                const boost::shared_ptr<AtomicUpdateCounter> first(
+                                                   new AtomicUpdateCounter);
+                boost::shared_ptr<AtomicUpdateCounter> second(
+                                                   new AtomicUpdateCounter);
+                for (Size i=0; i<quotes_.size(); ++i) {
+                    first->registerWith(quotes_[i]);
+                    second->registerWith(quotes_[i]);
+                }
+                first->unregisterWith(quotes_[k%quotes_.size()]);
+                second.reset();
+                first->registerWith(quotes_[k%quotes_.size()]);
+            }
+        }
+      private:
+        std::vector<boost::shared_ptr<SimpleQuote> > quotes_;
+        Size rounds_;
+    };
+
+    class SelfDestroyingObserver : public Observer {
+      public:
+        explicit SelfDestroyingObserver(bool& destroyed)
+        : destroyed_(destroyed) {}
+        ~SelfDestroyingObserver() { destroyed_ = true; }
+        void update() { delete this; }
+      private:
+        bool& destroyed_;
+    };
+
+    /* Baseline for the throughput test, reproducing the former
+       thread-safe notifications: each observable emits a signal
+       guarded by a recursive mutex, whose slots track a proxy that
+       takes another one before updating its observer.  Locking the
+       observer's weak pointer, which both versions do, is omitted. */
+
+    typedef boost::signals2::signal_type<
+        void(),
+        boost::signals2::keywords::mutex_type<boost::recursive_mutex> >
+        ::type LockingSignal;
+
+    class LockingProxy;
+
+    class LockingQuote {
+      public:
+        explicit LockingQuote(Real value) : value_(value) {}
+        void registerObserver(const boost::shared_ptr<LockingProxy>& p);
+        void setValue(Real value) {
+            value_ = value;
+            signal_();
+        }
+        Real value() const { return value_; }
+      private:
+        LockingSignal signal_;
+        Real value_;
+    };
+
+    class LockingSum {
+      public:
+        explicit LockingSum(
+                     const std::vector<boost::shared_ptr<LockingQuote> >& q);
+        void update() {
+            if (calculated_) {
+                calculated_ = false;
+                signal_();
+            }
+        }
+        Real value() {
+            if (!calculated_) {
+                calculated_ = true;
+                value_ = 0.0;
+                for (Size i=0; i<quotes_.size(); ++i)
+                    value_ += quotes_[i]->value();
+            }
+            return value_;
+        }
+      private:
+        std::vector<boost::shared_ptr<LockingQuote> > quotes_;
+        boost::shared_ptr<LockingProxy> proxy_;
+        LockingSignal signal_;
+        bool calculated_;
+        Real value_;
+    };
+
+    class LockingProxy {
+      public:
+        explicit LockingProxy(LockingSum* observer) : observer_(observer) {}
+        void update() const {
+            boost::lock_guard<boost::recursive_mutex> lock(mutex_);
+            observer_->update();
+        }
+      private:
+        LockingSum* observer_;
+        mutable boost::recursive_mutex mutex_;
+    };
+
+    void LockingQuote::registerObserver(
+                                  const boost::shared_ptr<LockingProxy>& p) {
+        LockingSignal::slot_type slot(&LockingProxy::update, p.get());
+        signal_.connect(slot.track(p));
+    }
+
+    LockingSum::LockingSum(
+                      const std::vector<boost::shared_ptr<LockingQuote> >& q)
+    : quotes_(q), proxy_(new LockingProxy(this)),
+      calculated_(false), value_(0.0) {
+        for (Size i=0; i<quotes_.size(); ++i)
+            quotes_[i]->registerObserver(proxy_);
+    }
+
+    #endif
+
+    // elapsed processor time in milliseconds
+    Real elapsed(std::clock_t start) {
+        return 1000.0*(std::clock() - start)/CLOCKS_PER_SEC;
+    }
+
+}
+
+
+void ObservableTest::testObservableSettings() {
+
+    BOOST_TEST_MESSAGE("Testing observable settings...");
+
+    const boost::shared_ptr<SimpleQuote> quote(new SimpleQuote(100.0));
+    UpdateCounter updateCounter;
+
+    updateCounter.registerWith(quote);
+    if (updateCounter.counter() != 0) {
+        BOOST_FAIL("update counter value is not zero");
+    }
+
+    quote->setValue(1.0);
+    if (updateCounter.counter() != 1) {
+        BOOST_FAIL("update counter value is not one");
+    }
+
+    ObservableSettings::instance().disableUpdates(false);
+    quote->setValue(2.0);
+    if (updateCounter.counter() != 1) {
+        BOOST_FAIL("update counter value is not one");
+    }
+    ObservableSettings::instance().enableUpdates();
+    if (updateCounter.counter() != 1) {
+        BOOST_FAIL("update counter value is not one");
+    }
+
+    ObservableSettings::instance().disableUpdates(true);
+    quote->setValue(3.0);
+    if (updateCounter.counter() != 1) {
+        BOOST_FAIL("update counter value is not one");
+    }
+    ObservableSettings::instance().enableUpdates();
+    if (updateCounter.counter() != 2) {
+        BOOST_FAIL("update counter value is not two");
+    }
+
+    UpdateCounter updateCounter2;
+    updateCounter2.registerWith(quote);
+    ObservableSettings::instance().disableUpdates(true);
+    for (Size i=0; i<10; ++i) {
+        quote->setValue(Real(i));
+    }
+    if (updateCounter.counter() != 2) {
+        BOOST_FAIL("update counter value is not two");
+    }
+    ObservableSettings::instance().enableUpdates();
+    if (updateCounter.counter() != 3 || updateCounter2.counter() != 1) {
+        BOOST_FAIL("update counter values are not correct");
+    }
+}
+
+
+void ObservableTest::testDeferredUpdates() {
+
+    BOOST_TEST_MESSAGE("Testing coalescing of deferred updates...");
+
+    std::vector<boost::shared_ptr<SimpleQuote> > quotes;
+    for (Size i=0; i<10; ++i)
+        quotes.push_back(
+                  boost::shared_ptr<SimpleQuote>(new SimpleQuote(1.0)));
+
+    const boost::shared_ptr<SumOfQuotes> sum(new SumOfQuotes(quotes));
+    UpdateCounter updateCounter;
+    updateCounter.registerWith(sum);
+
+    if (sum->value() != 10.0 || sum->calculations() != 1) {
+        BOOST_FAIL("unexpected initial value or number of calculations");
+    }
+
+    {
+        DeferredUpdates tick;
+
+        // the deferral is local to the instance and the thread
+        if (!ObservableSettings::instance().updatesEnabled()) {
+            BOOST_FAIL("updates globally disabled by deferral");
+        }
+
+        // a nested instance must not flush the outer one
+        {
+            DeferredUpdates nested;
+            quotes[0]->setValue(2.0);
+        }
+        if (updateCounter.counter() != 0) {
+            BOOST_FAIL("update sent by nested deferral");
+        }
+
+        for (Size k=0; k<100; ++k) {
+            for (Size i=0; i<quotes.size(); ++i)
+                quotes[i]->setValue(Real(k+1));
+        }
+        if (updateCounter.counter() != 0) {
+            BOOST_FAIL("update sent while deferred");
+        }
+    }
+
+    if (!ObservableSettings::instance().updatesEnabled()) {
+        BOOST_FAIL("updates not enabled after deferral");
+    }
+    if (updateCounter.counter() != 1) {
+        BOOST_FAIL("deferred updates were not coalesced:"
+                    << "\n    updates received: " << updateCounter.counter()
+                    << "\n    expected:         " << 1);
+    }
+    if (sum->value() != 1000.0 || sum->calculations() != 2) {
+        BOOST_FAIL("lazy object not recalculated once:"
+                   << "\n    value:        " << sum->value()
+                   << "\n    calculations: " << sum->calculations());
+    }
+
+    DeferredUpdates tick;
+    quotes[0]->setValue(0.0);
+    tick.flush();
+    if (updateCounter.counter() != 2) {
+        BOOST_FAIL("flush did not send the pending update");
+    }
+    quotes[0]->setValue(100.0);
+    if (updateCounter.counter() != 2) {
+        BOOST_FAIL("update sent to an already notified lazy object");
+    }
+}
+
+
+#ifdef QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN
+
+void ObservableTest::testConcurrentNotifications() {
+
+    BOOST_TEST_MESSAGE("Testing concurrent registration, notification "
+                       "and destruction of observers...");
+
+    // each quote is changed by a single thread, since quotes
+    // themselves are not meant to be written concurrently
+    const std::vector<boost::shared_ptr<SimpleQuote> > quotes =
+        observedQuotes(12);
+    typedef std::vector<boost::shared_ptr<SimpleQuote> >::const_iterator
+        quote_iterator;
+    const quote_iterator begin = quotes.begin();
+
+    boost::thread_group threads;
+    threads.create_thread(QuoteChanger(
+        std::vector<boost::shared_ptr<SimpleQuote> >(begin, begin+5),
+        20000, false));
+    threads.create_thread(QuoteChanger(
+        std::vector<boost::shared_ptr<SimpleQuote> >(begin+5, begin+10),
+        20000, false));
+    threads.create_thread(QuoteChanger(
+        std::vector<boost::shared_ptr<SimpleQuote> >(begin+10, begin+11),
+        2000, true));
+    for (Size i=0; i<4; ++i)
+        threads.create_thread(ObserverChurner(quotes, 2000));
+
+    // a deferral on this thread doesn't hold back the other threads
+    const boost::shared_ptr<AtomicUpdateCounter> counter(
+                                                   new AtomicUpdateCounter);
+    counter->registerWith(quotes.back());
+    {
+        DeferredUpdates tick;
+        boost::thread changer(QuoteChanger(
+            std::vector<boost::shared_ptr<SimpleQuote> >(1, quotes.back()),
+            10, false));
+        changer.join();
+        if (counter->counter() != 10) {
+            BOOST_ERROR("notifications from another thread deferred:"
+                        << "\n    updates received: " << counter->counter()
+                        << "\n    expected:         10");
+        }
+    }
+
+    threads.join_all();
+
+    // the observers left are notified exactly once per change
+    const boost::shared_ptr<AtomicUpdateCounter> last(
+                                                   new AtomicUpdateCounter);
+    for (Size i=0; i<quotes.size(); ++i)
+        last->registerWith(quotes[i]);
+    for (Size i=0; i<quotes.size(); ++i)
+        quotes[i]->setValue(-1.0);
+    if (last->counter() != quotes.size()) {
+        BOOST_FAIL("wrong number of notifications after concurrent use:"
+                   << "\n    updates received: " << last->counter()
+                   << "\n    expected:         " << quotes.size());
+    }
+}
+
+
+void ObservableTest::testSelfDestruction() {
+
+    BOOST_TEST_MESSAGE("Testing observers destroyed "
+                       "by their own update...");
+
+    const std::vector<boost::shared_ptr<SimpleQuote> > quotes =
+        observedQuotes(1);
+
+    // the destructor must not wait for the notification it is
+    // called from
+    bool destroyed = false;
+    (new SelfDestroyingObserver(destroyed))->registerWith(quotes[0]);
+    quotes[0]->setValue(2.0);
+    if (!destroyed) {
+        BOOST_FAIL("observer not destroyed by its update");
+    }
+
+    // nor for the one it's called from while deferred updates
+    // are sent
+    destroyed = false;
+    (new SelfDestroyingObserver(destroyed))->registerWith(quotes[0]);
+    {
+        DeferredUpdates tick;
+        quotes[0]->setValue(3.0);
+    }
+    if (!destroyed) {
+        BOOST_FAIL("observer not destroyed by its deferred update");
+    }
+}
+
+#endif
+
+
+void ObservableTest::testNotificationThroughput() {
+
+    BOOST_TEST_MESSAGE("Testing throughput of notifications...");
+
+    // 1000 lazy objects observing 10 quotes each
+    const std::vector<boost::shared_ptr<SimpleQuote> > quotes =
+        observedQuotes(10);
+    std::vector<boost::shared_ptr<SumOfQuotes> > sums;
+    for (Size i=0; i<1000; ++i)
+        sums.push_back(boost::shared_ptr<SumOfQuotes>(
+                                                  new SumOfQuotes(quotes)));
+
+    const Size ticks = 2000;
+    std::clock_t start = std::clock();
+    Real total = 0.0;
+    for (Size k=0; k<ticks; ++k) {
+        for (Size i=0; i<quotes.size(); ++i)
+            quotes[i]->setValue(Real(k));
+        total += sums[k%sums.size()]->value();
+    }
+    const Real direct = elapsed(start);
+    if (!(total > 0.0))
+        BOOST_ERROR("unexpected sum of lazy-object values: " << total);
+
+    // the same ticks, with each one's notifications coalesced
+    start = std::clock();
+    Real deferredTotal = 0.0;
+    for (Size k=0; k<ticks; ++k) {
+        {
+            DeferredUpdates tick;
+            for (Size i=0; i<quotes.size(); ++i)
+                quotes[i]->setValue(Real(k));
+        }
+        deferredTotal += sums[k%sums.size()]->value();
+    }
+    const Real deferred = elapsed(start);
+    if (deferredTotal != total)
+        BOOST_ERROR("different results with deferred updates:"
+                    << "\n    direct:   " << total
+                    << "\n    deferred: " << deferredTotal);
+
+    BOOST_TEST_MESSAGE("    direct notifications:   "
+                       << direct << " ms"
+                       << "\n    deferred notifications: "
+                       << deferred << " ms");
+
+    #ifdef QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN
+    // and the same ticks through mutex-guarded notifications
+    std::vector<boost::shared_ptr<LockingQuote> > lockingQuotes;
+    for (Size i=0; i<quotes.size(); ++i)
+        lockingQuotes.push_back(
+                  boost::shared_ptr<LockingQuote>(new LockingQuote(1.0)));
+    std::vector<boost::shared_ptr<LockingSum> > lockingSums;
+    for (Size i=0; i<sums.size(); ++i)
+        lockingSums.push_back(boost::shared_ptr<LockingSum>(
+                                            new LockingSum(lockingQuotes)));
+
+    start = std::clock();
+    Real lockingTotal = 0.0;
+    for (Size k=0; k<ticks; ++k) {
+        for (Size i=0; i<lockingQuotes.size(); ++i)
+            lockingQuotes[i]->setValue(Real(k));
+        lockingTotal += lockingSums[k%lockingSums.size()]->value();
+    }
+    const Real locking = elapsed(start);
+    if (lockingTotal != total)
+        BOOST_ERROR("different results with mutex-guarded baseline:"
+                    << "\n    direct:   " << total
+                    << "\n    baseline: " << lockingTotal);
+
+    BOOST_TEST_MESSAGE("    mutex-guarded baseline: "
+                       << locking << " ms");
+    #endif
+}
+
+
+test_suite* ObservableTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Observer tests");
+
+    suite->add(QUANTLIB_TEST_CASE(&ObservableTest::testObservableSettings));
+    suite->add(QUANTLIB_TEST_CASE(&ObservableTest::testDeferredUpdates));
+    #ifdef QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN
+    suite->add(QUANTLIB_TEST_CASE(
+                             &ObservableTest::testConcurrentNotifications));
+    suite->add(QUANTLIB_TEST_CASE(&ObservableTest::testSelfDestruction));
+    #endif
+
+    return suite;
+}
+
+
+#endif
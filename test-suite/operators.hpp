@@ -0,0 +1,141 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef quantlib_test_operators_hpp
+#define quantlib_test_operators_hpp
+
+#include <boost/test/unit_test.hpp>
+
+/* remember to document new and/or updated tests in the Doxygen
+   comment block of the corresponding class */
+
+class OperatorTest {
+  public:
+    static void testTridiagonal();
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <ql/methods/finitedifferences/tridiagonaloperator.hpp>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    // checks that L x reproduces the right-hand side
+    void checkSolution(const TridiagonalOperator& L,
+                       const Array& x, const Array& rhs,
+                       const std::string& tag) {
+        const Array result = L.applyTo(x);
+        for (Size i=0; i<rhs.size(); ++i) {
+            if (std::fabs(result[i] - rhs[i]) > 1.0e-12)
+                BOOST_FAIL("wrong solution " << tag << ":"
+                           << "\n    row:        " << i
+                           << "\n    L x:        " << result[i]
+                           << "\n    rhs:        " << rhs[i]);
+        }
+    }
+
+}
+
+
+void OperatorTest::testTridiagonal() {
+
+    BOOST_TEST_MESSAGE("Testing tridiagonal operator...");
+
+    const Size n = 50;
+    TridiagonalOperator L(n);
+    L.setFirstRow(2.0, -0.5);
+    L.setMidRows(-0.7, 2.5, -0.9);
+    L.setLastRow(-0.4, 2.0);
+
+    Array rhs(n);
+    for (Size i=0; i<n; ++i)
+        rhs[i] = std::sin(0.3*i) + 1.0;
+
+    // in-place application gives the same results as the
+    // allocating one
+    const Array expected = L.applyTo(rhs);
+    Array v = rhs;
+    L.applyTo(v, v);
+    for (Size i=0; i<n; ++i) {
+        if (v[i] != expected[i])
+            BOOST_FAIL("in-place application failed:"
+                       << "\n    row:        " << i
+                       << "\n    calculated: " << v[i]
+                       << "\n    expected:   " << expected[i]);
+    }
+
+    // the factorization is reused for further right-hand sides...
+    Array x = L.solveFor(rhs);
+    checkSolution(L, x, rhs, "with fresh factorization");
+    x = rhs;
+    L.solveFor(x, x);
+    checkSolution(L, x, rhs, "with cached factorization");
+
+    // ...including when boundary rows are set again to the same
+    // values, and it is recalculated when the operator changes
+    L.setFirstRow(2.0, -0.5);
+    L.solveFor(rhs, x);
+    checkSolution(L, x, rhs, "after resetting first row");
+    L.setLastRow(-0.4, 3.0);
+    L.solveFor(rhs, x);
+    checkSolution(L, x, rhs, "after changing last row");
+    L.setMidRow(n/2, -1.0, 4.0, -1.5);
+    L.solveFor(rhs, x);
+    checkSolution(L, x, rhs, "after changing a row");
+    L.setMidRows(-0.2, 1.5, -0.3);
+    L.solveFor(rhs, x);
+    checkSolution(L, x, rhs, "after changing all rows");
+
+    // operators obtained by algebra are factorized anew
+    TridiagonalOperator M = L;
+    M = TridiagonalOperator::identity(n) + 0.5*L;
+    M.solveFor(rhs, x);
+    checkSolution(M, x, rhs, "after assignment");
+    L.solveFor(rhs, x);
+    checkSolution(L, x, rhs, "of the original after assignment");
+}
+
+
+test_suite* OperatorTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Operator tests");
+    suite->add(QUANTLIB_TEST_CASE(&OperatorTest::testTridiagonal));
+    return suite;
+}
+
+
+#endif
@@ -0,0 +1,307 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef quantlib_test_path_generator_hpp
+#define quantlib_test_path_generator_hpp
+
+#include <boost/test/unit_test.hpp>
+
+/* remember to document new and/or updated tests in the Doxygen
+   comment block of the corresponding class */
+
+class PathGeneratorTest {
+  public:
+    static void testBatchPaths();
+    static void testMultiPathBatch();
+    static void testMultiPathBridge();
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <ql/methods/montecarlo/pathgenerator.hpp>
+#include <ql/methods/montecarlo/multipathgenerator.hpp>
+#include <ql/math/randomnumbers/rngtraits.hpp>
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/processes/eulerdiscretization.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/time/daycounters/actual360.hpp>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    // batched evolutions may compute drifts and variances once per
+    // step instead of once per path
+    const Real batchTolerance = 1.0e-12;
+
+    boost::shared_ptr<GeneralizedBlackScholesProcess> batchTestProcess() {
+        const Date today = Settings::instance().evaluationDate();
+        const DayCounter dc = Actual360();
+        const boost::shared_ptr<Quote> spot(new SimpleQuote(100.0));
+        return boost::shared_ptr<GeneralizedBlackScholesProcess>(
+            new BlackScholesMertonProcess(
+                Handle<Quote>(spot),
+                Handle<YieldTermStructure>(flatRate(today, 0.02, dc)),
+                Handle<YieldTermStructure>(flatRate(today, 0.05, dc)),
+                Handle<BlackVolTermStructure>(flatVol(today, 0.30, dc))));
+    }
+
+    // two correlated arithmetic Brownian motions with drift
+    class CorrelatedBrownianProcess : public StochasticProcess {
+      public:
+        CorrelatedBrownianProcess()
+        : StochasticProcess(boost::shared_ptr<discretization>(
+                                                new EulerDiscretization)),
+          diffusion_(2, 2, 0.0) {
+            diffusion_[0][0] = 0.3;
+            diffusion_[1][0] = 0.1;
+            diffusion_[1][1] = 0.2;
+        }
+        Size size() const { return 2; }
+        Disposable<Array> initialValues() const {
+            Array x(2);
+            x[0] = 1.0;
+            x[1] = -0.5;
+            return x;
+        }
+        Disposable<Array> drift(Time, const Array&) const {
+            Array mu(2);
+            mu[0] = 0.04;
+            mu[1] = -0.02;
+            return mu;
+        }
+        Disposable<Matrix> diffusion(Time, const Array&) const {
+            Matrix sigma = diffusion_;
+            return sigma;
+        }
+      private:
+        Matrix diffusion_;
+    };
+
+    void checkBatchColumn(const std::string& what,
+                          const Matrix& batch, Size j,
+                          const Path& path) {
+        for (Size i=0; i<path.length(); ++i) {
+            const Real error = std::fabs(batch[i][j] - path[i]);
+            if (error > batchTolerance*std::max(1.0, std::fabs(path[i])))
+                BOOST_FAIL("failed to reproduce " << what << ":"
+                           << "\n    path:        " << j
+                           << "\n    time point:  " << i
+                           << "\n    batch value: " << batch[i][j]
+                           << "\n    path value:  " << path[i]);
+        }
+    }
+
+    void checkBatchWeight(const std::string& what, Real batchWeight,
+                          Size j, Real weight) {
+        if (batchWeight != weight)
+            BOOST_FAIL("failed to reproduce " << what << " weight:"
+                       << "\n    path:         " << j
+                       << "\n    batch weight: " << batchWeight
+                       << "\n    path weight:  " << weight);
+    }
+
+}
+
+
+void PathGeneratorTest::testBatchPaths() {
+
+    BOOST_TEST_MESSAGE("Testing batched path generation...");
+
+    SavedSettings backup;
+
+    typedef PseudoRandom::rsg_type rsg_type;
+    typedef PathGenerator<rsg_type> generator_type;
+
+    const boost::shared_ptr<GeneralizedBlackScholesProcess> process =
+        batchTestProcess();
+    const TimeGrid grid(1.5, 12);
+    const Size nPaths = 37;
+
+    for (Size b=0; b<2; ++b) {
+        const bool brownianBridge = (b == 1);
+        const std::string what =
+            brownianBridge ? "bridged path" : "path";
+
+        generator_type batchGenerator(
+            process, grid,
+            PseudoRandom::make_sequence_generator(grid.size()-1, 42),
+            brownianBridge);
+        generator_type pathGenerator(
+            process, grid,
+            PseudoRandom::make_sequence_generator(grid.size()-1, 42),
+            brownianBridge);
+
+        // two batches, to check that buffers are reused correctly
+        Matrix batch(grid.size(), nPaths), antithetic(grid.size(), nPaths);
+        std::vector<Real> weights, antitheticWeights;
+        for (Size n=0; n<2; ++n) {
+            batchGenerator.nextBatch(batch, weights);
+            batchGenerator.antitheticBatch(antithetic, antitheticWeights);
+            for (Size j=0; j<nPaths; ++j) {
+                const generator_type::sample_type& path =
+                    pathGenerator.next();
+                checkBatchColumn(what, batch, j, path.value);
+                checkBatchWeight(what, weights[j], j, path.weight);
+                const generator_type::sample_type& mirror =
+                    pathGenerator.antithetic();
+                checkBatchColumn("antithetic " + what,
+                                 antithetic, j, mirror.value);
+                checkBatchWeight("antithetic " + what,
+                                 antitheticWeights[j], j, mirror.weight);
+            }
+        }
+    }
+}
+
+
+void PathGeneratorTest::testMultiPathBatch() {
+
+    BOOST_TEST_MESSAGE("Testing batched multi-path generation...");
+
+    SavedSettings backup;
+
+    typedef PseudoRandom::rsg_type rsg_type;
+    typedef MultiPathGenerator<rsg_type> generator_type;
+
+    // a multi-factor process evolving through evolve(), and a 1-D
+    // one evolving through its own batched implementation
+    const boost::shared_ptr<StochasticProcess> processes[] = {
+        boost::shared_ptr<StochasticProcess>(new CorrelatedBrownianProcess),
+        batchTestProcess()
+    };
+    const TimeGrid grid(2.0, 10);
+    const Size nPaths = 29;
+
+    for (Size p=0; p<LENGTH(processes); ++p) {
+        const boost::shared_ptr<StochasticProcess>& process = processes[p];
+        const Size assets = process->size();
+        const Size dimension = process->factors()*(grid.size()-1);
+        for (Size b=0; b<2; ++b) {
+            const bool brownianBridge = (b == 1);
+            const std::string what =
+                brownianBridge ? "bridged multi-path" : "multi-path";
+
+            generator_type batchGenerator(
+                process, grid,
+                PseudoRandom::make_sequence_generator(dimension, 42),
+                brownianBridge);
+            generator_type pathGenerator(
+                process, grid,
+                PseudoRandom::make_sequence_generator(dimension, 42),
+                brownianBridge);
+
+            generator_type::batch_type batch(assets,
+                                             Matrix(grid.size(), nPaths));
+            generator_type::batch_type antithetic = batch;
+            std::vector<Real> weights, antitheticWeights;
+            batchGenerator.nextBatch(batch, weights);
+            batchGenerator.antitheticBatch(antithetic, antitheticWeights);
+            for (Size j=0; j<nPaths; ++j) {
+                const generator_type::sample_type& path =
+                    pathGenerator.next();
+                checkBatchWeight(what, weights[j], j, path.weight);
+                for (Size k=0; k<assets; ++k)
+                    checkBatchColumn(what, batch[k], j, path.value[k]);
+                const generator_type::sample_type& mirror =
+                    pathGenerator.antithetic();
+                checkBatchWeight("antithetic " + what,
+                                 antitheticWeights[j], j, mirror.weight);
+                for (Size k=0; k<assets; ++k)
+                    checkBatchColumn("antithetic " + what,
+                                     antithetic[k], j, mirror.value[k]);
+            }
+        }
+    }
+}
+
+
+void PathGeneratorTest::testMultiPathBridge() {
+
+    BOOST_TEST_MESSAGE("Testing Brownian bridge in multi-path generation...");
+
+    typedef PseudoRandom::rsg_type rsg_type;
+    typedef MultiPathGenerator<rsg_type> generator_type;
+
+    const boost::shared_ptr<CorrelatedBrownianProcess> process(
+                                               new CorrelatedBrownianProcess);
+    const TimeGrid grid(2.0, 16);
+    const Size factors = process->factors();
+    const Size dimension = factors*(grid.size()-1);
+    const Time maturity = grid.back();
+
+    generator_type generator(
+        process, grid,
+        PseudoRandom::make_sequence_generator(dimension, 42), true);
+    rsg_type sequenceGenerator =
+        PseudoRandom::make_sequence_generator(dimension, 42);
+
+    // the first variates of each sequence, one per factor, give the
+    // final values of the Brownian motions
+    const Array x0 = process->initialValues();
+    const Array mu = process->drift(0.0, x0);
+    const Matrix sigma = process->diffusion(0.0, x0);
+    for (Size n=0; n<100; ++n) {
+        const MultiPath& path = generator.next().value;
+        const std::vector<Real>& z =
+            sequenceGenerator.nextSequence().value;
+        for (Size k=0; k<process->size(); ++k) {
+            Real expected = x0[k] + mu[k]*maturity;
+            for (Size l=0; l<factors; ++l)
+                expected += sigma[k][l]*std::sqrt(maturity)*z[l];
+            const Real calculated = path[k].back();
+            if (std::fabs(calculated - expected) > 1.0e-12)
+                BOOST_FAIL("failed to reproduce final value "
+                           "of bridged multi-path:"
+                           << "\n    path:       " << n
+                           << "\n    asset:      " << k
+                           << "\n    calculated: " << calculated
+                           << "\n    expected:   " << expected);
+        }
+    }
+}
+
+
+test_suite* PathGeneratorTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Path generation tests");
+    suite->add(QUANTLIB_TEST_CASE(&PathGeneratorTest::testBatchPaths));
+    suite->add(QUANTLIB_TEST_CASE(&PathGeneratorTest::testMultiPathBatch));
+    suite->add(QUANTLIB_TEST_CASE(&PathGeneratorTest::testMultiPathBridge));
+    return suite;
+}
+
+
+#endif
@@ -23,7 +23,9 @@ QuantLib Benchmark Suite
 
 Measures the performance of a preselected set of numerically intensive
 test cases. The overall QuantLib Benchmark Index is given by the average
-performance in mflops.
+performance in mflops.  Test cases whose number of floating point
+operations hasn't been measured are timed and reported in seconds, but
+don't contribute to the index.
 
 The number of floating point operations of a given test case was measured
 using the perfex library, http://user.it.uu.se/~mikpe/linux/perfctr
@@ -110,12 +112,16 @@ See http://www.wilmott.com/messageview.cfm?catid=10&threadid=9481
 #include "utilities.hpp"
 
 //#include "americanoption.hpp"
+#include "array.hpp"
 //#include "asianoptions.hpp"
 //#include "barrieroption.hpp"
 //#include "basketoption.hpp"
 //#include "batesmodel.hpp"
+#include "blackformula.hpp"
 //#include "convertiblebonds.hpp"
+#include "counterbasedrng.hpp"
 //#include "digitaloption.hpp"
+#include "distributions.hpp"
 //#include "dividendoption.hpp"
 //#include "europeanoption.hpp"
 //#include "fdheston.hpp"
@@ -124,10 +130,13 @@ See http://www.wilmott.com/messageview.cfm?catid=10&threadid=9481
 //#include "jumpdiffusion.hpp"
 //#include "marketmodel_smm.hpp"
 //#include "marketmodel_cms.hpp"
+#include "matrices.hpp"
 //#include "lowdiscrepancysequences.hpp"
+#include "observable.hpp"
 //#include "quantooption.hpp"
 //#include "riskstats.hpp"
 //#include "shortratemodels.hpp"
+#include "stats.hpp"
 
 using namespace boost::unit_test_framework;
 
@@ -139,7 +148,7 @@ namespace
 	{
 	public:
 		typedef void(*fct_ptr)();
-		Benchmark(const std::string& name, fct_ptr f, double mflop)
+		Benchmark(const std::string& name, fct_ptr f, double mflop = 0.0)
 			: f_(f), name_(name), mflop_(mflop)
 		{}
 
@@ -155,11 +164,16 @@ namespace
 		{
 			return name_;
 		}
+		bool isScored() const
+		{
+			return mflop_ > 0.0;
+		}
 	private:
 		fct_ptr f_;
 		const std::string name_;
 		const double mflop_; // total number of mega floating
-							 // point operations (not per sec!)
+							 // point operations (not per sec!),
+							 // zero if not measured
 	};
 
 	boost::timer t;
@@ -203,26 +217,35 @@ namespace
 			<< std::endl << std::endl;
 
 		double sum = 0;
+		std::size_t scored = 0;
 		std::list<double>::const_iterator iterT = runTimes.begin();
 		std::list<Benchmark>::const_iterator iterBM = bm.begin();
 
 		while (iterT != runTimes.end())
 		{
-			const double mflopsPerSec = iterBM->getMflop() / (*iterT);
 			std::cout << iterBM->getName()
 				<< std::string(42 - iterBM->getName().length(), ' ') << ":"
-				<< std::fixed << std::setw(6) << std::setprecision(1)
-				<< mflopsPerSec
-				<< " mflops" << std::endl;
-
-			sum += mflopsPerSec;
+				<< std::fixed << std::setw(6) << std::setprecision(1);
+			if (iterBM->isScored())
+			{
+				const double mflopsPerSec = iterBM->getMflop() / (*iterT);
+				std::cout << mflopsPerSec << " mflops" << std::endl;
+
+				sum += mflopsPerSec;
+				++scored;
+			}
+			else
+			{
+				std::cout << std::setprecision(3) << *iterT
+					<< " s (not scored)" << std::endl;
+			}
 			++iterT;
 			++iterBM;
 		}
 		std::cout << std::string(56, '-') << std::endl
 			<< "QuantLib Benchmark Index                  :"
 			<< std::fixed << std::setw(6) << std::setprecision(1)
-			<< sum / runTimes.size()
+			<< (scored > 0 ? sum / scored : 0.0)
 			<< " mflops" << std::endl;
 	}
 }
@@ -241,6 +264,8 @@ test_suite* init_unit_test_suite(int, char*[])
 						   &AmericanOptionTest::testFdAmericanGreeks, 518.31));*/
 	/*bm.push_back(Benchmark("AmericanOption::FdShoutGreeks",
 						   &AmericanOptionTest::testFdShoutGreeks, 546.58));*/
+	bm.push_back(Benchmark("Array::ExpressionThroughput",
+						   &ArrayTest::testExpressionThroughput, 400.0));
 	/*bm.push_back(Benchmark("AsianOption::MCArithmeticAveragePrice",
 						   &AsianOptionTest::testMCDiscreteArithmeticAveragePrice, 5186.13));*/
 	/*bm.push_back(Benchmark("BarrierOption::BabsiriValues",
@@ -253,10 +278,22 @@ test_suite* init_unit_test_suite(int, char*[])
 						   &BasketOptionTest::testOddSamples, 642.46));*/
 	/*bm.push_back(Benchmark("BatesModel::DAXCalibration",
 						   &BatesModelTest::testDAXCalibration, 1993.35));*/
+	bm.push_back(Benchmark("BlackFormula::ScalarThroughput",
+						   &BlackFormulaTest::testScalarThroughput));
+	bm.push_back(Benchmark("BlackFormula::BatchThroughput",
+						   &BlackFormulaTest::testBatchThroughput));
+	bm.push_back(Benchmark("BlackFormula::ImpliedStdDevThroughput",
+						   &BlackFormulaTest::testImpliedStdDevThroughput));
+	bm.push_back(Benchmark("BlackFormula::LetsBeRationalThroughput",
+						   &BlackFormulaTest::testLetsBeRationalThroughput));
 	/*bm.push_back(Benchmark("ConvertibleBondTest::testBond",
 						   &ConvertibleBondTest::testBond, 159.85));*/
+	bm.push_back(Benchmark("CounterBasedRng::Throughput",
+						   &CounterBasedRngTest::testThroughput));
 	/*bm.push_back(Benchmark("DigitalOption::MCCashAtHit",
 						   &DigitalOptionTest::testMCCashAtHit, 995.87));*/
+	bm.push_back(Benchmark("Distribution::InverseNormalThroughput",
+						   &DistributionTest::testInverseCumulativeNormalThroughput));
 	/*bm.push_back(Benchmark("DividendOption::FdEuropeanGreeks",
 						   &DividendOptionTest::testFdEuropeanGreeks, 949.52));*/
 	/*bm.push_back(Benchmark("DividendOption::FdAmericanGreeks",
@@ -283,6 +320,10 @@ test_suite* init_unit_test_suite(int, char*[])
 	/*bm.push_back(Benchmark("MarketModelSmmTest::testMultiSmmSwaptions",
 						   &MarketModelSmmTest::testMultiStepCoterminalSwapsAndSwaptions,
 						   11244.95));*/
+	bm.push_back(Benchmark("Matrices::KernelThroughput",
+						   &MatricesTest::testKernelThroughput, 21331.5));
+	bm.push_back(Benchmark("Observable::NotificationThroughput",
+						   &ObservableTest::testNotificationThroughput));
 	/*bm.push_back(Benchmark("QuantoOption::ForwardGreeks",
 						   &QuantoOptionTest::testForwardGreeks, 90.98));*/
 	/*bm.push_back(Benchmark("RandomNumber::MersenneTwisterDescrepancy",
@@ -291,6 +332,8 @@ test_suite* init_unit_test_suite(int, char*[])
 						   &RiskStatisticsTest::testResults, 300.28));*/
 	/*bm.push_back(Benchmark("ShortRateModel::Swaps",
 						   &ShortRateModelTest::testSwaps, 454.73));*/
+	bm.push_back(Benchmark("Statistics::TDigestThroughput",
+						   &StatisticsTest::testTDigestThroughput));
 
 	test_suite* test = BOOST_TEST_SUITE("QuantLib benchmark suite");
 
@@ -53,7 +53,7 @@
 #endif
 #include "utilities.hpp"
 
-// #include "americanoption.hpp"
+ #include "americanoption.hpp"
 // #include "amortizingbond.hpp"
  #include "array.hpp"
 // #include "asianoptions.hpp"
@@ -67,7 +67,7 @@
 // #include "blackdeltacalculator.hpp"
  #include "blackformula.hpp"
 // #include "bonds.hpp"
-// #include "brownianbridge.hpp"
+ #include "brownianbridge.hpp"
  #include "businessdayconventions.hpp"
  #include "calendars.hpp"
 // #include "capfloor.hpp"
@@ -82,6 +82,7 @@
 // #include "commodityunitofmeasure.hpp"
 // #include "compoundoption.hpp"
 // #include "convertiblebonds.hpp"
+ #include "counterbasedrng.hpp"
  #include "covariance.hpp"
 // #include "creditdefaultswap.hpp"
 // #include "creditriskplus.hpp"
@@ -125,7 +126,8 @@
 // #include "interestrates.hpp"
  #include "interpolations.hpp"
 // #include "jumpdiffusion.hpp"
-// #include "lazyobject.hpp"
+ #include "lattices.hpp"
+ #include "lazyobject.hpp"
 // #include "libormarketmodel.hpp"
 // #include "libormarketmodelprocess.hpp"
  #include "linearleastsquaresregression.hpp"
@@ -140,21 +142,22 @@
 // #include "marketmodel_cms.hpp"
 // #include "markovfunctional.hpp"
  #include "matrices.hpp"
-// #include "mclongstaffschwartzengine.hpp"
+ #include "mclongstaffschwartzengine.hpp"
  #include "mersennetwister.hpp"
 // #include "money.hpp"
+ #include "multilevelmontecarlo.hpp"
 // #include "noarbsabr.hpp"
 // #include "nthtodefault.hpp"
 // #include "numericaldifferentiation.hpp"
-// #include "observable.hpp"
+ #include "observable.hpp"
  #include "ode.hpp"
-// #include "operators.hpp"
+ #include "operators.hpp"
  #include "optimizers.hpp"
 // #include "optionletstripper.hpp"
 // #include "overnightindexedswap.hpp"
 // #include "pagodaoption.hpp"
 // #include "partialtimebarrieroption.hpp"
-// #include "pathgenerator.hpp"
+ #include "pathgenerator.hpp"
 // #include "period.hpp"
 // #include "piecewiseyieldcurve.hpp"
 // #include "piecewisezerospreadedtermstructure.hpp"
@@ -166,6 +169,7 @@
 // #include "rounding.hpp"
 // #include "sampledcurve.hpp"
 // #include "schedule.hpp"
+ #include "settings.hpp"
 // #include "shortratemodels.hpp"
  #include "solvers.hpp"
 // #include "spreadoption.hpp"
@@ -321,7 +325,7 @@ test_suite* init_unit_test_suite(int, char* []) {
 
     test->add(QUANTLIB_TEST_CASE(startTimer));
 
-    // test->add(AmericanOptionTest::suite());
+    test->add(AmericanOptionTest::suite());
      test->add(ArrayTest::suite());
     // test->add(AsianOptionTest::suite());
     // test->add(AssetSwapTest::suite()); // fails with QL_USE_INDEXED_COUPON
@@ -333,7 +337,7 @@ test_suite* init_unit_test_suite(int, char* []) {
     // test->add(BinaryOptionTest::suite());
      test->add(BlackFormulaTest::suite());
     // test->add(BondTest::suite());
-    // test->add(BrownianBridgeTest::suite());
+     test->add(BrownianBridgeTest::suite());
      test->add(BusinessDayConventionTest::suite());
      test->add(CalendarTest::suite());
     // test->add(CapFloorTest::suite());
@@ -341,6 +345,7 @@ test_suite* init_unit_test_suite(int, char* []) {
     // test->add(CashFlowsTest::suite());
     // test->add(CliquetOptionTest::suite());
     // test->add(CmsTest::suite());
+     test->add(CounterBasedRngTest::suite());
      test->add(CovarianceTest::suite());
     // test->add(CPISwapTest::suite());
     // test->add(CreditDefaultSwapTest::suite());
@@ -374,7 +379,8 @@ test_suite* init_unit_test_suite(int, char* []) {
     // test->add(InterestRateTest::suite());
      test->add(InterpolationTest::suite());
     // test->add(JumpDiffusionTest::suite());
-    // test->add(LazyObjectTest::suite());
+     test->add(LatticeTest::suite());
+     test->add(LazyObjectTest::suite());
      test->add(LinearLeastSquaresRegressionTest::suite());
     // test->add(LookbackOptionTest::suite());
      test->add(LowDiscrepancyTest::suite());
@@ -386,16 +392,17 @@ test_suite* init_unit_test_suite(int, char* []) {
     // test->add(MarketModelSmmCapletHomoCalibrationTest::suite());
     // test->add(MarkovFunctionalTest::suite());
      test->add(MatricesTest::suite());
-    // test->add(MCLongstaffSchwartzEngineTest::suite());
+     test->add(MCLongstaffSchwartzEngineTest::suite());
      test->add(MersenneTwisterTest::suite());
     // test->add(MoneyTest::suite());
-    // test->add(ObservableTest::suite());
+     test->add(MultiLevelMonteCarloTest::suite());
+     test->add(ObservableTest::suite());
      test->add(OdeTest::suite());
-    // test->add(OperatorTest::suite());
+     test->add(OperatorTest::suite());
      test->add(OptimizersTest::suite(Faster));
     // test->add(OptionletStripperTest::suite());
     // test->add(OvernightIndexedSwapTest::suite());
-    // test->add(PathGeneratorTest::suite());
+     test->add(PathGeneratorTest::suite());
     // test->add(PeriodTest::suite());
     // test->add(PiecewiseYieldCurveTest::suite());
     // test->add(PiecewiseZeroSpreadedTermStructureTest::suite());
@@ -406,6 +413,7 @@ test_suite* init_unit_test_suite(int, char* []) {
     // test->add(RoundingTest::suite());
     // test->add(SampledCurveTest::suite());
     // test->add(ScheduleTest::suite());
+     test->add(SettingsTest::suite());
     // test->add(ShortRateModelTest::suite()); // fails with QL_USE_INDEXED_COUPON
      test->add(Solver1DTest::suite());
      test->add(StatisticsTest::suite());
@@ -31,6 +31,7 @@ class RngTraitsTest {
     static void testGaussian();
     static void testDefaultPoisson();
     static void testCustomPoisson();
+    static void testWorkerErrorEstimate();
     static boost::unit_test_framework::test_suite* suite();
 };
 
@@ -60,10 +61,24 @@ class RngTraitsTest {
 #include "utilities.hpp"
 #include <ql/math/comparison.hpp>
 #include <ql/math/randomnumbers/rngtraits.hpp>
+#include <ql/math/randomnumbers/randomizedrngtraits.hpp>
 
 using namespace QuantLib;
 using namespace boost::unit_test_framework;
 
+namespace {
+
+    // user-defined traits, redefining the trait or written before
+    // it existed
+    struct RedefiningTraits : PseudoRandom {
+        enum { workerErrorEstimate = 1 };
+    };
+    struct LegacyTraits {
+        enum { allowsErrorEstimate = 1 };
+    };
+
+}
+
 void RngTraitsTest::testGaussian() {
 
     BOOST_TEST_MESSAGE("Testing Gaussian pseudo-random number generation...");
@@ -130,11 +145,29 @@ void RngTraitsTest::testCustomPoisson() {
 }
 
 
+void RngTraitsTest::testWorkerErrorEstimate() {
+
+    BOOST_TEST_MESSAGE("Testing worker error-estimate trait...");
+
+    if (WorkerErrorEstimate<PseudoRandom>::value
+        || WorkerErrorEstimate<LowDiscrepancy>::value
+        || !WorkerErrorEstimate<RandomizedLowDiscrepancy>::value)
+        BOOST_FAIL("wrong worker error-estimate trait for library traits");
+
+    if (!WorkerErrorEstimate<RedefiningTraits>::value)
+        BOOST_FAIL("redefined worker error-estimate trait not used");
+
+    if (WorkerErrorEstimate<LegacyTraits>::value)
+        BOOST_FAIL("worker error-estimate trait not defaulted to false");
+}
+
+
 test_suite* RngTraitsTest::suite() {
     test_suite* suite = BOOST_TEST_SUITE("RNG traits tests");
     suite->add(QUANTLIB_TEST_CASE(&RngTraitsTest::testGaussian));
     suite->add(QUANTLIB_TEST_CASE(&RngTraitsTest::testDefaultPoisson));
     suite->add(QUANTLIB_TEST_CASE(&RngTraitsTest::testCustomPoisson));
+    suite->add(QUANTLIB_TEST_CASE(&RngTraitsTest::testWorkerErrorEstimate));
     return suite;
 }
 
@@ -0,0 +1,166 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef quantlib_test_settings_hpp
+#define quantlib_test_settings_hpp
+
+#include <boost/test/unit_test.hpp>
+
+/* remember to document new and/or updated tests in the Doxygen
+   comment block of the corresponding class */
+
+class SettingsTest {
+  public:
+    static void testNotificationsOnDateChange();
+    #ifdef QL_ENABLE_THREAD_LOCAL_SESSIONS
+    static void testThreadLocalSessions();
+    #endif
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <ql/settings.hpp>
+#ifdef QL_ENABLE_THREAD_LOCAL_SESSIONS
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/thread.hpp>
+#endif
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    #ifdef QL_ENABLE_THREAD_LOCAL_SESSIONS
+
+    // sets the evaluation date of its thread and reads it back after
+    // the other threads set theirs
+    class SessionDateSetter {
+      public:
+        SessionDateSetter(const Date& date, Date& initial, Date& result,
+                          boost::barrier& barrier)
+        : date_(date), initial_(initial), result_(result),
+          barrier_(barrier) {}
+        void operator()() const {
+            initial_ = Settings::instance().evaluationDate();
+            Settings::instance().evaluationDate() = date_;
+            barrier_.wait();
+            result_ = Settings::instance().evaluationDate();
+        }
+      private:
+        Date date_;
+        Date& initial_;
+        Date& result_;
+        boost::barrier& barrier_;
+    };
+
+    #endif
+
+}
+
+
+void SettingsTest::testNotificationsOnDateChange() {
+
+    BOOST_TEST_MESSAGE("Testing notifications on evaluation-date change...");
+
+    SavedSettings backup;
+
+    const Date today(15, March, 2021);
+    Settings::instance().evaluationDate() = today;
+
+    Flag flag;
+    flag.registerWith(Settings::instance().evaluationDate());
+
+    Settings::instance().evaluationDate() = today + 1;
+    if (!flag.isUp())
+        BOOST_FAIL("observer not notified of evaluation-date change");
+}
+
+
+#ifdef QL_ENABLE_THREAD_LOCAL_SESSIONS
+
+void SettingsTest::testThreadLocalSessions() {
+
+    BOOST_TEST_MESSAGE("Testing evaluation dates in thread-local sessions...");
+
+    SavedSettings backup;
+
+    const Date today(15, March, 2021);
+    Settings::instance().evaluationDate() = today;
+
+    const Date dates[] = { Date(1, June, 2020), Date(1, June, 2022) };
+    Date initial[LENGTH(dates)], results[LENGTH(dates)];
+    boost::barrier barrier(LENGTH(dates));
+    boost::thread_group threads;
+    for (Size i=0; i<LENGTH(dates); ++i)
+        threads.create_thread(SessionDateSetter(dates[i], initial[i],
+                                                results[i], barrier));
+    threads.join_all();
+
+    for (Size i=0; i<LENGTH(dates); ++i) {
+        // each thread starts from the default settings...
+        if (initial[i] != Date::todaysDate())
+            BOOST_ERROR("wrong initial evaluation date in thread " << i
+                        << ":\n    evaluation date: " << initial[i]
+                        << "\n    expected:        "
+                        << Date::todaysDate());
+        // ...and keeps its own date while the others change theirs
+        if (results[i] != dates[i])
+            BOOST_ERROR("wrong evaluation date in thread " << i << ":"
+                        << "\n    evaluation date: " << results[i]
+                        << "\n    expected:        " << dates[i]);
+    }
+
+    const Date current = Settings::instance().evaluationDate();
+    if (current != today)
+        BOOST_FAIL("evaluation date changed by other threads:"
+                   << "\n    evaluation date: " << current
+                   << "\n    expected:        " << today);
+}
+
+#endif
+
+
+test_suite* SettingsTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Settings tests");
+    suite->add(QUANTLIB_TEST_CASE(
+                             &SettingsTest::testNotificationsOnDateChange));
+    #ifdef QL_ENABLE_THREAD_LOCAL_SESSIONS
+    suite->add(QUANTLIB_TEST_CASE(&SettingsTest::testThreadLocalSessions));
+    #endif
+    return suite;
+}
+
+
+#endif
@@ -33,6 +33,9 @@ class StatisticsTest {
     static void testSequenceStatistics();
     static void testConvergenceStatistics();
     static void testIncrementalStatistics();
+    static void testMerge();
+    static void testTDigestStatistics();
+    static void testTDigestThroughput();
     static boost::unit_test_framework::test_suite* suite();
 };
 
@@ -65,6 +68,7 @@ class StatisticsTest {
 #include <ql/math/statistics/gaussianstatistics.hpp>
 #include <ql/math/statistics/sequencestatistics.hpp>
 #include <ql/math/statistics/convergencestatistics.hpp>
+#include <ql/math/statistics/tdigeststatistics.hpp>
 #include <ql/math/randomnumbers/mt19937uniformrng.hpp>
 #include <ql/math/randomnumbers/inversecumulativerng.hpp>
 #include <ql/math/distributions/normaldistribution.hpp>
@@ -427,12 +431,330 @@ void StatisticsTest::testIncrementalStatistics() {
                                  << tol);
 }
 
+
+namespace {
+
+    template <class S>
+    void checkMerge(const std::string& name, Real offset) {
+
+        MersenneTwisterUniformRng mt(42);
+        InverseCumulativeRng<MersenneTwisterUniformRng,
+                             InverseCumulativeNormal> gen(mt);
+
+        // the data are split in chunks of different sizes, including
+        // empty ones, which are merged as they would be by threads
+        const Size sizes[] = { 0, 1, 17, 1000, 0, 4096, 3, 10000 };
+        S whole, merged;
+        for (Size k=0; k<LENGTH(sizes); ++k) {
+            S chunk;
+            for (Size i=0; i<sizes[k]; ++i) {
+                Real x = offset + 1.0e-1*gen.next().value;
+                Real w = (k % 2 == 0) ? 1.0 : mt.nextReal();
+                chunk.add(x, w);
+                whole.add(x, w);
+            }
+            merged.merge(chunk);
+        }
+
+        if (merged.samples() != whole.samples())
+            BOOST_FAIL(name << ": wrong number of merged samples\n"
+                       << "    calculated: " << merged.samples() << "\n"
+                       << "    expected:   " << whole.samples());
+
+        // with a large offset, both the merged and the sequential
+        // variance are affected by rounding errors; the higher
+        // moments are calculated from raw sums and are meaningless
+        const Real tolerance = 1.0e-10;
+        const Real varianceTolerance = (offset == 0.0 ? 1.0e-10 : 1.0e-6);
+        #define CHECK_MERGED(method, tol) \
+            if (std::fabs(merged.method() - whole.method()) > \
+                (tol)*std::max<Real>(1.0, std::fabs(whole.method()))) \
+                BOOST_FAIL(name << ": wrong merged " #method "\n" \
+                           << std::setprecision(16) \
+                           << "    calculated: " << merged.method() << "\n" \
+                           << "    expected:   " << whole.method());
+        CHECK_MERGED(weightSum, tolerance);
+        CHECK_MERGED(mean, tolerance);
+        CHECK_MERGED(variance, varianceTolerance);
+        CHECK_MERGED(min, 0.0);
+        CHECK_MERGED(max, 0.0);
+        if (offset == 0.0) {
+            CHECK_MERGED(skewness, tolerance);
+            CHECK_MERGED(kurtosis, tolerance);
+        }
+        #undef CHECK_MERGED
+
+        // the merged variance is still accurate with a large offset
+        if (std::fabs(merged.variance() - 1.0e-2) > 1.0e-3)
+            BOOST_FAIL(name << ": merged variance (" << merged.variance()
+                       << ") out of expected range "
+                       << 1.0e-2 << " +- " << 1.0e-3);
+    }
+
+}
+
+void StatisticsTest::testMerge() {
+
+    BOOST_TEST_MESSAGE("Testing merge of statistics accumulators...");
+
+    checkMerge<IncrementalStatistics>(
+                          std::string("IncrementalStatistics"), 0.0);
+    checkMerge<IncrementalStatistics>(
+                          std::string("IncrementalStatistics"), 1.0e8);
+    checkMerge<Statistics>(std::string("Statistics"), 0.0);
+    checkMerge<Statistics>(std::string("Statistics"), 1.0e8);
+
+    // sorted data sets are kept sorted...
+    Statistics sorted, other;
+    for (Size i=0; i<LENGTH(data); ++i) {
+        if (i % 2 == 0)
+            sorted.add(data[i]);
+        else
+            other.add(data[i]);
+    }
+    sorted.sort();
+    other.sort();
+    sorted.merge(other);
+    for (Size i=1; i<sorted.samples(); ++i)
+        if (sorted.data()[i].first < sorted.data()[i-1].first)
+            BOOST_FAIL("merged data set not sorted");
+    // ...and percentiles are those of the whole set
+    std::vector<Real> all(data, data+LENGTH(data));
+    std::sort(all.begin(), all.end());
+    if (sorted.percentile(0.5) != all[LENGTH(data)/2-1])
+        BOOST_FAIL("wrong merged percentile:\n"
+                   << "    calculated: " << sorted.percentile(0.5) << "\n"
+                   << "    expected:   " << all[LENGTH(data)/2-1]);
+
+    // sequence statistics merge each dimension and the covariance
+    const Size dimension = 3;
+    MersenneTwisterUniformRng mt(1234);
+    SequenceStatistics whole(dimension), first(dimension), second;
+    std::vector<Real> sample(dimension);
+    for (Size i=0; i<2000; ++i) {
+        for (Size j=0; j<dimension; ++j)
+            sample[j] = mt.nextReal() + (j == 2 ? sample[0] : 0.0);
+        whole.add(sample);
+        if (i < 700)
+            first.add(sample);
+        else
+            second.add(sample);
+    }
+    first.merge(second);
+    if (first.samples() != whole.samples())
+        BOOST_FAIL("wrong number of merged sequence samples\n"
+                   << "    calculated: " << first.samples() << "\n"
+                   << "    expected:   " << whole.samples());
+    const Matrix c1 = first.covariance(), c2 = whole.covariance();
+    const std::vector<Real> m1 = first.mean(), m2 = whole.mean();
+    for (Size i=0; i<dimension; ++i) {
+        if (std::fabs(m1[i] - m2[i]) > 1.0e-12)
+            BOOST_FAIL("wrong merged sequence mean in dimension " << i
+                       << "\n    calculated: " << m1[i]
+                       << "\n    expected:   " << m2[i]);
+        for (Size j=0; j<dimension; ++j)
+            if (std::fabs(c1[i][j] - c2[i][j]) > 1.0e-12)
+                BOOST_FAIL("wrong merged covariance at (" << i << ", "
+                           << j << ")"
+                           << "\n    calculated: " << c1[i][j]
+                           << "\n    expected:   " << c2[i][j]);
+    }
+
+    SequenceStatistics wrong(dimension+1);
+    wrong.add(std::vector<Real>(dimension+1, 1.0));
+    BOOST_CHECK_THROW(first.merge(wrong), Error);
+}
+
+
+namespace {
+
+    // fraction of the sorted data below the given value
+    Real rank(const std::vector<Real>& sorted, Real x) {
+        return Real(std::lower_bound(sorted.begin(), sorted.end(), x)
+                    - sorted.begin()) / sorted.size();
+    }
+
+    void checkTDigest(const std::string& name,
+                      const TDigestRiskStatistics& digest,
+                      const RiskStatistics& exact) {
+
+        if (digest.samples() != exact.samples())
+            BOOST_FAIL(name << ": wrong number of samples\n"
+                       << "    calculated: " << digest.samples() << "\n"
+                       << "    expected:   " << exact.samples());
+        if (digest.centroids() > Size(digest.compression()))
+            BOOST_FAIL(name << ": too many centroids\n"
+                       << "    used:        " << digest.centroids() << "\n"
+                       << "    compression: " << digest.compression());
+
+        std::vector<Real> sorted(exact.samples());
+        for (Size i=0; i<exact.samples(); ++i)
+            sorted[i] = exact.data()[i].first;
+        std::sort(sorted.begin(), sorted.end());
+
+        // the rank of the returned percentiles is within the
+        // documented bound
+        const Real percentiles[] = { 0.001, 0.01, 0.05, 0.25, 0.5,
+                                     0.75, 0.95, 0.99, 0.999 };
+        for (Size i=0; i<LENGTH(percentiles); ++i) {
+            const Real q = percentiles[i];
+            const Real bound = 2.0*M_PI*std::sqrt(q*(1.0-q))
+                             / digest.compression();
+            const Real x = digest.percentile(q);
+            if (std::fabs(rank(sorted, x) - q) > bound)
+                BOOST_FAIL(name << ": wrong " << q << " percentile\n"
+                           << std::setprecision(8)
+                           << "    calculated: " << x
+                           << " (rank " << rank(sorted, x) << ")\n"
+                           << "    expected:   " << exact.percentile(q)
+                           << "\n    tolerance:  " << bound);
+            const Real y = digest.topPercentile(1.0-q);
+            if (std::fabs(rank(sorted, y) - q) > bound)
+                BOOST_FAIL(name << ": wrong " << 1.0-q
+                           << " top percentile\n"
+                           << std::setprecision(8)
+                           << "    calculated: " << y
+                           << " (rank " << rank(sorted, y) << ")\n"
+                           << "    expected:   " << exact.topPercentile(1.0-q)
+                           << "\n    tolerance:  " << bound);
+        }
+
+        // value at risk is a percentile, and expected shortfall
+        // averages the tail of the same interpolated distribution
+        const Real centiles[] = { 0.95, 0.99 };
+        for (Size i=0; i<LENGTH(centiles); ++i) {
+            const Real p = centiles[i];
+            const Real bound = 2.0*M_PI*std::sqrt(p*(1.0-p))
+                             / digest.compression();
+            Real calculated = digest.valueAtRisk(p);
+            if (std::fabs(rank(sorted, -calculated) - (1.0-p)) > bound)
+                BOOST_FAIL(name << ": wrong " << p << " value at risk\n"
+                           << "    calculated: " << calculated
+                           << " (rank " << rank(sorted, -calculated) << ")\n"
+                           << "    expected:   " << exact.valueAtRisk(p)
+                           << "\n    tolerance:  " << bound);
+            calculated = digest.expectedShortfall(p);
+            Real expected = exact.expectedShortfall(p);
+            if (std::fabs(calculated/expected - 1.0) >
+                                                3.0/digest.compression())
+                BOOST_FAIL(name << ": wrong " << p
+                           << " expected shortfall\n"
+                           << "    calculated: " << calculated << "\n"
+                           << "    expected:   " << expected << "\n"
+                           << "    tolerance:  "
+                           << 3.0/digest.compression() << " (relative)");
+        }
+        const Real tolerance = 1.0e-2*exact.standardDeviation();
+        Real calculated = digest.downsideDeviation(),
+             expected = exact.downsideDeviation();
+        if (std::fabs(calculated-expected) > tolerance)
+            BOOST_FAIL(name << ": wrong downside deviation\n"
+                       << "    calculated: " << calculated << "\n"
+                       << "    expected:   " << expected << "\n"
+                       << "    tolerance:  " << tolerance);
+    }
+
+}
+
+void StatisticsTest::testTDigestStatistics() {
+
+    BOOST_TEST_MESSAGE("Testing t-digest statistics...");
+
+    // small data sets are stored exactly...
+    const Real sampleWeights[] = { 1.0, 2.0, 0.5, 1.0, 3.0,
+                                   1.0, 0.5, 2.0, 1.0, 1.5 };
+    TDigestRiskStatistics small;
+    RiskStatistics reference;
+    for (Size i=0; i<LENGTH(data); i++) {
+        small.add(data[i], sampleWeights[i]);
+        reference.add(data[i], sampleWeights[i]);
+    }
+    for (Real q=0.05; q<=1.0; q+=0.05) {
+        if (small.percentile(q) != reference.percentile(q))
+            BOOST_FAIL("wrong " << q << " percentile of small data set\n"
+                       << "    calculated: " << small.percentile(q) << "\n"
+                       << "    expected:   " << reference.percentile(q));
+    }
+    if (small.regret(5.0) != reference.regret(5.0))
+        BOOST_FAIL("wrong regret of small data set\n"
+                   << "    calculated: " << small.regret(5.0) << "\n"
+                   << "    expected:   " << reference.regret(5.0));
+
+    // ...and large ones are approximated within the documented bounds
+    MersenneTwisterUniformRng mt(42);
+    InverseCumulativeRng<MersenneTwisterUniformRng,
+                         InverseCumulativeNormal> gen(mt);
+    const Size n = 200000, chunks = 7;
+    const Real compressions[] = { 100.0, 200.0, 500.0 };
+    for (Size k=0; k<LENGTH(compressions); ++k) {
+        const TDigestStatistics empty(compressions[k]);
+        TDigestRiskStatistics digest(empty), merged(empty);
+        std::vector<TDigestRiskStatistics> parts(chunks, digest);
+        RiskStatistics exact;
+        exact.reserve(n);
+        for (Size i=0; i<n; ++i) {
+            // a skewed, fat-tailed P&L
+            Real z = gen.next().value;
+            Real x = 100.0*(z + 0.3*z*z*(z < 0.0 ? -1.0 : 0.5));
+            digest.add(x);
+            exact.add(x);
+            parts[i % chunks].add(x);
+        }
+        for (Size i=0; i<chunks; ++i)
+            merged.merge(parts[i]);
+
+        std::ostringstream name;
+        name << "t-digest (compression " << compressions[k] << ")";
+        checkTDigest(name.str(), digest, exact);
+        checkTDigest("merged " + name.str(), merged, exact);
+    }
+
+    BOOST_CHECK_THROW(TDigestStatistics(1.0), Error);
+}
+
+void StatisticsTest::testTDigestThroughput() {
+
+    BOOST_TEST_MESSAGE("Testing throughput of t-digest statistics...");
+
+    MersenneTwisterUniformRng mt(42);
+    const Size n = 2000000;
+    std::vector<Real> samples(n);
+    for (Size i=0; i<n; ++i)
+        samples[i] = mt.nextReal() - 0.5;
+
+    Real sum = 0.0;
+    for (Size k=0; k<2; ++k) {
+        // compared to the exact statistics, which store and sort
+        // all the samples
+        TDigestRiskStatistics digest;
+        RiskStatistics exact;
+        if (k == 0)
+            digest.addSequence(samples.begin(), samples.end());
+        else
+            exact.addSequence(samples.begin(), samples.end());
+        const Real centiles[] = { 0.95, 0.975, 0.99 };
+        for (Size i=0; i<LENGTH(centiles); ++i) {
+            if (k == 0)
+                sum += digest.valueAtRisk(centiles[i])
+                     + digest.expectedShortfall(centiles[i]);
+            else
+                sum += exact.valueAtRisk(centiles[i])
+                     + exact.expectedShortfall(centiles[i]);
+        }
+    }
+
+    if (!(sum > 0.0 && sum < 12.0))
+        BOOST_FAIL("unexpected sum of risk measures: " << sum);
+}
+
 test_suite* StatisticsTest::suite() {
     test_suite* suite = BOOST_TEST_SUITE("Statistics tests");
     suite->add(QUANTLIB_TEST_CASE(&StatisticsTest::testStatistics));
     suite->add(QUANTLIB_TEST_CASE(&StatisticsTest::testSequenceStatistics));
     suite->add(QUANTLIB_TEST_CASE(&StatisticsTest::testConvergenceStatistics));
     suite->add(QUANTLIB_TEST_CASE(&StatisticsTest::testIncrementalStatistics));
+    suite->add(QUANTLIB_TEST_CASE(&StatisticsTest::testMerge));
+    suite->add(QUANTLIB_TEST_CASE(&StatisticsTest::testTDigestStatistics));
     return suite;
 }
 